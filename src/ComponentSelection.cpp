@@ -0,0 +1,230 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "ComponentSelection.h"
+#include "PointBvh.h"
+#include "Trace.h"
+
+#include <maya/MSelectInfo.h>
+#include <maya/MSelectionList.h>
+#include <maya/MSelectionMask.h>
+#include <maya/MAttributeSpecArray.h>
+#include <maya/MAttributeSpec.h>
+#include <maya/MAttributeIndex.h>
+#include <maya/MObjectArray.h>
+#include <maya/MPointArray.h>
+#include <maya/MFnSingleIndexedComponent.h>
+#include <maya/MDagPath.h>
+#include <maya/MMatrix.h>
+#include <maya/M3dView.h>
+
+#include <float.h>
+#include <algorithm>
+
+// minimum size in pixels of the selection region, so that single clicks
+// still produce a valid (if narrow) selection frustum
+#define MIN_PICK_SIZE 4
+
+//////////////////////////////////////////////////////////////////////////
+// ComponentSelection::matchComponent
+//
+//	Look for attributes specifications of the form:
+//		vtx[ index ]
+//		vtx[ lower:upper ]
+//////////////////////////////////////////////////////////////////////////
+
+MPxSurfaceShape::MatchResult ComponentSelection::matchComponent( const MSelectionList& item, const MAttributeSpecArray& spec,
+																 MSelectionList& list, unsigned int numComponents ) {
+	if ( spec.length() != 1 ) return MPxSurfaceShape::kMatchNone;
+
+	MAttributeSpec attrSpec = spec[ 0 ];
+	if ( attrSpec.dimensions() <= 0 || attrSpec.name() != "vtx" ) {
+		return MPxSurfaceShape::kMatchNone;
+	}
+
+	MAttributeIndex attrIndex = attrSpec[ 0 ];
+	int lower = 0;
+	int upper = (int)numComponents - 1;
+	if ( attrIndex.hasLowerBound() ) attrIndex.getLower( lower );
+	if ( attrIndex.hasUpperBound() ) attrIndex.getUpper( upper );
+
+	if ( lower < 0 || lower > upper || upper >= (int)numComponents ) {
+		return MPxSurfaceShape::kMatchInvalidAttributeRange;
+	}
+
+	MDagPath path;
+	item.getDagPath( 0, path );
+	MFnSingleIndexedComponent fnComponent;
+	MObject component = fnComponent.create( MFn::kMeshVertComponent );
+	fnComponent.setCompleteData( numComponents );
+	for( int i = lower; i <= upper; i++ ) {
+		fnComponent.addElement( i );
+	}
+	list.add( path, component );
+
+	return MPxSurfaceShape::kMatchOk;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ComponentSelection::match
+//////////////////////////////////////////////////////////////////////////
+
+bool ComponentSelection::match( const MSelectionMask& mask, const MObjectArray& componentList ) {
+	if ( componentList.length() == 0 ) {
+		return mask.intersects( MSelectionMask::kSelectMeshes );
+	}
+	for( unsigned int i = 0; i < componentList.length(); i++ ) {
+		if ( componentList[ i ].apiType() == MFn::kMeshVertComponent &&
+			 mask.intersects( MSelectionMask::kSelectMeshVerts ) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ComponentSelection::createFullGroup
+//////////////////////////////////////////////////////////////////////////
+
+MObject ComponentSelection::createFullGroup( unsigned int numComponents ) {
+	MFnSingleIndexedComponent fnComponent;
+	MObject component = fnComponent.create( MFn::kMeshVertComponent );
+	fnComponent.setCompleteData( numComponents );
+	return component;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ComponentSelection::select
+//
+//	Builds the selection frustum from the rectangle in the view, brings it
+//	to object space and queries the hierarchy with it. For a lasso the
+//	rectangle is the one bounding it.
+//////////////////////////////////////////////////////////////////////////
+
+bool ComponentSelection::select( MSelectInfo& selectInfo, const PointBvh& index, const float* points,
+								 MSelectionList& selectionList, MPointArray& worldSpaceSelectPts ) {
+	TRACE_SCOPE( "ComponentSelection::select" );
+	if ( index.empty() ) return false;
+
+	M3dView view = selectInfo.view();
+	const MDagPath path = selectInfo.selectPath();
+	const MMatrix localToWorld = path.inclusiveMatrix();
+	const MMatrix worldToLocal = path.inclusiveMatrixInverse();
+
+	unsigned int rectX, rectY, rectWidth, rectHeight;
+	selectInfo.selectRect( rectX, rectY, rectWidth, rectHeight );
+	if ( rectWidth < MIN_PICK_SIZE ) {
+		rectX -= std::min( rectX, (unsigned int)( MIN_PICK_SIZE - rectWidth ) / 2 );
+		rectWidth = MIN_PICK_SIZE;
+	}
+	if ( rectHeight < MIN_PICK_SIZE ) {
+		rectY -= std::min( rectY, (unsigned int)( MIN_PICK_SIZE - rectHeight ) / 2 );
+		rectHeight = MIN_PICK_SIZE;
+	}
+
+	// rays through the rectangle corners, in object space
+	const short cornerX[ 4 ] = { (short)rectX, (short)( rectX + rectWidth ), (short)( rectX + rectWidth ), (short)rectX };
+	const short cornerY[ 4 ] = { (short)rectY, (short)rectY, (short)( rectY + rectHeight ), (short)( rectY + rectHeight ) };
+	MPoint rayBegin[ 4 ], rayEnd[ 4 ];
+	for( int i = 0; i < 4; i++ ) {
+		MPoint origin;
+		MVector direction;
+		view.viewToWorld( cornerX[ i ], cornerY[ i ], origin, direction );
+		rayBegin[ i ] = origin * worldToLocal;
+		rayEnd[ i ] = ( origin + direction ) * worldToLocal;
+	}
+
+	MPoint centerBegin, centerEnd;
+	{
+		MPoint origin;
+		MVector direction;
+		view.viewToWorld( (short)( rectX + rectWidth / 2 ), (short)( rectY + rectHeight / 2 ), origin, direction );
+		centerBegin = origin * worldToLocal;
+		centerEnd = ( origin + direction ) * worldToLocal;
+	}
+
+	// side planes of the frustum, oriented so that the center ray is inside
+	float planes[ 4 ][ 4 ];
+	for( int i = 0; i < 4; i++ ) {
+		const int next = ( i + 1 ) % 4;
+		MVector normal = ( rayEnd[ i ] - rayBegin[ i ] ) ^ ( rayBegin[ next ] - rayBegin[ i ] );
+		normal.normalize();
+		double d = -( normal * MVector( rayBegin[ i ] ) );
+		if ( normal * MVector( centerEnd ) + d < 0 ) {
+			normal = -normal;
+			d = -d;
+		}
+		planes[ i ][ 0 ] = (float)normal.x;
+		planes[ i ][ 1 ] = (float)normal.y;
+		planes[ i ][ 2 ] = (float)normal.z;
+		planes[ i ][ 3 ] = (float)d;
+	}
+
+	std::vector< int > hits;
+	index.queryPlanes( planes, 4, hits );
+	if ( hits.empty() ) return false;
+
+	MFnSingleIndexedComponent fnComponent;
+	MObject component = fnComponent.create( MFn::kMeshVertComponent );
+	MPoint selectionPoint;
+
+	if ( selectInfo.singleSelection() ) {
+		// keep the component closest to the center of the pick region
+		const MVector centerDir = ( centerEnd - centerBegin ).normal();
+		double closestDistance = DBL_MAX;
+		int closest = hits[ 0 ];
+		for( size_t i = 0; i < hits.size(); i++ ) {
+			const float* p = points + 3 * hits[ i ];
+			const MVector toPoint = MPoint( p[ 0 ], p[ 1 ], p[ 2 ] ) - centerBegin;
+			const double distance = ( toPoint - ( toPoint * centerDir ) * centerDir ).length();
+			if ( distance < closestDistance ) {
+				closestDistance = distance;
+				closest = hits[ i ];
+			}
+		}
+		fnComponent.addElement( closest );
+		const float* p = points + 3 * closest;
+		selectionPoint = MPoint( p[ 0 ], p[ 1 ], p[ 2 ] ) * localToWorld;
+	} else {
+		MIntArray elements( (unsigned int)hits.size() );
+		for( size_t i = 0; i < hits.size(); i++ ) {
+			elements[ (unsigned int)i ] = hits[ i ];
+		}
+		fnComponent.addElements( elements );
+	}
+
+	MSelectionList selectionItem;
+	selectionItem.add( path, component );
+	MSelectionMask mask( MSelectionMask::kSelectComponentsMask );
+	selectInfo.addSelection( selectionItem, selectionPoint, selectionList, worldSpaceSelectPts, mask, true );
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ComponentSelection::getElements
+//////////////////////////////////////////////////////////////////////////
+
+void ComponentSelection::getElements( const MObject& component, unsigned int numComponents, std::vector< int >& elements ) {
+	elements.clear();
+	MFnSingleIndexedComponent fnComponent( component );
+	if ( fnComponent.isComplete() ) {
+		elements.resize( numComponents );
+		for( unsigned int i = 0; i < numComponents; i++ ) {
+			elements[ i ] = (int)i;
+		}
+		return;
+	}
+	const int count = fnComponent.elementCount();
+	elements.reserve( count );
+	for( int i = 0; i < count; i++ ) {
+		const int element = fnComponent.element( i );
+		if ( element >= 0 && element < (int)numComponents ) {
+			elements.push_back( element );
+		}
+	}
+}
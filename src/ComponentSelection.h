@@ -0,0 +1,62 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <maya/MPxSurfaceShape.h>
+#include <maya/MObject.h>
+
+#include <vector>
+
+class MSelectInfo;
+class MSelectionList;
+class MSelectionMask;
+class MAttributeSpecArray;
+class MObjectArray;
+class MPointArray;
+class PointBvh;
+
+/* ==========================================
+	Class ComponentSelection
+
+	Helpers shared by the preview shapes to expose their
+	samples (or voxels) as selectable 'vtx' components.
+
+	Selection is resolved against a PointBvh built over the
+	preview data: the selection rectangle is turned into four
+	planes in object space and the hierarchy culls or accepts
+	whole subtrees, so marquee selection over millions of
+	points only tests the few leaves crossing the border.
+
+	Lasso selection is not resolved exactly. MSelectInfo only
+	gives the shapes the rectangle bounding the lasso, not its
+	outline, so a lasso selects every sample or voxel within
+	that rectangle, as a marquee drawn over it would.
+
+   ========================================== */
+
+class ComponentSelection {
+public:
+	// MPxSurfaceShape::matchComponent implementation for vtx[ index ] and
+	// vtx[ lower:upper ] specifications
+	static MPxSurfaceShape::MatchResult	matchComponent( const MSelectionList& item, const MAttributeSpecArray& spec,
+														MSelectionList& list, unsigned int numComponents );
+
+	// MPxSurfaceShape::match implementation
+	static bool		match( const MSelectionMask& mask, const MObjectArray& componentList );
+
+	// component holding every index, for MPxSurfaceShape::createFullVertexGroup
+	static MObject	createFullGroup( unsigned int numComponents );
+
+	// MPxSurfaceShapeUI::select implementation for components. 'points' holds
+	// the xyz position of each component, in the same order used to build 'index'
+	static bool		select( MSelectInfo& selectInfo, const PointBvh& index, const float* points,
+							MSelectionList& selectionList, MPointArray& worldSpaceSelectPts );
+
+	// gathers the indices of a component object created by the methods above
+	static void		getElements( const MObject& component, unsigned int numComponents, std::vector< int >& elements );
+};
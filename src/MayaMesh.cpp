@@ -0,0 +1,50 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "MayaMesh.h"
+#include "Trace.h"
+
+#include <maya/MFnMesh.h>
+#include <maya/MFloatPointArray.h>
+#include <maya/MIntArray.h>
+#include <maya/MMatrix.h>
+
+bool MayaMesh::GetTriangles( const MFnMesh& mesh, TriangleMesh& triangles, MSpace::Space space ) {
+	TRACE_SCOPE( "MayaMesh::GetTriangles" );
+	triangles.clear();
+
+	MStatus stat;
+	MFloatPointArray points;
+	stat = mesh.getPoints( points, space );
+	if ( !stat ) return false;
+
+	MIntArray triangleCounts, triVertices;
+	stat = mesh.getTriangles( triangleCounts, triVertices );
+	if ( !stat ) return false;
+
+	triangles.points.resize( 3 * points.length() );
+	for( unsigned int i = 0; i < points.length(); i++ ) {
+		triangles.points[ 3 * i + 0 ] = points[ i ].x;
+		triangles.points[ 3 * i + 1 ] = points[ i ].y;
+		triangles.points[ 3 * i + 2 ] = points[ i ].z;
+	}
+
+	triangles.triangles.resize( triVertices.length() );
+	for( unsigned int i = 0; i < triVertices.length(); i++ ) {
+		triangles.triangles[ i ] = triVertices[ i ];
+	}
+
+	return true;
+}
+
+void MayaMesh::GetMatrix( const MMatrix& matrix, float* elements ) {
+	for( int row = 0; row < 4; row++ ) {
+		for( int column = 0; column < 4; column++ ) {
+			elements[ 4 * row + column ] = (float)matrix( row, column );
+		}
+	}
+}
@@ -0,0 +1,32 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+
+#include <maya/MTypes.h>
+
+class MFnMesh;
+class MMatrix;
+
+/* ==========================================
+	Class MayaMesh
+
+	Converts Maya meshes into the plain triangle meshes the
+	core samplers operate on.
+
+   ========================================== */
+
+class MayaMesh {
+public:
+	// triangulates 'mesh' and copies its positions in the given space
+	static bool		GetTriangles( const MFnMesh& mesh, TriangleMesh& triangles, MSpace::Space space = MSpace::kWorld );
+
+	// 'matrix' as the 16 floats TransformPoints expects
+	static void		GetMatrix( const MMatrix& matrix, float* elements );
+};
@@ -6,31 +6,51 @@
 */
 
 #include "RaySampler.h"
+#include "SampleBufferData.h"
+#include "MayaMesh.h"
+#include "RayMarchSampler.h"
+#include "SampleCache.h"
+#include "Hash.h"
+#include "MeshMeasures.h"
+#include "Transform.h"
+#include "Timer.h"
+#include "Trace.h"
 
 #include <maya/MPlug.h>
 #include <maya/MDataBlock.h>
 #include <maya/MDataHandle.h>
 #include <maya/MFnTypedAttribute.h>
 #include <maya/MFnNumericAttribute.h>
-#include <maya/MPointArray.h>
-#include <maya/MFnPointArrayData.h>
-#include <maya/MFloatPointArray.h>
+#include <maya/MFnEnumAttribute.h>
+#include <maya/MFnMatrixAttribute.h>
+#include <maya/MMatrix.h>
 #include <maya/MFnMesh.h>
 #include <maya/MGlobal.h>
-#include <maya/MBoundingBox.h>
-#include <maya/MMatrix.h>
-#include <maya/MFloatMatrix.h>
-#include <maya/MFloatArray.h>
 
 #include <assert.h>
+#include <algorithm>
+
 MTypeId     RaySampler::id( 0x83100 );
 
 // Attributes
 MObject		RaySampler::numSamples;
+MObject		RaySampler::seed;
+MObject		RaySampler::cacheFile;
+MObject		RaySampler::sampleSpace;
+MObject		RaySampler::method;
+MObject		RaySampler::chordResolution;
+MObject		RaySampler::guideRays;
+MObject		RaySampler::insideTest;
 MObject     RaySampler::mesh;        
 MObject     RaySampler::outSamples;
+MObject     RaySampler::outMatrix;
+MObject     RaySampler::meshVolume;
+MObject     RaySampler::meshArea;
+MObject     RaySampler::statistics;
 
-RaySampler::RaySampler() {}
+SamplerStatsAttribute RaySampler::statsAttribute;
+
+RaySampler::RaySampler() : chordsHash( 0 ), samplesHash( 0 ), worldSamplesHash( 0 ) {}
 RaySampler::~RaySampler() {}
 
 MStatus RaySampler::compute( const MPlug& plug, MDataBlock& data )
@@ -44,6 +64,7 @@ MStatus RaySampler::compute( const MPlug& plug, MDataBlock& data )
 //		data - object that provides access to the attributes for this node
 //
 {
+	TRACE_SCOPE( "RaySampler::compute" );
 	MStatus returnStatus;
 
 	// Check which output attribute we have been asked to compute.  If this 
@@ -55,18 +76,124 @@ MStatus RaySampler::compute( const MPlug& plug, MDataBlock& data )
 		// Read the input value from the handle.
 		//
 		int numSamples = data.inputValue( RaySampler::numSamples ).asInt();
+		const int seed = data.inputValue( RaySampler::seed ).asInt();
+		const MString cachePath = data.inputValue( cacheFile ).asString();
+		const short space = data.inputValue( sampleSpace ).asShort();
+		const short method = data.inputValue( RaySampler::method ).asShort();
+		const int resolution = data.inputValue( chordResolution ).asInt();
+		const bool guided = data.inputValue( guideRays ).asBool();
+		const short test = data.inputValue( insideTest ).asShort();
 		// by querying the voxels as input value we ensure the attribute is evaluated
 		// if necessary and we're getting an up-to-date copy
+		MDataHandle meshHandle = data.inputValue( mesh );
+		MFnMesh inMesh( meshHandle.asMesh() );
+
+		Timer timer;
+
+		TriangleMesh triangles;
+		MayaMesh::GetTriangles( inMesh, triangles, space == SPACE_WORLD ? MSpace::kWorld : MSpace::kObject );
+		const double meshMs = timer.elapsedMs();
+
+		// nothing to sample if neither the geometry nor the parameters changed
+		// since the last evaluation
+		const uint64_t meshHash = triangles.view().hash();
+		const int params[ 5 ] = { numSamples, seed, method, method == METHOD_CHORDS ? resolution : guided, method == METHOD_RAYS ? test : 0 };
+		uint64_t hash = Hash64( params, sizeof( params ), meshHash );
+		hash = Hash64( cachePath.asChar(), cachePath.length(), hash );
+		if ( hash != samplesHash || samplesData.isNull() ) {
+			stats.clear();
+			stats.meshMs = meshMs;
+
+			// the chords only depend on the mesh and the resolution, and are
+			// kept for as long as these don't change
+			timer.restart();
+			const uint64_t chordsKey = Hash64( &resolution, sizeof( resolution ), meshHash );
+			if ( method == METHOD_RAYS ) {
+				sampler.setMesh( triangles.view(), guided ? RayMarchSampler::DEFAULT_GUIDE_RESOLUTION : 0, (InsideTest)test );
+			} else if ( chordsKey != chordsHash ) {
+				chordSampler.setMesh( triangles.view(), resolution, &stats );
+				chordsHash = chordsKey;
+			}
+			stats.acceleratorMs = timer.elapsedMs();
+
+			timer.restart();
+			SampleCacheWriter cache;
+			if ( cachePath.length() > 0 && !cache.open( cachePath.asChar(), seed ) ) {
+				MGlobal::displayWarning( MString( "RaySampler: can't write the sample cache " ) + cachePath );
+			}
+
+			// when caching, samples are generated a block at a time so that the
+			// cache writes the previous block while the next one is sampled
+			const int chunkSize = cache.isOpen() ? (int)SampleCacheWriter::DEFAULT_BLOCK_SIZE : numSamples;
+			std::vector< float > samples;
+			samples.reserve( 3 * (size_t)numSamples );
+			Random rng( seed );
+			for( int done = 0; done < numSamples; done += chunkSize ) {
+				const size_t first = samples.size();
+				const int chunk = std::min( chunkSize, numSamples - done );
+				const bool sampled = method == METHOD_RAYS ?
+									 sampler.Sample( chunk, numSamples, rng, samples, &stats ) :
+									 chordSampler.Sample( chunk, rng, samples, &stats );
+				if ( !sampled ) break;
+				if ( cache.isOpen() ) cache.append( &samples[ first ], ( samples.size() - first ) / 3 );
+			}
+			if ( cache.isOpen() && !cache.close() ) {
+				MGlobal::displayWarning( MString( "RaySampler: failed writing the sample cache " ) + cachePath );
+			}
+			stats.samplingMs = timer.elapsedMs();
+
+			// Hand the samples over to an immutable shared buffer, which every
+			// node downstream will reference rather than copy.
+			//
+			samplesData = SampleBufferData::create( SampleBuffer::create( samples ), &returnStatus );
+			if ( !returnStatus ) return returnStatus;
+			samplesHash = hash;
+		}
+
+		// in object space mode the samples taken in the mesh's local space
+		// are moved to world space, which is all that needs to be done again
+		// when only the transform of the mesh changes
+		MObject output = samplesData;
+		if ( space == SPACE_OBJECT ) {
+			float matrix[ 16 ];
+			MayaMesh::GetMatrix( meshHandle.geometryTransformMatrix(), matrix );
+			if ( !IsIdentity( matrix ) ) {
+				const uint64_t worldHash = Hash64( matrix, sizeof( matrix ), samplesHash );
+				if ( worldHash != worldSamplesHash || worldSamplesData.isNull() ) {
+					worldSamplesData = SampleBufferData::createTransformed( samplesData, matrix, &returnStatus );
+					if ( !returnStatus ) return returnStatus;
+					worldSamplesHash = worldHash;
+				}
+				output = worldSamplesData;
+			}
+		}
+		data.outputValue( RaySampler::outSamples ).set( output );
+
+	} else if ( plug == outMatrix ) {
+
+		const short space = data.inputValue( sampleSpace ).asShort();
+		data.outputValue( outMatrix ).set( space == SPACE_LOCAL ? data.inputValue( mesh ).geometryTransformMatrix() : MMatrix::identity );
+
+	} else if ( plug == meshVolume || plug == meshArea ) {
+
+		const short space = data.inputValue( sampleSpace ).asShort();
 		MFnMesh inMesh( data.inputValue( mesh ).asMesh() );
+		TriangleMesh triangles;
+		MayaMesh::GetTriangles( inMesh, triangles, space == SPACE_WORLD ? MSpace::kWorld : MSpace::kObject );
+		const MeshMeasures measures = MeshMeasures::Compute( triangles.view() );
+
+		// both are computed at once, so both are clean afterwards
+		data.outputValue( meshVolume ).set( measures.volume );
+		data.outputValue( meshArea ).set( measures.area );
+		data.setClean( meshVolume );
+		data.setClean( meshArea );
+		return MS::kSuccess;
 
-		// Get a handle to the output attribute.  This is similar to the
-		// "inputValue" call above except that no dependency graph 
-		// computation will be done as a result of this call.
-		// 
-		MFnPointArrayData samplesHandle( data.outputValue( RaySampler::outSamples ).data() );
-		MPointArray samples = samplesHandle.array();
+	} else if ( plug == statistics || ( plug.isChild() && plug.parent() == statistics ) ) {
 
-		Sample( inMesh, numSamples, samples );
+		// make sure the samples are up to date before publishing their statistics
+		data.inputValue( RaySampler::outSamples );
+		statsAttribute.set( data, statistics, stats );
 
 	} else {
 		return MS::kUnknownParameter;
@@ -108,6 +235,8 @@ MStatus RaySampler::initialize()
 {
 	MFnTypedAttribute	tAttr;
 	MFnNumericAttribute nAttr;
+	MFnEnumAttribute	eAttr;
+	MFnMatrixAttribute	mAttr;
 	MStatus				stat;
 
 	numSamples = nAttr.create( "sampleCount", "sc", MFnNumericData::kInt, 100, &stat );
@@ -116,15 +245,57 @@ MStatus RaySampler::initialize()
 	nAttr.setWritable( true );
 	nAttr.setStorable( true );
 
+	seed = nAttr.create( "seed", "sd", MFnNumericData::kInt, 0, &stat );
+	if ( !stat ) return stat;
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	cacheFile = tAttr.create( "cacheFile", "cf", MFnData::kString, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( true );
+	tAttr.setStorable( true );
+	tAttr.setUsedAsFilename( true );
+
+	sampleSpace = eAttr.create( "sampleSpace", "ss", SPACE_WORLD, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "World", SPACE_WORLD );
+	eAttr.addField( "Object", SPACE_OBJECT );
+	eAttr.addField( "Local", SPACE_LOCAL );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	method = eAttr.create( "method", "mt", METHOD_RAYS, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "Random Rays", METHOD_RAYS );
+	eAttr.addField( "Axis Chords", METHOD_CHORDS );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	chordResolution = nAttr.create( "chordResolution", "cr", MFnNumericData::kInt, ChordSampler::DEFAULT_RESOLUTION, &stat );
+	if ( !stat ) return stat;
+	nAttr.setMin( 1 );
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	guideRays = nAttr.create( "guideRays", "gr", MFnNumericData::kBoolean, false, &stat );
+	if ( !stat ) return stat;
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	insideTest = eAttr.create( "insideTest", "it", INSIDE_PARITY, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "Parity", INSIDE_PARITY );
+	eAttr.addField( "Winding Number", INSIDE_WINDING_NUMBER );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
 	mesh = tAttr.create( "inputMesh", "in", MFnData::kMesh, MObject::kNullObj, &stat );
 	if ( !stat ) return stat;
 	tAttr.setWritable( true );
 	tAttr.setStorable( false );
 	tAttr.setHidden( true );
 
-	MFnPointArrayData pCreator;
-	MObject pa = pCreator.create();	
-	outSamples = tAttr.create( "outSamples", "os", MFnData::kPointArray, pa, &stat );
+	outSamples = tAttr.create( "outSamples", "os", SampleBufferData::id, MObject::kNullObj, &stat );
 	if ( !stat ) return stat;
 	// Attribute is read-only because it is an output attribute
 	tAttr.setWritable(false);
@@ -132,128 +303,69 @@ MStatus RaySampler::initialize()
 	tAttr.setStorable(false);
 	tAttr.setCached( false );// allow us to query it as often as we want
 
+	outMatrix = mAttr.create( "outMatrix", "om", MFnMatrixAttribute::kDouble, &stat );
+	if ( !stat ) return stat;
+	mAttr.setWritable( false );
+	mAttr.setStorable( false );
+
+	meshVolume = nAttr.create( "meshVolume", "mvo", MFnNumericData::kDouble, 0.0, &stat );
+	if ( !stat ) return stat;
+	nAttr.setWritable( false );
+	nAttr.setStorable( false );
+
+	meshArea = nAttr.create( "meshArea", "mar", MFnNumericData::kDouble, 0.0, &stat );
+	if ( !stat ) return stat;
+	nAttr.setWritable( false );
+	nAttr.setStorable( false );
+
+	statistics = statsAttribute.create( &stat );
+	if ( !stat ) return stat;
+
 	// Add the attributes we have created to the node
 	//
 	addAttribute( numSamples );
+	addAttribute( seed );
+	addAttribute( cacheFile );
+	addAttribute( sampleSpace );
+	addAttribute( method );
+	addAttribute( chordResolution );
+	addAttribute( guideRays );
+	addAttribute( insideTest );
 	addAttribute( mesh );
 	addAttribute( outSamples );
+	addAttribute( outMatrix );
+	addAttribute( meshVolume );
+	addAttribute( meshArea );
+	addAttribute( statistics );
 
 	// Set up a dependency between the input and the output.  This will cause
 	// the output to be marked dirty when the input changes.  The output will
 	// then be recomputed the next time the value of the output is requested.
 	//
 	attributeAffects( numSamples, outSamples );
+	attributeAffects( seed, outSamples );
+	attributeAffects( cacheFile, outSamples );
+	attributeAffects( sampleSpace, outSamples );
+	attributeAffects( method, outSamples );
+	attributeAffects( chordResolution, outSamples );
+	attributeAffects( guideRays, outSamples );
+	attributeAffects( insideTest, outSamples );
 	attributeAffects( mesh, outSamples );
+	attributeAffects( sampleSpace, outMatrix );
+	attributeAffects( mesh, outMatrix );
+	attributeAffects( sampleSpace, meshVolume );
+	attributeAffects( sampleSpace, meshArea );
+	attributeAffects( mesh, meshVolume );
+	attributeAffects( mesh, meshArea );
+	attributeAffects( numSamples, statistics );
+	attributeAffects( seed, statistics );
+	attributeAffects( cacheFile, statistics );
+	attributeAffects( sampleSpace, statistics );
+	attributeAffects( method, statistics );
+	attributeAffects( chordResolution, statistics );
+	attributeAffects( guideRays, statistics );
+	attributeAffects( insideTest, statistics );
+	attributeAffects( mesh, statistics );
 
 	return MS::kSuccess;
 }
-
-static inline float random01() { return (float)rand() / RAND_MAX; }
-
-void RaySampler::Sample( MFnMesh& mesh, int numSamples, MPointArray& samples ) {
-
-	samples.clear();
-
-	MStatus stat;
-
-	MFloatPoint rayOrigin, rayEnd;
-
-	// calculate mesh bounds
-	MBoundingBox bounds;
-	bounds.clear();
-	{
-		MPointArray points;
-		mesh.getPoints( points, MSpace::kWorld );
-		for( unsigned int i = 0; i < points.length(); i++ ) {
-			bounds.expand( points[ i ] );
-		}
-
-		// expand the bounds slightly to avoid touching the mesh faces
-		
-		MBoundingBox expanded( MPoint( bounds.min().x - 1, bounds.min().y - 1, bounds.min().z - 1 ),
-							   MPoint( bounds.max().x + 1, bounds.max().y + 1, bounds.max().z + 1 ) );
-		bounds = expanded; 
-	}
-	
-
-	const float boundsWidth = (float)bounds.width();
-	const float boundsHeight = (float)bounds.height();
-	const float boundsDepth = (float)bounds.depth();
-	const MFloatPoint boundsMin( (float)bounds.min().x, (float)bounds.min().y, (float)bounds.min().z );
-	
-	// use a common accelerator params object between raytrace calls
-	// so Maya reuses the internal accelerator structure
-	MMeshIsectAccelParams accelerator = mesh.autoUniformGridParams();
-
-	// Trace random rays between opposed pairs of faces and produce samples along each entry/exit segment
-
-	float volume = (float)(bounds.width() * bounds.height() * bounds.depth());
-	float linearDensity = std::max( 1e-4f,  (float)numSamples / volume );
-	int maxSamplesPerRay = std::max( 1, (int)powf( volume, 1.0f / 3.0f ) ) >> 1;
-	
-	while( (int)samples.length() < numSamples ) {
-
-		int boxFace = random() % 6;
-		switch( boxFace ) {
-			case 0:
-				rayOrigin = boundsMin + MFloatPoint( 0, random01() * boundsHeight, random01() * boundsDepth );
-				rayEnd = boundsMin + MFloatPoint( boundsWidth, random01() * boundsHeight, random01() * boundsDepth );
-				break;
-			case 1:
-				rayOrigin = boundsMin + MFloatPoint( boundsWidth, random01() * boundsHeight, random01() * boundsDepth );
-				rayEnd = boundsMin + MFloatPoint( 0, random01() * boundsHeight, random01() * boundsDepth );
-				break;
-			case 2:
-				rayOrigin = boundsMin + MFloatPoint( random01() * boundsWidth, 0, random01() * boundsDepth );
-				rayEnd = boundsMin + MFloatPoint( random01() * boundsWidth, boundsHeight, random01() * boundsDepth );
-				break;
-			case 3:
-				rayOrigin = boundsMin + MFloatPoint( random01() * boundsWidth, boundsHeight, random01() * boundsDepth );
-				rayEnd = boundsMin + MFloatPoint( random01() * boundsWidth, 0, random01() * boundsDepth );
-				break;
-			case 4:
-				rayOrigin = boundsMin + MFloatPoint( random01() * boundsWidth, random01() * boundsHeight, 0 );
-				rayEnd = boundsMin + MFloatPoint( random01() * boundsWidth, random01() * boundsHeight, boundsDepth );
-				break;
-			case 5:
-				rayOrigin = boundsMin + MFloatPoint( random01() * boundsWidth, random01() * boundsHeight, boundsDepth );
-				rayEnd = boundsMin + MFloatPoint( random01() * boundsWidth, random01() * boundsHeight, 0 );
-				break;
-			default: break;
-		}
-
-		MFloatVector rayDir = rayEnd - rayOrigin;
-		
-		MFloatPointArray hitPoints;
-		mesh.allIntersections( rayOrigin, rayDir, 
-							   NULL, NULL, 
-							   false, 
-							   MSpace::kWorld, 
-							   1.0,
-							   false,
-							   &accelerator, 
-							   true, // sort hits
-							   hitPoints,
-							   NULL,
-							   NULL,
-							   NULL,
-							   NULL, NULL );
-
-		if ( hitPoints.length() < 2 ) {
-			continue;
-		}
-
-		for( unsigned int i = 0; i < hitPoints.length() - 1; i += 2 ) {
-			const MFloatPoint segmentBegin = hitPoints[ i ];
-			const MFloatPoint segmentEnd = hitPoints[ i + 1 ];
-			const float length = segmentBegin.distanceTo(segmentEnd);
-			const int ns = std::min( maxSamplesPerRay, (int)ceil( length * linearDensity ) );
-			const MFloatVector dir = segmentEnd - segmentBegin;
-			for( int j = 0; j < ns; j++ ) {
-				MPoint sample = segmentBegin + random01() * dir;
-				samples.append( sample );
-			}
-		}
-	}
-	mesh.freeCachedIntersectionAccelerator();
-}
\ No newline at end of file
@@ -11,16 +11,63 @@
 #include <maya/MPxNode.h>
 #include <maya/MFnNumericAttribute.h>
 #include <maya/MTypeId.h> 
-#include <maya/MPointArray.h>
-#include <maya/MFnMesh.h>
+
+#include "SamplerStatsAttribute.h"
+#include "RayMarchSampler.h"
+#include "ChordSampler.h"
+
+#include <stdint.h>
 
 /* ==========================================
 	Class RaySampler
 
-	Implements a volume sampler by using raymarching. 
-	Requires a polygonal mesh to be connected to it's inMesh
-	attribute, and outputs a MFnPointArray with the sample
-	locations.
+	Implements a volume sampler by using raymarching (see
+	RayMarchSampler in the core library). Requires a polygonal
+	mesh to be connected to it's inMesh attribute, and outputs
+	a SampleBufferData with the sample locations. The counters
+	and stage timings of the last evaluation are published in
+	the 'statistics' attribute.
+
+	'method' selects between casting random rays across the
+	mesh bounds for every evaluation, and sampling the chords
+	of rays along X, Y and Z through a grid of
+	'chordResolution' cells (see ChordSampler). The chords are
+	kept while the mesh and resolution don't change, so new
+	sample counts or seeds are drawn from them directly.
+	With 'guideRays' the random rays are only cast through
+	the columns of a coarse voxelization of the mesh that
+	contain some of it. 'insideTest' selects how the random
+	rays tell the inside of the mesh: Parity pairs up their
+	hits, which needs a closed mesh, and Winding Number keeps
+	the stretches between hits where the generalized winding
+	number says so (see WindingNumber), for meshes with
+	holes or overlapping shells. The chords are always paired
+	up.
+
+	When 'cacheFile' is set, the samples are also streamed to
+	that path as a sample cache (see SampleCache.h) while they
+	are being generated.
+
+	The mesh is dirtied by upstream changes which don't alter
+	its points (e.g. transforming an unrelated parent), so the
+	inputs are hashed and the previous samples are returned
+	as long as the hash doesn't change.
+
+	'sampleSpace' selects where the mesh is sampled:
+	  - World: the world space mesh, as it is placed in the scene.
+	  - Object: the mesh in its local space. The samples are then
+		moved to world space with the mesh's transform, so that
+		moving the mesh around only transforms the previous
+		samples instead of sampling it again.
+	  - Local: as Object, but the samples are output in local
+		space, and the transform is left in 'outMatrix' for the
+		consumers to apply.
+	'outMatrix' holds the identity in the other modes. Sample
+	caches are written in the space the mesh is sampled in.
+
+	'meshVolume' and 'meshArea' hold the enclosed volume and
+	surface area of the mesh (see MeshMeasures), also in the
+	space it is sampled in.
 
    ========================================== */
 
@@ -42,8 +89,21 @@ public:
 	// the values later.
 	//
 	static MObject  numSamples;
+	static MObject  seed;
+	static MObject  cacheFile;
+	static MObject  sampleSpace;
+	static MObject  method;
+	static MObject  chordResolution;
+	static MObject  guideRays;
+	static MObject  insideTest;
 	static MObject  mesh;        
 	static MObject	outSamples;
+	static MObject	outMatrix;
+	static MObject	meshVolume;
+	static MObject	meshArea;
+	static MObject	statistics;
+
+	static SamplerStatsAttribute	statsAttribute;
 
 	// The typeid is a unique 32bit identifier that describes this node.
 	// It is used to save and retrieve nodes of this type from the binary
@@ -51,8 +111,36 @@ public:
 	//
 	static	MTypeId		id;
 
+	enum Method {
+		METHOD_RAYS = 0,
+		METHOD_CHORDS
+	};
+
+	enum SampleSpace {
+		SPACE_WORLD = 0,
+		SPACE_OBJECT,
+		SPACE_LOCAL
+	};
+
 private:
 
-	void Sample( MFnMesh& mesh, int numSamples, MPointArray& samples );
+	SamplerStats	stats;	// last evaluation of outSamples
+
+	// kept between evaluations so that its buffers are reused
+	RayMarchSampler	sampler;
+
+	// chords of the last mesh sampled with METHOD_CHORDS, keyed by the mesh
+	// contents and resolution
+	ChordSampler	chordSampler;
+	uint64_t		chordsHash;
+
+	// content hash of the inputs of the last evaluation of outSamples, and
+	// the SampleBufferData it produced
+	uint64_t		samplesHash;
+	MObject			samplesData;
 
+	// the samples of the last evaluation in object space mode moved to world
+	// space, keyed by samplesHash and the mesh transform
+	uint64_t		worldSamplesHash;
+	MObject			worldSamplesData;
 };
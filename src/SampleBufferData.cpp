@@ -0,0 +1,92 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "SampleBufferData.h"
+
+#include <maya/MDataHandle.h>
+#include <maya/MFnPluginData.h>
+
+const MTypeId SampleBufferData::id( 0x80104 );
+const MString SampleBufferData::typeName( "SampleBufferData" );
+
+//////////////////////////////////////////////////////////////////////////
+// SampleBufferData::create
+//
+//	Wraps the provided buffer in a new plugin data object
+//////////////////////////////////////////////////////////////////////////
+
+MObject SampleBufferData::create( const SampleBuffer* buffer, MStatus* status ) {
+	MFnPluginData fnDataCreator;
+	MObject dataObj = fnDataCreator.create( SampleBufferData::id, status );
+	SampleBufferData* bufferData = (SampleBufferData*)fnDataCreator.data( status );
+	if ( bufferData != NULL ) {
+		bufferData->reset( buffer );
+	}
+	return dataObj;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SampleBufferData::fromHandle
+//////////////////////////////////////////////////////////////////////////
+
+const SampleBuffer* SampleBufferData::fromHandle( const MDataHandle& handle ) {
+	MPxData* pxData = handle.asPluginData();
+	if ( pxData == NULL || pxData->typeId() != SampleBufferData::id ) {
+		return NULL;
+	}
+	return ((SampleBufferData*)pxData)->getBuffer();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SampleBufferData::fromObject
+//////////////////////////////////////////////////////////////////////////
+
+const SampleBuffer* SampleBufferData::fromObject( const MObject& data ) {
+	if ( data.isNull() ) return NULL;
+	MFnPluginData fnData( data );
+	MPxData* pxData = fnData.data();
+	if ( pxData == NULL || pxData->typeId() != SampleBufferData::id ) {
+		return NULL;
+	}
+	return ((SampleBufferData*)pxData)->getBuffer();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SampleBufferData::createTransformed
+//////////////////////////////////////////////////////////////////////////
+
+MObject SampleBufferData::createTransformed( const MObject& data, const float* matrix, MStatus* status ) {
+	const SampleBuffer* source = fromObject( data );
+	if ( source == NULL ) {
+		if ( status != NULL ) *status = MS::kFailure;
+		return MObject::kNullObj;
+	}
+	return create( SampleBuffer::createTransformed( *source, matrix ), status );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SampleBufferData::copy (override)
+//
+//	Copies only the reference, never the samples
+//////////////////////////////////////////////////////////////////////////
+
+void SampleBufferData::copy( const MPxData& other ) {
+	if ( other.typeId() == typeId() ) {
+		reset( ((const SampleBufferData &)other).buffer );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SampleBufferData::creator
+//
+//	This method exists to give Maya a way to create new objects
+//	of this type.
+//////////////////////////////////////////////////////////////////////////
+
+void * SampleBufferData::creator() {
+	return new SampleBufferData();
+}
@@ -0,0 +1,74 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <maya/MPxData.h>
+#include <maya/MTypeId.h>
+#include <maya/MString.h>
+#include <maya/MObject.h>
+
+#include "SampleBuffer.h"
+
+class MDataHandle;
+
+/* ==========================================
+
+	Class SampleBufferData
+
+	Shared data pointer wrapper used to pass a SampleBuffer
+	along the DG. Maya makes copies of attribute data when
+	connecting plugs, but copying this wrapper only adds a
+	reference to the underlying buffer, so all the nodes
+	downstream of a sampler share a single allocation.
+
+========================================== */
+
+class SampleBufferData : public MPxData {
+public:
+							SampleBufferData() : buffer( NULL ) {}
+	virtual					~SampleBufferData() { reset( NULL ); }
+
+	const SampleBuffer*		getBuffer() const { return buffer; }
+
+	void reset( const SampleBuffer* bufferPtr ) {
+		if ( bufferPtr ) bufferPtr->incRef();
+		SampleBuffer::release( buffer );
+		buffer = bufferPtr;
+	}
+
+	// helpers
+
+	// creates a new data object holding a reference to 'buffer', ready to be
+	// set on an output attribute handle
+	static MObject				create( const SampleBuffer* buffer, MStatus* status = NULL );
+
+	// returns the buffer held by the handle, or NULL if there isn't any
+	static const SampleBuffer*	fromHandle( const MDataHandle& handle );
+	static const SampleBuffer*	fromObject( const MObject& data );
+
+	// creates a new data object with the points of 'data' transformed by
+	// 'matrix' (see TransformPoints)
+	static MObject				createTransformed( const MObject& data, const float* matrix, MStatus* status = NULL );
+
+	// overrides
+
+	virtual	void			copy ( const MPxData& );
+
+	virtual MTypeId         typeId() const { return id; }
+	virtual MString         name() const { return typeName; }
+
+	static void * creator();
+
+public:
+
+	static const MString typeName;
+	static const MTypeId id;
+
+private:
+	const SampleBuffer* buffer;
+};
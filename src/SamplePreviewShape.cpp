@@ -6,6 +6,10 @@
 */
 
 #include "SamplePreviewShape.h"
+#include "SampleBufferData.h"
+#include "ComponentSelection.h"
+#include "SampleCache.h"
+#include "Trace.h"
 
 #include <assert.h>
 
@@ -27,6 +31,7 @@ const MTypeId SamplePreviewData::id( 0x80103 );
 const MString SamplePreviewData::typeName( "SamplePreviewData" );
 
 MObject     SampleShape::sampleData;
+MObject     SampleShape::cacheFile;
 MObject     SampleShape::outData;
 
 //////////////////////////////////////////////////////////////////////
@@ -78,6 +83,7 @@ MObject SampleShape::geometryData() const {
 ////////////////////////////////////////////////////////////////////////////
 
 MStatus SampleShape::compute( const MPlug& plug, MDataBlock& data ) {
+	TRACE_SCOPE( "SampleShape::compute" );
 	MStatus stat;
 
 	// Check which output attribute we have been asked to compute.  If this 
@@ -92,8 +98,6 @@ MStatus SampleShape::compute( const MPlug& plug, MDataBlock& data ) {
 		// connections to be evaluated so that the correct value is supplied.
 		// 
 		MDataHandle inputDataHandle = data.inputValue( sampleData, &stat );
-
-		MObject inputDataObj = inputDataHandle.data();
 		
 		MFnPluginData fnDataCreator;
 		MTypeId tmpid( SamplePreviewData::id );
@@ -110,15 +114,24 @@ MStatus SampleShape::compute( const MPlug& plug, MDataBlock& data ) {
 			MCHECKERROR( stat, "compute : error getting proxy SamplePreviewData object")
 		}
 
-		// compute the output values			
-		MFnPointArrayData inputData;
-		inputData.setObject(inputDataObj);
-		newData->samples = inputData.array();
-
-		// compute bounding box for fast retrieval
-		bounds.clear();			
-		for( unsigned int i = 0; i < newData->samples.length(); i += 2 ) {
-			bounds.expand( newData->samples[ i ] );
+		// compute the output values: just take a reference to the incoming
+		// samples, which are never copied
+		const SampleBuffer* samples = SampleBufferData::fromHandle( inputDataHandle );
+		if ( samples == NULL ) {
+			const MString cachePath = data.inputValue( cacheFile ).asString();
+			if ( cachePath.length() > 0 ) {
+				samples = ReadCache( cachePath );
+			}
+		}
+		newData->reset( samples );
+
+		// bounding box for fast retrieval, precalculated by the buffer
+		bounds.clear();
+		if ( samples != NULL && !samples->empty() ) {
+			const float* bbMin = samples->boundsMin();
+			const float* bbMax = samples->boundsMax();
+			bounds.expand( MPoint( bbMin[ 0 ], bbMin[ 1 ], bbMin[ 2 ] ) );
+			bounds.expand( MPoint( bbMax[ 0 ], bbMax[ 1 ], bbMax[ 2 ] ) );
 		}
 		
 		// Assign the new data to the outputSurface handle
@@ -135,6 +148,27 @@ MStatus SampleShape::compute( const MPlug& plug, MDataBlock& data ) {
 	return MS::kSuccess;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// SampleShape::ReadCache
+//
+//	Loads the samples of a cache file. The file is memory-mapped and
+//	decoded straight into the buffer, so only the blocks are read and no
+//	intermediate copy is made. Returns NULL if the file can't be read.
+////////////////////////////////////////////////////////////////////////////
+
+const SampleBuffer* SampleShape::ReadCache( const MString& path ) {
+	TRACE_SCOPE( "SampleShape::ReadCache" );
+	SampleCacheReader reader;
+	std::string error;
+	std::vector< float > xyz;
+	if ( !reader.open( path.asChar(), &error ) || !reader.readAll( xyz ) ) {
+		if ( error.empty() ) error = "can't decode samples";
+		MGlobal::displayWarning( MString( "SamplePreview: " ) + path + ": " + error.c_str() );
+		return NULL;
+	}
+	return SampleBuffer::create( xyz );
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 // SampleShape::meshDataRef
@@ -177,6 +211,47 @@ SamplePreviewData* SampleShape::getData() {
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+// SampleShape::numSamples
+////////////////////////////////////////////////////////////////////////////
+
+unsigned int SampleShape::numSamples() {
+	SamplePreviewData* data = getData();
+	if ( data == NULL || data->getSamples() == NULL ) return 0;
+	return (unsigned int)data->getSamples()->size();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SampleShape::matchComponent (override)
+//
+//	Resolves 'vtx[...]' specifications into sample components
+////////////////////////////////////////////////////////////////////////////
+
+MPxSurfaceShape::MatchResult SampleShape::matchComponent( const MSelectionList& item, const MAttributeSpecArray& spec, MSelectionList& list ) {
+	MatchResult result = ComponentSelection::matchComponent( item, spec, list, numSamples() );
+	if ( result == kMatchNone ) {
+		return MPxSurfaceShape::matchComponent( item, spec, list );
+	}
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SampleShape::match (override)
+////////////////////////////////////////////////////////////////////////////
+
+bool SampleShape::match( const MSelectionMask& mask, const MObjectArray& componentList ) const {
+	return ComponentSelection::match( mask, componentList );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SampleShape::createFullVertexGroup (override)
+////////////////////////////////////////////////////////////////////////////
+
+MObject SampleShape::createFullVertexGroup() const {
+	SampleShape* nonConstThis = const_cast<SampleShape*>(this);
+	return ComponentSelection::createFullGroup( nonConstThis->numSamples() );
+}
+
 //////////////////////////////////////////////////////////////////////////
 // SampleShape::creator
 //
@@ -203,14 +278,15 @@ MStatus SampleShape::initialize() {
 
 	// Input attributes
 
-	MPointArray defaultPointArray;
-	MFnPointArrayData pointArrayDataFn;
-	pointArrayDataFn.create( defaultPointArray );
-
-	sampleData = typedAttr.create( "sampleData", "sd", MFnData::kPointArray, pointArrayDataFn.object() );
+	sampleData = typedAttr.create( "sampleData", "sd", SampleBufferData::id, MObject::kNullObj );
 	typedAttr.setWritable( true );
 	typedAttr.setReadable( true );
 
+	cacheFile = typedAttr.create( "cacheFile", "cf", MFnData::kString, MObject::kNullObj );
+	typedAttr.setWritable( true );
+	typedAttr.setStorable( true );
+	typedAttr.setUsedAsFilename( true );
+
 	outData = typedAttr.create( "output", "out", SamplePreviewData::id );
 	typedAttr.setWritable( false );
 	typedAttr.setStorable(false);
@@ -219,10 +295,12 @@ MStatus SampleShape::initialize() {
 	// Add the attributes to the node
 
 	addAttribute( sampleData );
+	addAttribute( cacheFile );
 	addAttribute( outData );
 
 	// Set the attribute dependencies
 	attributeAffects( sampleData, outData );
+	attributeAffects( cacheFile, outData );
 	
 	return MS::kSuccess;
 }
@@ -243,12 +321,29 @@ void* SamplePreviewData::creator() {
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+// SamplePreviewData::getIndex
+//
+//	The hierarchy is only needed for component selection, so it is built
+//	the first time it is requested rather than on every compute.
+////////////////////////////////////////////////////////////////////////////
+
+const PointBvh& SamplePreviewData::getIndex() const {
+	if ( index == NULL ) {
+		index = new PointBvh();
+		if ( samples != NULL ) {
+			index->build( samples->data(), samples->size() );
+		}
+	}
+	return *index;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // SamplePreviewData::copy
 ////////////////////////////////////////////////////////////////////////////
 
 void SamplePreviewData::copy( const MPxData& other ) {
 	if ( other.typeId() == typeId() ) {
-		*this = (const SamplePreviewData&)other;
+		reset( ((const SamplePreviewData&)other).samples );
 	}
 }
\ No newline at end of file
@@ -17,6 +17,9 @@
 #include <maya/MTypeId.h>
 #include <maya/MString.h>
 
+#include "SampleBuffer.h"
+#include "PointBvh.h"
+
 class MPointArray;
 
 
@@ -36,9 +39,11 @@ class SamplePreviewData;
 	Class SampleShape
 
 	Helper node used to preview the sample positions.
-	Plug a MFnPointArray output attribute from the
+	Plug a SampleBufferData output attribute from the
 	samplers to 'sampleData' and trigger the evaluation
-	of 'outData'
+	of 'outData'. Alternatively, samples written to disk
+	can be previewed by setting 'cacheFile', which is only
+	read when nothing is connected to 'sampleData'.
    ========================================== */
 
 class SampleShape : public MPxSurfaceShape
@@ -57,10 +62,17 @@ public:
 	virtual MObject			localShapeOutAttr() const { return outData; }
 	virtual MObject			geometryData() const;
 
+	// component support: each sample is exposed as a 'vtx' component
+
+	virtual MatchResult		matchComponent( const MSelectionList& item, const MAttributeSpecArray& spec, MSelectionList& list );
+	virtual bool			match( const MSelectionMask& mask, const MObjectArray& componentList ) const;
+	virtual MObject			createFullVertexGroup() const;
+
 	// methods
 
 	MObject					meshDataRef();
 	SamplePreviewData*		getData();
+	unsigned int			numSamples();
 
 
 	static  void*		creator();
@@ -74,9 +86,12 @@ public:
 	// the values later.
 	//
 	static MObject		sampleData;	// input sample data
+	static MObject		cacheFile;	// sample cache read in absence of sampleData
 	static MObject		outData;	// output data
 
 private:
+	static const SampleBuffer* ReadCache( const MString& path );
+
 	MBoundingBox		bounds;
 	
 };
@@ -90,8 +105,24 @@ private:
 
 class SamplePreviewData : public MPxGeometryData {
 public:
+						SamplePreviewData() : samples( NULL ), index( NULL ) {}
+						SamplePreviewData( const SamplePreviewData& other ) : MPxGeometryData(), samples( NULL ), index( NULL ) { reset( other.samples ); }
+	virtual				~SamplePreviewData() { reset( NULL ); }
 
-	MPointArray& getSamples() { return samples; }
+	// the samples are shared with the sampler which produced them, we only
+	// hold a reference to them
+	const SampleBuffer*	getSamples() const { return samples; }
+
+	void reset( const SampleBuffer* buffer ) {
+		if ( buffer ) buffer->incRef();
+		SampleBuffer::release( samples );
+		samples = buffer;
+		delete index;
+		index = NULL;
+	}
+
+	// spatial index used for component selection, built on first use
+	const PointBvh&		getIndex() const;
 
 	// overrides 
 
@@ -107,5 +138,9 @@ public:
 	static const MString typeName;
 	static const MTypeId id;
 
-	MPointArray  samples;
+private:
+	SamplePreviewData& operator=( const SamplePreviewData& );
+
+	const SampleBuffer* samples;
+	mutable PointBvh*	index;
 };
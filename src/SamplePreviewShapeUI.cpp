@@ -11,11 +11,14 @@
 
 #include "SamplePreviewShapeUI.h"
 #include "SamplePreviewShape.h"
+#include "ComponentSelection.h"
+#include "Trace.h"
 #include <maya/MColor.h>
 #include <maya/MDrawData.h>
 #include <maya/MSelectionMask.h>
 #include <maya/MSelectionList.h>
 #include <maya/MDagPath.h>
+#include <maya/MObjectArray.h>
 
 // Object and component color defines
 //
@@ -114,6 +117,18 @@ void SampleShapeUI::getDrawRequests(	const MDrawInfo & info,
 		  }
 
 		  queue.add( request );
+
+		  // while in component mode, draw the selected samples on top
+		  if ( displayStatus == M3dView::kHilite && shape->hasActiveComponents() ) {
+			  MObjectArray components = shape->activeComponents();
+			  MObject component = components[ 0 ];
+			  MDrawRequest activeRequest = info.getPrototype( *this );
+			  activeRequest.setDrawData( data );
+			  activeRequest.setToken( kDrawVertices );
+			  activeRequest.setColor( ACTIVE_VERTEX_COLOR, activeColorTable );
+			  activeRequest.setComponent( component );
+			  queue.add( activeRequest );
+		  }
 		  break;
 		}
 
@@ -139,6 +154,7 @@ void SampleShapeUI::getDrawRequests(	const MDrawInfo & info,
 //////////////////////////////////////////////////////////////////////////
 
 void SampleShapeUI::draw( const MDrawRequest & request, M3dView & view ) const{ 
+	TRACE_SCOPE( "SampleShapeUI::draw" );
 	// Get the token from the draw request.
 	// The token specifies what needs to be drawn.
 	//
@@ -155,13 +171,37 @@ void SampleShapeUI::draw( const MDrawRequest & request, M3dView & view ) const{
 			glGetFloatv( GL_POINT_SIZE, &oldPointSize );
 			glPointSize( 2.0 );
 
-			glBegin( GL_POINTS );
-
-			const MPointArray& samples = previewData->samples;
-			for( unsigned int i = 0; i < samples.length(); i++ ) {
-				glVertex3d( samples[ i ].x, samples[ i ].y, samples[ i ].z );
+			// draw straight from the shared sample buffer
+			const SampleBuffer* samples = previewData->getSamples();
+			if ( samples != NULL && !samples->empty() ) {
+				glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+				glEnableClientState( GL_VERTEX_ARRAY );
+				glVertexPointer( 3, GL_FLOAT, 0, samples->data() );
+				glDrawArrays( GL_POINTS, 0, (GLsizei)samples->size() );
+				glPopClientAttrib();
 			}
 
+			glPointSize( oldPointSize );
+			view.endGL();
+			break;
+		}
+	case kDrawVertices :
+		{
+			const SampleBuffer* samples = previewData->getSamples();
+			if ( samples == NULL ) break;
+
+			std::vector< int > selected;
+			ComponentSelection::getElements( request.component(), (unsigned int)samples->size(), selected );
+
+			view.beginGL();
+			float oldPointSize;
+			glGetFloatv( GL_POINT_SIZE, &oldPointSize );
+			glPointSize( 4.0 );
+
+			glBegin( GL_POINTS );
+			for( size_t i = 0; i < selected.size(); i++ ) {
+				glVertex3fv( samples->point( selected[ i ] ) );
+			}
 			glEnd();
 
 			glPointSize( oldPointSize );
@@ -192,10 +232,19 @@ void SampleShapeUI::draw( const MDrawRequest & request, M3dView & view ) const{
 bool SampleShapeUI::select( MSelectInfo &selectInfo, 
 					  MSelectionList &selectionList,
 					  MPointArray &worldSpaceSelectPts ) const {
+	TRACE_SCOPE( "SampleShapeUI::select" );
 					  
 	 SampleShape* shape = (SampleShape*)surfaceShape();
 	 if ( shape == NULL ) return false;
 
+	 // in component mode, pick individual samples through the spatial index
+	 if ( selectInfo.displayStatus() == M3dView::kHilite ) {
+		 SamplePreviewData* previewData = shape->getData();
+		 if ( previewData == NULL || previewData->getSamples() == NULL ) return false;
+		 return ComponentSelection::select( selectInfo, previewData->getIndex(), previewData->getSamples()->data(),
+											selectionList, worldSpaceSelectPts );
+	 }
+
 	 // NOTE: If the geometry has an intersect routine it should
 	 // be called here with the selection ray to determine if the
 	 // the object was selected.
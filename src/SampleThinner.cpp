@@ -0,0 +1,131 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "SampleThinner.h"
+#include "SampleBufferData.h"
+#include "Thinning.h"
+#include "Hash.h"
+#include "Trace.h"
+
+#include <maya/MPlug.h>
+#include <maya/MDataBlock.h>
+#include <maya/MDataHandle.h>
+#include <maya/MFnTypedAttribute.h>
+#include <maya/MFnNumericAttribute.h>
+#include <maya/MFnEnumAttribute.h>
+
+MTypeId     SampleThinner::id( 0x83101 );
+
+// Attributes
+MObject		SampleThinner::inSamples;
+MObject		SampleThinner::numSamples;
+MObject		SampleThinner::method;
+MObject		SampleThinner::seed;
+MObject		SampleThinner::outSamples;
+
+SampleThinner::SampleThinner() : input( NULL ), paramsHash( 0 ) {}
+SampleThinner::~SampleThinner() { SampleBuffer::release( input ); }
+
+MStatus SampleThinner::compute( const MPlug& plug, MDataBlock& data )
+//
+//	Description:
+//		This method computes the value of the given output plug based
+//		on the values of the input attributes.
+//
+//	Arguments:
+//		plug - the plug to compute
+//		data - object that provides access to the attributes for this node
+//
+{
+	if ( plug != outSamples ) return MS::kUnknownParameter;
+
+	TRACE_SCOPE( "SampleThinner::compute" );
+	MStatus returnStatus;
+
+	const SampleBuffer* samples = SampleBufferData::fromHandle( data.inputValue( inSamples ) );
+	const int count = data.inputValue( numSamples ).asInt();
+	const int params[ 3 ] = { count, data.inputValue( method ).asShort(), data.inputValue( seed ).asInt() };
+	const uint64_t hash = Hash64( params, sizeof( params ) );
+
+	if ( samples != input || hash != paramsHash || samplesData.isNull() ) {
+		std::vector< float > thinned;
+		if ( samples != NULL ) {
+			const uint64_t thinSeed = Hash64( &params[ 2 ], sizeof( params[ 2 ] ) );
+			ThinPoints( samples->data(), samples->size(), (size_t)count, (ThinningMethod)params[ 1 ], thinSeed, thinned );
+		}
+		samplesData = SampleBufferData::create( SampleBuffer::create( thinned ), &returnStatus );
+		if ( !returnStatus ) return returnStatus;
+
+		// holding a reference keeps the buffer, and its address, from being
+		// reused by a different one
+		if ( samples != NULL ) samples->incRef();
+		SampleBuffer::release( input );
+		input = samples;
+		paramsHash = hash;
+	}
+	data.outputValue( outSamples ).set( samplesData );
+	data.setClean( plug );
+
+	return MS::kSuccess;
+}
+
+void* SampleThinner::creator()
+{
+	return new SampleThinner();
+}
+
+MStatus SampleThinner::initialize()
+{
+	MFnTypedAttribute	tAttr;
+	MFnNumericAttribute nAttr;
+	MFnEnumAttribute	eAttr;
+	MStatus				stat;
+
+	inSamples = tAttr.create( "inSamples", "is", SampleBufferData::id, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( true );
+	tAttr.setStorable( false );
+	tAttr.setHidden( true );
+
+	numSamples = nAttr.create( "sampleCount", "sc", MFnNumericData::kInt, 1000, &stat );
+	if ( !stat ) return stat;
+	nAttr.setMin( 0 );
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	method = eAttr.create( "method", "mt", THINNING_RANDOM, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "Random", THINNING_RANDOM );
+	eAttr.addField( "Stratified", THINNING_STRATIFIED );
+	eAttr.addField( "Elimination", THINNING_ELIMINATION );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	seed = nAttr.create( "seed", "sd", MFnNumericData::kInt, 0, &stat );
+	if ( !stat ) return stat;
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	outSamples = tAttr.create( "outSamples", "os", SampleBufferData::id, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( false );
+	tAttr.setStorable( false );
+	tAttr.setCached( false );
+
+	addAttribute( inSamples );
+	addAttribute( numSamples );
+	addAttribute( method );
+	addAttribute( seed );
+	addAttribute( outSamples );
+
+	attributeAffects( inSamples, outSamples );
+	attributeAffects( numSamples, outSamples );
+	attributeAffects( method, outSamples );
+	attributeAffects( seed, outSamples );
+
+	return MS::kSuccess;
+}
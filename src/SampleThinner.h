@@ -0,0 +1,70 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <maya/MPxNode.h>
+#include <maya/MTypeId.h>
+
+#include "SampleBuffer.h"
+
+#include <stdint.h>
+
+/* ==========================================
+	Class SampleThinner
+
+	Reduces the samples plugged to 'inSamples', usually the
+	'outSamples' of a sampler, to 'sampleCount' of them, so
+	that a single dense sample set can feed several sparser
+	ones without sampling the mesh again (see ThinPoints).
+
+	'method' selects how the samples are picked:
+	  - Random: a uniformly random subset.
+	  - Stratified: one sample per cell of a grid sized for
+		'sampleCount' cells, which avoids the clumps of a random
+		subset.
+	  - Elimination: weighted sample elimination, which keeps
+		the samples spread apart as blue noise. Slower than the
+		others, as samples are removed one at a time: about 2 s
+		for 100k samples and 26 s for a million, growing faster
+		than 'sampleCount'. Use Stratified for larger counts.
+
+	Sample buffers are immutable, so the node holds a
+	reference to its last input and returns the previous
+	samples while neither it nor the parameters change.
+
+   ========================================== */
+
+class SampleThinner : public MPxNode
+{
+public:
+	SampleThinner();
+	virtual				~SampleThinner();
+
+	virtual MStatus		compute( const MPlug& plug, MDataBlock& data );
+
+	static  void*		creator();
+	static  MStatus		initialize();
+
+public:
+
+	static MObject	inSamples;
+	static MObject	numSamples;
+	static MObject	method;
+	static MObject	seed;
+	static MObject	outSamples;
+
+	static	MTypeId		id;
+
+private:
+
+	// the input of the last evaluation, the hash of the parameters, and the
+	// SampleBufferData it produced
+	const SampleBuffer*	input;
+	uint64_t			paramsHash;
+	MObject				samplesData;
+};
@@ -0,0 +1,87 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "SamplerStatsAttribute.h"
+
+#include <maya/MDataBlock.h>
+#include <maya/MDataHandle.h>
+#include <maya/MFnNumericAttribute.h>
+#include <maya/MFnCompoundAttribute.h>
+
+#include <limits.h>
+
+namespace {
+	MObject createOutput( const char* name, const char* shortName, MFnNumericData::Type type, MStatus* status ) {
+		MFnNumericAttribute nAttr;
+		MObject attr = nAttr.create( name, shortName, type, 0, status );
+		// Attribute is read-only because it is an output attribute
+		nAttr.setWritable( false );
+		// Attribute will not be written to files when this type of node is stored
+		nAttr.setStorable( false );
+		return attr;
+	}
+
+	inline int clampCount( long long count ) {
+		return count > INT_MAX ? INT_MAX : (int)count;
+	}
+}
+
+MObject SamplerStatsAttribute::create( MStatus* status ) {
+	MStatus stat;
+	if ( status == NULL ) status = &stat;
+
+	struct Child {
+		MObject*				attr;
+		const char*				name;
+		const char*				shortName;
+		MFnNumericData::Type	type;
+	} children[] = {
+		{ &raysCast,			"raysCast",			"strc",	MFnNumericData::kInt },
+		{ &raysMissed,			"raysMissed",		"strm",	MFnNumericData::kInt },
+		{ &chords,				"chords",			"stch",	MFnNumericData::kInt },
+		{ &samplesRequested,	"samplesRequested",	"stsr",	MFnNumericData::kInt },
+		{ &samplesProduced,		"samplesProduced",	"stsp",	MFnNumericData::kInt },
+		{ &voxelsOccupied,		"voxelsOccupied",	"stvo",	MFnNumericData::kInt },
+		{ &meshTime,			"meshTime",			"stmt",	MFnNumericData::kDouble },
+		{ &acceleratorTime,		"acceleratorTime",	"stat",	MFnNumericData::kDouble },
+		{ &voxelizeTime,		"voxelizeTime",		"stvt",	MFnNumericData::kDouble },
+		{ &readbackTime,		"readbackTime",		"strt",	MFnNumericData::kDouble },
+		{ &samplingTime,		"samplingTime",		"stst",	MFnNumericData::kDouble },
+		{ &distanceTime,		"distanceTime",		"stdt",	MFnNumericData::kDouble }
+	};
+
+	MFnCompoundAttribute cAttr;
+	MObject compound = cAttr.create( "statistics", "st", status );
+	if ( !*status ) return MObject::kNullObj;
+
+	for( size_t i = 0; i < sizeof( children ) / sizeof( children[ 0 ] ); i++ ) {
+		*children[ i ].attr = createOutput( children[ i ].name, children[ i ].shortName, children[ i ].type, status );
+		if ( !*status ) return MObject::kNullObj;
+		cAttr.addChild( *children[ i ].attr );
+	}
+
+	cAttr.setWritable( false );
+	cAttr.setStorable( false );
+	return compound;
+}
+
+void SamplerStatsAttribute::set( MDataBlock& data, const MObject& compound, const SamplerStats& stats ) const {
+	MDataHandle handle = data.outputValue( compound );
+	handle.child( raysCast ).set( clampCount( stats.raysCast ) );
+	handle.child( raysMissed ).set( clampCount( stats.raysMissed ) );
+	handle.child( chords ).set( clampCount( stats.chords ) );
+	handle.child( samplesRequested ).set( clampCount( stats.samplesRequested ) );
+	handle.child( samplesProduced ).set( clampCount( stats.samplesProduced ) );
+	handle.child( voxelsOccupied ).set( clampCount( stats.voxelsOccupied ) );
+	handle.child( meshTime ).set( stats.meshMs );
+	handle.child( acceleratorTime ).set( stats.acceleratorMs );
+	handle.child( voxelizeTime ).set( stats.voxelizeMs );
+	handle.child( readbackTime ).set( stats.readbackMs );
+	handle.child( samplingTime ).set( stats.samplingMs );
+	handle.child( distanceTime ).set( stats.distanceMs );
+	handle.setClean();
+}
@@ -0,0 +1,51 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <maya/MObject.h>
+#include <maya/MStatus.h>
+
+#include "SamplerStats.h"
+
+class MDataBlock;
+
+/* ==========================================
+
+	Class SamplerStatsAttribute
+
+	Read-only compound attribute ("statistics") publishing the
+	SamplerStats of the last compute of a sampler node, so the
+	cost of each stage can be inspected from the attribute
+	editor. Each node type owns a static instance, created
+	from its initialize() method.
+
+========================================== */
+
+class SamplerStatsAttribute {
+public:
+	// creates the compound and its children. The returned attribute is the
+	// one to add to the node.
+	MObject			create( MStatus* status = NULL );
+
+	// copies 'stats' to the children of 'compound' and marks them clean
+	void			set( MDataBlock& data, const MObject& compound, const SamplerStats& stats ) const;
+
+private:
+	MObject			raysCast;
+	MObject			raysMissed;
+	MObject			chords;
+	MObject			samplesRequested;
+	MObject			samplesProduced;
+	MObject			voxelsOccupied;
+	MObject			meshTime;
+	MObject			acceleratorTime;
+	MObject			voxelizeTime;
+	MObject			readbackTime;
+	MObject			samplingTime;
+	MObject			distanceTime;
+};
@@ -0,0 +1,66 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "SamplerTraceCmd.h"
+#include "Trace.h"
+
+#include <maya/MArgList.h>
+#include <maya/MArgDatabase.h>
+#include <maya/MGlobal.h>
+#include <maya/MString.h>
+
+const char* SamplerTraceCmd::name = "samplerTrace";
+
+namespace {
+	const char* enableFlag		= "-e";
+	const char* enableLongFlag	= "-enable";
+	const char* writeFlag		= "-w";
+	const char* writeLongFlag	= "-write";
+	const char* clearFlag		= "-c";
+	const char* clearLongFlag	= "-clear";
+}
+
+void* SamplerTraceCmd::creator() {
+	return new SamplerTraceCmd();
+}
+
+MSyntax SamplerTraceCmd::newSyntax() {
+	MSyntax syntax;
+	syntax.addFlag( enableFlag, enableLongFlag, MSyntax::kBoolean );
+	syntax.addFlag( writeFlag, writeLongFlag, MSyntax::kString );
+	syntax.addFlag( clearFlag, clearLongFlag );
+	return syntax;
+}
+
+MStatus SamplerTraceCmd::doIt( const MArgList& args ) {
+	MStatus status;
+	MArgDatabase argData( syntax(), args, &status );
+	if ( !status ) return status;
+
+	// write before clearing, so both flags can be combined
+	if ( argData.isFlagSet( writeFlag ) ) {
+		MString path;
+		argData.getFlagArgument( writeFlag, 0, path );
+		if ( !Trace::WriteChromeJson( path.asChar() ) ) {
+			MGlobal::displayError( MString( "samplerTrace: can't write " ) + path );
+			return MS::kFailure;
+		}
+	}
+
+	if ( argData.isFlagSet( clearFlag ) ) {
+		Trace::Clear();
+	}
+
+	if ( argData.isFlagSet( enableFlag ) ) {
+		bool enable = false;
+		argData.getFlagArgument( enableFlag, 0, enable );
+		Trace::Enable( enable );
+	}
+
+	setResult( Trace::IsEnabled() );
+	return MS::kSuccess;
+}
@@ -0,0 +1,37 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <maya/MPxCommand.h>
+#include <maya/MSyntax.h>
+
+/* ==========================================
+	Class SamplerTraceCmd
+
+	MEL command controlling the timeline of the sampling
+	stages (see Trace in the core library):
+
+		samplerTrace -enable on;
+		// ... evaluate some samplers ...
+		samplerTrace -write "/tmp/sampler.json" -clear;
+
+	Returns whether tracing is enabled. The resulting file can
+	be opened in chrome://tracing or ui.perfetto.dev.
+
+========================================== */
+
+class SamplerTraceCmd : public MPxCommand {
+public:
+	virtual MStatus		doIt( const MArgList& args );
+	virtual bool		isUndoable() const { return false; }
+
+	static void*		creator();
+	static MSyntax		newSyntax();
+
+	static const char*	name;
+};
@@ -7,41 +7,88 @@
 
 
 #include "VoxelSamplerNode.h"
+#include "SampleBufferData.h"
+#include "MayaMesh.h"
+#include "SolidVoxelizer.h"
+#include "VoxelGridSampler.h"
+#include "VoxelCache.h"
+#include "VoxelMorphology.h"
+#include "VoxelCsg.h"
+#include "SampleCache.h"
+#include "Hash.h"
+#include "MeshMeasures.h"
+#include "Transform.h"
+#include "Timer.h"
+#include "Trace.h"
 
 #include <maya/MPlug.h>
 #include <maya/MDataBlock.h>
 #include <maya/MDataHandle.h>
+#include <maya/MArrayDataHandle.h>
 #include <maya/MFnTypedAttribute.h>
 #include <maya/MFnNumericAttribute.h>
-#include <maya/MPointArray.h>
-#include <maya/MFnPointArrayData.h>
-#include <maya/MFloatPointArray.h>
+#include <maya/MFnEnumAttribute.h>
+#include <maya/MFnCompoundAttribute.h>
+#include <maya/MFnMatrixAttribute.h>
+#include <maya/MFnDoubleArrayData.h>
+#include <maya/MDoubleArray.h>
+#include <maya/MFnIntArrayData.h>
+#include <maya/MIntArray.h>
+#include <maya/MMatrix.h>
 #include <maya/MFnMesh.h>
 #include <maya/MGlobal.h>
-#include <maya/MBoundingBox.h>
-#include <maya/MMatrix.h>
-#include <maya/MFloatMatrix.h>
 
 #include <assert.h>
+#include <limits.h>
+#include <algorithm>
 #include <vector>
 
 #include <gl/glew.h>
 #include <gl/GL.h>
 #include <gl/GLU.h>
 
-#include <time.h>
-
 //
 MTypeId     VoxelSampler::id( 0x83099 );
 
 // Attributes
 MObject		VoxelSampler::voxelRes;
+MObject		VoxelSampler::voxelizer;
+MObject		VoxelSampler::insideTest;
+MObject		VoxelSampler::voxelCache;
+MObject		VoxelSampler::voxelCacheSize;
 MObject		VoxelSampler::numSamples;
+MObject		VoxelSampler::seed;
+MObject		VoxelSampler::cacheFile;
+MObject		VoxelSampler::sampleSpace;
+MObject		VoxelSampler::sampleRegion;
+MObject		VoxelSampler::shellThickness;
+MObject		VoxelSampler::distribution;
+MObject		VoxelSampler::minDistance;
+MObject		VoxelSampler::distanceField;
+MObject		VoxelSampler::distanceBand;
+MObject		VoxelSampler::islandBudget;
+MObject		VoxelSampler::islandMinSamples;
+MObject		VoxelSampler::morphology;
+MObject		VoxelSampler::morphologyRadius;
+MObject		VoxelSampler::csgMeshes;
+MObject		VoxelSampler::csgMesh;
+MObject		VoxelSampler::csgOperation;
 MObject     VoxelSampler::mesh;        
 MObject     VoxelSampler::outVoxels;
 MObject     VoxelSampler::outSamples;
-
-VoxelSampler::VoxelSampler() {}
+MObject     VoxelSampler::outMatrix;
+MObject     VoxelSampler::outDistanceField;
+MObject     VoxelSampler::outSampleDistances;
+MObject     VoxelSampler::outSampleIslands;
+MObject     VoxelSampler::outIslandVoxels;
+MObject     VoxelSampler::outIslandBounds;
+MObject     VoxelSampler::meshVolume;
+MObject     VoxelSampler::meshArea;
+MObject     VoxelSampler::statistics;
+
+SamplerStatsAttribute VoxelSampler::statsAttribute;
+
+VoxelSampler::VoxelSampler() : csgVoxels( false ), shellHash( 0 ), islandsHash( 0 ), islandDataHash( 0 ), sampleIslandsHash( 0 ), voxelsHash( 0 ), samplesHash( 0 ), fieldHash( 0 ), distancesHash( 0 ), worldSamplesHash( 0 ) {}
 VoxelSampler::~VoxelSampler() {}
 
 MStatus VoxelSampler::compute( const MPlug& plug, MDataBlock& data )
@@ -55,6 +102,7 @@ MStatus VoxelSampler::compute( const MPlug& plug, MDataBlock& data )
 //		data - object that provides access to the attributes for this node
 //
 {
+	TRACE_SCOPE( "VoxelSampler::compute" );
 	MStatus returnStatus;
  
 	// Check which output attribute we have been asked to compute.  If this 
@@ -66,35 +114,371 @@ MStatus VoxelSampler::compute( const MPlug& plug, MDataBlock& data )
 		// Read the input value from the handle.
 		//
 		int3& numVoxels = data.inputValue( VoxelSampler::voxelRes ).asInt3();
+		short method = data.inputValue( VoxelSampler::voxelizer ).asShort();
+		const InsideTest test = (InsideTest)data.inputValue( insideTest ).asShort();
+		const MString cacheDir = data.inputValue( voxelCache ).asString();
+		const int cacheSize = data.inputValue( voxelCacheSize ).asInt();
+		const short space = data.inputValue( sampleSpace ).asShort();
+		const short morphOp = data.inputValue( morphology ).asShort();
+		const int morphRadius = data.inputValue( morphologyRadius ).asInt();
 		MFnMesh inMesh( data.inputValue( mesh ).asMesh() );
 
-		// Get a handle to the output attribute.  This is similar to the
-		// "inputValue" call above except that no dependency graph 
-		// computation will be done as a result of this call.
-		// 
-		MFnPointArrayData voxelsHandle( data.outputValue( VoxelSampler::outVoxels ).data() );
-		MPointArray voxels = voxelsHandle.array();
-	
-		Voxelize( inMesh, numVoxels[ 0 ], numVoxels[ 1 ], numVoxels[ 2 ], voxels );
+		Timer timer;
+
+		TriangleMesh triangles;
+		MayaMesh::GetTriangles( inMesh, triangles, space == SPACE_WORLD ? MSpace::kWorld : MSpace::kObject );
+
+		// meshes combined with the input one, in order. In Object and Local
+		// modes they are moved to the space of the input mesh.
+		std::vector< TriangleMesh > csgTriangles;
+		std::vector< CsgOp > csgOps;
+		{
+			float toLocal[ 16 ];
+			MayaMesh::GetMatrix( data.inputValue( mesh ).geometryTransformMatrix().inverse(), toLocal );
+			MArrayDataHandle operands = data.inputArrayValue( csgMeshes );
+			for( unsigned int i = 0; i < operands.elementCount(); i++ ) {
+				operands.jumpToArrayElement( i );
+				MDataHandle operand = operands.inputValue();
+				const MObject operandMesh = operand.child( csgMesh ).asMesh();
+				if ( operandMesh.isNull() ) continue;
+				csgTriangles.push_back( TriangleMesh() );
+				TriangleMesh& operandTriangles = csgTriangles.back();
+				MayaMesh::GetTriangles( MFnMesh( operandMesh ), operandTriangles, MSpace::kWorld );
+				if ( space != SPACE_WORLD && operandTriangles.numPoints() > 0 ) {
+					TransformPoints( toLocal, &operandTriangles.points[ 0 ], operandTriangles.numPoints(), &operandTriangles.points[ 0 ] );
+				}
+				csgOps.push_back( (CsgOp)operand.child( csgOperation ).asShort() );
+			}
+		}
+		// the operands share the bounds of the grid, which only the CPU
+		// voxelizer can be given, and only it has the winding number test
+		// and grids finer than the bits of a pixel
+		if ( !csgOps.empty() || test != INSIDE_PARITY ) method = VOXELIZER_CPU;
+		if ( std::max( numVoxels[ 0 ], std::max( numVoxels[ 1 ], numVoxels[ 2 ] ) ) > MAX_GPU_RESOLUTION ) method = VOXELIZER_CPU;
+		const double meshMs = timer.elapsedMs();
+
+		// the voxel cache key identifies the grid, the voxels don't need to
+		// be computed again if it hasn't changed since the last evaluation.
+		// The cache holds the voxels before any morphology.
+		uint64_t key = VoxelCache::Key( triangles.view(), numVoxels[ 0 ], numVoxels[ 1 ], numVoxels[ 2 ], method );
+		if ( test != INSIDE_PARITY ) {
+			const int testParam = test;
+			key = Hash64( &testParam, sizeof( testParam ), key );
+		}
+		for( size_t i = 0; i < csgOps.size(); i++ ) {
+			const int op = csgOps[ i ];
+			key = csgTriangles[ i ].view().hash( Hash64( &op, sizeof( op ), key ) );
+		}
+		const int morphParams[ 2 ] = { morphOp, morphOp != MORPHOLOGY_NONE ? morphRadius : 0 };
+		const uint64_t hash = Hash64( morphParams, sizeof( morphParams ), key );
+		if ( hash == voxelsHash && !voxelsData.isNull() ) {
+			data.outputValue( VoxelSampler::outVoxels ).set( voxelsData );
+			data.setClean( plug );
+			return MS::kSuccess;
+		}
 
-	} if ( plug == outSamples ) {
+		stats.clear();
+		stats.meshMs = meshMs;
+
+		timer.restart();
+		const VoxelCache cache( cacheDir.asChar(), (uint64_t)std::max( 0, cacheSize ) << 20 );
+		bool voxelized = cache.load( key, grid );
+		if ( !voxelized ) {
+			if ( !csgOps.empty() ) {
+				std::vector< CsgOperand > operands( csgOps.size() );
+				for( size_t i = 0; i < operands.size(); i++ ) {
+					operands[ i ].mesh = csgTriangles[ i ].view();
+					operands[ i ].op = csgOps[ i ];
+				}
+				voxelized = VoxelizeCsg( triangles.view(), &operands[ 0 ], operands.size(), numVoxels[ 0 ], numVoxels[ 1 ], numVoxels[ 2 ], grid, test );
+			} else if ( method == VOXELIZER_CPU ) {
+				voxelized = SolidVoxelizer::Voxelize( triangles.view(), numVoxels[ 0 ], numVoxels[ 1 ], numVoxels[ 2 ], grid, test );
+			} else {
+				voxelized = VoxelizeGPU( triangles.view(), numVoxels[ 0 ], numVoxels[ 1 ], numVoxels[ 2 ], grid, stats );
+			}
+			if ( voxelized && cache.enabled() && !cache.store( key, grid ) ) {
+				MGlobal::displayWarning( MString( "VoxelSampler: can't write to the voxel cache " ) + cacheDir );
+			}
+		}
+		csgVoxels = !csgOps.empty();
+		meshGrid.clear();
+		if ( voxelized && morphOp != MORPHOLOGY_NONE ) {
+			meshGrid = grid;
+			ApplyMorphology( grid, (MorphologyOp)morphOp, morphRadius );
+		}
+		stats.voxelizeMs = timer.elapsedMs() - stats.readbackMs;
+		stats.voxelsOccupied = (long long)grid.countOccupied();
+
+		std::vector< float > voxels;
+		grid.getVoxelBoxes( voxels );
+
+		// Hand the voxels over to an immutable shared buffer: both outSamples
+		// and any preview node will reference it rather than copy it.
+		//
+		voxelsData = SampleBufferData::create( SampleBuffer::create( voxels ), &returnStatus );
+		if ( !returnStatus ) return returnStatus;
+		voxelsHash = voxelized ? hash : 0; // try again next time if it failed
+		data.outputValue( VoxelSampler::outVoxels ).set( voxelsData );
+
+	} else if ( plug == outSamples ) {
 
 		// Read the input value from the handle.
 		//
 		int numSamples = data.inputValue( VoxelSampler::numSamples ).asInt();
+		const int seed = data.inputValue( VoxelSampler::seed ).asInt();
+		const MString cachePath = data.inputValue( cacheFile ).asString();
+		const short space = data.inputValue( sampleSpace ).asShort();
+		const short region = data.inputValue( sampleRegion ).asShort();
+		const float thickness = region == REGION_SHELL ? data.inputValue( shellThickness ).asFloat() : 0.0f;
+		const short spread = region == REGION_VOLUME ? data.inputValue( distribution ).asShort() : DISTRIBUTION_UNIFORM;
+		const float spacing = spread == DISTRIBUTION_BLUE_NOISE ? data.inputValue( minDistance ).asFloat() : 0.0f;
+		// the budgets only apply to uniform samples of the volume
+		const bool budgeted = region == REGION_VOLUME && spread == DISTRIBUTION_UNIFORM;
+		const short budget = budgeted ? data.inputValue( islandBudget ).asShort() : ISLANDS_OFF;
+		const int minIslandSamples = budget == ISLANDS_MINIMUM ? data.inputValue( islandMinSamples ).asInt() : 0;
 		// by querying the voxels as input value we ensure the attribute is evaluated
-		// if necessary and we're getting an up-to-date copy
-		MFnPointArrayData voxelsHandle( data.inputValue( VoxelSampler::outVoxels ).data() );
-		MPointArray voxels = voxelsHandle.array();
+		// if necessary, and therefore the voxel grid is up to date
+		data.inputValue( VoxelSampler::outVoxels );
+
+		const int params[ 6 ] = { numSamples, seed, region, spread, budget, minIslandSamples };
+		const float distances[ 2 ] = { thickness, spacing };
+		uint64_t hash = Hash64( params, sizeof( params ), voxelsHash );
+		hash = Hash64( distances, sizeof( distances ), hash );
+		hash = Hash64( cachePath.asChar(), cachePath.length(), hash );
+		if ( hash != samplesHash || samplesData.isNull() ) {
+			stats.samplesRequested = stats.samplesProduced = 0;
+			Timer timer;
+
+			// the shell is measured from the input mesh, which doesn't bound
+			// voxels combined with other meshes
+			const bool shellUnavailable = region == REGION_SHELL && csgVoxels;
+
+			// the shell is gathered again only if the voxels or its thickness changed
+			const uint64_t shellKey = Hash64( &thickness, sizeof( thickness ), voxelsHash );
+			if ( shellUnavailable ) {
+				MGlobal::displayWarning( "VoxelSampler: the Shell region can't be sampled while csgMeshes are connected" );
+			} else if ( region == REGION_SHELL && ( shellKey != shellHash || voxelsHash == 0 ) ) {
+				MFnMesh inMesh( data.inputValue( mesh ).asMesh() );
+				TriangleMesh triangles;
+				MayaMesh::GetTriangles( inMesh, triangles, space == SPACE_WORLD ? MSpace::kWorld : MSpace::kObject );
+				// the inside test is already part of voxelsHash
+				const InsideTest test = (InsideTest)data.inputValue( insideTest ).asShort();
+				shellSampler.setMesh( triangles.view(), meshVoxels(), thickness, test );
+				shellHash = shellKey;
+				stats.acceleratorMs = timer.elapsedMs();
+				timer.restart();
+			}
+
+			SampleCacheWriter cache;
+			if ( cachePath.length() > 0 && !cache.open( cachePath.asChar(), seed ) ) {
+				MGlobal::displayWarning( MString( "VoxelSampler: can't write the sample cache " ) + cachePath );
+			}
+
+			// when caching, samples are generated a block at a time so that the
+			// cache writes the previous block while the next one is sampled
+			const int chunkSize = cache.isOpen() ? (int)SampleCacheWriter::DEFAULT_BLOCK_SIZE : numSamples;
+			std::vector< float > samples;
+			samples.reserve( 3 * (size_t)numSamples );
+			Random rng( seed );
+			if ( shellUnavailable ) {
+				// no samples
+			} else if ( spread == DISTRIBUTION_BLUE_NOISE ) {
+				// the samples depend on each other, so they are all produced at once
+				blueNoiseSampler.setGrid( grid );
+				if ( blueNoiseSampler.Sample( spacing, numSamples, rng, samples, &stats ) && cache.isOpen() ) {
+					cache.append( &samples[ 0 ], samples.size() / 3 );
+				}
+			} else if ( budget != ISLANDS_OFF ) {
+				// every island gets its share, one after the other
+				updateIslands();
+				std::vector< int > counts;
+				islands.budget( numSamples, (IslandBudget)( budget - ISLANDS_PROPORTIONAL ), minIslandSamples, counts );
+				for( size_t i = 0; i < counts.size(); i++ ) {
+					const size_t first = samples.size();
+					islands.Sample( (int)i, counts[ i ], rng, samples, &stats );
+					if ( cache.isOpen() && samples.size() > first ) cache.append( &samples[ first ], ( samples.size() - first ) / 3 );
+				}
+			} else {
+				if ( region == REGION_VOLUME ) sampler.setGrid( grid );
+				for( int done = 0; done < numSamples; done += chunkSize ) {
+					const size_t first = samples.size();
+					const int chunk = std::min( chunkSize, numSamples - done );
+					const bool sampled = region == REGION_SHELL ?
+										 shellSampler.Sample( chunk, rng, samples, &stats ) :
+										 sampler.Sample( chunk, rng, samples, &stats );
+					if ( !sampled ) break;
+					if ( cache.isOpen() ) cache.append( &samples[ first ], ( samples.size() - first ) / 3 );
+				}
+			}
+			if ( cache.isOpen() && !cache.close() ) {
+				MGlobal::displayWarning( MString( "VoxelSampler: failed writing the sample cache " ) + cachePath );
+			}
+			stats.samplingMs = timer.elapsedMs();
+
+			samplesData = SampleBufferData::create( SampleBuffer::create( samples ), &returnStatus );
+			if ( !returnStatus ) return returnStatus;
+			samplesHash = hash;
+		}
+
+		// in object space mode the samples are moved from the local space
+		// of the voxels to world space (see RaySampler)
+		MObject output = samplesData;
+		if ( space == SPACE_OBJECT ) {
+			float matrix[ 16 ];
+			MayaMesh::GetMatrix( data.inputValue( mesh ).geometryTransformMatrix(), matrix );
+			if ( !IsIdentity( matrix ) ) {
+				const uint64_t worldHash = Hash64( matrix, sizeof( matrix ), samplesHash );
+				if ( worldHash != worldSamplesHash || worldSamplesData.isNull() ) {
+					worldSamplesData = SampleBufferData::createTransformed( samplesData, matrix, &returnStatus );
+					if ( !returnStatus ) return returnStatus;
+					worldSamplesHash = worldHash;
+				}
+				output = worldSamplesData;
+			}
+		}
+		data.outputValue( VoxelSampler::outSamples ).set( output );
+
+	} else if ( plug == outDistanceField ) {
+
+		const short type = data.inputValue( distanceField ).asShort();
+		const int band = data.inputValue( distanceBand ).asInt();
+		const short space = data.inputValue( sampleSpace ).asShort();
+		// the field is computed on the voxels, make sure they are up to date
+		data.inputValue( VoxelSampler::outVoxels );
+
+		const int params[ 2 ] = { type, type == FIELD_NARROW_BAND ? band : 0 };
+		const uint64_t hash = Hash64( params, sizeof( params ), voxelsHash );
+		if ( hash != fieldHash || fieldData.isNull() ) {
+			Timer timer;
+			if ( type == FIELD_OFF ) {
+				field.clear();
+			} else if ( csgVoxels ) {
+				MGlobal::displayWarning( "VoxelSampler: the distance field can't be computed while csgMeshes are connected" );
+				field.clear();
+			} else {
+				MFnMesh inMesh( data.inputValue( mesh ).asMesh() );
+				TriangleMesh triangles;
+				MayaMesh::GetTriangles( inMesh, triangles, space == SPACE_WORLD ? MSpace::kWorld : MSpace::kObject );
+				field.build( triangles.view(), meshVoxels(), type == FIELD_NARROW_BAND ? band : 0 );
+			}
+
+			MDoubleArray values( (unsigned int)field.size() );
+			for( size_t i = 0; i < field.size(); i++ ) {
+				values[ (unsigned int)i ] = field.data()[ i ];
+			}
+			MFnDoubleArrayData fnData;
+			fieldData = fnData.create( values, &returnStatus );
+			if ( !returnStatus ) return returnStatus;
+			fieldHash = hash;
+			stats.distanceMs = timer.elapsedMs();
+		}
+		data.outputValue( outDistanceField ).set( fieldData );
+
+	} else if ( plug == outSampleDistances ) {
+
+		// both the samples and the field have to be up to date
+		data.inputValue( VoxelSampler::outSamples );
+		data.inputValue( outDistanceField );
+
+		const uint64_t hash = Hash64( &fieldHash, sizeof( fieldHash ), samplesHash );
+		if ( hash != distancesHash || distancesData.isNull() ) {
+			// the samples are read before being moved to world space, so they
+			// are in the space of the field
+			const SampleBuffer* samples = SampleBufferData::fromObject( samplesData );
+			const size_t count = field.empty() || samples == NULL ? 0 : samples->size();
+			std::vector< float > distances( count );
+			if ( count > 0 ) field.sample( samples->data(), count, &distances[ 0 ] );
+
+			MDoubleArray values( (unsigned int)count );
+			for( size_t i = 0; i < count; i++ ) {
+				values[ (unsigned int)i ] = distances[ i ];
+			}
+			MFnDoubleArrayData fnData;
+			distancesData = fnData.create( values, &returnStatus );
+			if ( !returnStatus ) return returnStatus;
+			distancesHash = hash;
+		}
+		data.outputValue( outSampleDistances ).set( distancesData );
 
-		// Get a handle to the output attribute.  This is similar to the
-		// "inputValue" call above except that no dependency graph 
-		// computation will be done as a result of this call.
-		// 
-		MFnPointArrayData samplesHandle( data.outputValue( VoxelSampler::outSamples ).data() );
-		MPointArray samples = samplesHandle.array();
+	} else if ( plug == outSampleIslands ) {
 
-		SampleVoxels( voxels, numSamples, samples );
+		// the samples are read before being moved to world space, so they
+		// are in the space of the voxels
+		data.inputValue( VoxelSampler::outSamples );
+		updateIslands();
+
+		if ( samplesHash != sampleIslandsHash || sampleIslandsData.isNull() ) {
+			const SampleBuffer* samples = SampleBufferData::fromObject( samplesData );
+			const size_t count = samples == NULL ? 0 : samples->size();
+			std::vector< int > labels( count );
+			if ( count > 0 ) islands.labelPoints( samples->data(), count, &labels[ 0 ] );
+
+			MIntArray values( (unsigned int)count );
+			for( size_t i = 0; i < count; i++ ) {
+				values[ (unsigned int)i ] = labels[ i ];
+			}
+			MFnIntArrayData fnData;
+			sampleIslandsData = fnData.create( values, &returnStatus );
+			if ( !returnStatus ) return returnStatus;
+			sampleIslandsHash = samplesHash;
+		}
+		data.outputValue( outSampleIslands ).set( sampleIslandsData );
+
+	} else if ( plug == outIslandVoxels || plug == outIslandBounds ) {
+
+		data.inputValue( VoxelSampler::outVoxels );
+		updateIslands();
+
+		if ( islandsHash != islandDataHash || islandVoxelsData.isNull() || islandBoundsData.isNull() ) {
+			const size_t count = islands.numIslands();
+			MIntArray voxels( (unsigned int)count );
+			std::vector< float > boxes( 6 * count );
+			for( size_t i = 0; i < count; i++ ) {
+				voxels[ (unsigned int)i ] = (int)std::min( islands.island( (int)i ).voxels, (size_t)INT_MAX );
+				islands.islandBounds( (int)i, &boxes[ 6 * i ], &boxes[ 6 * i + 3 ] );
+			}
+			MFnIntArrayData fnData;
+			islandVoxelsData = fnData.create( voxels, &returnStatus );
+			if ( !returnStatus ) return returnStatus;
+			islandBoundsData = SampleBufferData::create( SampleBuffer::create( boxes ), &returnStatus );
+			if ( !returnStatus ) return returnStatus;
+			islandDataHash = islandsHash;
+		}
+
+		// both are computed at once, so both are clean afterwards
+		data.outputValue( outIslandVoxels ).set( islandVoxelsData );
+		data.outputValue( outIslandBounds ).set( islandBoundsData );
+		data.setClean( outIslandVoxels );
+		data.setClean( outIslandBounds );
+		return MS::kSuccess;
+
+	} else if ( plug == outMatrix ) {
+
+		const short space = data.inputValue( sampleSpace ).asShort();
+		data.outputValue( outMatrix ).set( space != SPACE_WORLD ? data.inputValue( mesh ).geometryTransformMatrix() : MMatrix::identity );
+
+	} else if ( plug == meshVolume || plug == meshArea ) {
+
+		const short space = data.inputValue( sampleSpace ).asShort();
+		MFnMesh inMesh( data.inputValue( mesh ).asMesh() );
+		TriangleMesh triangles;
+		MayaMesh::GetTriangles( inMesh, triangles, space == SPACE_WORLD ? MSpace::kWorld : MSpace::kObject );
+		const MeshMeasures measures = MeshMeasures::Compute( triangles.view() );
+
+		// both are computed at once, so both are clean afterwards
+		data.outputValue( meshVolume ).set( measures.volume );
+		data.outputValue( meshArea ).set( measures.area );
+		data.setClean( meshVolume );
+		data.setClean( meshArea );
+		return MS::kSuccess;
+
+	} else if ( plug == statistics || ( plug.isChild() && plug.parent() == statistics ) ) {
+
+		// make sure the voxels, samples and distance field are up to date
+		// before publishing their statistics
+		data.inputValue( VoxelSampler::outSamples );
+		data.inputValue( outDistanceField );
+		statsAttribute.set( data, statistics, stats );
 
 	} else {
 		return MS::kUnknownParameter;
@@ -109,6 +493,13 @@ MStatus VoxelSampler::compute( const MPlug& plug, MDataBlock& data )
 	return MS::kSuccess;
 }
 
+void VoxelSampler::updateIslands() {
+	if ( islandsHash != voxelsHash || voxelsHash == 0 ) {
+		islands.build( grid );
+		islandsHash = voxelsHash;
+	}
+}
+
 void* VoxelSampler::creator()
 //
 //	Description:
@@ -136,13 +527,42 @@ MStatus VoxelSampler::initialize()
 {
 	MFnTypedAttribute	tAttr;
 	MFnNumericAttribute nAttr;
+	MFnEnumAttribute	eAttr;
+	MFnMatrixAttribute	mAttr;
 	MStatus				stat;
 
 
 	voxelRes = nAttr.create( "voxelResolution", "vr", MFnNumericData::k3Int, 16, &stat );
 	if ( !stat ) return stat;
 	nAttr.setMin( 1 );
-	nAttr.setMax( 32 );
+	nAttr.setSoftMax( 32 );
+	nAttr.setMax( MAX_RESOLUTION );
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	voxelizer = eAttr.create( "voxelizer", "vx", VOXELIZER_GPU, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "GPU", VOXELIZER_GPU );
+	eAttr.addField( "CPU", VOXELIZER_CPU );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	insideTest = eAttr.create( "insideTest", "it", INSIDE_PARITY, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "Parity", INSIDE_PARITY );
+	eAttr.addField( "Winding Number", INSIDE_WINDING_NUMBER );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	voxelCache = tAttr.create( "voxelCache", "vc", MFnData::kString, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( true );
+	tAttr.setStorable( true );
+	tAttr.setUsedAsFilename( true );
+
+	voxelCacheSize = nAttr.create( "voxelCacheSize", "vcs", MFnNumericData::kInt, VoxelCache::DEFAULT_MAX_MB, &stat );
+	if ( !stat ) return stat;
+	nAttr.setMin( 0 );
 	nAttr.setWritable( true );
 	nAttr.setStorable( true );
 
@@ -152,6 +572,120 @@ MStatus VoxelSampler::initialize()
 	nAttr.setWritable( true );
 	nAttr.setStorable( true );
 
+	seed = nAttr.create( "seed", "sd", MFnNumericData::kInt, 0, &stat );
+	if ( !stat ) return stat;
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	cacheFile = tAttr.create( "cacheFile", "cf", MFnData::kString, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( true );
+	tAttr.setStorable( true );
+	tAttr.setUsedAsFilename( true );
+
+	sampleSpace = eAttr.create( "sampleSpace", "ss", SPACE_WORLD, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "World", SPACE_WORLD );
+	eAttr.addField( "Object", SPACE_OBJECT );
+	eAttr.addField( "Local", SPACE_LOCAL );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	sampleRegion = eAttr.create( "sampleRegion", "sr", REGION_VOLUME, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "Volume", REGION_VOLUME );
+	eAttr.addField( "Shell", REGION_SHELL );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	shellThickness = nAttr.create( "shellThickness", "sht", MFnNumericData::kFloat, 0.1f, &stat );
+	if ( !stat ) return stat;
+	nAttr.setMin( 0.0f );
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	distribution = eAttr.create( "distribution", "dst", DISTRIBUTION_UNIFORM, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "Uniform", DISTRIBUTION_UNIFORM );
+	eAttr.addField( "Blue Noise", DISTRIBUTION_BLUE_NOISE );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	minDistance = nAttr.create( "minDistance", "mnd", MFnNumericData::kFloat, 0.0f, &stat );
+	if ( !stat ) return stat;
+	nAttr.setMin( 0.0f );
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	distanceField = eAttr.create( "distanceField", "df", FIELD_OFF, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "Off", FIELD_OFF );
+	eAttr.addField( "Dense", FIELD_DENSE );
+	eAttr.addField( "Narrow Band", FIELD_NARROW_BAND );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	distanceBand = nAttr.create( "distanceBand", "db", MFnNumericData::kInt, DistanceField::DEFAULT_BAND, &stat );
+	if ( !stat ) return stat;
+	nAttr.setMin( 1 );
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	islandBudget = eAttr.create( "islandBudget", "ib", ISLANDS_OFF, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "Off", ISLANDS_OFF );
+	eAttr.addField( "Proportional", ISLANDS_PROPORTIONAL );
+	eAttr.addField( "Equal", ISLANDS_EQUAL );
+	eAttr.addField( "Minimum", ISLANDS_MINIMUM );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	islandMinSamples = nAttr.create( "islandMinSamples", "ims", MFnNumericData::kInt, 10, &stat );
+	if ( !stat ) return stat;
+	nAttr.setMin( 0 );
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	morphology = eAttr.create( "morphology", "mph", MORPHOLOGY_NONE, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "Off", MORPHOLOGY_NONE );
+	eAttr.addField( "Dilate", MORPHOLOGY_DILATE );
+	eAttr.addField( "Erode", MORPHOLOGY_ERODE );
+	eAttr.addField( "Open", MORPHOLOGY_OPEN );
+	eAttr.addField( "Close", MORPHOLOGY_CLOSE );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	morphologyRadius = nAttr.create( "morphologyRadius", "mpr", MFnNumericData::kInt, 1, &stat );
+	if ( !stat ) return stat;
+	nAttr.setMin( 1 );
+	nAttr.setWritable( true );
+	nAttr.setStorable( true );
+
+	csgMesh = tAttr.create( "csgMesh", "csm", MFnData::kMesh, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( true );
+	tAttr.setStorable( false );
+
+	csgOperation = eAttr.create( "csgOperation", "cso", CSG_SUBTRACT, &stat );
+	if ( !stat ) return stat;
+	eAttr.addField( "Union", CSG_UNION );
+	eAttr.addField( "Intersect", CSG_INTERSECT );
+	eAttr.addField( "Subtract", CSG_SUBTRACT );
+	eAttr.setWritable( true );
+	eAttr.setStorable( true );
+
+	{
+		MFnCompoundAttribute cAttr;
+		csgMeshes = cAttr.create( "csgMeshes", "csg", &stat );
+		if ( !stat ) return stat;
+		cAttr.addChild( csgMesh );
+		cAttr.addChild( csgOperation );
+		cAttr.setArray( true );
+		cAttr.setWritable( true );
+		cAttr.setStorable( true );
+	}
+
 	mesh = tAttr.create( "inputMesh", "in", MFnData::kMesh, MObject::kNullObj, &stat );
 	if ( !stat ) return stat;
 	tAttr.setWritable( true );
@@ -159,9 +693,7 @@ MStatus VoxelSampler::initialize()
 	tAttr.setHidden( true );
 
 	{
-		MFnPointArrayData pCreator;
-		MObject pa = pCreator.create();
-		outVoxels = tAttr.create( "outVoxels", "ov", MFnData::kPointArray, pa, &stat );
+		outVoxels = tAttr.create( "outVoxels", "ov", SampleBufferData::id, MObject::kNullObj, &stat );
 		if ( !stat ) return stat;
 		// Attribute is read-only because it is an output attribute
 		tAttr.setWritable(false);
@@ -171,9 +703,7 @@ MStatus VoxelSampler::initialize()
 	}
 
 	{
-		MFnPointArrayData pCreator;
-		MObject pa = pCreator.create();
-		outSamples = tAttr.create( "outSamples", "os", MFnData::kPointArray, pa, &stat );
+		outSamples = tAttr.create( "outSamples", "os", SampleBufferData::id, MObject::kNullObj, &stat );
 		if ( !stat ) return stat;
 		// Attribute is read-only because it is an output attribute
 		tAttr.setWritable(false);
@@ -182,23 +712,209 @@ MStatus VoxelSampler::initialize()
 		tAttr.setCached( false );// allow us to query it as often as we want
 	}
 
+	outMatrix = mAttr.create( "outMatrix", "om", MFnMatrixAttribute::kDouble, &stat );
+	if ( !stat ) return stat;
+	mAttr.setWritable( false );
+	mAttr.setStorable( false );
+
+	outDistanceField = tAttr.create( "outDistanceField", "odf", MFnData::kDoubleArray, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( false );
+	tAttr.setStorable( false );
+
+	outSampleDistances = tAttr.create( "outSampleDistances", "osd", MFnData::kDoubleArray, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( false );
+	tAttr.setStorable( false );
+
+	outSampleIslands = tAttr.create( "outSampleIslands", "osi", MFnData::kIntArray, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( false );
+	tAttr.setStorable( false );
+
+	outIslandVoxels = tAttr.create( "outIslandVoxels", "oiv", MFnData::kIntArray, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( false );
+	tAttr.setStorable( false );
+
+	outIslandBounds = tAttr.create( "outIslandBounds", "oib", SampleBufferData::id, MObject::kNullObj, &stat );
+	if ( !stat ) return stat;
+	tAttr.setWritable( false );
+	tAttr.setStorable( false );
+	tAttr.setCached( false );
+
+	meshVolume = nAttr.create( "meshVolume", "mvo", MFnNumericData::kDouble, 0.0, &stat );
+	if ( !stat ) return stat;
+	nAttr.setWritable( false );
+	nAttr.setStorable( false );
+
+	meshArea = nAttr.create( "meshArea", "mar", MFnNumericData::kDouble, 0.0, &stat );
+	if ( !stat ) return stat;
+	nAttr.setWritable( false );
+	nAttr.setStorable( false );
+
+	statistics = statsAttribute.create( &stat );
+	if ( !stat ) return stat;
+
 	// Add the attributes we have created to the node
 	//
 	addAttribute( voxelRes );
+	addAttribute( voxelizer );
+	addAttribute( insideTest );
+	addAttribute( voxelCache );
+	addAttribute( voxelCacheSize );
 	addAttribute( numSamples );
+	addAttribute( seed );
+	addAttribute( cacheFile );
+	addAttribute( sampleSpace );
+	addAttribute( sampleRegion );
+	addAttribute( shellThickness );
+	addAttribute( distribution );
+	addAttribute( minDistance );
+	addAttribute( distanceField );
+	addAttribute( distanceBand );
+	addAttribute( islandBudget );
+	addAttribute( islandMinSamples );
+	addAttribute( morphology );
+	addAttribute( morphologyRadius );
+	addAttribute( csgMeshes );
 	addAttribute( mesh );
 	addAttribute( outVoxels );
 	addAttribute( outSamples );
+	addAttribute( outMatrix );
+	addAttribute( outDistanceField );
+	addAttribute( outSampleDistances );
+	addAttribute( outSampleIslands );
+	addAttribute( outIslandVoxels );
+	addAttribute( outIslandBounds );
+	addAttribute( meshVolume );
+	addAttribute( meshArea );
+	addAttribute( statistics );
 
 	// Set up a dependency between the input and the output.  This will cause
 	// the output to be marked dirty when the input changes.  The output will
 	// then be recomputed the next time the value of the output is requested.
 	//
 	attributeAffects( voxelRes, outSamples );
+	attributeAffects( csgMeshes, outSamples );
+	attributeAffects( morphology, outSamples );
+	attributeAffects( morphologyRadius, outSamples );
 	attributeAffects( voxelRes, outVoxels );
+	attributeAffects( csgMeshes, outVoxels );
+	attributeAffects( morphology, outVoxels );
+	attributeAffects( morphologyRadius, outVoxels );
+	attributeAffects( voxelizer, outSamples );
+	attributeAffects( insideTest, outSamples );
+	attributeAffects( voxelizer, outVoxels );
+	attributeAffects( insideTest, outVoxels );
+	attributeAffects( voxelCache, outSamples );
+	attributeAffects( voxelCache, outVoxels );
+	attributeAffects( voxelCache, statistics );
 	attributeAffects( numSamples, outSamples );
+	attributeAffects( seed, outSamples );
+	attributeAffects( cacheFile, outSamples );
+	attributeAffects( sampleSpace, outSamples );
+	attributeAffects( sampleRegion, outSamples );
+	attributeAffects( shellThickness, outSamples );
+	attributeAffects( distribution, outSamples );
+	attributeAffects( minDistance, outSamples );
+	attributeAffects( islandBudget, outSamples );
+	attributeAffects( islandMinSamples, outSamples );
+	attributeAffects( sampleSpace, outVoxels );
+	attributeAffects( sampleSpace, outMatrix );
 	attributeAffects( mesh, outSamples );
 	attributeAffects( mesh, outVoxels );
+	attributeAffects( mesh, outMatrix );
+	attributeAffects( sampleSpace, meshVolume );
+	attributeAffects( sampleSpace, meshArea );
+	attributeAffects( mesh, meshVolume );
+	attributeAffects( mesh, meshArea );
+	attributeAffects( voxelRes, outDistanceField );
+	attributeAffects( csgMeshes, outDistanceField );
+	attributeAffects( morphology, outDistanceField );
+	attributeAffects( morphologyRadius, outDistanceField );
+	attributeAffects( voxelizer, outDistanceField );
+	attributeAffects( insideTest, outDistanceField );
+	attributeAffects( voxelCache, outDistanceField );
+	attributeAffects( sampleSpace, outDistanceField );
+	attributeAffects( distanceField, outDistanceField );
+	attributeAffects( distanceBand, outDistanceField );
+	attributeAffects( mesh, outDistanceField );
+	attributeAffects( voxelRes, outSampleDistances );
+	attributeAffects( csgMeshes, outSampleDistances );
+	attributeAffects( morphology, outSampleDistances );
+	attributeAffects( morphologyRadius, outSampleDistances );
+	attributeAffects( voxelizer, outSampleDistances );
+	attributeAffects( insideTest, outSampleDistances );
+	attributeAffects( voxelCache, outSampleDistances );
+	attributeAffects( numSamples, outSampleDistances );
+	attributeAffects( sampleRegion, outSampleDistances );
+	attributeAffects( shellThickness, outSampleDistances );
+	attributeAffects( distribution, outSampleDistances );
+	attributeAffects( minDistance, outSampleDistances );
+	attributeAffects( islandBudget, outSampleDistances );
+	attributeAffects( islandMinSamples, outSampleDistances );
+	attributeAffects( seed, outSampleDistances );
+	attributeAffects( cacheFile, outSampleDistances );
+	attributeAffects( sampleSpace, outSampleDistances );
+	attributeAffects( distanceField, outSampleDistances );
+	attributeAffects( distanceBand, outSampleDistances );
+	attributeAffects( mesh, outSampleDistances );
+	attributeAffects( voxelRes, statistics );
+	attributeAffects( csgMeshes, statistics );
+	attributeAffects( morphology, statistics );
+	attributeAffects( morphologyRadius, statistics );
+	attributeAffects( voxelizer, statistics );
+	attributeAffects( insideTest, statistics );
+	attributeAffects( numSamples, statistics );
+	attributeAffects( seed, statistics );
+	attributeAffects( cacheFile, statistics );
+	attributeAffects( sampleSpace, statistics );
+	attributeAffects( sampleRegion, statistics );
+	attributeAffects( shellThickness, statistics );
+	attributeAffects( distribution, statistics );
+	attributeAffects( minDistance, statistics );
+	attributeAffects( islandBudget, statistics );
+	attributeAffects( islandMinSamples, statistics );
+	attributeAffects( distanceField, statistics );
+	attributeAffects( distanceBand, statistics );
+	attributeAffects( mesh, statistics );
+	attributeAffects( voxelRes, outSampleIslands );
+	attributeAffects( csgMeshes, outSampleIslands );
+	attributeAffects( morphology, outSampleIslands );
+	attributeAffects( morphologyRadius, outSampleIslands );
+	attributeAffects( voxelizer, outSampleIslands );
+	attributeAffects( insideTest, outSampleIslands );
+	attributeAffects( voxelCache, outSampleIslands );
+	attributeAffects( numSamples, outSampleIslands );
+	attributeAffects( seed, outSampleIslands );
+	attributeAffects( cacheFile, outSampleIslands );
+	attributeAffects( sampleSpace, outSampleIslands );
+	attributeAffects( sampleRegion, outSampleIslands );
+	attributeAffects( shellThickness, outSampleIslands );
+	attributeAffects( distribution, outSampleIslands );
+	attributeAffects( minDistance, outSampleIslands );
+	attributeAffects( islandBudget, outSampleIslands );
+	attributeAffects( islandMinSamples, outSampleIslands );
+	attributeAffects( mesh, outSampleIslands );
+	attributeAffects( voxelRes, outIslandVoxels );
+	attributeAffects( csgMeshes, outIslandVoxels );
+	attributeAffects( morphology, outIslandVoxels );
+	attributeAffects( morphologyRadius, outIslandVoxels );
+	attributeAffects( voxelizer, outIslandVoxels );
+	attributeAffects( insideTest, outIslandVoxels );
+	attributeAffects( voxelCache, outIslandVoxels );
+	attributeAffects( sampleSpace, outIslandVoxels );
+	attributeAffects( mesh, outIslandVoxels );
+	attributeAffects( voxelRes, outIslandBounds );
+	attributeAffects( csgMeshes, outIslandBounds );
+	attributeAffects( morphology, outIslandBounds );
+	attributeAffects( morphologyRadius, outIslandBounds );
+	attributeAffects( voxelizer, outIslandBounds );
+	attributeAffects( insideTest, outIslandBounds );
+	attributeAffects( voxelCache, outIslandBounds );
+	attributeAffects( sampleSpace, outIslandBounds );
+	attributeAffects( mesh, outIslandBounds );
 
 
 
@@ -207,7 +923,8 @@ MStatus VoxelSampler::initialize()
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
-bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ, MPointArray& voxels ) {
+bool VoxelSampler::VoxelizeGPU( const MeshView& mesh, int resX, int resY, int resZ, VoxelGrid& grid, SamplerStats& stats ) {
+	TRACE_SCOPE( "VoxelSampler::VoxelizeGPU" );
 	
 	// This method is an implementation of the paper "Single-Pass GPU Solid 
 	// Voxelization for Real-Time Applications"
@@ -217,9 +934,8 @@ bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ,
 	// around the bounding box and, for each fragment, packing the depth information
 	// on the color components, and accumulating the results in the framebuffer using
 	// a XOR bitwise operator in the blend mode. The resulting image will contain
-	// a row of voxels for each x,y pixel, packed in the color bits. To reconstruct
-	// the voxels from there, we just have to check which bits are set to 1 and
-	// dump a voxel (given as a pair of min/max points) to the output array.
+	// a row of voxels for each x,y pixel, packed in the color bits, which are
+	// then copied to the columns of the voxel grid.
 
 	// Note the implementation of this method is self-contained and therefore
 	// we're allocating and deallocating resources each time we voxelize. This
@@ -229,9 +945,9 @@ bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ,
 
 	// clamp to the limits of this implementation 
 	// (128 bits as 4 x 32 bit color channels)
-	resX = std::max( 1, std::min( 128, resX ) );
-	resY = std::max( 1, std::min( 128, resY ) );
-	resZ = std::max( 1, std::min( 128, resZ ) );
+	resX = std::max( 1, std::min( (int)MAX_GPU_RESOLUTION, resX ) );
+	resY = std::max( 1, std::min( (int)MAX_GPU_RESOLUTION, resY ) );
+	resZ = std::max( 1, std::min( (int)MAX_GPU_RESOLUTION, resZ ) );
 
 	struct Vertex {
 		float x,y,z,w;
@@ -246,7 +962,11 @@ bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ,
 	GLuint bitmaskTex;
 	GLuint fbo, rbo;
 
-	MBoundingBox bounds;
+	const Bounds bounds = mesh.bounds();
+	if ( bounds.empty() ) {
+		grid.clear();
+		return false;
+	}
 
 	{ // create shader program
 
@@ -343,28 +1063,22 @@ bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ,
 		glBindFramebuffer( GL_FRAMEBUFFER, 0 );
 	}
 
-	// map Maya mesh to OpenGL
+	// map the mesh to OpenGL
 	{
 		{ // copy vertices
 
 			glGenBuffers( 1, &vbo );
 			glBindBuffer( GL_ARRAY_BUFFER, vbo );
-			glBufferData( GL_ARRAY_BUFFER, mesh.numVertices() * sizeof( Vertex ), NULL, GL_STATIC_DRAW );
+			glBufferData( GL_ARRAY_BUFFER, mesh.numPoints * sizeof( Vertex ), NULL, GL_STATIC_DRAW );
 			Vertex* glVertices = (Vertex*)glMapBuffer( GL_ARRAY_BUFFER, GL_WRITE_ONLY );
 			if ( glVertices == NULL ) return false;
 
-			MFloatPointArray vertices;
-			mesh.getPoints( vertices, MSpace::kWorld );		
-
-			bounds.clear();
-
-			for( unsigned int i = 0; i < vertices.length(); i++ ) {
-				MFloatPoint& worldPoint =  vertices[ i ];
-				glVertices[ i ].x =  worldPoint.x;
-				glVertices[ i ].y =  worldPoint.y;
-				glVertices[ i ].z =  worldPoint.z;
-				glVertices[ i ].w =  worldPoint.w;
-				bounds.expand( worldPoint );
+			for( size_t i = 0; i < mesh.numPoints; i++ ) {
+				const float* p = mesh.point( i );
+				glVertices[ i ].x = p[ 0 ];
+				glVertices[ i ].y = p[ 1 ];
+				glVertices[ i ].z = p[ 2 ];
+				glVertices[ i ].w = 1.0f;
 			}
 
 			// commit data
@@ -373,17 +1087,14 @@ bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ,
 		}
 
 		{ // copy indices
-			MIntArray triangleCounts, triVertices;
-			mesh.getTriangles( triangleCounts, triVertices );
-
 			glGenBuffers( 1, &ibo );
 			glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo );
-			numIndices = (int)triVertices.length();
-			glBufferData( GL_ELEMENT_ARRAY_BUFFER, numIndices * 3 * sizeof( Index ), NULL, GL_STATIC_DRAW );
+			numIndices = (int)( 3 * mesh.numTriangles );
+			glBufferData( GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof( Index ), NULL, GL_STATIC_DRAW );
 			Index* indices = (Index*)glMapBuffer( GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY );
 
-			for( unsigned int i = 0; i < triVertices.length(); i++ ) {
-				indices[ i ] = triVertices[ i ];
+			for( int i = 0; i < numIndices; i++ ) {
+				indices[ i ] = mesh.triangles[ i ];
 			}
 
 			// commit data
@@ -451,17 +1162,17 @@ bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ,
 		glMatrixMode( GL_PROJECTION );			
 		glPushMatrix();							
 		glLoadIdentity();	
-		glOrtho( -bounds.width() / 2, bounds.width() / 2,
-				 -bounds.height() / 2, bounds.height() / 2,
-				 0, bounds.max().z - bounds.min().z );
+		glOrtho( -bounds.size( 0 ) / 2, bounds.size( 0 ) / 2,
+				 -bounds.size( 1 ) / 2, bounds.size( 1 ) / 2,
+				 0, bounds.size( 2 ) );
 				 /*bounds.min().z, bounds.max().z );*/
 
 		glMatrixMode( GL_MODELVIEW );
 		glPushMatrix();				
 		glLoadIdentity();
 		//glScaled( 1.0 / bounds.width(), 1.0 / bounds.height(), 1.0 / bounds.depth() );
-		gluLookAt( bounds.center().x, bounds.center().y, bounds.max().z,
-				   bounds.center().x, bounds.center().y, bounds.center().z,
+		gluLookAt( bounds.center( 0 ), bounds.center( 1 ), bounds.max[ 2 ],
+				   bounds.center( 0 ), bounds.center( 1 ), bounds.center( 2 ),
 				   0, 1, 0 );
 	}
 
@@ -493,7 +1204,7 @@ bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ,
 	glUniform1f( nearClipHandle, 0.0f);
 
 	int farClipHandle = glGetUniformLocation( program, "farClipPlane" );
-	glUniform1f( farClipHandle, (float)bounds.depth() );
+	glUniform1f( farClipHandle, bounds.size( 2 ) );
 
 	// set blending mode
 	glLogicOp( GL_XOR );
@@ -516,7 +1227,9 @@ bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ,
 		fprintf (stderr, "OpenGL Error: %s\n", errString);
 	}
 
-	// gather the resulting texture data
+	// gather the resulting texture data. glGetTexImage waits for the
+	// rendering to finish, so the readback time includes any pending GL work
+	Timer readbackTimer;
 	glBindTexture( GL_TEXTURE_2D, renderTarget );
 	unsigned int* data = (unsigned int*)malloc( 4 * resX * resY * sizeof(unsigned int) );
 	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
@@ -527,43 +1240,8 @@ bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ,
 		fprintf (stderr, "OpenGL Error: %s\n", errString);
 	}
 
-	{ // dump voxels
-
-		voxels.clear();
-
-		const float deltaX = (float)bounds.width()  / resX;
-		const float deltaY = (float)bounds.height() / resY;
-		const float deltaZ = (float)bounds.depth()  / resZ;
-
-		// due to the way the bits are constructed, the
-		// resulting boxes are shifted half a voxel - we'll
-		// compensate that shift while dumping the geometry.
-		const MPoint halfVoxel( 0, 0, -deltaZ * 0.5f );
-
-		for( int y = 0; y < resY; y++ ) {
-			for( int x = 0; x < resX; x++ ) {
-				
-				for( int i = 3; i >= 0; i-- ) {
-					unsigned int col = data[ 4 * ( x + y * resX ) + i ];
-					
-					if ( col == 0 ) continue;
-					
-					for( int z = 0; z < 32; z++ ) { // unpack color data
-
-						if ( ( col & ( 1 << z ) ) != 0 ) { // if the z-th bit is set, create a voxel
-							
-							MPoint bbMin( bounds.min().x + x * deltaX, bounds.min().y + y * deltaY, bounds.max().z - ( 32 * ( 3 - i ) + z ) * deltaZ );
-							MPoint bbMax( bbMin.x + deltaX, bbMin.y + deltaY, bbMin.z + deltaZ );
-							bbMin += halfVoxel;
-							bbMax += halfVoxel;
-							voxels.append( bbMin );
-							voxels.append( bbMax );
-						}
-					}
-				}
-			}
-		}
-	}
+	SolidVoxelizer::DecodeGpuColumns( data, resX, resY, resZ, bounds, grid );
+	stats.readbackMs = readbackTimer.elapsedMs();
 
 	free( data );
 
@@ -593,47 +1271,3 @@ bool VoxelSampler::Voxelize( const MFnMesh& mesh, int resX, int resY, int resZ,
 
 	return true;
 }
-
-// this random distribution is far from good, but it'll do for our purposes
-static inline double random01() {
-	return (double)rand() / RAND_MAX;
-}
-
-bool VoxelSampler::SampleVoxels( const MPointArray& voxels, int numSamples,
-								 MPointArray& samples ) {
-
-	srand( (unsigned int)time(0) );
-
-	if ( voxels.length() == 0 || numSamples <= 0 ) return false;
-
-	// sample voxels assuming they're the same size. If they were not, we would
-	// sample them according to their volume by finding the common denominator
-	// and building an array so that each voxel index would appear a proportional
-	// number of times, then choosing a random element each time within that array.
-
-	unsigned int numVoxels = voxels.length() / 2; // (min,max), (min,max)...
-
-	samples.clear();
-
-	for( int i = 0; i < numSamples; i++ ) {
-		unsigned int voxelIndex = (unsigned int)( random01() * numVoxels );
-
-		// sample voxel
-		const MPoint& bbMin = voxels[ 2 * voxelIndex ];
-		const MPoint& bbMax = voxels[ 2 * voxelIndex + 1 ];
-
-		// recalculating this every time would be unnecessary as every voxel will
-		// be the same dimensions but it's left for illustration purposes
-		const double voxelsWidth  = bbMax.x - bbMin.x;
-		const double voxelsHeight = bbMax.y - bbMin.y;
-		const double voxelsDepth  = bbMax.z - bbMin.z;
-
-		MPoint sample(	bbMin.x + voxelsWidth * random01(), 
-						bbMin.y + voxelsHeight * random01(),
-						bbMin.z + voxelsDepth * random01() );				
-
-		samples.append( sample );
-	}
-
-	return true;
-}
@@ -11,8 +11,18 @@
 #include <maya/MPxNode.h>
 #include <maya/MFnNumericAttribute.h>
 #include <maya/MTypeId.h> 
-#include <maya/MPointArray.h>
-#include <maya/MFnMesh.h>
+
+#include "SamplerStatsAttribute.h"
+
+#include <stdint.h>
+
+#include "TriangleMesh.h"
+#include "VoxelGrid.h"
+#include "VoxelGridSampler.h"
+#include "DistanceField.h"
+#include "ShellSampler.h"
+#include "PoissonDiskSampler.h"
+#include "VoxelIslands.h"
 
  
 /* ==========================================
@@ -20,13 +30,109 @@
 
 	Samples the input mesh plugged to its 'mesh' attribute
 	by voxelizing with a resolution set by 'voxelRes' and 
-	generating points within each voxels.
+	generating points within each voxels. The 'voxelizer'
+	attribute selects between the GPU voxelizer and its CPU
+	counterpart from the core library (SolidVoxelizer).
+
+	'insideTest' chooses how voxels are found inside the
+	mesh: Parity counts the surfaces crossed, which needs a
+	closed mesh, and Winding Number uses the generalized
+	winding number (see WindingNumber), which still fills
+	meshes with holes or overlapping shells. The latter is
+	only done by the CPU voxelizer, which it selects. The
+	Shell region tests its samples the same way.
+
+	The slider of 'voxelRes' stops at 32 voxels per axis, but
+	values up to MAX_RESOLUTION can be typed in. The GPU
+	voxelizer handles up to MAX_GPU_RESOLUTION, and finer
+	grids are voxelized on the CPU instead.
 
-	The samples are provided as a MFnPointArray in the 
-	'outVoxels' output attribute. Additionally the voxels
+	The samples are provided as a SampleBufferData in the 
+	'outSamples' output attribute. Additionally the voxels
 	can be retrieved from the 'outVoxels' attribute as 
-	a point array where each pair of points describes the
+	a point buffer where each pair of points describes the
 	min and max points of an axis-aligned voxel.
+
+	The counters and stage timings of the last evaluation
+	are published in the read-only 'statistics' attribute.
+
+	When 'voxelCache' names a directory, grids are stored in
+	it keyed by the mesh contents and resolution (see
+	VoxelCache), and reused instead of voxelizing again, also
+	across sessions. 'voxelCacheSize' bounds the directory
+	size in megabytes.
+
+	When 'cacheFile' is set, the samples are also streamed to
+	that path as a sample cache (see SampleCache.h) while they
+	are being generated.
+
+	Both outputs keep a hash of the inputs they were computed
+	from, and are not evaluated again while it doesn't change
+	even if the mesh has been dirtied.
+
+	'sampleSpace' works as in RaySampler: in Object and Local
+	modes the mesh is voxelized in its local space, so the
+	grid (and its voxel cache entry) survives transforming
+	the mesh. In Object mode only the samples are moved to
+	world space; 'outVoxels' stays in local space and has to
+	be placed with 'outMatrix', as everything in Local mode.
+
+	'meshVolume' and 'meshArea' are computed as in RaySampler.
+
+	With 'sampleRegion' set to Shell, samples are only placed
+	inside the mesh within 'shellThickness' of its surface
+	(see ShellSampler). Only the voxels near the surface are
+	visited, so the cost follows the area of the mesh.
+
+	Setting 'distribution' to Blue Noise spreads the samples of
+	the Volume region so that none are closer than
+	'minDistance' (see PoissonDiskSampler). At most
+	'numSamples' are produced: the distance grows if more
+	would fit, and 0 derives it from 'numSamples' alone.
+
+	The occupied voxels are split into islands connected
+	through their faces (see VoxelIslands). With
+	'islandBudget' set, the samples of the Volume region are
+	split between the islands by volume, equally, or by
+	volume with at least 'islandMinSamples' each, instead of
+	landing mostly on the larger pieces. The island of each
+	sample is output in 'outSampleIslands', in the same order
+	as 'outSamples', and the voxel count and bounds of each
+	island in 'outIslandVoxels' and 'outIslandBounds', in the
+	space of the voxels.
+
+	Each element of 'csgMeshes' combines a further mesh with
+	the input one, in order of their indices: 'csgOperation'
+	adds its interior to the voxels (Union), keeps only the
+	voxels it shares with them (Intersect), or removes its
+	interior from them (Subtract), e.g. to sample a container
+	minus its contents (see VoxelizeCsg). The meshes are
+	voxelized on the CPU on a common grid and combined with
+	bitwise operations on its columns. The Shell region and
+	the distance field are measured from the surface of the
+	input mesh only, so they are not available while any
+	mesh is connected to 'csgMeshes': a warning is shown and
+	no samples or distances are output.
+
+	'morphology' dilates, erodes, opens or closes the voxels
+	by 'morphologyRadius' voxels right after voxelizing (see
+	ApplyMorphology), before anything is sampled from them:
+	opening removes thin parts and specks, closing fills
+	small holes and cracks. The voxel cache keeps the grid as
+	voxelized, so changing these doesn't voxelize again. The
+	Shell region and the distance field are measured from
+	the mesh surface, so they ignore the morphology and use
+	the voxels as voxelized.
+
+	When 'distanceField' is not Off, the signed distance from
+	each voxel center to the mesh surface (negative inside)
+	is output in 'outDistanceField', along X then Y then Z,
+	over the same bounds and resolution as the voxels. Narrow
+	Band only computes distances up to 'distanceBand' voxels
+	and clamps the rest (see DistanceField). The distance of
+	every sample, interpolated from the field, is output in
+	'outSampleDistances' in the same order as 'outSamples'.
+	Both are in the space of the voxels.
 		
 ========================================== */
 
@@ -48,10 +154,41 @@ public:
 	// the values later.
 	//
 	static MObject  voxelRes;
+	static MObject  voxelizer;
+	static MObject  insideTest;
+	static MObject  voxelCache;
+	static MObject  voxelCacheSize;
 	static MObject  numSamples;
+	static MObject  seed;
+	static MObject  cacheFile;
+	static MObject  sampleSpace;
+	static MObject  sampleRegion;
+	static MObject  shellThickness;
+	static MObject  distribution;
+	static MObject  minDistance;
+	static MObject  distanceField;
+	static MObject  distanceBand;
+	static MObject  islandBudget;
+	static MObject  islandMinSamples;
+	static MObject  morphology;
+	static MObject  morphologyRadius;
+	static MObject  csgMeshes;
+	static MObject  csgMesh;
+	static MObject  csgOperation;
 	static MObject  mesh;        
 	static MObject	outVoxels;
 	static MObject	outSamples;
+	static MObject	outMatrix;
+	static MObject	outDistanceField;
+	static MObject	outSampleDistances;
+	static MObject	outSampleIslands;
+	static MObject	outIslandVoxels;
+	static MObject	outIslandBounds;
+	static MObject	meshVolume;
+	static MObject	meshArea;
+	static MObject	statistics;
+
+	static SamplerStatsAttribute	statsAttribute;
 
 	// The typeid is a unique 32bit identifier that describes this node.
 	// It is used to save and retrieve nodes of this type from the binary
@@ -59,12 +196,104 @@ public:
 	//
 	static	MTypeId		id;
 
+	enum VoxelizerType {
+		VOXELIZER_GPU = 0,
+		VOXELIZER_CPU
+	};
+
+	enum {
+		MAX_RESOLUTION = 1024,		// voxels along each axis
+		MAX_GPU_RESOLUTION = 128	// a column is packed in the 128 bits of a pixel
+	};
+
+	enum SampleRegion {
+		REGION_VOLUME = 0,
+		REGION_SHELL
+	};
+
+	enum Distribution {
+		DISTRIBUTION_UNIFORM = 0,
+		DISTRIBUTION_BLUE_NOISE
+	};
+
+	enum IslandBudgetMode {
+		ISLANDS_OFF = 0,
+		ISLANDS_PROPORTIONAL,
+		ISLANDS_EQUAL,
+		ISLANDS_MINIMUM
+	};
+
+	enum DistanceFieldType {
+		FIELD_OFF = 0,
+		FIELD_DENSE,
+		FIELD_NARROW_BAND
+	};
+
+	enum SampleSpace {
+		SPACE_WORLD = 0,
+		SPACE_OBJECT,
+		SPACE_LOCAL
+	};
+
 private:
 
-	static bool Voxelize( const MFnMesh& inMesh, int resX, int resY, int resZ, 
-						  MPointArray& voxels );
+	static bool VoxelizeGPU( const MeshView& mesh, int resX, int resY, int resZ, 
+							 VoxelGrid& grid, SamplerStats& stats );
+
+	// labels the islands of the voxels if they changed since the last time
+	void			updateIslands();
+
+	// voxels from the last evaluation of outVoxels, sampled by outSamples
+	VoxelGrid		grid;
+
+	// the voxels before any morphology, only kept when there is some. The
+	// shell and the distance field measure the mesh itself, so they are
+	// built on a voxelization of it.
+	VoxelGrid		meshGrid;
+	const VoxelGrid&	meshVoxels() const { return meshGrid.empty() ? grid : meshGrid; }
+
+	// whether the voxels combine other meshes with the input one, which
+	// then no longer bounds them alone
+	bool			csgVoxels;
+	SamplerStats	stats;
+
+	// kept between evaluations so that its buffers are reused
+	VoxelGridSampler	sampler;
+
+	// shell of the last voxels sampled with REGION_SHELL, keyed by the
+	// voxels and the thickness
+	ShellSampler	shellSampler;
+	uint64_t		shellHash;
+
+	PoissonDiskSampler	blueNoiseSampler;
+
+	// islands of the voxels, keyed by voxelsHash, with their voxel counts
+	// and bounds, and the islands of the samples keyed by samplesHash
+	VoxelIslands	islands;
+	uint64_t		islandsHash;
+	MObject			islandVoxelsData;
+	MObject			islandBoundsData;
+	uint64_t		islandDataHash;
+	uint64_t		sampleIslandsHash;
+	MObject			sampleIslandsData;
+
+	// content hashes of the inputs of the last evaluation of each output,
+	// and the SampleBufferData it produced
+	uint64_t		voxelsHash;
+	MObject			voxelsData;
+	uint64_t		samplesHash;
+	MObject			samplesData;
 
-	static bool SampleVoxels( const MPointArray& voxels, int numSamples,
-							  MPointArray& samples );
+	// distance field of the voxels and the distances of the samples, with
+	// the hashes they were computed from
+	DistanceField	field;
+	uint64_t		fieldHash;
+	MObject			fieldData;
+	uint64_t		distancesHash;
+	MObject			distancesData;
 
+	// the samples of the last evaluation in object space mode moved to world
+	// space, keyed by samplesHash and the mesh transform
+	uint64_t		worldSamplesHash;
+	MObject			worldSamplesData;
 };
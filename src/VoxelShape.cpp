@@ -6,6 +6,9 @@
 */
 
 #include "VoxelShape.h"
+#include "SampleBufferData.h"
+#include "ComponentSelection.h"
+#include "Trace.h"
 
 #include <assert.h>
 
@@ -78,6 +81,7 @@ MObject VoxelShape::geometryData() const {
 ////////////////////////////////////////////////////////////////////////////
 
 MStatus VoxelShape::compute( const MPlug& plug, MDataBlock& data ) {
+	TRACE_SCOPE( "VoxelShape::compute" );
 	MStatus stat;
 
 	// Check which output attribute we have been asked to compute.  If this 
@@ -92,8 +96,6 @@ MStatus VoxelShape::compute( const MPlug& plug, MDataBlock& data ) {
 		// connections to be evaluated so that the correct value is supplied.
 		// 
 		MDataHandle inputDataHandle = data.inputValue( voxelData, &stat );
-
-		MObject inputDataObj = inputDataHandle.data();
 		
 		MFnPluginData fnDataCreator;
 		MTypeId tmpid( VoxelPreviewDataWrapper::id );
@@ -110,12 +112,16 @@ MStatus VoxelShape::compute( const MPlug& plug, MDataBlock& data ) {
 			MCHECKERROR( stat, "compute : error getting proxy VoxelPreviewDataWrapper object")
 		}
 
-		// compute the output values			
-		MFnPointArrayData inputData;
-		inputData.setObject(inputDataObj);
-		MPointArray voxels = inputData.array();
-		newData->reset( new VoxelPreviewData( voxels ) );
-		bounds = newData->getData()->bounds();
+		// compute the output values: the voxels are read straight from the
+		// buffer shared with the sampler
+		const SampleBuffer* voxels = SampleBufferData::fromHandle( inputDataHandle );
+		if ( voxels == NULL ) {
+			newData->reset( NULL );
+			bounds.clear();
+		} else {
+			newData->reset( new VoxelPreviewData( *voxels ) );
+			bounds = newData->getData()->bounds();
+		}
 
 		#if 0 // enable to dump voxels to Maya
 		{
@@ -126,9 +132,9 @@ MStatus VoxelShape::compute( const MPlug& plug, MDataBlock& data ) {
 			// low voxel densities.
 
 			char cmd[ 128];
-			for( unsigned int i = 0; i < voxels.length(); i += 2 ) {
-				MPoint bbMin = voxels[ i ];
-				MPoint bbMax = voxels[ i + 1 ];
+			for( size_t i = 0; voxels != NULL && i < voxels->size(); i += 2 ) {
+				MPoint bbMin( voxels->point( i )[ 0 ], voxels->point( i )[ 1 ], voxels->point( i )[ 2 ] );
+				MPoint bbMax( voxels->point( i + 1 )[ 0 ], voxels->point( i + 1 )[ 1 ], voxels->point( i + 1 )[ 2 ] );
 				MVector extents = bbMax - bbMin;
 				MPoint center = ( bbMax + bbMin ) * 0.5f;
 				sprintf_s( cmd, 128, "$c = `polyCube -ch on -o on -w %f -h %f -d %f`; move -a %f %f %f $c;", extents.x, extents.y, extents.z, center.x, center.y, center.z );
@@ -199,6 +205,47 @@ VoxelPreviewData* VoxelShape::getData() {
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+// VoxelShape::numVoxels
+////////////////////////////////////////////////////////////////////////////
+
+unsigned int VoxelShape::numVoxels() {
+	VoxelPreviewData* data = getData();
+	if ( data == NULL ) return 0;
+	return (unsigned int)data->numVoxels();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// VoxelShape::matchComponent (override)
+//
+//	Resolves 'vtx[...]' specifications into voxel components
+////////////////////////////////////////////////////////////////////////////
+
+MPxSurfaceShape::MatchResult VoxelShape::matchComponent( const MSelectionList& item, const MAttributeSpecArray& spec, MSelectionList& list ) {
+	MatchResult result = ComponentSelection::matchComponent( item, spec, list, numVoxels() );
+	if ( result == kMatchNone ) {
+		return MPxSurfaceShape::matchComponent( item, spec, list );
+	}
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// VoxelShape::match (override)
+////////////////////////////////////////////////////////////////////////////
+
+bool VoxelShape::match( const MSelectionMask& mask, const MObjectArray& componentList ) const {
+	return ComponentSelection::match( mask, componentList );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// VoxelShape::createFullVertexGroup (override)
+////////////////////////////////////////////////////////////////////////////
+
+MObject VoxelShape::createFullVertexGroup() const {
+	VoxelShape* nonConstThis = const_cast<VoxelShape*>(this);
+	return ComponentSelection::createFullGroup( nonConstThis->numVoxels() );
+}
+
 //////////////////////////////////////////////////////////////////////////
 // VoxelShape::creator
 //
@@ -225,11 +272,7 @@ MStatus VoxelShape::initialize() {
 
 	// Input attributes
 
-	MPointArray defaultPointArray;
-	MFnPointArrayData pointArrayDataFn;
-	pointArrayDataFn.create( defaultPointArray );
-
-	voxelData = typedAttr.create( "voxelData", "vd", MFnData::kPointArray, pointArrayDataFn.object() );
+	voxelData = typedAttr.create( "voxelData", "vd", SampleBufferData::id, MObject::kNullObj );
 	typedAttr.setWritable( true );
 	typedAttr.setReadable( true );
 
@@ -254,61 +297,72 @@ MStatus VoxelShape::initialize() {
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
-VoxelPreviewData::VoxelPreviewData( const MPointArray& points ) : references(0) {
+//////////////////////////////////////////////////////////////////////////
+// drawVoxel
+//
+//	Emits the faces of an axis-aligned box, must be called between
+//	glBegin( GL_QUADS ) and glEnd()
+//////////////////////////////////////////////////////////////////////////
+
+static void drawVoxel( const float* bbMin, const float* bbMax ) {
+	// Bottom Face
+	glTexCoord2f( 1.0f, 1.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Top Right Of The Texture and Quad
+	glTexCoord2f( 0.0f, 1.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Top Left Of The Texture and Quad
+	glTexCoord2f( 0.0f, 0.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Left Of The Texture and Quad
+	glTexCoord2f( 1.0f, 0.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Right Of The Texture and Quad
+	// Front Face
+	glTexCoord2f( 0.0f, 0.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Left Of The Texture and Quad
+	glTexCoord2f( 1.0f, 0.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Right Of The Texture and Quad
+	glTexCoord2f( 1.0f, 1.0f ); glVertex3f( bbMax[ 0 ], bbMax[ 1 ], bbMax[ 2 ] );	// Top Right Of The Texture and Quad
+	glTexCoord2f( 0.0f, 1.0f ); glVertex3f( bbMin[ 0 ], bbMax[ 1 ], bbMax[ 2 ] );	// Top Left Of The Texture and Quad
+	// Back Face
+	glTexCoord2f( 1.0f, 0.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Bottom Right Of The Texture and Quad
+	glTexCoord2f( 1.0f, 1.0f ); glVertex3f( bbMin[ 0 ], bbMax[ 1 ], bbMin[ 2 ] );	// Top Right Of The Texture and Quad
+	glTexCoord2f( 0.0f, 1.0f ); glVertex3f( bbMax[ 0 ], bbMax[ 1 ], bbMin[ 2 ] );	// Top Left Of The Texture and Quad
+	glTexCoord2f( 0.0f, 0.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Bottom Left Of The Texture and Quad
+	// Right face
+	glTexCoord2f( 1.0f, 0.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Bottom Right Of The Texture and Quad
+	glTexCoord2f( 1.0f, 1.0f ); glVertex3f( bbMax[ 0 ], bbMax[ 1 ], bbMin[ 2 ] );	// Top Right Of The Texture and Quad
+	glTexCoord2f( 0.0f, 1.0f ); glVertex3f( bbMax[ 0 ], bbMax[ 1 ], bbMax[ 2 ] );	// Top Left Of The Texture and Quad
+	glTexCoord2f( 0.0f, 0.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Left Of The Texture and Quad
+	// Left Face
+	glTexCoord2f( 0.0f, 0.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Bottom Left Of The Texture and Quad
+	glTexCoord2f( 1.0f, 0.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Right Of The Texture and Quad
+	glTexCoord2f( 1.0f, 1.0f ); glVertex3f( bbMin[ 0 ], bbMax[ 1 ], bbMax[ 2 ] );	// Top Right Of The Texture and Quad
+	glTexCoord2f( 0.0f, 1.0f ); glVertex3f( bbMin[ 0 ], bbMax[ 1 ], bbMin[ 2 ] );	// Top Left Of The Texture and Quad
+}
+
+VoxelPreviewData::VoxelPreviewData( const SampleBuffer& voxelBuffer ) : references(0), voxels( &voxelBuffer ), index( NULL ) {
+
+	// keep a reference to the voxels for component selection
+	voxels->incRef();
 
 	listId = glGenLists( 1 );
 
 	boundingBox.clear();
-
-	float bbMin[3];
-	float bbMax[3];
+	if ( !voxels->empty() ) {
+		const float* boundsMin = voxels->boundsMin();
+		const float* boundsMax = voxels->boundsMax();
+		boundingBox.expand( MPoint( boundsMin[ 0 ], boundsMin[ 1 ], boundsMin[ 2 ] ) );
+		boundingBox.expand( MPoint( boundsMax[ 0 ], boundsMax[ 1 ], boundsMax[ 2 ] ) );
+	}
 
 	glNewList(listId, GL_COMPILE);
 	glBegin(GL_QUADS);
 
-	for( unsigned int i = 0; i < points.length(); i += 2 ) {
-
-		boundingBox.expand( points[ i ] );
-		boundingBox.expand( points[ i + 1 ] );
-
-		bbMin[ 0 ] = (float)points[ i ].x;
-		bbMin[ 1 ] = (float)points[ i ].y;
-		bbMin[ 2 ] = (float)points[ i ].z;
-		bbMax[ 0 ] = (float)points[ i + 1 ].x;
-		bbMax[ 1 ] = (float)points[ i + 1 ].y;
-		bbMax[ 2 ] = (float)points[ i + 1 ].z;
-
-		// Bottom Face
-		glTexCoord2f( 1.0f, 1.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Top Right Of The Texture and Quad
-		glTexCoord2f( 0.0f, 1.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Top Left Of The Texture and Quad
-		glTexCoord2f( 0.0f, 0.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Left Of The Texture and Quad
-		glTexCoord2f( 1.0f, 0.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Right Of The Texture and Quad
-		// Front Face
-		glTexCoord2f( 0.0f, 0.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Left Of The Texture and Quad
-		glTexCoord2f( 1.0f, 0.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Right Of The Texture and Quad
-		glTexCoord2f( 1.0f, 1.0f ); glVertex3f( bbMax[ 0 ], bbMax[ 1 ], bbMax[ 2 ] );	// Top Right Of The Texture and Quad
-		glTexCoord2f( 0.0f, 1.0f ); glVertex3f( bbMin[ 0 ], bbMax[ 1 ], bbMax[ 2 ] );	// Top Left Of The Texture and Quad
-		// Back Face
-		glTexCoord2f( 1.0f, 0.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Bottom Right Of The Texture and Quad
-		glTexCoord2f( 1.0f, 1.0f ); glVertex3f( bbMin[ 0 ], bbMax[ 1 ], bbMin[ 2 ] );	// Top Right Of The Texture and Quad
-		glTexCoord2f( 0.0f, 1.0f ); glVertex3f( bbMax[ 0 ], bbMax[ 1 ], bbMin[ 2 ] );	// Top Left Of The Texture and Quad
-		glTexCoord2f( 0.0f, 0.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Bottom Left Of The Texture and Quad
-		// Right face
-		glTexCoord2f( 1.0f, 0.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Bottom Right Of The Texture and Quad
-		glTexCoord2f( 1.0f, 1.0f ); glVertex3f( bbMax[ 0 ], bbMax[ 1 ], bbMin[ 2 ] );	// Top Right Of The Texture and Quad
-		glTexCoord2f( 0.0f, 1.0f ); glVertex3f( bbMax[ 0 ], bbMax[ 1 ], bbMax[ 2 ] );	// Top Left Of The Texture and Quad
-		glTexCoord2f( 0.0f, 0.0f ); glVertex3f( bbMax[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Left Of The Texture and Quad
-		// Left Face
-		glTexCoord2f( 0.0f, 0.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMin[ 2 ] );	// Bottom Left Of The Texture and Quad
-		glTexCoord2f( 1.0f, 0.0f ); glVertex3f( bbMin[ 0 ], bbMin[ 1 ], bbMax[ 2 ] );	// Bottom Right Of The Texture and Quad
-		glTexCoord2f( 1.0f, 1.0f ); glVertex3f( bbMin[ 0 ], bbMax[ 1 ], bbMax[ 2 ] );	// Top Right Of The Texture and Quad
-		glTexCoord2f( 0.0f, 1.0f ); glVertex3f( bbMin[ 0 ], bbMax[ 1 ], bbMin[ 2 ] );	// Top Left Of The Texture and Quad
+	for( size_t i = 0; i < voxels->size(); i += 2 ) {
+		drawVoxel( voxels->point( i ), voxels->point( i + 1 ) );
 	}
 
 	glEnd();	
 	glEndList();
 }
 
+VoxelPreviewData::~VoxelPreviewData() {
+	SampleBuffer::release( voxels );
+	delete index;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // VoxelPreviewDataWrapper::copy (override)
 //////////////////////////////////////////////////////////////////////////
@@ -339,6 +393,39 @@ void VoxelPreviewData::draw() const {
 	glCallList( listId );
 }
 
+void VoxelPreviewData::drawVoxels( const std::vector< int >& selected ) const {
+	glBegin( GL_QUADS );
+	for( size_t i = 0; i < selected.size(); i++ ) {
+		drawVoxel( voxels->point( 2 * selected[ i ] ), voxels->point( 2 * selected[ i ] + 1 ) );
+	}
+	glEnd();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// VoxelPreviewData::getIndex
+//
+//	Voxels are selected through their centers. Both the centers and the
+//	hierarchy are only needed for component selection, so they are built
+//	the first time they are requested.
+//////////////////////////////////////////////////////////////////////////
+
+const PointBvh& VoxelPreviewData::getIndex() const {
+	if ( index == NULL ) {
+		const size_t numVoxels = voxels->size() / 2;
+		centers.resize( 3 * numVoxels );
+		for( size_t i = 0; i < numVoxels; i++ ) {
+			const float* bbMin = voxels->point( 2 * i );
+			const float* bbMax = voxels->point( 2 * i + 1 );
+			for( int axis = 0; axis < 3; axis++ ) {
+				centers[ 3 * i + axis ] = 0.5f * ( bbMin[ axis ] + bbMax[ axis ] );
+			}
+		}
+		index = new PointBvh();
+		index->build( centers.empty() ? NULL : &centers[ 0 ], numVoxels );
+	}
+	return *index;
+}
+
 void VoxelPreviewData::destroy() {
 	assert( references == 0 );
 	glDeleteLists(listId, 1);
@@ -22,7 +22,10 @@
 #include <maya/MTypeId.h>
 #include <maya/MString.h>
 
-class MPointArray;
+#include <vector>
+
+#include "PointBvh.h"
+#include "SampleBuffer.h"
 
 /* ==========================================
 	
@@ -52,10 +55,17 @@ public:
 	virtual MObject			localShapeOutAttr() const { return outData; }
 	virtual MObject			geometryData() const;
 
+	// component support: each voxel is exposed as a 'vtx' component
+
+	virtual MatchResult		matchComponent( const MSelectionList& item, const MAttributeSpecArray& spec, MSelectionList& list );
+	virtual bool			match( const MSelectionMask& mask, const MObjectArray& componentList ) const;
+	virtual MObject			createFullVertexGroup() const;
+
 	// methods
 
 	MObject					meshDataRef();
 	VoxelPreviewData*		getData();
+	unsigned int			numVoxels();
 
 
 	static  void*		creator();
@@ -87,10 +97,19 @@ private:
 
 class VoxelPreviewData {
 public:
-	explicit VoxelPreviewData( const MPointArray& points );
+	explicit VoxelPreviewData( const SampleBuffer& voxels );
+	~VoxelPreviewData();
 
 	void destroy();
 	void draw() const;
+	void drawVoxels( const std::vector< int >& selected ) const; // immediate mode
+
+	size_t numVoxels() const { return voxels->size() / 2; }
+
+	// spatial index over the voxel centers used for component selection,
+	// built on first use
+	const PointBvh& getIndex() const;
+	const float* getCenters() const { return centers.empty() ? NULL : &centers[ 0 ]; }
 
 	inline void incRef() { references++; }
 	inline int decRef() { references--; return references; }
@@ -105,6 +124,9 @@ private:
 
 	MBoundingBox boundingBox;
 
+	const SampleBuffer*				voxels; // shared with the sampler
+	mutable std::vector< float >	centers;
+	mutable PointBvh*				index;
 };
 
 /* ==========================================
@@ -118,8 +140,8 @@ private:
 class VoxelPreviewDataWrapper : public MPxGeometryData {
 public:
 	explicit VoxelPreviewDataWrapper() : data( NULL ) {}
-	explicit VoxelPreviewDataWrapper( const MPointArray& points ) {
-		data = new VoxelPreviewData( points );
+	explicit VoxelPreviewDataWrapper( const SampleBuffer& voxels ) {
+		data = new VoxelPreviewData( voxels );
 		data->incRef();
 	}
 
@@ -7,11 +7,14 @@
 
 #include "VoxelShapeUI.h"
 #include "VoxelShape.h"
+#include "ComponentSelection.h"
+#include "Trace.h"
 #include <maya/MColor.h>
 #include <maya/MDrawData.h>
 #include <maya/MSelectionMask.h>
 #include <maya/MSelectionList.h>
 #include <maya/MDagPath.h>
+#include <maya/MObjectArray.h>
 
 // Object and component color defines
 //
@@ -110,6 +113,18 @@ void VoxelShapeUI::getDrawRequests(	const MDrawInfo & info,
 		  }
 
 		  queue.add( request );
+
+		  // while in component mode, draw the selected voxels on top
+		  if ( displayStatus == M3dView::kHilite && shape->hasActiveComponents() ) {
+			  MObjectArray components = shape->activeComponents();
+			  MObject component = components[ 0 ];
+			  MDrawRequest activeRequest = info.getPrototype( *this );
+			  activeRequest.setDrawData( data );
+			  activeRequest.setToken( kDrawVertices );
+			  activeRequest.setColor( ACTIVE_VERTEX_COLOR, activeColorTable );
+			  activeRequest.setComponent( component );
+			  queue.add( activeRequest );
+		  }
 		  break;
 		}
 
@@ -135,6 +150,7 @@ void VoxelShapeUI::getDrawRequests(	const MDrawInfo & info,
 //////////////////////////////////////////////////////////////////////////
 
 void VoxelShapeUI::draw( const MDrawRequest & request, M3dView & view ) const{ 
+	TRACE_SCOPE( "VoxelShapeUI::draw" );
 	// Get the token from the draw request.
 	// The token specifies what needs to be drawn.
 	//
@@ -150,6 +166,16 @@ void VoxelShapeUI::draw( const MDrawRequest & request, M3dView & view ) const{
 		previewData->draw();
 		view.endGL();
 		break;
+	case kDrawVertices :
+		{
+			std::vector< int > selected;
+			ComponentSelection::getElements( request.component(), (unsigned int)previewData->numVoxels(), selected );
+			view.beginGL();
+			glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
+			previewData->drawVoxels( selected );
+			view.endGL();
+			break;
+		}
 	default: break;
 	}
 }
@@ -174,10 +200,20 @@ void VoxelShapeUI::draw( const MDrawRequest & request, M3dView & view ) const{
 bool VoxelShapeUI::select( MSelectInfo &selectInfo, 
 					  MSelectionList &selectionList,
 					  MPointArray &worldSpaceSelectPts ) const {
+	TRACE_SCOPE( "VoxelShapeUI::select" );
 					  
 	 VoxelShape* shape = (VoxelShape*)surfaceShape();
 	 if ( shape == NULL ) return false;
 
+	 // in component mode, pick individual voxels through the spatial index
+	 if ( selectInfo.displayStatus() == M3dView::kHilite ) {
+		 VoxelPreviewData* previewData = shape->getData();
+		 if ( previewData == NULL ) return false;
+		 const PointBvh& index = previewData->getIndex();
+		 return ComponentSelection::select( selectInfo, index, previewData->getCenters(),
+											selectionList, worldSpaceSelectPts );
+	 }
+
 	 // NOTE: If the geometry has an intersect routine it should
 	 // be called here with the selection ray to determine if the
 	 // the object was selected.
@@ -0,0 +1,48 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "AliasTable.h"
+
+void AliasTable::build( const float* weights, size_t count ) {
+	slots.resize( count );
+	if ( count == 0 ) return;
+
+	double total = 0;
+	for( size_t i = 0; i < count; i++ ) {
+		total += weights[ i ];
+	}
+
+	// weights scaled so that they average 1, split between the slots below
+	// and above it. Each small slot is topped up from a large one, which
+	// becomes its alias.
+	std::vector< double > scaled( count );
+	std::vector< unsigned int > small, large;
+	for( size_t i = 0; i < count; i++ ) {
+		scaled[ i ] = total > 0 ? weights[ i ] * count / total : 1.0;
+		( scaled[ i ] < 1.0 ? small : large ).push_back( (unsigned int)i );
+	}
+	while( !small.empty() && !large.empty() ) {
+		const unsigned int s = small.back(); small.pop_back();
+		const unsigned int l = large.back();
+		slots[ s ].probability = (float)scaled[ s ];
+		slots[ s ].alias = l;
+		scaled[ l ] -= 1.0 - scaled[ s ];
+		if ( scaled[ l ] < 1.0 ) {
+			large.pop_back();
+			small.push_back( l );
+		}
+	}
+	// whatever is left is 1 up to rounding errors
+	for( size_t i = 0; i < large.size(); i++ ) {
+		slots[ large[ i ] ].probability = 1.0f;
+		slots[ large[ i ] ].alias = large[ i ];
+	}
+	for( size_t i = 0; i < small.size(); i++ ) {
+		slots[ small[ i ] ].probability = 1.0f;
+		slots[ small[ i ] ].alias = small[ i ];
+	}
+}
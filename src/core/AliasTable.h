@@ -0,0 +1,46 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "Random.h"
+
+#include <vector>
+#include <stddef.h>
+
+/* ==========================================
+	Class AliasTable
+
+	Draws indices in proportion to a set of weights in
+	constant time, whatever their number (Walker's alias
+	method). Each slot of the table holds the probability of
+	keeping its own index, and the index to take otherwise.
+
+   ========================================== */
+
+class AliasTable {
+public:
+	// builds the table for 'count' non-negative weights
+	void			build( const float* weights, size_t count );
+	void			clear() { slots.clear(); }
+
+	size_t			size() const { return slots.size(); }
+	bool			empty() const { return slots.empty(); }
+
+	// random index, with a probability proportional to its weight
+	size_t			sample( Random& rng ) const {
+		const Slot& slot = slots[ rng.nextInt( (uint32_t)slots.size() ) ];
+		return rng.nextFloat() < slot.probability ? &slot - &slots[ 0 ] : slot.alias;
+	}
+
+private:
+	struct Slot {
+		float			probability;
+		unsigned int	alias;
+	};
+	std::vector< Slot >	slots;
+};
@@ -0,0 +1,56 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// Bit counting helpers for the packed voxel columns, and Morton codes
+
+inline int PopCount( uint64_t w ) {
+#if defined( __GNUC__ )
+	return __builtin_popcountll( w );
+#else
+	int count = 0;
+	for( ; w != 0; count++ ) w &= w - 1;
+	return count;
+#endif
+}
+
+// index of the lowest set bit, w must not be 0
+inline int LowestBit( uint64_t w ) {
+#if defined( __GNUC__ )
+	return __builtin_ctzll( w );
+#else
+	int bit = 0;
+	while( ( w & 1 ) == 0 ) { w >>= 1; bit++; }
+	return bit;
+#endif
+}
+
+// spreads the lowest 21 bits of v so that there are two 0 bits between each
+// of them, e.g. to interleave three coordinates into a 63-bit Morton code
+inline uint64_t SpreadBits3( uint64_t v ) {
+	v &= 0x1fffff;
+	v = ( v | v << 32 ) & 0x1f00000000ffffULL;
+	v = ( v | v << 16 ) & 0x1f0000ff0000ffULL;
+	v = ( v | v << 8 ) & 0x100f00f00f00f00fULL;
+	v = ( v | v << 4 ) & 0x10c30c30c30c30c3ULL;
+	v = ( v | v << 2 ) & 0x1249249249249249ULL;
+	return v;
+}
+
+// inverse of SpreadBits3: gathers every third bit of v, starting at bit 0
+inline uint64_t CompactBits3( uint64_t v ) {
+	v &= 0x1249249249249249ULL;
+	v = ( v ^ ( v >> 2 ) ) & 0x10c30c30c30c30c3ULL;
+	v = ( v ^ ( v >> 4 ) ) & 0x100f00f00f00f00fULL;
+	v = ( v ^ ( v >> 8 ) ) & 0x1f0000ff0000ffULL;
+	v = ( v ^ ( v >> 16 ) ) & 0x1f00000000ffffULL;
+	v = ( v ^ ( v >> 32 ) ) & 0x1fffff;
+	return v;
+}
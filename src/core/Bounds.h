@@ -0,0 +1,62 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <float.h>
+#include <algorithm>
+
+/* ==========================================
+	Struct Bounds
+
+	Axis-aligned bounding box in single precision.
+
+   ========================================== */
+
+struct Bounds {
+	float min[ 3 ];
+	float max[ 3 ];
+
+	Bounds() { clear(); }
+
+	void clear() {
+		min[ 0 ] = min[ 1 ] = min[ 2 ] = FLT_MAX;
+		max[ 0 ] = max[ 1 ] = max[ 2 ] = -FLT_MAX;
+	}
+
+	bool empty() const { return min[ 0 ] > max[ 0 ] || min[ 1 ] > max[ 1 ] || min[ 2 ] > max[ 2 ]; }
+
+	void expand( const float* p ) {
+		for( int axis = 0; axis < 3; axis++ ) {
+			min[ axis ] = std::min( min[ axis ], p[ axis ] );
+			max[ axis ] = std::max( max[ axis ], p[ axis ] );
+		}
+	}
+
+	void expand( const Bounds& other ) {
+		for( int axis = 0; axis < 3; axis++ ) {
+			min[ axis ] = std::min( min[ axis ], other.min[ axis ] );
+			max[ axis ] = std::max( max[ axis ], other.max[ axis ] );
+		}
+	}
+
+	float size( int axis ) const { return max[ axis ] - min[ axis ]; }
+	float center( int axis ) const { return 0.5f * ( min[ axis ] + max[ axis ] ); }
+	float volume() const { return empty() ? 0.0f : size( 0 ) * size( 1 ) * size( 2 ); }
+
+	int longestAxis() const {
+		int axis = size( 0 ) > size( 1 ) ? 0 : 1;
+		return size( axis ) > size( 2 ) ? axis : 2;
+	}
+
+	// surface area, used by the SAH when building hierarchies
+	float area() const {
+		if ( empty() ) return 0.0f;
+		const float w = size( 0 ), h = size( 1 ), d = size( 2 );
+		return 2.0f * ( w * h + w * d + h * d );
+	}
+};
@@ -0,0 +1,254 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "ChordSampler.h"
+#include "Random.h"
+#include "Trace.h"
+
+#include <math.h>
+#include <algorithm>
+#include <thread>
+
+namespace {
+	// seed of the positions of the rays within their cells
+	const uint64_t JITTER_SEED = 0x9E3779B97F4A7C15ULL;
+
+	// layered depth image along one axis: the sorted crossings of the ray
+	// through each cell
+	struct Layer {
+		int							axis;
+		int							width, height;	// cells along (axis + 1) % 3 and (axis + 2) % 3
+		float						origin[ 2 ];	// corner of the first cell
+		std::vector< float >		jitter;			// ray of each cell from its center, in cells within +-0.5
+		std::vector< unsigned int >	offsets;		// first crossing of each cell, width * height + 1
+		std::vector< float >		depths;
+		long long					rays, missed, chords;
+	};
+
+	// twice the signed area of (a, b, p). Shared edges are evaluated with
+	// their endpoints in the same order from either triangle, so that the
+	// result is exactly the same up to the sign.
+	inline double edgeFunction( const double* a, const double* b, const double* p ) {
+		if ( a[ 0 ] > b[ 0 ] || ( a[ 0 ] == b[ 0 ] && a[ 1 ] > b[ 1 ] ) ) {
+			return -edgeFunction( b, a, p );
+		}
+		return ( b[ 0 ] - a[ 0 ] ) * ( p[ 1 ] - a[ 1 ] ) - ( b[ 1 ] - a[ 1 ] ) * ( p[ 0 ] - a[ 0 ] );
+	}
+
+	// whether points exactly on the edge a -> b of a counterclockwise
+	// triangle belong to it. Reversing the edge flips the answer, so a ray
+	// through an edge shared by two triangles crosses only one of them.
+	inline bool ownsEdge( const double* a, const double* b ) {
+		const double dx = b[ 0 ] - a[ 0 ], dy = b[ 1 ] - a[ 1 ];
+		return dy > 0 || ( dy == 0 && dx < 0 );
+	}
+
+	// calls visit( cell, depth ) for every cell whose ray the projection of
+	// a triangle covers
+	template< typename Visitor >
+	void rasterize( const MeshView& mesh, const Layer& layer, float cellSize, Visitor& visit ) {
+		const int u = ( layer.axis + 1 ) % 3, v = ( layer.axis + 2 ) % 3;
+		for( size_t t = 0; t < mesh.numTriangles; t++ ) {
+			const int* triangle = mesh.triangle( t );
+			double p[ 3 ][ 2 ], depth[ 3 ];
+			for( int corner = 0; corner < 3; corner++ ) {
+				const float* point = mesh.point( triangle[ corner ] );
+				// in cell units, with cell centers at integer coordinates
+				p[ corner ][ 0 ] = ( point[ u ] - layer.origin[ 0 ] ) / cellSize - 0.5;
+				p[ corner ][ 1 ] = ( point[ v ] - layer.origin[ 1 ] ) / cellSize - 0.5;
+				depth[ corner ] = point[ layer.axis ];
+			}
+			const double area = edgeFunction( p[ 0 ], p[ 1 ], p[ 2 ] );
+			if ( area == 0 ) continue; // parallel to the rays
+			if ( area < 0 ) {
+				std::swap( p[ 1 ][ 0 ], p[ 2 ][ 0 ] );
+				std::swap( p[ 1 ][ 1 ], p[ 2 ][ 1 ] );
+				std::swap( depth[ 1 ], depth[ 2 ] );
+			}
+			const bool owns[ 3 ] = { ownsEdge( p[ 1 ], p[ 2 ] ), ownsEdge( p[ 2 ], p[ 0 ] ), ownsEdge( p[ 0 ], p[ 1 ] ) };
+
+			// the ray of a cell is within half a cell of its center
+			const int x0 = std::max( 0, (int)floor( std::min( p[ 0 ][ 0 ], std::min( p[ 1 ][ 0 ], p[ 2 ][ 0 ] ) ) - 0.5 ) );
+			const int x1 = std::min( layer.width - 1, (int)ceil( std::max( p[ 0 ][ 0 ], std::max( p[ 1 ][ 0 ], p[ 2 ][ 0 ] ) ) + 0.5 ) );
+			const int y0 = std::max( 0, (int)floor( std::min( p[ 0 ][ 1 ], std::min( p[ 1 ][ 1 ], p[ 2 ][ 1 ] ) ) - 0.5 ) );
+			const int y1 = std::min( layer.height - 1, (int)ceil( std::max( p[ 0 ][ 1 ], std::max( p[ 1 ][ 1 ], p[ 2 ][ 1 ] ) ) + 0.5 ) );
+			for( int y = y0; y <= y1; y++ ) {
+				for( int x = x0; x <= x1; x++ ) {
+					const size_t cell = (size_t)y * layer.width + x;
+					const double ray[ 2 ] = { x + layer.jitter[ 2 * cell ], y + layer.jitter[ 2 * cell + 1 ] };
+					const double w[ 3 ] = { edgeFunction( p[ 1 ], p[ 2 ], ray ),
+											edgeFunction( p[ 2 ], p[ 0 ], ray ),
+											edgeFunction( p[ 0 ], p[ 1 ], ray ) };
+					bool inside = true;
+					for( int e = 0; e < 3 && inside; e++ ) {
+						inside = w[ e ] > 0 || ( w[ e ] == 0 && owns[ e ] );
+					}
+					if ( !inside ) continue;
+					const double sum = w[ 0 ] + w[ 1 ] + w[ 2 ];
+					visit( y * layer.width + x, (float)( ( w[ 0 ] * depth[ 0 ] + w[ 1 ] * depth[ 1 ] + w[ 2 ] * depth[ 2 ] ) / sum ) );
+				}
+			}
+		}
+	}
+
+	struct CountCrossings {
+		std::vector< unsigned int >& counts;
+		explicit CountCrossings( std::vector< unsigned int >& c ) : counts( c ) {}
+		void operator()( int cell, float ) { counts[ cell ]++; }
+	};
+
+	struct StoreCrossings {
+		std::vector< unsigned int >& cursors;
+		std::vector< float >& depths;
+		StoreCrossings( std::vector< unsigned int >& c, std::vector< float >& d ) : cursors( c ), depths( d ) {}
+		void operator()( int cell, float depth ) { depths[ cursors[ cell ]++ ] = depth; }
+	};
+
+	void buildLayer( const MeshView& mesh, float cellSize, Layer& layer ) {
+		TRACE_SCOPE( "ChordSampler::buildLayer" );
+		const size_t numCells = (size_t)layer.width * layer.height;
+
+		// a random ray in every cell, so that together they cover the cells
+		// evenly
+		Random rng( JITTER_SEED + layer.axis );
+		layer.jitter.resize( 2 * numCells );
+		for( size_t i = 0; i < layer.jitter.size(); i++ ) {
+			layer.jitter[ i ] = rng.nextFloat() - 0.5f;
+		}
+
+		// the crossings are counted first, so that they can be stored in a
+		// single array
+		layer.offsets.assign( numCells + 1, 0 );
+		CountCrossings count( layer.offsets );
+		rasterize( mesh, layer, cellSize, count );
+		unsigned int total = 0;
+		for( size_t i = 0; i <= numCells; i++ ) {
+			const unsigned int n = layer.offsets[ i ];
+			layer.offsets[ i ] = total;
+			total += n;
+		}
+
+		layer.depths.resize( total );
+		std::vector< unsigned int > cursors( layer.offsets.begin(), layer.offsets.end() - 1 );
+		StoreCrossings store( cursors, layer.depths );
+		rasterize( mesh, layer, cellSize, store );
+
+		layer.rays = (long long)numCells;
+		layer.missed = layer.chords = 0;
+		for( size_t i = 0; i < numCells; i++ ) {
+			float* first = layer.depths.empty() ? NULL : &layer.depths[ 0 ] + layer.offsets[ i ];
+			const unsigned int n = layer.offsets[ i + 1 ] - layer.offsets[ i ];
+			std::sort( first, first + n );
+			if ( n < 2 || ( n & 1 ) ) {
+				// rays grazing the surface, or through holes in it, can't be
+				// split into chords
+				layer.missed++;
+			} else {
+				layer.chords += n / 2;
+			}
+		}
+	}
+}
+
+void ChordSampler::setMesh( const MeshView& mesh, int resolution, SamplerStats* stats ) {
+	TRACE_SCOPE( "ChordSampler::setMesh" );
+	chords.clear();
+	table.clear();
+	cellSize = 0;
+
+	const Bounds bounds = mesh.bounds();
+	if ( bounds.empty() || resolution <= 0 ) return;
+	const float longest = bounds.size( bounds.longestAxis() );
+	if ( longest <= 0 ) return;
+	cellSize = longest / resolution;
+
+	// the layers are independent, and built in parallel
+	Layer layers[ 3 ];
+	std::vector< std::thread > workers;
+	for( int axis = 0; axis < 3; axis++ ) {
+		Layer& layer = layers[ axis ];
+		layer.axis = axis;
+		for( int i = 0; i < 2; i++ ) {
+			const int lateral = ( axis + 1 + i ) % 3;
+			const int cells = std::max( 1, (int)ceilf( bounds.size( lateral ) / cellSize ) );
+			// centered on the bounds
+			layer.origin[ i ] = bounds.center( lateral ) - 0.5f * cells * cellSize;
+			( i == 0 ? layer.width : layer.height ) = cells;
+		}
+		workers.push_back( std::thread( buildLayer, std::cref( mesh ), cellSize, std::ref( layer ) ) );
+	}
+	for( int axis = 0; axis < 3; axis++ ) {
+		workers[ axis ].join();
+	}
+
+	size_t numChords = 0;
+	for( int axis = 0; axis < 3; axis++ ) {
+		numChords += (size_t)layers[ axis ].chords;
+	}
+	chords.reserve( numChords );
+	std::vector< float > lengths;
+	lengths.reserve( numChords );
+	for( int axis = 0; axis < 3; axis++ ) {
+		const Layer& layer = layers[ axis ];
+		for( int y = 0; y < layer.height; y++ ) {
+			for( int x = 0; x < layer.width; x++ ) {
+				const size_t cell = (size_t)y * layer.width + x;
+				const unsigned int first = layer.offsets[ cell ], n = layer.offsets[ cell + 1 ] - first;
+				if ( n < 2 || ( n & 1 ) ) continue;
+				for( unsigned int i = 0; i < n; i += 2 ) {
+					Chord chord;
+					chord.start = layer.depths[ first + i ];
+					chord.length = layer.depths[ first + i + 1 ] - chord.start;
+					chord.ray[ 0 ] = layer.origin[ 0 ] + ( x + 0.5f + layer.jitter[ 2 * cell ] ) * cellSize;
+					chord.ray[ 1 ] = layer.origin[ 1 ] + ( y + 0.5f + layer.jitter[ 2 * cell + 1 ] ) * cellSize;
+					chord.axis = axis;
+					chords.push_back( chord );
+					lengths.push_back( chord.length );
+				}
+			}
+		}
+		if ( stats ) {
+			stats->raysCast += layer.rays;
+			stats->raysMissed += layer.missed;
+			stats->chords += layer.chords;
+		}
+	}
+
+	// all the cells have the same section, so the volume around each chord
+	// is proportional to its length
+	if ( !lengths.empty() ) {
+		table.build( &lengths[ 0 ], lengths.size() );
+	}
+}
+
+double ChordSampler::volume() const {
+	double length = 0;
+	for( size_t i = 0; i < chords.size(); i++ ) {
+		length += chords[ i ].length;
+	}
+	// every axis covers the whole volume
+	return length * cellSize * cellSize / 3.0;
+}
+
+bool ChordSampler::Sample( int numSamples, Random& rng, std::vector< float >& samples, SamplerStats* stats ) const {
+	TRACE_SCOPE( "ChordSampler::Sample" );
+	if ( stats ) stats->samplesRequested += std::max( 0, numSamples );
+	if ( numSamples <= 0 || chords.empty() ) return false;
+
+	const size_t first = samples.size();
+	samples.resize( first + 3 * (size_t)numSamples );
+	float* out = &samples[ first ];
+	for( int i = 0; i < numSamples; i++, out += 3 ) {
+		const Chord& chord = chords[ table.sample( rng ) ];
+		const int u = ( chord.axis + 1 ) % 3, v = ( chord.axis + 2 ) % 3;
+		out[ chord.axis ] = chord.start + rng.nextFloat() * chord.length;
+		out[ u ] = chord.ray[ 0 ];
+		out[ v ] = chord.ray[ 1 ];
+	}
+	if ( stats ) stats->samplesProduced += numSamples;
+	return true;
+}
@@ -0,0 +1,73 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+#include "AliasTable.h"
+#include "Random.h"
+#include "SamplerStats.h"
+
+#include <vector>
+
+/* ==========================================
+	Class ChordSampler
+
+	Volume sampler over axis-aligned chords. Rays are cast
+	along X, Y and Z through a grid of square cells covering
+	the mesh bounds, one through a random point of each cell,
+	and the crossings of each ray with the mesh are gathered
+	into a layered depth image per axis. Rather than
+	intersecting each ray with the whole mesh, every triangle
+	is rasterized into the cells its projection covers, as a
+	GPU would, so building the images costs about as much as
+	reading the mesh once per axis.
+
+	The crossings are paired into chords once, by setMesh.
+	Samples are then drawn from them in constant time: a chord
+	is picked in proportion to its length, and the sample is
+	placed uniformly along it. Samples always lie on a chord,
+	so they are inside the mesh. The rays are jittered with a
+	fixed seed, so the chords only depend on the mesh and the
+	resolution.
+
+   ========================================== */
+
+class ChordSampler {
+public:
+	enum {
+		DEFAULT_RESOLUTION = 128
+	};
+
+					ChordSampler() : cellSize( 0 ) {}
+
+	// builds the chords of 'mesh' on a grid of 'resolution' cells along the
+	// longest side of its bounds. The rays cast and the chords found are
+	// added to 'stats' if given.
+	void			setMesh( const MeshView& mesh, int resolution, SamplerStats* stats = NULL );
+
+	size_t			numChords() const { return chords.size(); }
+
+	// volume of the mesh estimated from its chords
+	double			volume() const;
+
+	// appends 'numSamples' xyz samples. Returns false if no chord was found.
+	// Sample counts are added to 'stats' if given.
+	bool			Sample( int numSamples, Random& rng, std::vector< float >& samples, SamplerStats* stats = NULL ) const;
+
+private:
+	struct Chord {
+		float			start;		// along the axis of the ray
+		float			length;
+		float			ray[ 2 ];	// position of the ray, along the other two axes
+		int				axis;
+	};
+
+	std::vector< Chord >	chords;
+	AliasTable				table;
+	float					cellSize;
+};
@@ -0,0 +1,204 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "DistanceField.h"
+#include "TriangleDistance.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+namespace {
+	// sweeps along X, Y and Z done to propagate the closest triangles, each
+	// one forwards and backwards
+	const int SWEEP_ROUNDS = 3;
+
+	struct Builder {
+		const MeshView&			mesh;
+		int						res[ 3 ];
+		float					origin[ 3 ];	// center of the first voxel
+		float					voxelSize[ 3 ];
+		std::vector< float >&	distance;		// squared, until the sign is applied
+		std::vector< int >		closest;		// triangle, -1 if none was tried yet
+
+		Builder( const MeshView& mesh, const VoxelGrid& grid, std::vector< float >& distance ) : mesh( mesh ), distance( distance ) {
+			for( int axis = 0; axis < 3; axis++ ) {
+				res[ axis ] = grid.resolution( axis );
+				voxelSize[ axis ] = grid.voxelSize( axis );
+				origin[ axis ] = grid.bounds().min[ axis ] + 0.5f * voxelSize[ axis ];
+			}
+			const size_t count = (size_t)res[ 0 ] * res[ 1 ] * res[ 2 ];
+			distance.assign( count, FLT_MAX );
+			closest.assign( count, -1 );
+		}
+
+		size_t index( int x, int y, int z ) const { return ( (size_t)z * res[ 1 ] + y ) * res[ 0 ] + x; }
+
+		void center( int x, int y, int z, float* p ) const {
+			p[ 0 ] = origin[ 0 ] + x * voxelSize[ 0 ];
+			p[ 1 ] = origin[ 1 ] + y * voxelSize[ 1 ];
+			p[ 2 ] = origin[ 2 ] + z * voxelSize[ 2 ];
+		}
+
+		void tryTriangle( size_t voxel, const float* p, int t ) {
+			const int* tri = mesh.triangle( t );
+			const float d = TriangleDistanceSquared( p, mesh.point( tri[ 0 ] ), mesh.point( tri[ 1 ] ), mesh.point( tri[ 2 ] ) );
+			if ( d < distance[ voxel ] ) {
+				distance[ voxel ] = d;
+				closest[ voxel ] = t;
+			}
+		}
+
+		// exact distances from every triangle to the voxels within 'band' voxels
+		// of its bounds, for the slices [z0, z1)
+		void exactBand( int band, int z0, int z1 ) {
+			for( size_t t = 0; t < mesh.numTriangles; t++ ) {
+				const int* tri = mesh.triangle( t );
+				int lo[ 3 ], hi[ 3 ];
+				for( int axis = 0; axis < 3; axis++ ) {
+					float tmin = mesh.point( tri[ 0 ] )[ axis ], tmax = tmin;
+					for( int k = 1; k < 3; k++ ) {
+						tmin = std::min( tmin, mesh.point( tri[ k ] )[ axis ] );
+						tmax = std::max( tmax, mesh.point( tri[ k ] )[ axis ] );
+					}
+					lo[ axis ] = std::max( 0, (int)floorf( ( tmin - origin[ axis ] ) / voxelSize[ axis ] ) - band + 1 );
+					hi[ axis ] = std::min( res[ axis ] - 1, (int)floorf( ( tmax - origin[ axis ] ) / voxelSize[ axis ] ) + band );
+				}
+				lo[ 2 ] = std::max( lo[ 2 ], z0 );
+				hi[ 2 ] = std::min( hi[ 2 ], z1 - 1 );
+				float p[ 3 ];
+				for( int z = lo[ 2 ]; z <= hi[ 2 ]; z++ ) {
+					for( int y = lo[ 1 ]; y <= hi[ 1 ]; y++ ) {
+						for( int x = lo[ 0 ]; x <= hi[ 0 ]; x++ ) {
+							center( x, y, z, p );
+							tryTriangle( index( x, y, z ), p, (int)t );
+						}
+					}
+				}
+			}
+		}
+
+		// forward and backward sweeps along 'axis' of the rows [first, last),
+		// rows being numbered along the next axis and then the one after
+		void sweep( int axis, size_t first, size_t last ) {
+			const int u = ( axis + 1 ) % 3, v = ( axis + 2 ) % 3;
+			const int n = res[ axis ];
+			int coords[ 3 ];
+			float p[ 3 ];
+			for( size_t row = first; row < last; row++ ) {
+				coords[ u ] = (int)( row % res[ u ] );
+				coords[ v ] = (int)( row / res[ u ] );
+				for( int pass = 0; pass < 2; pass++ ) {
+					const int step = pass == 0 ? 1 : -1;
+					coords[ axis ] = pass == 0 ? 0 : n - 1;
+					size_t previous = index( coords[ 0 ], coords[ 1 ], coords[ 2 ] );
+					for( int i = 1; i < n; i++ ) {
+						coords[ axis ] += step;
+						const size_t voxel = index( coords[ 0 ], coords[ 1 ], coords[ 2 ] );
+						const int t = closest[ previous ];
+						if ( t >= 0 && t != closest[ voxel ] ) {
+							center( coords[ 0 ], coords[ 1 ], coords[ 2 ], p );
+							tryTriangle( voxel, p, t );
+						}
+						previous = voxel;
+					}
+				}
+			}
+		}
+	};
+}
+
+DistanceField::DistanceField() {
+	res[ 0 ] = res[ 1 ] = res[ 2 ] = 0;
+	voxelSize[ 0 ] = voxelSize[ 1 ] = voxelSize[ 2 ] = 0;
+}
+
+void DistanceField::clear() {
+	res[ 0 ] = res[ 1 ] = res[ 2 ] = 0;
+	box.clear();
+	values.clear();
+}
+
+void DistanceField::build( const MeshView& mesh, const VoxelGrid& grid, int band, int threads ) {
+	TRACE_SCOPE( "DistanceField::build" );
+	clear();
+	if ( grid.empty() || mesh.numTriangles == 0 ) return;
+	threads = WorkerThreads( threads );
+
+	for( int axis = 0; axis < 3; axis++ ) {
+		res[ axis ] = grid.resolution( axis );
+		voxelSize[ axis ] = grid.voxelSize( axis );
+	}
+	box = grid.bounds();
+
+	Builder builder( mesh, grid, values );
+
+	// exact distances next to the surface. Threads own slices along Z, so
+	// that no two of them write the same voxel.
+	const int exactBand = band > 0 ? band : 1;
+	{
+		TRACE_SCOPE( "DistanceField::exactBand" );
+		ParallelFor( res[ 2 ], threads, [ & ]( size_t begin, size_t end ) {
+			builder.exactBand( exactBand, (int)begin, (int)end );
+		} );
+	}
+
+	if ( band <= 0 ) {
+		TRACE_SCOPE( "DistanceField::sweep" );
+		for( int round = 0; round < SWEEP_ROUNDS; round++ ) {
+			for( int axis = 0; axis < 3; axis++ ) {
+				const size_t rows = (size_t)res[ ( axis + 1 ) % 3 ] * res[ ( axis + 2 ) % 3 ];
+				ParallelFor( rows, threads, [ & ]( size_t begin, size_t end ) {
+					builder.sweep( axis, begin, end );
+				} );
+			}
+		}
+	}
+
+	// voxels beyond the band are clamped to it
+	const float limit = band > 0 ? band * std::min( voxelSize[ 0 ], std::min( voxelSize[ 1 ], voxelSize[ 2 ] ) ) : FLT_MAX;
+	for( int z = 0; z < res[ 2 ]; z++ ) {
+		for( int y = 0; y < res[ 1 ]; y++ ) {
+			float* row = &values[ builder.index( 0, y, z ) ];
+			for( int x = 0; x < res[ 0 ]; x++ ) {
+				const float d = std::min( limit, sqrtf( row[ x ] ) );
+				row[ x ] = grid.get( x, y, z ) ? -d : d;
+			}
+		}
+	}
+}
+
+float DistanceField::sample( const float* p ) const {
+	int i0[ 3 ], i1[ 3 ];
+	float f[ 3 ];
+	for( int axis = 0; axis < 3; axis++ ) {
+		const float u = std::max( 0.0f, std::min( (float)( res[ axis ] - 1 ), ( p[ axis ] - box.min[ axis ] ) / voxelSize[ axis ] - 0.5f ) );
+		i0[ axis ] = std::min( (int)u, std::max( 0, res[ axis ] - 2 ) );
+		i1[ axis ] = std::min( i0[ axis ] + 1, res[ axis ] - 1 );
+		f[ axis ] = u - i0[ axis ];
+	}
+	const float c00 = at( i0[ 0 ], i0[ 1 ], i0[ 2 ] ) + f[ 0 ] * ( at( i1[ 0 ], i0[ 1 ], i0[ 2 ] ) - at( i0[ 0 ], i0[ 1 ], i0[ 2 ] ) );
+	const float c10 = at( i0[ 0 ], i1[ 1 ], i0[ 2 ] ) + f[ 0 ] * ( at( i1[ 0 ], i1[ 1 ], i0[ 2 ] ) - at( i0[ 0 ], i1[ 1 ], i0[ 2 ] ) );
+	const float c01 = at( i0[ 0 ], i0[ 1 ], i1[ 2 ] ) + f[ 0 ] * ( at( i1[ 0 ], i0[ 1 ], i1[ 2 ] ) - at( i0[ 0 ], i0[ 1 ], i1[ 2 ] ) );
+	const float c11 = at( i0[ 0 ], i1[ 1 ], i1[ 2 ] ) + f[ 0 ] * ( at( i1[ 0 ], i1[ 1 ], i1[ 2 ] ) - at( i0[ 0 ], i1[ 1 ], i1[ 2 ] ) );
+	const float c0 = c00 + f[ 1 ] * ( c10 - c00 );
+	const float c1 = c01 + f[ 1 ] * ( c11 - c01 );
+	return c0 + f[ 2 ] * ( c1 - c0 );
+}
+
+void DistanceField::sample( const float* points, size_t count, float* distances ) const {
+	TRACE_SCOPE( "DistanceField::sample" );
+	if ( empty() ) {
+		std::fill( distances, distances + count, 0.0f );
+		return;
+	}
+	for( size_t i = 0; i < count; i++ ) {
+		distances[ i ] = sample( points + 3 * i );
+	}
+}
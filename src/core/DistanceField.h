@@ -0,0 +1,70 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+#include "VoxelGrid.h"
+
+#include <vector>
+#include <stddef.h>
+
+/* ==========================================
+	Class DistanceField
+
+	Signed distance from the voxel centers of a VoxelGrid to
+	the surface of the mesh it was voxelized from, negative
+	inside. The sign is taken from the voxels themselves.
+
+	Distances are exact within a band around each triangle,
+	and then propagated to the rest of the grid by fast
+	sweeping along the axes: every voxel tries the closest
+	triangle of its neighbour in the direction of the sweep.
+	The rows of a sweep are independent, so they are split
+	among several threads.
+
+	A narrow band field only computes the distances within
+	'band' voxels of the surface, with no sweeps, and clamps
+	the rest to +-band voxels.
+
+   ========================================== */
+
+class DistanceField {
+public:
+	enum { DEFAULT_BAND = 3 };
+
+						DistanceField();
+
+	// computes the field on the voxel centers of 'grid', which has to be a
+	// voxelization of 'mesh'. If 'band' is not 0 only distances up to that
+	// many voxels are computed. Uses up to 'threads' threads (0 for all the cores).
+	void				build( const MeshView& mesh, const VoxelGrid& grid, int band = 0, int threads = 0 );
+	void				clear();
+
+	bool				empty() const { return values.empty(); }
+	int					resolution( int axis ) const { return res[ axis ]; }
+	const Bounds&		bounds() const { return box; }
+
+	// every value, along X then Y then Z
+	size_t				size() const { return values.size(); }
+	const float*		data() const { return values.empty() ? NULL : &values[ 0 ]; }
+
+	float				at( int x, int y, int z ) const { return values[ ( (size_t)z * res[ 1 ] + y ) * res[ 0 ] + x ]; }
+
+	// distance at 'p' interpolated between the closest voxel centers.
+	// Points outside the grid take the value of the closest voxel.
+	float				sample( const float* p ) const;
+
+	// 'count' xyz points to 'count' distances
+	void				sample( const float* points, size_t count, float* distances ) const;
+
+private:
+	int						res[ 3 ];
+	Bounds					box;
+	float					voxelSize[ 3 ];
+	std::vector< float >	values;
+};
@@ -0,0 +1,87 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Hash.h"
+
+#include <string.h>
+
+namespace {
+	const uint64_t PRIME1 = 11400714785074694791ULL;
+	const uint64_t PRIME2 = 14029467366897019727ULL;
+	const uint64_t PRIME3 = 1609587929392839161ULL;
+	const uint64_t PRIME4 = 9650029242287828579ULL;
+	const uint64_t PRIME5 = 2870177450012600261ULL;
+
+	inline uint64_t rotl( uint64_t x, int r ) { return ( x << r ) | ( x >> ( 64 - r ) ); }
+
+	// unaligned little-endian reads
+	inline uint64_t read64( const unsigned char* p ) { uint64_t v; memcpy( &v, p, sizeof( v ) ); return v; }
+	inline uint32_t read32( const unsigned char* p ) { uint32_t v; memcpy( &v, p, sizeof( v ) ); return v; }
+
+	inline uint64_t mixRound( uint64_t acc, uint64_t input ) {
+		acc += input * PRIME2;
+		acc = rotl( acc, 31 );
+		return acc * PRIME1;
+	}
+
+	inline uint64_t mergeRound( uint64_t acc, uint64_t value ) {
+		acc ^= mixRound( 0, value );
+		return acc * PRIME1 + PRIME4;
+	}
+}
+
+uint64_t Hash64( const void* data, size_t size, uint64_t seed ) {
+	const unsigned char* p = (const unsigned char*)data;
+	const unsigned char* end = p + size;
+	uint64_t h;
+
+	if ( size >= 32 ) {
+		uint64_t v1 = seed + PRIME1 + PRIME2;
+		uint64_t v2 = seed + PRIME2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - PRIME1;
+		const unsigned char* limit = end - 32;
+		do {
+			v1 = mixRound( v1, read64( p ) );
+			v2 = mixRound( v2, read64( p + 8 ) );
+			v3 = mixRound( v3, read64( p + 16 ) );
+			v4 = mixRound( v4, read64( p + 24 ) );
+			p += 32;
+		} while( p <= limit );
+
+		h = rotl( v1, 1 ) + rotl( v2, 7 ) + rotl( v3, 12 ) + rotl( v4, 18 );
+		h = mergeRound( h, v1 );
+		h = mergeRound( h, v2 );
+		h = mergeRound( h, v3 );
+		h = mergeRound( h, v4 );
+	} else {
+		h = seed + PRIME5;
+	}
+
+	h += (uint64_t)size;
+
+	for( ; p + 8 <= end; p += 8 ) {
+		h ^= mixRound( 0, read64( p ) );
+		h = rotl( h, 27 ) * PRIME1 + PRIME4;
+	}
+	if ( p + 4 <= end ) {
+		h ^= (uint64_t)read32( p ) * PRIME1;
+		h = rotl( h, 23 ) * PRIME2 + PRIME3;
+		p += 4;
+	}
+	for( ; p < end; p++ ) {
+		h ^= (*p) * PRIME5;
+		h = rotl( h, 11 ) * PRIME1;
+	}
+
+	h ^= h >> 33;
+	h *= PRIME2;
+	h ^= h >> 29;
+	h *= PRIME3;
+	h ^= h >> 32;
+	return h;
+}
@@ -0,0 +1,26 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ==========================================
+	Hash64
+
+	64-bit non-cryptographic hash (the XXH64 algorithm) used
+	to key cached results by the contents of their inputs.
+	Large buffers are consumed in four independent lanes, so
+	hashing runs close to memory bandwidth.
+
+	Several buffers are combined by passing the hash of the
+	previous one as the seed of the next.
+
+   ========================================== */
+
+uint64_t Hash64( const void* data, size_t size, uint64_t seed = 0 );
@@ -0,0 +1,87 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : base( NULL ), length( 0 ), file( INVALID_HANDLE_VALUE ), mapping( NULL ) {}
+
+bool MappedFile::open( const char* path ) {
+	close();
+	file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if ( file == INVALID_HANDLE_VALUE ) return false;
+
+	LARGE_INTEGER fileSize;
+	if ( !GetFileSizeEx( file, &fileSize ) || fileSize.QuadPart == 0 ) {
+		close();
+		return false;
+	}
+	mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( mapping == NULL ) {
+		close();
+		return false;
+	}
+	base = (const char*)MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if ( base == NULL ) {
+		close();
+		return false;
+	}
+	length = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::close() {
+	if ( base != NULL ) UnmapViewOfFile( base );
+	if ( mapping != NULL ) CloseHandle( mapping );
+	if ( file != INVALID_HANDLE_VALUE ) CloseHandle( file );
+	base = NULL;
+	length = 0;
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile() : base( NULL ), length( 0 ) {}
+
+bool MappedFile::open( const char* path ) {
+	close();
+	const int fd = ::open( path, O_RDONLY );
+	if ( fd < 0 ) return false;
+
+	struct stat st;
+	if ( fstat( fd, &st ) != 0 || st.st_size == 0 ) {
+		::close( fd );
+		return false;
+	}
+	// the mapping keeps its own reference to the file
+	void* address = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	::close( fd );
+	if ( address == MAP_FAILED ) return false;
+
+	base = (const char*)address;
+	length = (size_t)st.st_size;
+	return true;
+}
+
+void MappedFile::close() {
+	if ( base != NULL ) munmap( (void*)base, length );
+	base = NULL;
+	length = 0;
+}
+
+#endif
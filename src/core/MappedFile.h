@@ -0,0 +1,44 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+/* ==========================================
+	Class MappedFile
+
+	Read-only memory mapping of a whole file. Pages are
+	loaded by the OS on first access, so opening a large
+	file is cheap and only the parts actually read are
+	brought into memory.
+
+   ========================================== */
+
+class MappedFile {
+public:
+					MappedFile();
+					~MappedFile() { close(); }
+
+	bool			open( const char* path );
+	void			close();
+
+	bool			isOpen() const { return base != NULL; }
+	const char*		data() const { return base; }
+	size_t			size() const { return length; }
+
+private:
+					MappedFile( const MappedFile& ); // non-copyable
+	MappedFile&		operator=( const MappedFile& );
+
+	const char*		base;
+	size_t			length;
+#ifdef _WIN32
+	void*			file;
+	void*			mapping;
+#endif
+};
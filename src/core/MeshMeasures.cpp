@@ -0,0 +1,125 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "MeshMeasures.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define SAMPLER_MEASURES_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+	// fewer triangles than this per thread are not worth starting a thread for
+	const size_t MIN_TRIANGLES_PER_THREAD = 65536;
+	// triangles accumulated in single precision before adding them to the
+	// double precision totals
+	const size_t FLUSH_INTERVAL = 1024;
+
+	// six times the signed volume of the tetrahedron (apex, a, b, c), and twice
+	// the area of the triangle. Positions are relative to the apex.
+	inline void measureTriangle( const float* a, const float* b, const float* c, double& volume, double& area ) {
+		const double e1[ 3 ] = { b[ 0 ] - a[ 0 ], b[ 1 ] - a[ 1 ], b[ 2 ] - a[ 2 ] };
+		const double e2[ 3 ] = { c[ 0 ] - a[ 0 ], c[ 1 ] - a[ 1 ], c[ 2 ] - a[ 2 ] };
+		const double n[ 3 ] = { e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ],
+								e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ],
+								e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ] };
+		// a . ( b x c ) == a . ( ( b - a ) x ( c - a ) )
+		volume += a[ 0 ] * n[ 0 ] + a[ 1 ] * n[ 1 ] + a[ 2 ] * n[ 2 ];
+		area += sqrt( n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ] );
+	}
+
+	void measureRange( const MeshView& mesh, const float* apex, size_t begin, size_t end, MeshMeasures& result ) {
+		double volume = 0, area = 0;
+		size_t i = begin;
+
+#ifdef SAMPLER_MEASURES_SSE
+		// the corners of 4 triangles are gathered into one register per
+		// coordinate, then measured together
+		while( i + 4 <= end ) {
+			const size_t blockEnd = std::min( end, i + FLUSH_INTERVAL );
+			__m128 volumeSum = _mm_setzero_ps();
+			__m128 areaSum = _mm_setzero_ps();
+			for( ; i + 4 <= blockEnd; i += 4 ) {
+				float corners[ 9 ][ 4 ];
+				for( int k = 0; k < 4; k++ ) {
+					const int* triangle = mesh.triangle( i + k );
+					for( int corner = 0; corner < 3; corner++ ) {
+						const float* p = mesh.point( triangle[ corner ] );
+						corners[ 3 * corner + 0 ][ k ] = p[ 0 ] - apex[ 0 ];
+						corners[ 3 * corner + 1 ][ k ] = p[ 1 ] - apex[ 1 ];
+						corners[ 3 * corner + 2 ][ k ] = p[ 2 ] - apex[ 2 ];
+					}
+				}
+				const __m128 ax = _mm_loadu_ps( corners[ 0 ] ), ay = _mm_loadu_ps( corners[ 1 ] ), az = _mm_loadu_ps( corners[ 2 ] );
+				const __m128 e1x = _mm_sub_ps( _mm_loadu_ps( corners[ 3 ] ), ax );
+				const __m128 e1y = _mm_sub_ps( _mm_loadu_ps( corners[ 4 ] ), ay );
+				const __m128 e1z = _mm_sub_ps( _mm_loadu_ps( corners[ 5 ] ), az );
+				const __m128 e2x = _mm_sub_ps( _mm_loadu_ps( corners[ 6 ] ), ax );
+				const __m128 e2y = _mm_sub_ps( _mm_loadu_ps( corners[ 7 ] ), ay );
+				const __m128 e2z = _mm_sub_ps( _mm_loadu_ps( corners[ 8 ] ), az );
+				const __m128 nx = _mm_sub_ps( _mm_mul_ps( e1y, e2z ), _mm_mul_ps( e1z, e2y ) );
+				const __m128 ny = _mm_sub_ps( _mm_mul_ps( e1z, e2x ), _mm_mul_ps( e1x, e2z ) );
+				const __m128 nz = _mm_sub_ps( _mm_mul_ps( e1x, e2y ), _mm_mul_ps( e1y, e2x ) );
+				volumeSum = _mm_add_ps( volumeSum, _mm_add_ps( _mm_add_ps( _mm_mul_ps( ax, nx ), _mm_mul_ps( ay, ny ) ), _mm_mul_ps( az, nz ) ) );
+				areaSum = _mm_add_ps( areaSum, _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, nx ), _mm_mul_ps( ny, ny ) ), _mm_mul_ps( nz, nz ) ) ) );
+			}
+			float lanes[ 4 ];
+			_mm_storeu_ps( lanes, volumeSum );
+			volume += (double)lanes[ 0 ] + lanes[ 1 ] + lanes[ 2 ] + lanes[ 3 ];
+			_mm_storeu_ps( lanes, areaSum );
+			area += (double)lanes[ 0 ] + lanes[ 1 ] + lanes[ 2 ] + lanes[ 3 ];
+		}
+#endif
+
+		for( ; i < end; i++ ) {
+			const int* triangle = mesh.triangle( i );
+			float corners[ 3 ][ 3 ];
+			for( int corner = 0; corner < 3; corner++ ) {
+				const float* p = mesh.point( triangle[ corner ] );
+				for( int axis = 0; axis < 3; axis++ ) {
+					corners[ corner ][ axis ] = p[ axis ] - apex[ axis ];
+				}
+			}
+			measureTriangle( corners[ 0 ], corners[ 1 ], corners[ 2 ], volume, area );
+		}
+
+		result.volume = volume / 6.0;
+		result.area = area / 2.0;
+	}
+}
+
+MeshMeasures MeshMeasures::Compute( const MeshView& mesh, int threads ) {
+	TRACE_SCOPE( "MeshMeasures::Compute" );
+	MeshMeasures result;
+	if ( mesh.numTriangles == 0 ) return result;
+
+	// the apex of the tetrahedra is placed on the mesh rather than at the
+	// origin, so that meshes far from it don't lose precision
+	const float* apex = mesh.point( 0 );
+
+	const size_t numRanges = std::max( (size_t)1, std::min( (size_t)WorkerThreads( threads ), mesh.numTriangles / MIN_TRIANGLES_PER_THREAD ) );
+	if ( numRanges == 1 ) {
+		measureRange( mesh, apex, 0, mesh.numTriangles, result );
+		return result;
+	}
+
+	std::vector< MeshMeasures > partial( numRanges );
+	ParallelForRanges( mesh.numTriangles, (int)numRanges, [ & ]( size_t r, size_t begin, size_t end ) {
+		measureRange( mesh, apex, begin, end, partial[ r ] );
+	} );
+	for( size_t r = 0; r < numRanges; r++ ) {
+		result.volume += partial[ r ].volume;
+		result.area += partial[ r ].area;
+	}
+	return result;
+}
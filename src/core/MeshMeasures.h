@@ -0,0 +1,36 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+
+/* ==========================================
+	Struct MeshMeasures
+
+	Enclosed volume and surface area of a triangle mesh.
+
+	The volume is obtained by the divergence theorem, as the
+	sum of the signed volumes of the tetrahedra formed by
+	each triangle and a common apex. It is only meaningful
+	for closed meshes, and negative when their triangles
+	face inwards.
+
+	Triangles are measured 4 at a time with SSE, and large
+	meshes are split among several threads.
+
+   ========================================== */
+
+struct MeshMeasures {
+	double	volume;
+	double	area;
+
+	MeshMeasures() : volume( 0 ), area( 0 ) {}
+
+	// measures 'mesh' using up to 'threads' threads (0 for all the cores)
+	static MeshMeasures	Compute( const MeshView& mesh, int threads = 0 );
+};
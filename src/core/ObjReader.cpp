@@ -0,0 +1,112 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "ObjReader.h"
+#include "Trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+	inline const char* skipSpaces( const char* p, const char* end ) {
+		while( p < end && ( *p == ' ' || *p == '\t' || *p == '\r' ) ) p++;
+		return p;
+	}
+
+	inline const char* skipLine( const char* p, const char* end ) {
+		while( p < end && *p != '\n' ) p++;
+		return p < end ? p + 1 : p;
+	}
+
+	// parses a face vertex "v", "v/vt", "v//vn" or "v/vt/vn" and returns the
+	// position index, or 0 if there is none
+	inline long parseFaceVertex( const char*& p, const char* end ) {
+		char* next;
+		long index = strtol( p, &next, 10 );
+		if ( next == p ) return 0;
+		p = next;
+		while( p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' ) p++;
+		return index;
+	}
+
+	void setError( std::string* error, const char* message, int line ) {
+		if ( error == NULL ) return;
+		char buffer[ 128 ];
+		sprintf( buffer, "%s (line %d)", message, line );
+		*error = buffer;
+	}
+}
+
+bool ObjReader::Read( const char* path, TriangleMesh& mesh, std::string* error ) {
+	TRACE_SCOPE( "ObjReader::Read" );
+	mesh.clear();
+
+	FILE* f = fopen( path, "rb" );
+	if ( f == NULL ) {
+		if ( error ) *error = std::string( "can't open " ) + path;
+		return false;
+	}
+
+	std::vector< char > contents;
+	char buffer[ 1 << 16 ];
+	size_t read;
+	while( ( read = fread( buffer, 1, sizeof( buffer ), f ) ) > 0 ) {
+		contents.insert( contents.end(), buffer, buffer + read );
+	}
+	fclose( f );
+
+	// terminate the buffer so strtod/strtol never run past the end
+	contents.push_back( '\0' );
+	return Parse( &contents[ 0 ], &contents[ 0 ] + contents.size() - 1, mesh, error );
+}
+
+bool ObjReader::Parse( const char* begin, const char* end, TriangleMesh& mesh, std::string* error ) {
+	mesh.clear();
+
+	std::vector< int > polygon;
+	int line = 1;
+	for( const char* p = begin; p < end; p = skipLine( p, end ), line++ ) {
+		p = skipSpaces( p, end );
+		if ( end - p < 2 || ( p[ 1 ] != ' ' && p[ 1 ] != '\t' ) ) continue;
+
+		if ( p[ 0 ] == 'v' ) {
+			p += 2;
+			for( int axis = 0; axis < 3; axis++ ) {
+				char* next;
+				const float value = (float)strtod( p, &next );
+				if ( next == p ) {
+					setError( error, "malformed vertex", line );
+					mesh.clear();
+					return false;
+				}
+				mesh.points.push_back( value );
+				p = next;
+			}
+		} else if ( p[ 0 ] == 'f' ) {
+			p += 2;
+			polygon.clear();
+			const long numPoints = (long)mesh.numPoints();
+			for( p = skipSpaces( p, end ); p < end && *p != '\n'; p = skipSpaces( p, end ) ) {
+				long index = parseFaceVertex( p, end );
+				if ( index < 0 ) index += numPoints + 1; // relative to the last vertex
+				if ( index <= 0 || index > numPoints ) {
+					setError( error, "invalid face index", line );
+					mesh.clear();
+					return false;
+				}
+				polygon.push_back( (int)( index - 1 ) );
+			}
+			for( size_t i = 2; i < polygon.size(); i++ ) {
+				mesh.triangles.push_back( polygon[ 0 ] );
+				mesh.triangles.push_back( polygon[ i - 1 ] );
+				mesh.triangles.push_back( polygon[ i ] );
+			}
+		}
+	}
+	return true;
+}
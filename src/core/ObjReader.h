@@ -0,0 +1,31 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+
+#include <string>
+
+/* ==========================================
+	Class ObjReader
+
+	Minimal Wavefront OBJ loader for the standalone tools.
+	Only vertex positions and faces are read; polygons are
+	triangulated as fans, and texture/normal indices, groups
+	and materials are ignored.
+
+   ========================================== */
+
+class ObjReader {
+public:
+	// returns false and fills 'error' (if given) when the file can't be read
+	static bool		Read( const char* path, TriangleMesh& mesh, std::string* error = NULL );
+
+	// parses an OBJ file already loaded in memory
+	static bool		Parse( const char* begin, const char* end, TriangleMesh& mesh, std::string* error = NULL );
+};
@@ -0,0 +1,38 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+int WorkerThreads( int threads ) {
+	if ( threads > 0 ) return threads;
+	return std::max( 1, (int)std::thread::hardware_concurrency() );
+}
+
+size_t NumRanges( size_t count, int threads ) {
+	return std::max( (size_t)1, std::min( (size_t)std::max( 1, threads ), count ) );
+}
+
+void ParallelFor( size_t count, int threads, const std::function< void( size_t, size_t ) >& task ) {
+	ParallelForRanges( count, threads, [ &task ]( size_t, size_t begin, size_t end ) { task( begin, end ); } );
+}
+
+void ParallelForRanges( size_t count, int threads, const std::function< void( size_t, size_t, size_t ) >& task ) {
+	const size_t numRanges = NumRanges( count, threads );
+	const size_t rangeSize = ( count + numRanges - 1 ) / numRanges;
+	std::vector< std::thread > workers;
+	for( size_t r = 1; r < numRanges; r++ ) {
+		workers.push_back( std::thread( task, r, std::min( count, r * rangeSize ), std::min( count, ( r + 1 ) * rangeSize ) ) );
+	}
+	task( 0, 0, std::min( count, rangeSize ) );
+	for( size_t i = 0; i < workers.size(); i++ ) {
+		workers[ i ].join();
+	}
+}
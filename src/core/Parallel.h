@@ -0,0 +1,36 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <functional>
+#include <stddef.h>
+
+/* ==========================================
+	Parallel loops
+
+	The passes of the core library over voxels, points or
+	triangles are split into contiguous ranges of about the
+	same size, one per thread, the calling thread running the
+	first one. Threads are started for every loop, with no
+	pool, so loops are kept coarse: a pass over a whole grid
+	or point set rather than over each of its rows.
+
+   ========================================== */
+
+// the threads to use when asked for 'threads', 0 or less meaning all the cores
+int		WorkerThreads( int threads );
+
+// the ranges ParallelFor splits 'count' items into
+size_t	NumRanges( size_t count, int threads );
+
+// runs 'task' over [0, count) split in up to 'threads' ranges
+void	ParallelFor( size_t count, int threads, const std::function< void( size_t, size_t ) >& task );
+
+// same, also passing 'task' the index of each range, below NumRanges,
+// e.g. to gather partial results per range
+void	ParallelForRanges( size_t count, int threads, const std::function< void( size_t, size_t, size_t ) >& task );
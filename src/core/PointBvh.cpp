@@ -0,0 +1,211 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "PointBvh.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <float.h>
+#include <assert.h>
+
+namespace {
+	// spreads the lower 10 bits of v so that there are two zero bits between each
+	inline unsigned int expandBits( unsigned int v ) {
+		v = ( v * 0x00010001u ) & 0xFF0000FFu;
+		v = ( v * 0x00000101u ) & 0x0F00F00Fu;
+		v = ( v * 0x00000011u ) & 0xC30C30C3u;
+		v = ( v * 0x00000005u ) & 0x49249249u;
+		return v;
+	}
+}
+
+void PointBvh::clear() {
+	nodes.clear();
+	indices.clear();
+	positions.clear();
+}
+
+void PointBvh::build( const float* points, size_t numPoints ) {
+	TRACE_SCOPE( "PointBvh::build" );
+	clear();
+	if ( points == NULL || numPoints == 0 ) return;
+
+	// Rather than partitioning the points at each level, sort them once along
+	// a Morton curve and split the sorted range in halves: nodes end up just
+	// as spatially coherent, and the build becomes a couple of linear passes.
+
+	float bbMin[ 3 ] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float bbMax[ 3 ] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for( size_t i = 0; i < numPoints; i++ ) {
+		for( int axis = 0; axis < 3; axis++ ) {
+			bbMin[ axis ] = std::min( bbMin[ axis ], points[ 3 * i + axis ] );
+			bbMax[ axis ] = std::max( bbMax[ axis ], points[ 3 * i + axis ] );
+		}
+	}
+	float scale[ 3 ];
+	for( int axis = 0; axis < 3; axis++ ) {
+		const float extent = bbMax[ axis ] - bbMin[ axis ];
+		scale[ axis ] = extent > 0 ? 1023.0f / extent : 0.0f;
+	}
+
+	std::vector< unsigned int > codes( numPoints );
+	indices.resize( numPoints );
+	for( size_t i = 0; i < numPoints; i++ ) {
+		const float* p = points + 3 * i;
+		unsigned int code = 0;
+		for( int axis = 0; axis < 3; axis++ ) {
+			code |= expandBits( (unsigned int)( ( p[ axis ] - bbMin[ axis ] ) * scale[ axis ] ) ) << ( 2 - axis );
+		}
+		codes[ i ] = code;
+		indices[ i ] = (unsigned int)i;
+	}
+
+	{ // LSD radix sort of the (code, index) pairs, 3 passes of 10 bits
+		std::vector< unsigned int > tmpCodes( numPoints ), tmpIndices( numPoints );
+		for( int shift = 0; shift < 30; shift += 10 ) {
+			size_t offsets[ 1024 + 1 ] = { 0 };
+			for( size_t i = 0; i < numPoints; i++ ) {
+				offsets[ ( ( codes[ i ] >> shift ) & 1023 ) + 1 ]++;
+			}
+			for( int i = 0; i < 1024; i++ ) {
+				offsets[ i + 1 ] += offsets[ i ];
+			}
+			for( size_t i = 0; i < numPoints; i++ ) {
+				const size_t dst = offsets[ ( codes[ i ] >> shift ) & 1023 ]++;
+				tmpCodes[ dst ] = codes[ i ];
+				tmpIndices[ dst ] = indices[ i ];
+			}
+			codes.swap( tmpCodes );
+			indices.swap( tmpIndices );
+		}
+	}
+
+	// store the points in leaf order so queries traverse memory linearly
+	positions.resize( 3 * numPoints );
+	for( size_t i = 0; i < numPoints; i++ ) {
+		const float* p = points + 3 * indices[ i ];
+		positions[ 3 * i + 0 ] = p[ 0 ];
+		positions[ 3 * i + 1 ] = p[ 1 ];
+		positions[ 3 * i + 2 ] = p[ 2 ];
+	}
+
+	// splitting at the middle produces a balanced tree with about 2N / MAX_LEAF_POINTS nodes
+	nodes.reserve( 2 * ( numPoints / MAX_LEAF_POINTS + 1 ) );
+	buildRecursive( 0, (unsigned int)numPoints );
+}
+
+unsigned int PointBvh::buildRecursive( unsigned int begin, unsigned int end ) {
+	const unsigned int nodeIndex = (unsigned int)nodes.size();
+	nodes.push_back( Node() );
+
+	Node node;
+	if ( end - begin <= MAX_LEAF_POINTS ) {
+		node.bbMin[ 0 ] = node.bbMin[ 1 ] = node.bbMin[ 2 ] = FLT_MAX;
+		node.bbMax[ 0 ] = node.bbMax[ 1 ] = node.bbMax[ 2 ] = -FLT_MAX;
+		for( unsigned int i = begin; i < end; i++ ) {
+			const float* p = &positions[ 3 * i ];
+			for( int axis = 0; axis < 3; axis++ ) {
+				node.bbMin[ axis ] = std::min( node.bbMin[ axis ], p[ axis ] );
+				node.bbMax[ axis ] = std::max( node.bbMax[ axis ], p[ axis ] );
+			}
+		}
+		node.first = begin;
+		node.count = end - begin;
+		nodes[ nodeIndex ] = node;
+		return nodeIndex;
+	}
+
+	const unsigned int middle = begin + ( end - begin ) / 2;
+	const unsigned int left = buildRecursive( begin, middle ); // always nodeIndex + 1
+	const unsigned int right = buildRecursive( middle, end );
+	for( int axis = 0; axis < 3; axis++ ) {
+		node.bbMin[ axis ] = std::min( nodes[ left ].bbMin[ axis ], nodes[ right ].bbMin[ axis ] );
+		node.bbMax[ axis ] = std::max( nodes[ left ].bbMax[ axis ], nodes[ right ].bbMax[ axis ] );
+	}
+	node.first = right;
+	node.count = 0;
+	nodes[ nodeIndex ] = node;
+	return nodeIndex;
+}
+
+void PointBvh::queryPlanes( const float ( *planes )[ 4 ], int numPlanes, std::vector< int >& result ) const {
+	TRACE_SCOPE( "PointBvh::queryPlanes" );
+	if ( nodes.empty() ) return;
+	assert( numPlanes <= 32 );
+
+	// each stack entry carries the mask of the planes the node still needs to
+	// be tested against: once a node is fully inside a plane, so are its children
+	struct Entry { unsigned int node; unsigned int planeMask; };
+	Entry stack[ 64 ];
+	int stackSize = 0;
+	stack[ stackSize ].node = 0;
+	stack[ stackSize ].planeMask = numPlanes == 32 ? 0xFFFFFFFF : ( 1U << numPlanes ) - 1;
+	stackSize++;
+
+	while( stackSize > 0 ) {
+		const Entry entry = stack[ --stackSize ];
+		const Node& node = nodes[ entry.node ];
+
+		unsigned int planeMask = entry.planeMask;
+		bool culled = false;
+		for( int i = 0; i < numPlanes && !culled; i++ ) {
+			if ( ( planeMask & ( 1U << i ) ) == 0 ) continue;
+			const float* plane = planes[ i ];
+			// distances of the box corners closest and farthest along the plane normal
+			float nearest = plane[ 3 ], farthest = plane[ 3 ];
+			for( int axis = 0; axis < 3; axis++ ) {
+				if ( plane[ axis ] >= 0 ) {
+					nearest += plane[ axis ] * node.bbMin[ axis ];
+					farthest += plane[ axis ] * node.bbMax[ axis ];
+				} else {
+					nearest += plane[ axis ] * node.bbMax[ axis ];
+					farthest += plane[ axis ] * node.bbMin[ axis ];
+				}
+			}
+			if ( farthest < 0 ) {
+				culled = true;
+			} else if ( nearest >= 0 ) {
+				planeMask &= ~( 1U << i );
+			}
+		}
+		if ( culled ) continue;
+
+		if ( planeMask == 0 ) {
+			// the whole subtree is inside: its points form a contiguous range
+			unsigned int last = entry.node;
+			while( nodes[ last ].count == 0 ) last = nodes[ last ].first;
+			unsigned int first = entry.node;
+			while( nodes[ first ].count == 0 ) first = first + 1;
+			for( unsigned int i = nodes[ first ].first; i < nodes[ last ].first + nodes[ last ].count; i++ ) {
+				result.push_back( (int)indices[ i ] );
+			}
+			continue;
+		}
+
+		if ( node.count > 0 ) {
+			for( unsigned int i = node.first; i < node.first + node.count; i++ ) {
+				const float* p = &positions[ 3 * i ];
+				bool inside = true;
+				for( int j = 0; j < numPlanes && inside; j++ ) {
+					if ( ( planeMask & ( 1U << j ) ) == 0 ) continue;
+					const float* plane = planes[ j ];
+					inside = plane[ 0 ] * p[ 0 ] + plane[ 1 ] * p[ 1 ] + plane[ 2 ] * p[ 2 ] + plane[ 3 ] >= 0;
+				}
+				if ( inside ) result.push_back( (int)indices[ i ] );
+			}
+			continue;
+		}
+
+		assert( stackSize + 2 <= 64 );
+		stack[ stackSize ].node = node.first;
+		stack[ stackSize ].planeMask = planeMask;
+		stackSize++;
+		stack[ stackSize ].node = entry.node + 1;
+		stack[ stackSize ].planeMask = planeMask;
+		stackSize++;
+	}
+}
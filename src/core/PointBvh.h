@@ -0,0 +1,57 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+
+/* ==========================================
+	Class PointBvh
+
+	Bounding volume hierarchy over a set of points, used to
+	resolve component selection on the preview shapes without
+	testing every sample against the selection region.
+
+	Nodes are laid out in depth-first order: the left child of
+	an inner node immediately follows it, and the right child
+	is found through its index. Leaves reference a contiguous
+	range of the reordered points.
+
+   ========================================== */
+
+class PointBvh {
+public:
+	PointBvh() {}
+
+	// builds the hierarchy over 'numPoints' xyz float triplets
+	void			build( const float* points, size_t numPoints );
+	void			clear();
+	bool			empty() const { return nodes.empty(); }
+
+	// Collects the original index of every point lying on the positive side
+	// of all the given planes (a * x + b * y + c * z + d >= 0). Subtrees fully
+	// inside the region are accepted without testing their points, and those
+	// fully outside any plane are culled.
+	void			queryPlanes( const float ( *planes )[ 4 ], int numPlanes, std::vector< int >& result ) const;
+
+private:
+	struct Node {
+		float			bbMin[ 3 ];
+		float			bbMax[ 3 ];
+		unsigned int	first;	// leaves: first point. Inner nodes: right child
+		unsigned int	count;	// number of points, 0 for inner nodes
+	};
+
+	enum { MAX_LEAF_POINTS = 16 };
+
+	unsigned int	buildRecursive( unsigned int begin, unsigned int end );
+
+	std::vector< Node >			nodes;
+	std::vector< unsigned int >	indices;	// original point index, in leaf order
+	std::vector< float >		positions;	// points reordered to match 'indices'
+};
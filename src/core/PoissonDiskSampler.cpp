@@ -0,0 +1,378 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "PoissonDiskSampler.h"
+#include "BitOps.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace {
+	// Background cells are distance / sqrt(3) wide, so they hold at most a
+	// sample, and the samples closer than the distance are within
+	// NEIGHBOUR_CELLS of each other. Tiles of the same phase are a tile
+	// apart, so they never see each other's cells.
+	const int NEIGHBOUR_CELLS = 2;
+	const int TILE_CELLS = 8;
+
+	// slices of cells kept: the layer of tiles being filled, the previous
+	// one and the padding around them
+	const int WINDOW_SLICES = 2 * TILE_CELLS + 2 * NEIGHBOUR_CELLS;
+
+	// samples are stored in their cell quantized to 10 bits per axis
+	const int QUANTIZATION_BITS = 10;
+	const uint32_t QUANTIZATION_MASK = ( 1 << QUANTIZATION_BITS ) - 1;
+	const float QUANTIZATION_STEPS = (float)( 1 << QUANTIZATION_BITS );
+	const uint32_t EMPTY_CELL = 0xFFFFFFFF;
+
+	// candidates are tried between the distance and this much further
+	const float CANDIDATE_SPREAD = 0.1f;
+
+	// samples per cubed distance and unit volume once it is filled
+	const float FILL_DENSITY = 0.6f;
+
+	// offsets of the cells that may hold a sample closer than the distance,
+	// nearest first so that most candidates are rejected early. Only the
+	// corners of the 5x5x5 block are too far.
+	struct NeighbourOffsets {
+		int		offsets[ 125 ][ 3 ];
+		int		count;
+
+		NeighbourOffsets() : count( 0 ) {
+			for( int gap = 0; gap < 3; gap++ ) {
+				for( int z = -NEIGHBOUR_CELLS; z <= NEIGHBOUR_CELLS; z++ ) {
+					for( int y = -NEIGHBOUR_CELLS; y <= NEIGHBOUR_CELLS; y++ ) {
+						for( int x = -NEIGHBOUR_CELLS; x <= NEIGHBOUR_CELLS; x++ ) {
+							// squared gap between the cells, in cell sizes
+							const int d[ 3 ] = { std::max( 0, abs( x ) - 1 ), std::max( 0, abs( y ) - 1 ), std::max( 0, abs( z ) - 1 ) };
+							if ( d[ 0 ] * d[ 0 ] + d[ 1 ] * d[ 1 ] + d[ 2 ] * d[ 2 ] != gap || ( x == 0 && y == 0 && z == 0 ) ) continue;
+							offsets[ count ][ 0 ] = x;
+							offsets[ count ][ 1 ] = y;
+							offsets[ count ][ 2 ] = z;
+							count++;
+						}
+					}
+				}
+			}
+		}
+	};
+	const NeighbourOffsets neighbours;
+
+	struct Filler {
+		const VoxelGrid&		grid;
+		float					voxelSize[ 3 ];
+		float					distance;
+		float					cellSize;
+		float					invCellSize;
+		float					invVoxelSize[ 3 ];
+		int						res[ 3 ];			// cells
+		int						tiles[ 3 ];
+		int						tries;
+		uint64_t				seed;
+		std::vector< bool >		tileUsed;			// whether the tile overlaps any voxel
+		std::vector< uint32_t >	cells;				// EMPTY_CELL or the quantized sample, with
+													// NEIGHBOUR_CELLS of padding around
+		int						windowZ;			// z of the first slice of cells
+		size_t					stride[ 3 ];
+		ptrdiff_t				neighbourIndex[ 125 ];
+
+		Filler( const VoxelGrid& grid, float distance, uint64_t seed ) : grid( grid ), distance( distance ), tries( PoissonDiskSampler::DEFAULT_TRIES ), seed( seed ) {
+			cellSize = distance / sqrtf( 3.0f );
+			invCellSize = 1.0f / cellSize;
+			for( int axis = 0; axis < 3; axis++ ) {
+				voxelSize[ axis ] = grid.voxelSize( axis );
+				invVoxelSize[ axis ] = 1.0f / voxelSize[ axis ];
+				res[ axis ] = std::max( 1, (int)ceilf( grid.bounds().size( axis ) / cellSize ) );
+				tiles[ axis ] = ( res[ axis ] + TILE_CELLS - 1 ) / TILE_CELLS;
+			}
+			stride[ 0 ] = 1;
+			stride[ 1 ] = res[ 0 ] + 2 * NEIGHBOUR_CELLS;
+			stride[ 2 ] = stride[ 1 ] * ( res[ 1 ] + 2 * NEIGHBOUR_CELLS );
+			cells.assign( stride[ 2 ] * WINDOW_SLICES, EMPTY_CELL );
+			windowZ = -TILE_CELLS - NEIGHBOUR_CELLS;
+			for( int n = 0; n < neighbours.count; n++ ) {
+				neighbourIndex[ n ] = neighbours.offsets[ n ][ 0 ] + neighbours.offsets[ n ][ 1 ] * (ptrdiff_t)stride[ 1 ] + neighbours.offsets[ n ][ 2 ] * (ptrdiff_t)stride[ 2 ];
+			}
+			markTiles();
+		}
+
+		size_t cellIndex( int x, int y, int z ) const {
+			return ( x + NEIGHBOUR_CELLS ) + ( y + NEIGHBOUR_CELLS ) * stride[ 1 ] + ( z - windowZ ) * stride[ 2 ];
+		}
+
+		int cellCoord( int axis, float p ) const {
+			return std::max( 0, std::min( res[ axis ] - 1, (int)floorf( ( p - grid.bounds().min[ axis ] ) / cellSize ) ) );
+		}
+
+		size_t tileIndex( int tx, int ty, int tz ) const { return ( (size_t)tz * tiles[ 1 ] + ty ) * tiles[ 0 ] + tx; }
+
+		// only the tiles the occupied voxels overlap are filled
+		void markTiles() {
+			tileUsed.assign( (size_t)tiles[ 0 ] * tiles[ 1 ] * tiles[ 2 ], false );
+			const Bounds& bounds = grid.bounds();
+			for( int y = 0; y < grid.resY(); y++ ) {
+				for( int x = 0; x < grid.resX(); x++ ) {
+					const VoxelGrid::Word* column = grid.column( x, y );
+					for( int w = 0; w < grid.wordsPerColumn(); w++ ) {
+						if ( column[ w ] == 0 ) continue;
+						// the word is taken as a whole, from its lowest voxel up
+						const int z0 = w * VoxelGrid::BITS_PER_WORD + LowestBit( column[ w ] );
+						const int z1 = std::min( grid.resZ(), ( w + 1 ) * VoxelGrid::BITS_PER_WORD );
+						const int lo[ 3 ] = { cellCoord( 0, bounds.min[ 0 ] + x * voxelSize[ 0 ] ) / TILE_CELLS,
+											  cellCoord( 1, bounds.min[ 1 ] + y * voxelSize[ 1 ] ) / TILE_CELLS,
+											  cellCoord( 2, bounds.min[ 2 ] + z0 * voxelSize[ 2 ] ) / TILE_CELLS };
+						const int hi[ 3 ] = { cellCoord( 0, bounds.min[ 0 ] + ( x + 1 ) * voxelSize[ 0 ] ) / TILE_CELLS,
+											  cellCoord( 1, bounds.min[ 1 ] + ( y + 1 ) * voxelSize[ 1 ] ) / TILE_CELLS,
+											  cellCoord( 2, bounds.min[ 2 ] + z1 * voxelSize[ 2 ] ) / TILE_CELLS };
+						for( int tz = lo[ 2 ]; tz <= hi[ 2 ]; tz++ ) {
+							for( int ty = lo[ 1 ]; ty <= hi[ 1 ]; ty++ ) {
+								for( int tx = lo[ 0 ]; tx <= hi[ 0 ]; tx++ ) {
+									tileUsed[ tileIndex( tx, ty, tz ) ] = true;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// position within its cell of a quantized sample, in cell sizes
+		static void decode( uint32_t code, float* f ) {
+			for( int axis = 0; axis < 3; axis++ ) {
+				f[ axis ] = ( ( ( code >> ( axis * QUANTIZATION_BITS ) ) & QUANTIZATION_MASK ) + 0.5f ) * ( 1.0f / QUANTIZATION_STEPS );
+			}
+		}
+
+		bool insideVoxels( const float* p ) const {
+			int v[ 3 ];
+			for( int axis = 0; axis < 3; axis++ ) {
+				const float u = ( p[ axis ] - grid.bounds().min[ axis ] ) * invVoxelSize[ axis ];
+				if ( u < 0 ) return false;
+				v[ axis ] = (int)u;
+				if ( v[ axis ] >= grid.resolution( axis ) ) return false;
+			}
+			return grid.get( v[ 0 ], v[ 1 ], v[ 2 ] );
+		}
+
+		// Snaps 'p' to the position it would be stored at, and stores it if it
+		// lies in the cells [lo, hi), in the voxels and far enough from every
+		// other sample.
+		bool tryPoint( float* p, const int* lo, const int* hi ) {
+			int c[ 3 ];
+			uint32_t code = 0;
+			for( int axis = 0; axis < 3; axis++ ) {
+				const float u = ( p[ axis ] - grid.bounds().min[ axis ] ) * invCellSize;
+				if ( u < lo[ axis ] || u >= hi[ axis ] ) return false;
+				c[ axis ] = std::min( hi[ axis ] - 1, (int)u );
+				const uint32_t q = std::min( QUANTIZATION_MASK, (uint32_t)( ( u - c[ axis ] ) * QUANTIZATION_STEPS ) );
+				code |= q << ( axis * QUANTIZATION_BITS );
+			}
+			uint32_t* target = &cells[ cellIndex( c[ 0 ], c[ 1 ], c[ 2 ] ) ];
+			if ( *target != EMPTY_CELL ) return false;
+			float f[ 3 ];
+			decode( code, f );
+			for( int axis = 0; axis < 3; axis++ ) {
+				p[ axis ] = grid.bounds().min[ axis ] + ( c[ axis ] + f[ axis ] ) * cellSize;
+			}
+			if ( !insideVoxels( p ) ) return false;
+
+			// in cell sizes, the distance is sqrt(3)
+			for( int n = 0; n < neighbours.count; n++ ) {
+				const uint32_t neighbour = target[ neighbourIndex[ n ] ];
+				if ( neighbour == EMPTY_CELL ) continue;
+				float g[ 3 ];
+				decode( neighbour, g );
+				const float dx = neighbours.offsets[ n ][ 0 ] + g[ 0 ] - f[ 0 ];
+				const float dy = neighbours.offsets[ n ][ 1 ] + g[ 1 ] - f[ 1 ];
+				const float dz = neighbours.offsets[ n ][ 2 ] + g[ 2 ] - f[ 2 ];
+				if ( dx * dx + dy * dy + dz * dz < 3.0f ) return false;
+			}
+			*target = code;
+			return true;
+		}
+		// Throws a dart in every occupied voxel overlapping the tile, and grows
+		// the samples from each one that is accepted. Only writes the cells of
+		// the tile.
+		void fillTile( int tx, int ty, int tz ) {
+			const size_t tile = tileIndex( tx, ty, tz );
+			Random rng( seed ^ ( (uint64_t)( tile + 1 ) * 0x9E3779B97F4A7C15ULL ) );
+			const int lo[ 3 ] = { tx * TILE_CELLS, ty * TILE_CELLS, tz * TILE_CELLS };
+			const int hi[ 3 ] = { std::min( res[ 0 ], lo[ 0 ] + TILE_CELLS ), std::min( res[ 1 ], lo[ 1 ] + TILE_CELLS ), std::min( res[ 2 ], lo[ 2 ] + TILE_CELLS ) };
+
+			const Bounds& bounds = grid.bounds();
+			float tileMin[ 3 ], tileMax[ 3 ];
+			int voxelLo[ 3 ], voxelHi[ 3 ];
+			for( int axis = 0; axis < 3; axis++ ) {
+				tileMin[ axis ] = bounds.min[ axis ] + lo[ axis ] * cellSize;
+				tileMax[ axis ] = std::min( bounds.max[ axis ], bounds.min[ axis ] + hi[ axis ] * cellSize );
+				voxelLo[ axis ] = std::max( 0, (int)floorf( ( tileMin[ axis ] - bounds.min[ axis ] ) / voxelSize[ axis ] ) );
+				voxelHi[ axis ] = std::min( grid.resolution( axis ) - 1, (int)floorf( ( tileMax[ axis ] - bounds.min[ axis ] ) / voxelSize[ axis ] ) );
+			}
+
+			std::vector< float > active;
+			for( int vz = voxelLo[ 2 ]; vz <= voxelHi[ 2 ]; vz++ ) {
+				for( int vy = voxelLo[ 1 ]; vy <= voxelHi[ 1 ]; vy++ ) {
+					for( int vx = voxelLo[ 0 ]; vx <= voxelHi[ 0 ]; vx++ ) {
+						if ( !grid.get( vx, vy, vz ) ) continue;
+						const int v[ 3 ] = { vx, vy, vz };
+						float p[ 3 ];
+						for( int axis = 0; axis < 3; axis++ ) {
+							const float from = std::max( tileMin[ axis ], bounds.min[ axis ] + v[ axis ] * voxelSize[ axis ] );
+							const float to = std::min( tileMax[ axis ], bounds.min[ axis ] + ( v[ axis ] + 1 ) * voxelSize[ axis ] );
+							p[ axis ] = from + rng.nextFloat() * ( to - from );
+						}
+						if ( !tryPoint( p, lo, hi ) ) continue;
+						active.assign( p, p + 3 );
+						grow( active, rng, lo, hi );
+					}
+				}
+			}
+		}
+
+		// Bridson: candidates around a random active sample, which is retired
+		// once none of them fits. Candidates are tried just beyond the
+		// distance rather than up to twice it, which packs the samples closer
+		// with fewer tries.
+		void grow( std::vector< float >& active, Random& rng, const int* lo, const int* hi ) {
+			while( !active.empty() ) {
+				const size_t index = rng.nextInt( (uint32_t)( active.size() / 3 ) );
+				const float center[ 3 ] = { active[ 3 * index ], active[ 3 * index + 1 ], active[ 3 * index + 2 ] };
+				bool found = false;
+				for( int k = 0; k < tries && !found; k++ ) {
+					// random direction, from a point in the unit ball
+					float d[ 3 ], length2;
+					do {
+						for( int axis = 0; axis < 3; axis++ ) d[ axis ] = 2.0f * rng.nextFloat() - 1.0f;
+						length2 = d[ 0 ] * d[ 0 ] + d[ 1 ] * d[ 1 ] + d[ 2 ] * d[ 2 ];
+					} while( length2 > 1.0f || length2 < 1e-4f );
+					const float scale = distance * ( 1.0f + CANDIDATE_SPREAD * rng.nextFloat() ) / sqrtf( length2 );
+					for( int axis = 0; axis < 3; axis++ ) d[ axis ] *= scale;
+					float p[ 3 ] = { center[ 0 ] + d[ 0 ], center[ 1 ] + d[ 1 ], center[ 2 ] + d[ 2 ] };
+					if ( tryPoint( p, lo, hi ) ) {
+						active.insert( active.end(), p, p + 3 );
+						found = true;
+					}
+				}
+				if ( !found ) {
+					std::copy( active.end() - 3, active.end(), active.begin() + 3 * index );
+					active.resize( active.size() - 3 );
+				}
+			}
+		}
+
+		void fillPhase( int tz, int phase, int threads ) {
+			std::vector< int > phaseTiles;
+			for( int ty = phase >> 1 & 1; ty < tiles[ 1 ]; ty += 2 ) {
+				for( int tx = phase & 1; tx < tiles[ 0 ]; tx += 2 ) {
+					if ( !tileUsed[ tileIndex( tx, ty, tz ) ] ) continue;
+					phaseTiles.push_back( tx );
+					phaseTiles.push_back( ty );
+				}
+			}
+			// tiles are handed out one at a time, their cost varies a lot
+			std::atomic< size_t > next( 0 );
+			const size_t count = phaseTiles.size() / 2;
+			auto work = [ & ]() {
+				for( size_t t = next++; t < count; t = next++ ) {
+					fillTile( phaseTiles[ 2 * t ], phaseTiles[ 2 * t + 1 ], tz );
+				}
+			};
+			const size_t numWorkers = std::min( (size_t)threads, count );
+			std::vector< std::thread > workers;
+			for( size_t i = 1; i < numWorkers; i++ ) {
+				workers.push_back( std::thread( work ) );
+			}
+			work();
+			for( size_t i = 0; i < workers.size(); i++ ) {
+				workers[ i ].join();
+			}
+		}
+
+		// appends the samples of the cells in the slices [z0, z1)
+		void gather( int z0, int z1, std::vector< float >& points ) const {
+			for( int z = z0; z < z1; z++ ) {
+				for( int y = 0; y < res[ 1 ]; y++ ) {
+					const uint32_t* row = &cells[ cellIndex( 0, y, z ) ];
+					for( int x = 0; x < res[ 0 ]; x++ ) {
+						if ( row[ x ] == EMPTY_CELL ) continue;
+						const int c[ 3 ] = { x, y, z };
+						float f[ 3 ];
+						decode( row[ x ], f );
+						for( int axis = 0; axis < 3; axis++ ) {
+							points.push_back( grid.bounds().min[ axis ] + ( c[ axis ] + f[ axis ] ) * cellSize );
+						}
+					}
+				}
+			}
+		}
+
+		// Fills the layers of tiles along Z in order, each one in 4 phases.
+		// The samples of a layer are only seen by the next one, so they are
+		// gathered and dropped once it is filled.
+		void fill( int threads, std::vector< float >& points ) {
+			for( int tz = 0; tz <= tiles[ 2 ]; tz++ ) {
+				if ( tz < tiles[ 2 ] ) {
+					for( int phase = 0; phase < 4; phase++ ) {
+						fillPhase( tz, phase, threads );
+					}
+				}
+				if ( tz > 0 ) {
+					gather( ( tz - 1 ) * TILE_CELLS, std::min( res[ 2 ], tz * TILE_CELLS ), points );
+				}
+				// move the window a layer up
+				std::copy( cells.begin() + TILE_CELLS * stride[ 2 ], cells.end(), cells.begin() );
+				std::fill( cells.end() - TILE_CELLS * stride[ 2 ], cells.end(), EMPTY_CELL );
+				windowZ += TILE_CELLS;
+			}
+		}
+	};
+}
+
+void PoissonDiskSampler::setGrid( const VoxelGrid& voxels ) {
+	TRACE_SCOPE( "PoissonDiskSampler::setGrid" );
+	grid = voxels;
+	volume = grid.empty() ? 0.0f : grid.countOccupied() * grid.voxelSize( 0 ) * grid.voxelSize( 1 ) * grid.voxelSize( 2 );
+}
+
+float PoissonDiskSampler::distanceFor( int numSamples ) const {
+	if ( numSamples <= 0 ) return 0;
+	return cbrtf( FILL_DENSITY * volume / numSamples );
+}
+
+bool PoissonDiskSampler::Sample( float minDistance, int maxSamples, Random& rng, std::vector< float >& samples, SamplerStats* stats, int threads ) const {
+	TRACE_SCOPE( "PoissonDiskSampler::Sample" );
+	if ( stats ) {
+		stats->samplesRequested += std::max( 0, maxSamples );
+		stats->voxelsOccupied = (long long)grid.countOccupied();
+	}
+	if ( maxSamples <= 0 || volume <= 0 ) return false;
+	threads = WorkerThreads( threads );
+
+	const float distance = std::max( minDistance, distanceFor( maxSamples ) );
+	const uint64_t seed = (uint64_t)rng.next() << 32 | rng.next();
+	Filler filler( grid, distance, seed );
+	std::vector< float > points;
+	filler.fill( threads, points );
+
+	// any subset keeps the distance between the samples
+	size_t count = points.size() / 3;
+	if ( count > (size_t)maxSamples ) {
+		for( size_t i = 0; i < (size_t)maxSamples; i++ ) {
+			const size_t j = i + rng.nextInt( (uint32_t)( count - i ) );
+			std::swap_ranges( &points[ 3 * i ], &points[ 3 * i ] + 3, &points[ 3 * j ] );
+		}
+		count = maxSamples;
+	}
+	samples.insert( samples.end(), points.begin(), points.begin() + 3 * count );
+	if ( stats ) stats->samplesProduced += (long long)count;
+	return count > 0;
+}
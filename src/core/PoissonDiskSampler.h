@@ -0,0 +1,63 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "VoxelGrid.h"
+#include "Random.h"
+#include "SamplerStats.h"
+
+#include <vector>
+#include <stdint.h>
+
+/* ==========================================
+	Class PoissonDiskSampler
+
+	Generates blue noise samples within the occupied voxels
+	of a VoxelGrid: no two samples are closer than a minimum
+	distance, and the volume is filled until no more fit.
+
+	Samples are grown from each other as in Bridson's
+	algorithm, trying candidates just beyond the distance
+	from an existing sample. The neighbours of a
+	candidate are looked up in a background grid whose cells
+	are small enough to hold a single sample each, stored in
+	32 bits quantized within the cell.
+
+	The background grid is split into tiles, filled a layer
+	along Z at a time in 4 phases, one for each parity of
+	their X and Y coordinates. Tiles of the same phase are far
+	enough apart not to see each other's samples, so they are
+	filled in parallel with no locking. Only the cells of the
+	last two layers are kept. Every tile has its own random
+	sequence, so the result doesn't depend on the number of
+	threads.
+
+   ========================================== */
+
+class PoissonDiskSampler {
+public:
+	enum { DEFAULT_TRIES = 10 };
+
+						PoissonDiskSampler() : volume( 0 ) {}
+
+	void				setGrid( const VoxelGrid& grid );
+
+	// distance between samples for which about 'numSamples' fill the voxels
+	float				distanceFor( int numSamples ) const;
+
+	// Appends samples at least 'minDistance' apart, up to 'maxSamples' of
+	// them. If more than that would fit, the distance is increased as given
+	// by distanceFor. Returns false if the grid is empty. Uses up to
+	// 'threads' threads (0 for all the cores).
+	bool				Sample( float minDistance, int maxSamples, Random& rng, std::vector< float >& samples,
+								SamplerStats* stats = NULL, int threads = 0 ) const;
+
+private:
+	VoxelGrid			grid;
+	float				volume;		// of the occupied voxels
+};
@@ -0,0 +1,48 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/* ==========================================
+	Class Random
+
+	Small, seedable pseudo-random generator (PCG32). Unlike
+	rand() it carries no global state, so every sampler (and
+	every thread) can own its own reproducible sequence.
+
+   ========================================== */
+
+class Random {
+public:
+	explicit Random( uint64_t seed = 0 ) { setSeed( seed ); }
+
+	void setSeed( uint64_t seed ) {
+		state = 0;
+		next();
+		state += seed + 0x853c49e6748fea9bULL;
+		next();
+	}
+
+	uint32_t next() {
+		const uint64_t old = state;
+		state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+		const uint32_t shifted = (uint32_t)( ( ( old >> 18 ) ^ old ) >> 27 );
+		const uint32_t rotation = (uint32_t)( old >> 59 );
+		return ( shifted >> rotation ) | ( shifted << ( ( 32 - rotation ) & 31 ) );
+	}
+
+	// uniform float in [0, 1)
+	float nextFloat() { return ( next() >> 8 ) * ( 1.0f / 16777216.0f ); }
+
+	// uniform integer in [0, n)
+	uint32_t nextInt( uint32_t n ) { return (uint32_t)( ( (uint64_t)next() * n ) >> 32 ); }
+
+private:
+	uint64_t state;
+};
@@ -0,0 +1,412 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "RayMarchSampler.h"
+#include "SolidVoxelizer.h"
+#include "BitOps.h"
+#include "Trace.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace {
+	// rays along each axis the expected chord lengths are worth when
+	// reweighting the axes with the observed ones
+	const int PRIOR_RAYS = 32;
+	// steps per lateral axis when averaging over the offsets of the rays
+	const int OFFSET_STEPS = 16;
+	// rays between updates of the face weights while sampling
+	const int REWEIGHT_INTERVAL = 256;
+	// limit to how far the weights can move from the face areas, so that no
+	// direction stops being sampled on account of a few misses
+	const float MIN_EFFICIENCY = 0.25f;
+	const float MAX_EFFICIENCY = 4.0f;
+	// largest lateral offset of a ray across the bounds, relative to their
+	// size. Oblique rays avoid aligning the samples with the axes, but more
+	// of them miss the mesh.
+	const float MAX_SLOPE = 0.25f;
+	// spans of a ray with a winding number further than this from 0 or 1
+	// are split in as many pieces
+	const float AMBIGUOUS_WINDING = 0.1f;
+	const int AMBIGUOUS_PIECES = 8;
+
+	inline float chordLength( const std::vector< float >& hits, const float* dir ) {
+		float length = 0;
+		for( size_t i = 0; i + 1 < hits.size(); i += 2 ) {
+			length += hits[ i + 1 ] - hits[ i ];
+		}
+		return length * sqrtf( dir[ 0 ] * dir[ 0 ] + dir[ 1 ] * dir[ 1 ] + dir[ 2 ] * dir[ 2 ] );
+	}
+}
+
+void RayMarchSampler::setMesh( const MeshView& mesh, int guideResolution, InsideTest test ) {
+	TRACE_SCOPE( "RayMarchSampler::setMesh" );
+	bvh.build( mesh );
+	meshMeasures = MeshMeasures::Compute( mesh );
+	volume = fabs( meshMeasures.volume );
+	insideTest = test;
+	winding.clear();
+	bounds = mesh.bounds();
+	for( int axis = 0; axis < 3; axis++ ) {
+		faceArea[ axis ] = chordPerRay[ axis ] = 0;
+		guides[ axis ].table.clear();
+	}
+	if ( bounds.empty() ) return;
+
+	// expand the bounds slightly to avoid touching the mesh faces, and so
+	// that flat meshes still have a volume to cast rays through
+	const float longest = bounds.size( bounds.longestAxis() );
+	const float padding = longest > 0 ? 0.01f * longest : 1.0f;
+	for( int axis = 0; axis < 3; axis++ ) {
+		bounds.min[ axis ] -= padding;
+		bounds.max[ axis ] += padding;
+	}
+
+	if ( guideResolution > 0 || test == INSIDE_WINDING_NUMBER ) {
+		if ( test == INSIDE_WINDING_NUMBER ) winding.build( mesh );
+		voxelize( mesh, guideResolution > 0 ? guideResolution : DEFAULT_GUIDE_RESOLUTION );
+		if ( test == INSIDE_WINDING_NUMBER ) {
+			volume = occupancy.countOccupied() * (double)occupancy.voxelSize( 0 ) * occupancy.voxelSize( 1 ) * occupancy.voxelSize( 2 );
+		}
+	}
+
+	// Rays with a given offset fill the face extended by it, and go 'depth'
+	// along the axis over a length of 'length'. Their chords add up to
+	// volume * length / depth over that area, which averaged over the
+	// offsets is the length to expect from a ray.
+	for( int axis = 0; axis < 3; axis++ ) {
+		const float depth = bounds.size( axis );
+		const float width = bounds.size( ( axis + 1 ) % 3 );
+		const float height = bounds.size( ( axis + 2 ) % 3 );
+		faceArea[ axis ] = width * height;
+
+		double sum = 0;
+		for( int i = 0; i < OFFSET_STEPS; i++ ) {
+			const double u = MAX_SLOPE * width * ( 2.0 * ( i + 0.5 ) / OFFSET_STEPS - 1.0 );
+			for( int j = 0; j < OFFSET_STEPS; j++ ) {
+				const double v = MAX_SLOPE * height * ( 2.0 * ( j + 0.5 ) / OFFSET_STEPS - 1.0 );
+				const double length = sqrt( (double)depth * depth + u * u + v * v );
+				sum += length / ( depth * ( width + fabs( u ) ) * ( height + fabs( v ) ) );
+			}
+		}
+		chordPerRay[ axis ] = (float)( volume * sum / ( OFFSET_STEPS * OFFSET_STEPS ) );
+	}
+
+	if ( guideResolution > 0 ) buildGuides( mesh );
+}
+
+void RayMarchSampler::voxelize( const MeshView& mesh, int resolution ) {
+	const float longest = bounds.size( bounds.longestAxis() );
+	int res[ 3 ];
+	for( int axis = 0; axis < 3; axis++ ) {
+		res[ axis ] = std::max( 1, (int)( resolution * bounds.size( axis ) / longest + 0.5f ) );
+	}
+	occupancy.init( res[ 0 ], res[ 1 ], res[ 2 ], bounds );
+	if ( insideTest == INSIDE_WINDING_NUMBER ) {
+		SolidVoxelizer::Voxelize( mesh, occupancy, winding );
+	} else {
+		SolidVoxelizer::Voxelize( mesh, occupancy );
+	}
+}
+
+void RayMarchSampler::buildGuides( const MeshView& mesh ) {
+	TRACE_SCOPE( "RayMarchSampler::buildGuides" );
+	const int res[ 3 ] = { occupancy.resX(), occupancy.resY(), occupancy.resZ() };
+
+	// interior voxels along the column of every cell of each face
+	std::vector< int > counts[ 3 ];
+	for( int axis = 0; axis < 3; axis++ ) {
+		Guide& guide = guides[ axis ];
+		for( int i = 0; i < 2; i++ ) {
+			const int lateral = ( axis + 1 + i ) % 3;
+			guide.cells[ i ] = res[ lateral ];
+			guide.cellSize[ i ] = occupancy.voxelSize( lateral );
+		}
+		counts[ axis ].assign( (size_t)guide.cells[ 0 ] * guide.cells[ 1 ], 0 );
+	}
+	for( int y = 0; y < res[ 1 ]; y++ ) {
+		for( int x = 0; x < res[ 0 ]; x++ ) {
+			const VoxelGrid::Word* column = occupancy.column( x, y );
+			for( int w = 0; w < occupancy.wordsPerColumn(); w++ ) {
+				for( VoxelGrid::Word bits = column[ w ]; bits != 0; bits &= bits - 1 ) {
+					const int z = w * VoxelGrid::BITS_PER_WORD + LowestBit( bits );
+					counts[ 0 ][ (size_t)z * res[ 1 ] + y ]++;
+					counts[ 1 ][ (size_t)x * res[ 2 ] + z ]++;
+					counts[ 2 ][ (size_t)y * res[ 0 ] + x ]++;
+				}
+			}
+		}
+	}
+
+	// Voxels are only set when their centers are inside, so thin parts of the
+	// mesh can be missed. Every cell a triangle projects onto is kept with at
+	// least a voxel of length: a ray that finds interior must cross the
+	// surface, so no part of the mesh is left out of the guide.
+	std::vector< char > touched[ 3 ];
+	for( int axis = 0; axis < 3; axis++ ) {
+		touched[ axis ].assign( counts[ axis ].size(), 0 );
+	}
+	for( size_t t = 0; t < mesh.numTriangles; t++ ) {
+		const int* tri = mesh.triangle( t );
+		int cellMin[ 3 ], cellMax[ 3 ];
+		for( int axis = 0; axis < 3; axis++ ) {
+			float lo = mesh.point( tri[ 0 ] )[ axis ], hi = lo;
+			for( int k = 1; k < 3; k++ ) {
+				lo = std::min( lo, mesh.point( tri[ k ] )[ axis ] );
+				hi = std::max( hi, mesh.point( tri[ k ] )[ axis ] );
+			}
+			const float size = occupancy.voxelSize( axis );
+			cellMin[ axis ] = std::max( 0, (int)( ( lo - bounds.min[ axis ] ) / size ) );
+			cellMax[ axis ] = std::min( res[ axis ] - 1, (int)( ( hi - bounds.min[ axis ] ) / size ) );
+		}
+		for( int axis = 0; axis < 3; axis++ ) {
+			const int u = ( axis + 1 ) % 3, v = ( axis + 2 ) % 3;
+			for( int j = cellMin[ v ]; j <= cellMax[ v ]; j++ ) {
+				char* row = &touched[ axis ][ (size_t)j * res[ u ] ];
+				std::fill( row + cellMin[ u ], row + cellMax[ u ] + 1, (char)1 );
+			}
+		}
+	}
+
+	for( int axis = 0; axis < 3; axis++ ) {
+		Guide& guide = guides[ axis ];
+		const float voxelLength = occupancy.voxelSize( axis );
+		double columnsVolume = 0;
+		guide.length.resize( counts[ axis ].size() );
+		for( size_t c = 0; c < guide.length.size(); c++ ) {
+			const int voxels = counts[ axis ][ c ] > 0 ? counts[ axis ][ c ] : touched[ axis ][ c ];
+			guide.length[ c ] = voxels * voxelLength;
+			columnsVolume += guide.length[ c ];
+		}
+		columnsVolume *= guide.cellSize[ 0 ] * guide.cellSize[ 1 ];
+		guide.scale = volume > 0 ? (float)( columnsVolume / volume ) : 1.0f;
+		guide.table.build( &guide.length[ 0 ], guide.length.size() );
+	}
+}
+
+int RayMarchSampler::SamplesPerRay( int totalSamples ) {
+	// a quarter of the samples along each dimension: fewer, longer runs of
+	// samples per ray leave visible clusters where chords cross
+	return std::max( 1, (int)ceilf( 0.25f * cbrtf( (float)totalSamples ) ) );
+}
+
+int RayMarchSampler::pairHits( const float* origin, const float* dir ) {
+	if ( insideTest == INSIDE_PARITY ) {
+		// a last odd hit grazed the mesh or went through a hole
+		hits.resize( hits.size() & ~(size_t)1 );
+		return (int)hits.size() / 2;
+	}
+
+	// the spans between hits, and from the ends of the ray to them
+	spanEnds.resize( hits.size() + 2 );
+	spanEnds[ 0 ] = 0.0f;
+	std::copy( hits.begin(), hits.end(), spanEnds.begin() + 1 );
+	spanEnds.back() = 1.0f;
+	const size_t numSpans = spanEnds.size() - 1;
+	spanPoints.resize( 3 * numSpans );
+	spanValues.resize( numSpans );
+	for( size_t i = 0; i < numSpans; i++ ) {
+		const float t = 0.5f * ( spanEnds[ i ] + spanEnds[ i + 1 ] );
+		for( int axis = 0; axis < 3; axis++ ) spanPoints[ 3 * i + axis ] = origin[ axis ] + t * dir[ axis ];
+	}
+	winding.evaluate( &spanPoints[ 0 ], numSpans, &spanValues[ 0 ] );
+
+	// Near holes the winding number is fractional and may cross one half
+	// within a span, e.g. on rays going into the mesh through one. Those
+	// spans are split in pieces classified on their own.
+	pieces.clear();
+	spanPoints.clear();
+	for( size_t i = 0; i < numSpans; i++ ) {
+		const float w = fabsf( spanValues[ i ] );
+		const float t0 = spanEnds[ i ], t1 = spanEnds[ i + 1 ];
+		// the ends of the ray are outside, so the spans reaching them can
+		// only be inside past a hole
+		const bool end = ( i == 0 || i + 1 == numSpans ) && WindingNumber::Inside( spanValues[ i ] );
+		if ( !end && ( w < AMBIGUOUS_WINDING || w > 1.0f - AMBIGUOUS_WINDING ) ) {
+			const Piece piece = { t0, t1, -1, WindingNumber::Inside( spanValues[ i ] ) };
+			pieces.push_back( piece );
+			continue;
+		}
+		for( int j = 0; j < AMBIGUOUS_PIECES; j++ ) {
+			const Piece piece = { t0 + ( t1 - t0 ) * j / AMBIGUOUS_PIECES, t0 + ( t1 - t0 ) * ( j + 1 ) / AMBIGUOUS_PIECES,
+								  (int)spanPoints.size() / 3, false };
+			const float t = 0.5f * ( piece.t0 + piece.t1 );
+			for( int axis = 0; axis < 3; axis++ ) spanPoints.push_back( origin[ axis ] + t * dir[ axis ] );
+			pieces.push_back( piece );
+		}
+	}
+	if ( !spanPoints.empty() ) {
+		const size_t numPoints = spanPoints.size() / 3;
+		spanValues.resize( numPoints );
+		winding.evaluate( &spanPoints[ 0 ], numPoints, &spanValues[ 0 ] );
+		for( size_t i = 0; i < pieces.size(); i++ ) {
+			if ( pieces[ i ].value >= 0 ) pieces[ i ].inside = WindingNumber::Inside( spanValues[ pieces[ i ].value ] );
+		}
+	}
+
+	// runs of pieces inside are joined into chords
+	chords.clear();
+	for( size_t i = 0; i < pieces.size(); i++ ) {
+		if ( !pieces[ i ].inside ) continue;
+		if ( !chords.empty() && chords.back() == pieces[ i ].t0 ) {
+			chords.back() = pieces[ i ].t1;
+		} else {
+			chords.push_back( pieces[ i ].t0 );
+			chords.push_back( pieces[ i ].t1 );
+		}
+	}
+	hits.swap( chords );
+	return (int)hits.size() / 2;
+}
+
+int RayMarchSampler::castRay( int axis, Random& rng, float* origin, float* dir ) {
+	// the ray crosses the bounds along 'axis' with a random lateral offset.
+	// Origins are spread over the face extended by that offset, so that
+	// parallel rays cover every point of the bounds with the same density:
+	// placing samples evenly along the chords of any mix of such rays fills
+	// the volume uniformly, however the axes are weighted.
+	const bool reverse = rng.nextInt( 2 ) != 0;
+	for( int i = 1; i < 3; i++ ) {
+		const int lateral = ( axis + i ) % 3;
+		const float offset = MAX_SLOPE * ( 2.0f * rng.nextFloat() - 1.0f ) * bounds.size( lateral );
+		origin[ lateral ] = bounds.min[ lateral ] - std::max( offset, 0.0f ) + rng.nextFloat() * ( bounds.size( lateral ) + fabsf( offset ) );
+		dir[ lateral ] = offset;
+	}
+	origin[ axis ] = reverse ? bounds.max[ axis ] : bounds.min[ axis ];
+	dir[ axis ] = reverse ? -bounds.size( axis ) : bounds.size( axis );
+	hits.clear();
+	return bvh.allIntersections( origin, dir, hits );
+}
+
+int RayMarchSampler::castGuidedRay( int axis, Random& rng, float* origin, float* dir, float& scale ) {
+	// Cells are drawn in proportion to their length, and the samples placed
+	// along the ray in inverse proportion to it, which leaves the expected
+	// number of samples per unit of volume the same in every cell.
+	const Guide& guide = guides[ axis ];
+	const size_t cell = guide.table.sample( rng );
+	const int index[ 2 ] = { (int)( cell % guide.cells[ 0 ] ), (int)( cell / guide.cells[ 0 ] ) };
+	for( int i = 0; i < 2; i++ ) {
+		const int lateral = ( axis + 1 + i ) % 3;
+		origin[ lateral ] = bounds.min[ lateral ] + ( index[ i ] + rng.nextFloat() ) * guide.cellSize[ i ];
+		dir[ lateral ] = 0;
+	}
+	const bool reverse = rng.nextInt( 2 ) != 0;
+	origin[ axis ] = reverse ? bounds.max[ axis ] : bounds.min[ axis ];
+	dir[ axis ] = reverse ? -bounds.size( axis ) : bounds.size( axis );
+	scale = guide.scale / guide.length[ cell ];
+	hits.clear();
+	return bvh.allIntersections( origin, dir, hits );
+}
+
+bool RayMarchSampler::Sample( int numSamples, int totalSamples, Random& rng, std::vector< float >& samples,
+							  SamplerStats* stats ) {
+	TRACE_SCOPE( "RayMarchSampler::Sample" );
+	if ( stats ) stats->samplesRequested += std::max( 0, numSamples );
+	if ( numSamples <= 0 || bvh.empty() ) return false;
+
+	// the samples are written in place and the array trimmed at the end,
+	// rather than growing it one coordinate at a time
+	const size_t first = samples.size();
+	samples.resize( first + 3 * (size_t)numSamples );
+	float* const begin = &samples[ first ];
+	float* const end = begin + 3 * (size_t)numSamples;
+	float* out = begin;
+
+	// Trace random rays between opposed pairs of faces and produce samples along each entry/exit segment
+
+	// the chord length observed along each axis, starting from the expected one
+	double axisRays[ 3 ], axisLength[ 3 ];
+	float weights[ 3 ];
+	float totalArea = 0, expectedLength = 0;
+	for( int axis = 0; axis < 3; axis++ ) {
+		axisRays[ axis ] = PRIOR_RAYS;
+		axisLength[ axis ] = PRIOR_RAYS * chordPerRay[ axis ];
+		weights[ axis ] = faceArea[ axis ];
+		totalArea += faceArea[ axis ];
+		expectedLength += faceArea[ axis ] * chordPerRay[ axis ];
+	}
+	expectedLength = totalArea > 0 ? expectedLength / totalArea : 0;
+
+	// the density along chords only depends on the mesh and the total sample
+	// count, so that the samples of every chunk are spaced in the same way
+	const int samplesPerRay = SamplesPerRay( std::max( numSamples, totalSamples ) );
+	const float averageSize = ( bounds.size( 0 ) + bounds.size( 1 ) + bounds.size( 2 ) ) / 3.0f;
+	const float linearDensity = samplesPerRay / ( expectedLength > 0 ? expectedLength : averageSize );
+	const int maxSamplesPerChord = 4 * samplesPerRay;
+
+	// give up on meshes no ray manages to get into (open or flat geometry)
+	const int maxMissedRays = 10000;
+	int missedRays = 0;
+	long long raysCast = 0, chords = 0;
+
+	float origin[ 3 ], dir[ 3 ];
+
+	while( out < end ) {
+
+		if ( raysCast > 0 && raysCast % REWEIGHT_INTERVAL == 0 ) {
+			// favour the axes along which rays find more of the mesh
+			double meanLength = 0;
+			for( int axis = 0; axis < 3; axis++ ) {
+				meanLength += faceArea[ axis ] * axisLength[ axis ] / axisRays[ axis ];
+			}
+			meanLength /= totalArea;
+			for( int axis = 0; axis < 3; axis++ ) {
+				const float efficiency = meanLength > 0 ? (float)( axisLength[ axis ] / axisRays[ axis ] / meanLength ) : 1.0f;
+				weights[ axis ] = faceArea[ axis ] * std::min( MAX_EFFICIENCY, std::max( MIN_EFFICIENCY, efficiency ) );
+			}
+		}
+
+		int axis;
+		float density = linearDensity;
+		if ( guided() ) {
+			// every axis covers the whole mesh with the same density
+			axis = rng.nextInt( 3 );
+			float scale;
+			castGuidedRay( axis, rng, origin, dir, scale );
+			density = samplesPerRay * scale;
+		} else {
+			const float pick = rng.nextFloat() * ( weights[ 0 ] + weights[ 1 ] + weights[ 2 ] );
+			axis = pick < weights[ 0 ] ? 0 : ( pick < weights[ 0 ] + weights[ 1 ] ? 1 : 2 );
+			castRay( axis, rng, origin, dir );
+		}
+
+		raysCast++;
+		axisRays[ axis ]++;
+		if ( pairHits( origin, dir ) == 0 ) {
+			if ( ++missedRays >= maxMissedRays && out == begin ) {
+				break;
+			}
+			continue;
+		}
+		axisLength[ axis ] += chordLength( hits, dir );
+
+		const float rayLength = sqrtf( dir[ 0 ] * dir[ 0 ] + dir[ 1 ] * dir[ 1 ] + dir[ 2 ] * dir[ 2 ] );
+		for( size_t i = 0; i + 1 < hits.size(); i += 2 ) {
+			chords++;
+			const float t0 = hits[ i ];
+			const float dt = hits[ i + 1 ] - t0;
+			// guided rays round their counts randomly, as the density varies between them
+			const float expected = dt * rayLength * density;
+			const int ns = std::min( maxSamplesPerChord, guided() ? (int)( expected + rng.nextFloat() ) : (int)ceil( expected ) );
+			for( int j = 0; j < ns && out < end; j++, out += 3 ) {
+				const float t = t0 + rng.nextFloat() * dt;
+				out[ 0 ] = origin[ 0 ] + t * dir[ 0 ];
+				out[ 1 ] = origin[ 1 ] + t * dir[ 1 ];
+				out[ 2 ] = origin[ 2 ] + t * dir[ 2 ];
+			}
+		}
+	}
+
+	if ( stats ) {
+		stats->raysCast += raysCast;
+		stats->raysMissed += missedRays;
+		stats->chords += chords;
+		stats->samplesProduced += ( out - begin ) / 3;
+	}
+	samples.resize( first + ( out - begin ) );
+	return out > begin;
+}
@@ -0,0 +1,148 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+#include "TriangleBvh.h"
+#include "WindingNumber.h"
+#include "MeshMeasures.h"
+#include "VoxelGrid.h"
+#include "AliasTable.h"
+#include "Random.h"
+#include "SamplerStats.h"
+
+#include <vector>
+
+/* ==========================================
+	Class RayMarchSampler
+
+	Volume sampler by raymarching, the algorithm behind the
+	RaySampler node: random segments are traced between
+	opposed faces of the (padded) mesh bounds, the sorted
+	hits are paired into entry/exit chords, and samples are
+	distributed uniformly along each chord.
+
+	The pair of faces of each ray is chosen in proportion to
+	their area, so rays cross the volume evenly whatever the
+	aspect of the bounds. The exact volume of the mesh gives
+	the length of the chords to expect from each ray: the
+	density of samples along chords is set from it so that
+	every ray yields SamplesPerRay samples on average, and the
+	face weights are adjusted while sampling towards the axes
+	whose rays miss the mesh less often.
+
+	Rays can optionally be guided by a coarse voxelization of
+	the mesh. Rays are then cast along the axes, from the
+	cells of each face whose columns contain some of the
+	mesh, drawn in proportion to the interior length of the
+	column. Each ray's samples are scaled back by that
+	length, so the density stays uniform while rays that miss
+	the mesh become rare on rings or branching shapes.
+
+	Pairing hits into chords by parity only works on closed
+	meshes. With INSIDE_WINDING_NUMBER every span of a ray
+	between consecutive hits is kept or not by the winding
+	number at its middle instead (see WindingNumber), and the
+	volume the density is set from is measured on a coarse
+	voxelization classified the same way, as the exact one
+	is meaningless on open meshes.
+
+	The sampler keeps its accelerator and scratch buffers
+	between calls, and between meshes, so that once they have
+	grown to size sampling doesn't allocate any memory. For
+	the same reason a sampler can't be used by several
+	threads at once.
+
+   ========================================== */
+
+class RayMarchSampler {
+public:
+	enum { DEFAULT_GUIDE_RESOLUTION = 32 };
+
+	// builds the ray intersection accelerator for 'mesh'. If 'guideResolution'
+	// is not 0 the rays are guided by an occupancy grid with that many voxels
+	// along the longest side of the mesh. 'test' tells the chords of the rays
+	// inside the mesh.
+	void			setMesh( const MeshView& mesh, int guideResolution = 0, InsideTest test = INSIDE_PARITY );
+
+	bool			guided() const { return !guides[ 0 ].table.empty(); }
+
+	// appends 'numSamples' xyz samples. Returns false if the mesh has no
+	// interior to sample. Ray and sample counts are added to 'stats' if given.
+	bool			Sample( int numSamples, Random& rng, std::vector< float >& samples, SamplerStats* stats = NULL ) {
+		return Sample( numSamples, numSamples, rng, samples, stats );
+	}
+
+	// same as above, but spacing the samples along each chord as if
+	// 'totalSamples' were being generated, so that a large set can be
+	// produced in chunks with the same distribution as in a single call.
+	bool			Sample( int numSamples, int totalSamples, Random& rng, std::vector< float >& samples,
+							SamplerStats* stats = NULL );
+
+	const TriangleBvh&	accelerator() const { return bvh; }
+
+	// volume and area of the mesh
+	const MeshMeasures&	measures() const { return meshMeasures; }
+
+	// average number of samples produced per ray when generating
+	// 'totalSamples', so that about totalSamples / SamplesPerRay rays are cast
+	static int		SamplesPerRay( int totalSamples );
+
+private:
+	// casts a random ray between the pair of faces perpendicular to 'axis'.
+	// Returns the number of hits, whose parameters along 'dir' are left in 'hits'.
+	int				castRay( int axis, Random& rng, float* origin, float* dir );
+
+	// casts a ray along 'axis' from a cell drawn from the guide of that axis,
+	// and sets 'scale' to the factor of the density of samples along it
+	int				castGuidedRay( int axis, Random& rng, float* origin, float* dir, float& scale );
+
+	// voxelizes the mesh on 'occupancy', with 'resolution' voxels along the
+	// longest side of the bounds
+	void			voxelize( const MeshView& mesh, int resolution );
+
+	void			buildGuides( const MeshView& mesh );
+
+	// turns the hits of the last ray cast into entry/exit pairs, and returns
+	// their number
+	int				pairHits( const float* origin, const float* dir );
+
+	// cells of the face perpendicular to an axis, along the next two axes
+	struct Guide {
+		AliasTable				table;		// cells in proportion to their length
+		std::vector< float >	length;		// estimated interior length of each cell's column
+		int						cells[ 2 ];
+		float					cellSize[ 2 ];
+		float					scale;		// volume of the columns over the exact volume
+	};
+
+	TriangleBvh		bvh;
+	Bounds			bounds;
+	MeshMeasures	meshMeasures;
+	InsideTest		insideTest;
+	WindingNumber	winding;
+	double			volume;				// of the interior the chords are found in
+	float			faceArea[ 3 ];		// area of the faces perpendicular to each axis
+	float			chordPerRay[ 3 ];	// expected length of the chords of a ray along each axis
+
+	Guide			guides[ 3 ];
+	VoxelGrid		occupancy;
+
+	std::vector< float >	hits;		// scratch for castRay
+	// scratch for pairHits
+	struct Piece {
+		float			t0, t1;
+		int				value;		// index in spanValues, -1 if known
+		bool			inside;
+	};
+	std::vector< float >	spanEnds;
+	std::vector< float >	spanPoints;
+	std::vector< float >	spanValues;
+	std::vector< Piece >	pieces;
+	std::vector< float >	chords;
+};
@@ -0,0 +1,55 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "SampleBuffer.h"
+#include "Transform.h"
+
+#include <float.h>
+
+SampleBuffer::SampleBuffer() : references( 0 ) {
+	bbMin[ 0 ] = bbMin[ 1 ] = bbMin[ 2 ] = 0.0f;
+	bbMax[ 0 ] = bbMax[ 1 ] = bbMax[ 2 ] = 0.0f;
+}
+
+SampleBuffer* SampleBuffer::create( std::vector< float >& xyz ) {
+	SampleBuffer* buffer = new SampleBuffer();
+	buffer->coords.swap( xyz );
+	xyz.clear();
+
+	// bounds are calculated once here so that consumers (e.g. the preview
+	// shapes) don't need to traverse the samples again
+	const size_t numPoints = buffer->size();
+	if ( numPoints > 0 ) {
+		float* bbMin = buffer->bbMin;
+		float* bbMax = buffer->bbMax;
+		bbMin[ 0 ] = bbMin[ 1 ] = bbMin[ 2 ] = FLT_MAX;
+		bbMax[ 0 ] = bbMax[ 1 ] = bbMax[ 2 ] = -FLT_MAX;
+		const float* p = buffer->data();
+		for( size_t i = 0; i < numPoints; i++, p += 3 ) {
+			for( int axis = 0; axis < 3; axis++ ) {
+				if ( p[ axis ] < bbMin[ axis ] ) bbMin[ axis ] = p[ axis ];
+				if ( p[ axis ] > bbMax[ axis ] ) bbMax[ axis ] = p[ axis ];
+			}
+		}
+	}
+
+	return buffer;
+}
+
+SampleBuffer* SampleBuffer::createTransformed( const SampleBuffer& source, const float* matrix ) {
+	std::vector< float > xyz( source.coords.size() );
+	if ( !xyz.empty() ) {
+		TransformPoints( matrix, source.data(), source.size(), &xyz[ 0 ] );
+	}
+	return create( xyz );
+}
+
+void SampleBuffer::release( const SampleBuffer* buffer ) {
+	if ( buffer != NULL && buffer->decRef() == 0 ) {
+		delete buffer;
+	}
+}
@@ -0,0 +1,65 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <stddef.h>
+
+/* ==========================================
+	Class SampleBuffer
+
+	Immutable array of 3D points (xyz floats, interleaved)
+	shared by every node downstream of a sampler. The
+	buffer is never modified once created, so instead of
+	copying it along the dependency graph each consumer
+	just holds a reference to it.
+
+	Voxels are stored in the same way, as consecutive
+	(min, max) point pairs.
+
+   ========================================== */
+
+class SampleBuffer {
+public:
+	// Creates a new buffer taking ownership of the contents of 'xyz',
+	// which is left empty. The returned buffer has no references: wrap it
+	// in a SampleBufferData (or call incRef) to keep it alive.
+	static SampleBuffer*	create( std::vector< float >& xyz );
+
+	// Creates a new buffer with the points of 'source' transformed by
+	// 'matrix' (see TransformPoints)
+	static SampleBuffer*	createTransformed( const SampleBuffer& source, const float* matrix );
+
+	size_t					size() const { return coords.size() / 3; }
+	bool					empty() const { return coords.empty(); }
+	const float*			data() const { return coords.empty() ? NULL : &coords[ 0 ]; }
+	const float*			point( size_t i ) const { return &coords[ 3 * i ]; }
+
+	const float*			boundsMin() const { return bbMin; }
+	const float*			boundsMax() const { return bbMax; }
+
+	// reference counting: buffers may be shared between threads evaluating
+	// different nodes, hence the atomic counter
+	inline void				incRef() const { references++; }
+	inline int				decRef() const { return --references; }
+
+	// drops a reference, deleting the buffer when nobody else is holding it
+	static void				release( const SampleBuffer* buffer );
+
+private:
+							SampleBuffer();
+							SampleBuffer( const SampleBuffer& ); // non-copyable
+	SampleBuffer&			operator=( const SampleBuffer& );
+
+	std::vector< float >	coords;
+	float					bbMin[ 3 ];
+	float					bbMax[ 3 ];
+
+	mutable std::atomic< int > references;
+};
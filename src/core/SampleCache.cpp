@@ -0,0 +1,390 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "SampleCache.h"
+#include "SampleCodec.h"
+#include "Trace.h"
+
+#include <string.h>
+#include <float.h>
+#include <algorithm>
+
+#ifdef SAMPLER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+	const char MAGIC[ 4 ] = { 'S', 'M', 'P', 'C' };
+	const uint64_t ALIGNMENT = 16;
+
+	inline uint64_t align( uint64_t offset ) {
+		return ( offset + ALIGNMENT - 1 ) & ~( ALIGNMENT - 1 );
+	}
+
+	// Floats of similar magnitude share their exponent bytes but not their
+	// low mantissa bytes. Grouping each byte of every float together leaves
+	// long runs of similar bytes which deflate compresses much better.
+	void shuffle( const float* values, size_t count, unsigned char* bytes ) {
+		const unsigned char* src = (const unsigned char*)values;
+		for( size_t i = 0; i < count; i++ ) {
+			for( size_t b = 0; b < sizeof( float ); b++ ) {
+				bytes[ b * count + i ] = src[ i * sizeof( float ) + b ];
+			}
+		}
+	}
+
+	void unshuffle( const unsigned char* bytes, size_t count, float* values ) {
+		unsigned char* dst = (unsigned char*)values;
+		for( size_t i = 0; i < count; i++ ) {
+			for( size_t b = 0; b < sizeof( float ); b++ ) {
+				dst[ i * sizeof( float ) + b ] = bytes[ b * count + i ];
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SampleCacheWriter
+//////////////////////////////////////////////////////////////////////////
+
+SampleCacheWriter::SampleCacheWriter() : file( NULL ), codec( SAMPLE_CODEC_RAW ), maxError( 0 ), fileOffset( 0 ), filling( 0 ),
+										 pending( NULL ), quit( false ), failed( false ) {
+	memset( &header, 0, sizeof( header ) );
+}
+
+SampleCacheWriter::~SampleCacheWriter() {
+	if ( isOpen() ) close();
+}
+
+bool SampleCacheWriter::CompressionSupported() {
+#ifdef SAMPLER_HAVE_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool SampleCacheWriter::open( const char* filePath, uint64_t seed, unsigned int blockSize, SampleCacheCodec blockCodec, float error ) {
+	if ( isOpen() ) close();
+	if ( blockSize == 0 ) return false;
+
+	file = fopen( filePath, "wb" );
+	if ( file == NULL ) return false;
+	path = filePath;
+
+	// the header is rewritten by close once the counts are known
+	memset( &header, 0, sizeof( header ) );
+	if ( fwrite( &header, sizeof( header ), 1, file ) != 1 ) {
+		fclose( file );
+		file = NULL;
+		remove( path.c_str() );
+		return false;
+	}
+	memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+	header.version = SAMPLE_CACHE_VERSION;
+	header.blockSize = blockSize;
+	header.seed = seed;
+	for( int axis = 0; axis < 3; axis++ ) {
+		header.boundsMin[ axis ] = FLT_MAX;
+		header.boundsMax[ axis ] = -FLT_MAX;
+	}
+
+	codec = blockCodec == SAMPLE_CODEC_DEFLATE && !CompressionSupported() ? SAMPLE_CODEC_RAW : blockCodec;
+	maxError = error;
+	fileOffset = sizeof( header );
+	table.clear();
+	for( int i = 0; i < 2; i++ ) {
+		blocks[ i ].columns.resize( 3 * (size_t)blockSize );
+		blocks[ i ].count = 0;
+	}
+	filling = 0;
+	pending = NULL;
+	quit = false;
+	failed = false;
+	writer = std::thread( &SampleCacheWriter::writerLoop, this );
+	return true;
+}
+
+void SampleCacheWriter::append( const float* xyz, size_t numPoints ) {
+	const unsigned int blockSize = header.blockSize;
+	while( numPoints > 0 ) {
+		Block& block = blocks[ filling ];
+		const size_t n = std::min( numPoints, (size_t)( blockSize - block.count ) );
+		float* x = &block.columns[ 0 ] + block.count;
+		float* y = x + blockSize;
+		float* z = y + blockSize;
+		for( size_t i = 0; i < n; i++, xyz += 3 ) {
+			x[ i ] = xyz[ 0 ];
+			y[ i ] = xyz[ 1 ];
+			z[ i ] = xyz[ 2 ];
+			for( int axis = 0; axis < 3; axis++ ) {
+				header.boundsMin[ axis ] = std::min( header.boundsMin[ axis ], xyz[ axis ] );
+				header.boundsMax[ axis ] = std::max( header.boundsMax[ axis ], xyz[ axis ] );
+			}
+		}
+		block.count += (unsigned int)n;
+		header.numSamples += n;
+		numPoints -= n;
+		if ( block.count == blockSize ) submit();
+	}
+}
+
+void SampleCacheWriter::submit() {
+	std::unique_lock< std::mutex > lock( mutex );
+	// wait for the other block to be written before filling it again
+	while( pending != NULL ) condition.wait( lock );
+	pending = &blocks[ filling ];
+	filling ^= 1;
+	blocks[ filling ].count = 0;
+	condition.notify_all();
+}
+
+void SampleCacheWriter::writerLoop() {
+	std::unique_lock< std::mutex > lock( mutex );
+	for( ;; ) {
+		while( pending == NULL && !quit ) condition.wait( lock );
+		if ( pending == NULL ) break;
+
+		const Block* block = pending;
+		lock.unlock();
+		const bool ok = writeBlock( *block );
+		lock.lock();
+
+		if ( !ok ) failed = true;
+		pending = NULL;
+		condition.notify_all();
+	}
+}
+
+bool SampleCacheWriter::writeBlock( const Block& block ) {
+	TRACE_SCOPE( "SampleCacheWriter::writeBlock" );
+	static const unsigned char padding[ ALIGNMENT ] = { 0 };
+
+	const uint64_t offset = align( fileOffset );
+	if ( offset > fileOffset && fwrite( padding, 1, (size_t)( offset - fileOffset ), file ) != offset - fileOffset ) return false;
+
+	SampleCacheBlock entry;
+	entry.offset = offset;
+	entry.numSamples = block.count;
+	entry.codec = SAMPLE_CODEC_RAW;
+	entry.size = 3 * sizeof( float ) * (uint64_t)block.count;
+
+	const float* columns[ 3 ] = { &block.columns[ 0 ],
+								  &block.columns[ 0 ] + header.blockSize,
+								  &block.columns[ 0 ] + 2 * header.blockSize };
+	bool written = false;
+
+	if ( codec == SAMPLE_CODEC_QUANTIZED ) {
+		scratch.clear();
+		SampleCodec::Encode( columns[ 0 ], columns[ 1 ], columns[ 2 ], block.count, maxError, scratch );
+		if ( !scratch.empty() && fwrite( &scratch[ 0 ], 1, scratch.size(), file ) != scratch.size() ) return false;
+		entry.codec = SAMPLE_CODEC_QUANTIZED;
+		entry.size = scratch.size();
+		written = true;
+	}
+
+#ifdef SAMPLER_HAVE_ZLIB
+	if ( codec == SAMPLE_CODEC_DEFLATE ) {
+		const size_t rawSize = (size_t)entry.size;
+		const uLong bound = compressBound( (uLong)rawSize );
+		scratch.resize( rawSize + bound );
+		unsigned char* shuffled = &scratch[ 0 ];
+		for( int axis = 0; axis < 3; axis++ ) {
+			shuffle( columns[ axis ], block.count, shuffled + axis * sizeof( float ) * block.count );
+		}
+		uLongf compressedSize = bound;
+		if ( compress2( shuffled + rawSize, &compressedSize, shuffled, (uLong)rawSize, Z_BEST_SPEED ) == Z_OK &&
+			 compressedSize < rawSize ) {
+			// keep the block raw when it doesn't get any smaller
+			if ( fwrite( shuffled + rawSize, 1, compressedSize, file ) != compressedSize ) return false;
+			entry.codec = SAMPLE_CODEC_DEFLATE;
+			entry.size = compressedSize;
+			written = true;
+		}
+	}
+#endif
+
+	if ( !written ) {
+		for( int axis = 0; axis < 3; axis++ ) {
+			if ( fwrite( columns[ axis ], sizeof( float ), block.count, file ) != block.count ) return false;
+		}
+	}
+
+	fileOffset = offset + entry.size;
+	table.push_back( entry );
+	return true;
+}
+
+bool SampleCacheWriter::close() {
+	if ( !isOpen() ) return false;
+
+	if ( blocks[ filling ].count > 0 ) submit();
+	{
+		std::unique_lock< std::mutex > lock( mutex );
+		while( pending != NULL ) condition.wait( lock );
+		quit = true;
+		condition.notify_all();
+	}
+	writer.join();
+
+	bool ok = !failed;
+	if ( ok ) {
+		static const unsigned char padding[ ALIGNMENT ] = { 0 };
+		const uint64_t tableOffset = align( fileOffset );
+		header.numBlocks = table.size();
+		header.blockTableOffset = tableOffset;
+		if ( header.numSamples == 0 ) {
+			memset( header.boundsMin, 0, sizeof( header.boundsMin ) );
+			memset( header.boundsMax, 0, sizeof( header.boundsMax ) );
+		}
+		ok = fwrite( padding, 1, (size_t)( tableOffset - fileOffset ), file ) == tableOffset - fileOffset &&
+			 ( table.empty() || fwrite( &table[ 0 ], sizeof( SampleCacheBlock ), table.size(), file ) == table.size() ) &&
+			 fseek( file, 0, SEEK_SET ) == 0 &&
+			 fwrite( &header, sizeof( header ), 1, file ) == 1;
+	}
+	if ( fclose( file ) != 0 ) ok = false;
+	file = NULL;
+	if ( !ok ) remove( path.c_str() );
+
+	table.clear();
+	scratch.clear();
+	for( int i = 0; i < 2; i++ ) {
+		std::vector< float >().swap( blocks[ i ].columns );
+	}
+	return ok;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SampleCacheReader
+//////////////////////////////////////////////////////////////////////////
+
+bool SampleCacheReader::open( const char* path, std::string* error ) {
+	TRACE_SCOPE( "SampleCacheReader::open" );
+	close();
+	if ( !file.open( path ) ) {
+		if ( error ) *error = "can't open file";
+		return false;
+	}
+
+	const char* base = file.data();
+	const uint64_t size = file.size();
+	const SampleCacheHeader* h = (const SampleCacheHeader*)base;
+	if ( size < sizeof( SampleCacheHeader ) || memcmp( h->magic, MAGIC, sizeof( MAGIC ) ) != 0 ) {
+		if ( error ) *error = "not a sample cache, or not closed properly";
+		close();
+		return false;
+	}
+	if ( h->version != SAMPLE_CACHE_VERSION ) {
+		if ( error ) *error = "unsupported sample cache version";
+		close();
+		return false;
+	}
+
+	const uint64_t tableSize = h->numBlocks * sizeof( SampleCacheBlock );
+	bool valid = h->blockSize > 0 &&
+				 h->blockTableOffset % ALIGNMENT == 0 &&
+				 h->numBlocks <= size / sizeof( SampleCacheBlock ) &&
+				 h->blockTableOffset <= size && tableSize <= size - h->blockTableOffset;
+	const SampleCacheBlock* blocks = (const SampleCacheBlock*)( base + h->blockTableOffset );
+	uint64_t total = 0;
+	for( uint64_t i = 0; valid && i < h->numBlocks; i++ ) {
+		const SampleCacheBlock& b = blocks[ i ];
+		valid = b.numSamples <= h->blockSize &&
+				b.offset % ALIGNMENT == 0 && b.offset <= size && b.size <= size - b.offset &&
+				( b.codec == SAMPLE_CODEC_DEFLATE || b.codec == SAMPLE_CODEC_QUANTIZED ||
+				  ( b.codec == SAMPLE_CODEC_RAW && b.size == 3 * sizeof( float ) * (uint64_t)b.numSamples ) );
+		total += b.numSamples;
+	}
+	if ( !valid || total != h->numSamples ) {
+		if ( error ) *error = "corrupt sample cache";
+		close();
+		return false;
+	}
+
+	fileHeader = h;
+	blockTable = blocks;
+	return true;
+}
+
+void SampleCacheReader::close() {
+	file.close();
+	fileHeader = NULL;
+	blockTable = NULL;
+}
+
+const float* SampleCacheReader::column( size_t block, int axis ) const {
+	const SampleCacheBlock& b = blockTable[ block ];
+	if ( b.codec != SAMPLE_CODEC_RAW ) return NULL;
+	return (const float*)( file.data() + b.offset ) + axis * (size_t)b.numSamples;
+}
+
+bool SampleCacheReader::readBlock( size_t block, float* x, float* y, float* z ) const {
+	const SampleCacheBlock& b = blockTable[ block ];
+	const size_t n = b.numSamples;
+	float* columns[ 3 ] = { x, y, z };
+
+	if ( b.codec == SAMPLE_CODEC_RAW ) {
+		for( int axis = 0; axis < 3; axis++ ) {
+			memcpy( columns[ axis ], column( block, axis ), n * sizeof( float ) );
+		}
+		return true;
+	}
+
+	if ( b.codec == SAMPLE_CODEC_QUANTIZED ) {
+		return SampleCodec::Decode( (const unsigned char*)file.data() + b.offset, (size_t)b.size, n, x, y, z );
+	}
+
+#ifdef SAMPLER_HAVE_ZLIB
+	if ( b.codec == SAMPLE_CODEC_DEFLATE ) {
+		std::vector< unsigned char > shuffled( 3 * sizeof( float ) * n );
+		uLongf rawSize = (uLongf)shuffled.size();
+		if ( n > 0 && ( uncompress( &shuffled[ 0 ], &rawSize, (const Bytef*)( file.data() + b.offset ), (uLong)b.size ) != Z_OK ||
+						rawSize != shuffled.size() ) ) {
+			return false;
+		}
+		for( int axis = 0; axis < 3; axis++ ) {
+			unshuffle( &shuffled[ 0 ] + axis * sizeof( float ) * n, n, columns[ axis ] );
+		}
+		return true;
+	}
+#endif
+	return false;
+}
+
+bool SampleCacheReader::readInterleaved( size_t block, float* xyz ) const {
+	const size_t n = blockSamples( block );
+	const float* x = column( block, 0 );
+	std::vector< float > decoded;
+	if ( x == NULL ) {
+		decoded.resize( 3 * n );
+		if ( n > 0 && !readBlock( block, &decoded[ 0 ], &decoded[ 0 ] + n, &decoded[ 0 ] + 2 * n ) ) return false;
+		x = n > 0 ? &decoded[ 0 ] : NULL;
+	}
+	const float* y = x + n;
+	const float* z = y + n;
+	for( size_t i = 0; i < n; i++, xyz += 3 ) {
+		xyz[ 0 ] = x[ i ];
+		xyz[ 1 ] = y[ i ];
+		xyz[ 2 ] = z[ i ];
+	}
+	return true;
+}
+
+bool SampleCacheReader::readAll( std::vector< float >& xyz ) const {
+	TRACE_SCOPE( "SampleCacheReader::readAll" );
+	const size_t first = xyz.size();
+	xyz.resize( first + 3 * (size_t)numSamples() );
+	float* dst = xyz.empty() ? NULL : &xyz[ 0 ] + first;
+	for( size_t block = 0; block < numBlocks(); block++ ) {
+		if ( !readInterleaved( block, dst ) ) {
+			xyz.resize( first );
+			return false;
+		}
+		dst += 3 * blockSamples( block );
+	}
+	return true;
+}
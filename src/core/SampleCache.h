@@ -0,0 +1,183 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/* ==========================================
+	Sample cache file format (.smpc)
+
+	Binary container for large sample sets, so they can be
+	generated once and reused. All values are little-endian.
+
+		SampleCacheHeader
+		block 0, block 1, ...		(16 byte aligned)
+		SampleCacheBlock[ numBlocks ]	(at blockTableOffset)
+
+	Each block holds up to 'blockSize' samples as three
+	float32 columns (all x, then all y, then all z). Blocks
+	are either stored raw, in which case the columns can be
+	used straight from the mapped file, compressed, or
+	quantized (see SampleCodec), which is lossy and does not
+	preserve the order of the samples within the block.
+
+	The header is written last, so a file whose magic or
+	block table is invalid was not closed properly.
+
+   ========================================== */
+
+enum {
+	SAMPLE_CACHE_VERSION = 1
+};
+
+enum SampleCacheCodec {
+	SAMPLE_CODEC_RAW = 0,
+	SAMPLE_CODEC_DEFLATE = 1,	// byte-shuffled columns compressed with zlib
+	SAMPLE_CODEC_QUANTIZED = 2	// SampleCodec stream
+};
+
+struct SampleCacheHeader {
+	char		magic[ 4 ];		// "SMPC"
+	uint32_t	version;
+	uint32_t	blockSize;		// samples per block, the last one may hold less
+	uint32_t	flags;			// reserved, 0
+	uint64_t	numSamples;
+	uint64_t	numBlocks;
+	uint64_t	seed;			// seed the samples were generated with
+	uint64_t	blockTableOffset;
+	float		boundsMin[ 3 ];
+	float		boundsMax[ 3 ];
+};
+
+struct SampleCacheBlock {
+	uint64_t	offset;			// from the beginning of the file
+	uint64_t	size;			// stored bytes
+	uint32_t	numSamples;
+	uint32_t	codec;			// SampleCacheCodec
+};
+
+/* ==========================================
+	Class SampleCacheWriter
+
+	Streams samples to a cache file while they are being
+	generated. Samples are gathered into a block while a
+	background thread compresses and writes the previous
+	one, so the sampler only waits on disk when it fills a
+	block faster than it can be written.
+
+   ========================================== */
+
+class SampleCacheWriter {
+public:
+	enum {
+		DEFAULT_BLOCK_SIZE = 1 << 16
+	};
+
+						SampleCacheWriter();
+						~SampleCacheWriter();
+
+	// starts a new cache at 'path', storing the blocks with 'codec'. Deflate
+	// falls back to raw blocks when the library was built without zlib.
+	// Quantized blocks keep samples within 'maxError' of their position.
+	bool				open( const char* path, uint64_t seed, unsigned int blockSize = DEFAULT_BLOCK_SIZE,
+							  SampleCacheCodec codec = SAMPLE_CODEC_RAW, float maxError = 0 );
+
+	// appends 'numPoints' interleaved xyz samples
+	void				append( const float* xyz, size_t numPoints );
+
+	// flushes the pending samples and writes the block table and header.
+	// Returns false if any write failed along the way, in which case the
+	// file is removed.
+	bool				close();
+
+	bool				isOpen() const { return file != NULL; }
+	uint64_t			numSamples() const { return header.numSamples; }
+
+	static bool			CompressionSupported();
+
+private:
+						SampleCacheWriter( const SampleCacheWriter& ); // non-copyable
+	SampleCacheWriter&	operator=( const SampleCacheWriter& );
+
+	struct Block {
+		std::vector< float >	columns;	// x[ blockSize ], y[ blockSize ], z[ blockSize ]
+		unsigned int			count;
+	};
+
+	void				submit();				// hands the filling block to the writer thread
+	void				writerLoop();
+	bool				writeBlock( const Block& block );
+
+	FILE*				file;
+	std::string			path;
+	SampleCacheHeader	header;
+	SampleCacheCodec	codec;
+	float				maxError;
+	uint64_t			fileOffset;
+	std::vector< SampleCacheBlock > table;
+	std::vector< unsigned char > scratch;
+
+	Block				blocks[ 2 ];
+	int					filling;				// block being filled by append
+	const Block*		pending;				// block waiting to be written, or NULL
+	bool				quit;
+	bool				failed;
+	std::thread			writer;
+	std::mutex			mutex;
+	std::condition_variable	condition;
+};
+
+/* ==========================================
+	Class SampleCacheReader
+
+	Memory-maps a cache file. Nothing is read on open
+	besides the header and block table; raw blocks are
+	accessed in place and compressed blocks are decoded on
+	request.
+
+   ========================================== */
+
+class SampleCacheReader {
+public:
+						SampleCacheReader() : fileHeader( NULL ), blockTable( NULL ) {}
+
+	// returns false and fills 'error' (if given) when the file can't be used
+	bool				open( const char* path, std::string* error = NULL );
+	void				close();
+
+	const SampleCacheHeader& header() const { return *fileHeader; }
+	uint64_t			numSamples() const { return fileHeader->numSamples; }
+	size_t				numBlocks() const { return (size_t)fileHeader->numBlocks; }
+	size_t				blockSamples( size_t block ) const { return blockTable[ block ].numSamples; }
+
+	// column 'axis' of a raw block, straight from the mapping. Returns NULL
+	// for compressed blocks.
+	const float*		column( size_t block, int axis ) const;
+
+	// decodes a block into separate x, y, z arrays of blockSamples( block ) floats
+	bool				readBlock( size_t block, float* x, float* y, float* z ) const;
+
+	// decodes a block as interleaved xyz
+	bool				readInterleaved( size_t block, float* xyz ) const;
+
+	// appends every sample in the file as interleaved xyz
+	bool				readAll( std::vector< float >& xyz ) const;
+
+private:
+	MappedFile					file;
+	const SampleCacheHeader*	fileHeader;
+	const SampleCacheBlock*		blockTable;
+};
@@ -0,0 +1,217 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "SampleCodec.h"
+#include "BitOps.h"
+#include "Trace.h"
+
+#include <string.h>
+#include <float.h>
+#include <stdint.h>
+#include <algorithm>
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#include <immintrin.h>
+#endif
+
+namespace {
+	const int LOW_BITS = 16;
+	const int HIGH_BITS = 21;
+	const size_t GROUP_SIZE = 128;
+	const size_t PADDING = 8;
+
+	struct StreamHeader {
+		float		origin[ 3 ];
+		float		step[ 3 ];		// size of a quantization step per axis
+		uint32_t	bits;
+		uint32_t	reserved;
+	};
+
+	inline uint64_t load64( const unsigned char* p ) { uint64_t v; memcpy( &v, p, sizeof( v ) ); return v; }
+	inline void store64( unsigned char* p, uint64_t v ) { memcpy( p, &v, sizeof( v ) ); }
+
+	inline int bitWidth( uint64_t v ) {
+#if defined( __GNUC__ )
+		return v == 0 ? 0 : 64 - __builtin_clzll( v );
+#else
+		int w = 0;
+		for( ; v != 0; v >>= 1 ) w++;
+		return w;
+#endif
+	}
+
+	inline uint64_t widthMask( int width ) {
+		return width >= 64 ? ~0ULL : ( 1ULL << width ) - 1;
+	}
+
+	// 'width' bits at bit offset 'bit' of a zero-initialized buffer with at
+	// least PADDING bytes past the last value
+	inline void putBits( unsigned char* base, uint64_t bit, int width, uint64_t v ) {
+		unsigned char* p = base + ( bit >> 3 );
+		const int shift = (int)( bit & 7 );
+		store64( p, load64( p ) | ( v << shift ) );
+		if ( shift + width > 64 ) p[ 8 ] |= (unsigned char)( v >> ( 64 - shift ) );
+	}
+
+	inline uint64_t getBits( const unsigned char* base, uint64_t bit, int width, uint64_t mask ) {
+		const unsigned char* p = base + ( bit >> 3 );
+		const int shift = (int)( bit & 7 );
+		uint64_t v = load64( p ) >> shift;
+		if ( shift + width > 64 ) v |= (uint64_t)p[ 8 ] << ( 64 - shift );
+		return v & mask;
+	}
+
+	// Morton codes back to positions. BMI2 extracts each coordinate in a
+	// single instruction; it is used when the CPU supports it even if the
+	// library was built for a generic target.
+	void decodePositions( const uint64_t* codes, size_t n, const StreamHeader& header, float* x, float* y, float* z ) {
+		float* columns[ 3 ] = { x, y, z };
+		for( int axis = 0; axis < 3; axis++ ) {
+			const float origin = header.origin[ axis ];
+			const float step = header.step[ axis ];
+			float* column = columns[ axis ];
+			for( size_t i = 0; i < n; i++ ) {
+				column[ i ] = origin + (float)CompactBits3( codes[ i ] >> axis ) * step;
+			}
+		}
+	}
+
+	typedef void ( *DecodePositionsFn )( const uint64_t*, size_t, const StreamHeader&, float*, float*, float* );
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+	__attribute__(( target( "bmi2" ) ))
+	void decodePositionsBmi2( const uint64_t* codes, size_t n, const StreamHeader& header, float* x, float* y, float* z ) {
+		float* columns[ 3 ] = { x, y, z };
+		for( int axis = 0; axis < 3; axis++ ) {
+			const uint64_t mask = 0x1249249249249249ULL << axis;
+			const float origin = header.origin[ axis ];
+			const float step = header.step[ axis ];
+			float* column = columns[ axis ];
+			for( size_t i = 0; i < n; i++ ) {
+				column[ i ] = origin + (float)_pext_u64( codes[ i ], mask ) * step;
+			}
+		}
+	}
+
+	const DecodePositionsFn decodePositionsBest = __builtin_cpu_supports( "bmi2" ) ? decodePositionsBmi2 : decodePositions;
+#else
+	const DecodePositionsFn decodePositionsBest = decodePositions;
+#endif
+}
+
+int SampleCodec::BitsForError( const float* boundsMin, const float* boundsMax, float maxError ) {
+	return MaxError( boundsMin, boundsMax, LOW_BITS ) <= maxError ? LOW_BITS : HIGH_BITS;
+}
+
+float SampleCodec::MaxError( const float* boundsMin, const float* boundsMax, int bits ) {
+	float extent = 0;
+	for( int axis = 0; axis < 3; axis++ ) {
+		extent = std::max( extent, boundsMax[ axis ] - boundsMin[ axis ] );
+	}
+	// points are rounded to the nearest step
+	return 0.5f * extent / (float)( ( 1u << bits ) - 1 );
+}
+
+void SampleCodec::Encode( const float* x, const float* y, const float* z, size_t count, float maxError,
+						  std::vector< unsigned char >& out ) {
+	TRACE_SCOPE( "SampleCodec::Encode" );
+	const float* columns[ 3 ] = { x, y, z };
+
+	StreamHeader header;
+	memset( &header, 0, sizeof( header ) );
+	float boundsMax[ 3 ];
+	for( int axis = 0; axis < 3; axis++ ) {
+		float lo = FLT_MAX, hi = -FLT_MAX;
+		for( size_t i = 0; i < count; i++ ) {
+			lo = std::min( lo, columns[ axis ][ i ] );
+			hi = std::max( hi, columns[ axis ][ i ] );
+		}
+		header.origin[ axis ] = count > 0 ? lo : 0;
+		boundsMax[ axis ] = count > 0 ? hi : 0;
+	}
+	header.bits = BitsForError( header.origin, boundsMax, maxError );
+
+	const uint32_t maxQ = ( 1u << header.bits ) - 1;
+	float scale[ 3 ];
+	for( int axis = 0; axis < 3; axis++ ) {
+		const float extent = boundsMax[ axis ] - header.origin[ axis ];
+		header.step[ axis ] = extent > 0 ? extent / maxQ : 0;
+		scale[ axis ] = extent > 0 ? maxQ / extent : 0;
+	}
+
+	std::vector< uint64_t > codes( count );
+	for( size_t i = 0; i < count; i++ ) {
+		uint64_t code = 0;
+		for( int axis = 0; axis < 3; axis++ ) {
+			const float q = ( columns[ axis ][ i ] - header.origin[ axis ] ) * scale[ axis ] + 0.5f;
+			code |= SpreadBits3( std::min( maxQ, (uint32_t)q ) ) << axis;
+		}
+		codes[ i ] = code;
+	}
+	std::sort( codes.begin(), codes.end() );
+
+	// the differences between consecutive codes are stored in groups, each
+	// one bit-packed with the width of its largest value
+	const size_t first = out.size();
+	out.resize( first + sizeof( header ) );
+	memcpy( &out[ first ], &header, sizeof( header ) );
+	uint64_t previous = 0;
+	for( size_t begin = 0; begin < count; begin += GROUP_SIZE ) {
+		const size_t n = std::min( GROUP_SIZE, count - begin );
+		uint64_t deltas[ GROUP_SIZE ];
+		uint64_t bitsUsed = 0;
+		for( size_t i = 0; i < n; i++ ) {
+			deltas[ i ] = codes[ begin + i ] - previous;
+			previous = codes[ begin + i ];
+			bitsUsed |= deltas[ i ];
+		}
+		const int width = bitWidth( bitsUsed );
+		const size_t groupStart = out.size();
+		out.resize( groupStart + 1 + ( n * width + 7 ) / 8 + PADDING, 0 );
+		out[ groupStart ] = (unsigned char)width;
+		unsigned char* packed = &out[ groupStart + 1 ];
+		for( size_t i = 0; i < n; i++ ) {
+			putBits( packed, (uint64_t)i * width, width, deltas[ i ] );
+		}
+		out.resize( out.size() - PADDING );
+	}
+	// so that the decoder can always read 64 bits at once
+	out.resize( out.size() + PADDING, 0 );
+}
+
+bool SampleCodec::Decode( const unsigned char* data, size_t size, size_t count, float* x, float* y, float* z ) {
+	TRACE_SCOPE( "SampleCodec::Decode" );
+	StreamHeader header;
+	if ( size < sizeof( header ) + PADDING ) return false;
+	memcpy( &header, data, sizeof( header ) );
+	if ( header.bits != LOW_BITS && header.bits != HIGH_BITS ) return false;
+
+	const unsigned char* p = data + sizeof( header );
+	const unsigned char* end = data + size - PADDING;
+
+	// groups are unpacked and accumulated into Morton codes, which are then
+	// turned into positions in a separate loop free of branches
+	uint64_t codes[ GROUP_SIZE ];
+	uint64_t code = 0;
+	for( size_t begin = 0; begin < count; begin += GROUP_SIZE ) {
+		const size_t n = std::min( GROUP_SIZE, count - begin );
+		if ( p >= end ) return false;
+		const int width = *p++;
+		const size_t bytes = ( n * width + 7 ) / 8;
+		if ( width > 64 || (size_t)( end - p ) < bytes ) return false;
+
+		const uint64_t mask = widthMask( width );
+		for( size_t i = 0; i < n; i++ ) {
+			code += getBits( p, (uint64_t)i * width, width, mask );
+			codes[ i ] = code;
+		}
+		p += bytes;
+
+		decodePositionsBest( codes, n, header, x + begin, y + begin, z + begin );
+	}
+	return p == end;
+}
@@ -0,0 +1,48 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+
+/* ==========================================
+	Class SampleCodec
+
+	Lossy compression of a set of points, used by the sample
+	cache for storage and transfer.
+
+	Positions are quantized to 16 or 21 bits per axis over
+	the bounds of the set, the smallest precision that keeps
+	every point within a given distance of its original
+	position. The quantized coordinates are interleaved into
+	Morton codes and sorted, so consecutive codes are close
+	to each other; only the differences between them are
+	stored, as variable length integers.
+
+	The order of the points is not preserved.
+
+   ========================================== */
+
+class SampleCodec {
+public:
+	// quantization bits per axis needed to keep the error of points within
+	// [boundsMin, boundsMax] under 'maxError'. Returns the highest precision
+	// available (21) if that is not enough.
+	static int		BitsForError( const float* boundsMin, const float* boundsMax, float maxError );
+
+	// largest distance along any axis between a point and its decoded position
+	static float	MaxError( const float* boundsMin, const float* boundsMax, int bits );
+
+	// appends the encoding of 'count' points, given as separate x, y and z arrays
+	static void		Encode( const float* x, const float* y, const float* z, size_t count, float maxError,
+							std::vector< unsigned char >& out );
+
+	// decodes 'count' points from an encoded stream. Returns false if the
+	// stream is malformed.
+	static bool		Decode( const unsigned char* data, size_t size, size_t count, float* x, float* y, float* z );
+};
@@ -0,0 +1,43 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+/* ==========================================
+	Struct SamplerStats
+
+	Counters and stage timings of a sampler evaluation. The
+	samplers accumulate their counters into it; timings are
+	measured by whoever drives the stages. Fields that don't
+	apply to a given sampler are left at 0.
+
+   ========================================== */
+
+struct SamplerStats {
+	long long	raysCast;
+	long long	raysMissed;		// rays with fewer than 2 hits, which produce no chord
+	long long	chords;
+	long long	samplesRequested;
+	long long	samplesProduced;
+	long long	voxelsOccupied;
+
+	// milliseconds per stage
+	double		meshMs;			// reading and triangulating the input mesh
+	double		acceleratorMs;	// building the ray intersection accelerator
+	double		voxelizeMs;		// voxelization, including GPU rendering
+	double		readbackMs;		// reading back and decoding the GPU voxels
+	double		samplingMs;		// ray casting and/or sample generation
+	double		distanceMs;		// building the signed distance field
+
+	SamplerStats() { clear(); }
+
+	void clear() {
+		raysCast = raysMissed = chords = 0;
+		samplesRequested = samplesProduced = voxelsOccupied = 0;
+		meshMs = acceleratorMs = voxelizeMs = readbackMs = samplingMs = distanceMs = 0;
+	}
+};
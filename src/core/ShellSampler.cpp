@@ -0,0 +1,166 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "ShellSampler.h"
+#include "Trace.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace {
+	// give up on shells no sample manages to fall into after this many tries
+	const int MAX_MISSES = 100000;
+}
+
+void ShellSampler::setMesh( const MeshView& mesh, const VoxelGrid& grid, float shellThickness, InsideTest test ) {
+	TRACE_SCOPE( "ShellSampler::setMesh" );
+	voxels.clear();
+	tests.clear();
+	thickness = std::max( 0.0f, shellThickness );
+	bvh.build( mesh );
+	winding.clear();
+	if ( test == INSIDE_WINDING_NUMBER ) winding.build( mesh );
+	bounds = grid.bounds();
+	if ( grid.empty() || thickness <= 0 ) return;
+
+	int res[ 3 ];
+	for( int axis = 0; axis < 3; axis++ ) {
+		res[ axis ] = grid.resolution( axis );
+		voxelSize[ axis ] = grid.voxelSize( axis );
+	}
+
+	// voxels already in the list
+	VoxelGrid visited;
+	visited.init( res[ 0 ], res[ 1 ], res[ 2 ], bounds );
+	std::vector< int > candidates;
+
+	// the voxels the bounds of every triangle overlap hold the whole surface
+	for( size_t t = 0; t < mesh.numTriangles; t++ ) {
+		const int* tri = mesh.triangle( t );
+		int lo[ 3 ], hi[ 3 ];
+		for( int axis = 0; axis < 3; axis++ ) {
+			float tmin = mesh.point( tri[ 0 ] )[ axis ], tmax = tmin;
+			for( int k = 1; k < 3; k++ ) {
+				tmin = std::min( tmin, mesh.point( tri[ k ] )[ axis ] );
+				tmax = std::max( tmax, mesh.point( tri[ k ] )[ axis ] );
+			}
+			// triangles on the max faces of the bounds fall in the last voxels
+			lo[ axis ] = std::min( res[ axis ] - 1, std::max( 0, (int)floorf( ( tmin - bounds.min[ axis ] ) / voxelSize[ axis ] ) ) );
+			hi[ axis ] = std::min( res[ axis ] - 1, (int)floorf( ( tmax - bounds.min[ axis ] ) / voxelSize[ axis ] ) );
+		}
+		for( int z = lo[ 2 ]; z <= hi[ 2 ]; z++ ) {
+			for( int y = lo[ 1 ]; y <= hi[ 1 ]; y++ ) {
+				for( int x = lo[ 0 ]; x <= hi[ 0 ]; x++ ) {
+					if ( visited.get( x, y, z ) ) continue;
+					visited.set( x, y, z );
+					candidates.push_back( x );
+					candidates.push_back( y );
+					candidates.push_back( z );
+				}
+			}
+		}
+	}
+	const size_t numSurfaceVoxels = candidates.size() / 3;
+
+	// The rest of the voxels don't cross the surface, so they are either
+	// inside or outside as a whole. The shell continues into the occupied
+	// ones: layers of voxels are grown from the surface voxels, through
+	// every voxel so that the layers follow the distance to the surface,
+	// and the occupied ones are kept.
+	const float smallest = std::min( voxelSize[ 0 ], std::min( voxelSize[ 1 ], voxelSize[ 2 ] ) );
+	const int layers = (int)ceilf( thickness / smallest );
+	std::vector< int > layer( candidates ), next;
+	for( int l = 0; l < layers && !layer.empty(); l++ ) {
+		next.clear();
+		for( size_t v = 0; v < layer.size(); v += 3 ) {
+			const int x = layer[ v ], y = layer[ v + 1 ], z = layer[ v + 2 ];
+			for( int nz = std::max( 0, z - 1 ); nz <= std::min( res[ 2 ] - 1, z + 1 ); nz++ ) {
+				for( int ny = std::max( 0, y - 1 ); ny <= std::min( res[ 1 ] - 1, y + 1 ); ny++ ) {
+					for( int nx = std::max( 0, x - 1 ); nx <= std::min( res[ 0 ] - 1, x + 1 ); nx++ ) {
+						if ( visited.get( nx, ny, nz ) ) continue;
+						visited.set( nx, ny, nz );
+						next.push_back( nx );
+						next.push_back( ny );
+						next.push_back( nz );
+						if ( grid.get( nx, ny, nz ) ) {
+							candidates.push_back( nx );
+							candidates.push_back( ny );
+							candidates.push_back( nz );
+						}
+					}
+				}
+			}
+		}
+		layer.swap( next );
+	}
+
+	// the distance of the center of each voxel bounds those of its points
+	const float halfDiagonal = 0.5f * sqrtf( voxelSize[ 0 ] * voxelSize[ 0 ] + voxelSize[ 1 ] * voxelSize[ 1 ] + voxelSize[ 2 ] * voxelSize[ 2 ] );
+	for( size_t v = 0; v < candidates.size(); v += 3 ) {
+		float center[ 3 ];
+		for( int axis = 0; axis < 3; axis++ ) {
+			center[ axis ] = bounds.min[ axis ] + ( candidates[ v + axis ] + 0.5f ) * voxelSize[ axis ];
+		}
+		const float distance = bvh.closestDistance( center, thickness + halfDiagonal );
+		if ( distance >= thickness + halfDiagonal ) continue; // out of the shell as a whole
+
+		unsigned char voxelTests = v / 3 < numSurfaceVoxels ? TEST_INSIDE : 0;
+		if ( distance + halfDiagonal > thickness ) voxelTests |= TEST_DISTANCE;
+		voxels.insert( voxels.end(), &candidates[ v ], &candidates[ v ] + 3 );
+		tests.push_back( voxelTests );
+	}
+}
+
+bool ShellSampler::Sample( int numSamples, Random& rng, std::vector< float >& samples, SamplerStats* stats ) {
+	TRACE_SCOPE( "ShellSampler::Sample" );
+	if ( stats ) {
+		stats->samplesRequested += std::max( 0, numSamples );
+		stats->voxelsOccupied = (long long)numVoxels();
+	}
+	if ( numSamples <= 0 || voxels.empty() ) return false;
+
+	const uint32_t count = (uint32_t)numVoxels();
+
+	const size_t first = samples.size();
+	samples.resize( first + 3 * (size_t)numSamples );
+	float* const begin = &samples[ first ];
+	float* const end = begin + 3 * (size_t)numSamples;
+	float* out = begin;
+
+	long long insideTests = 0;
+	int misses = 0;
+	while( out < end ) {
+		const uint32_t index = rng.nextInt( count );
+		const int* voxel = &voxels[ 3 * index ];
+		for( int axis = 0; axis < 3; axis++ ) {
+			out[ axis ] = bounds.min[ axis ] + ( voxel[ axis ] + rng.nextFloat() ) * voxelSize[ axis ];
+		}
+
+		bool accepted = true;
+		if ( tests[ index ] & TEST_INSIDE ) {
+			insideTests++;
+			accepted = winding.empty() ? bvh.inside( out, hits ) : winding.inside( out );
+		}
+		if ( accepted && ( tests[ index ] & TEST_DISTANCE ) ) {
+			accepted = bvh.withinDistance( out, thickness );
+		}
+
+		if ( accepted ) {
+			out += 3;
+			misses = 0;
+		} else if ( ++misses >= MAX_MISSES && out == begin ) {
+			break;
+		}
+	}
+
+	if ( stats ) {
+		stats->raysCast += insideTests;
+		stats->samplesProduced += ( out - begin ) / 3;
+	}
+	samples.resize( first + ( out - begin ) );
+	return out > begin;
+}
@@ -0,0 +1,77 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+#include "TriangleBvh.h"
+#include "WindingNumber.h"
+#include "VoxelGrid.h"
+#include "Random.h"
+#include "SamplerStats.h"
+
+#include <vector>
+
+/* ==========================================
+	Class ShellSampler
+
+	Generates uniformly distributed samples inside a mesh and
+	within a given thickness of its surface.
+
+	Only the voxels that can hold such samples are kept, in a
+	sparse list: the voxels crossed by the surface, and the
+	occupied voxels within the thickness of them. Samples are
+	drawn uniformly in those voxels and kept if they lie
+	inside the mesh and close enough to the surface, both
+	tested exactly against the triangles.
+
+	Each voxel records which tests its samples need: voxels
+	away from the surface are inside as a whole, and those
+	whose center is close enough to the surface lie in the
+	shell as a whole, so most samples need no test at all.
+	The inside test counts the surfaces crossed by a ray, or
+	with INSIDE_WINDING_NUMBER evaluates the winding number,
+	for meshes with holes (which should then be voxelized
+	the same way).
+
+	The cost follows the area of the surface times the
+	thickness, not the volume of the mesh.
+
+   ========================================== */
+
+class ShellSampler {
+public:
+						ShellSampler() : thickness( 0 ) {}
+
+	// gathers the voxels of 'grid', a voxelization of 'mesh', that are
+	// within 'thickness' of its surface, whose samples are then tested
+	// inside the mesh with 'test'
+	void				setMesh( const MeshView& mesh, const VoxelGrid& grid, float thickness, InsideTest test = INSIDE_PARITY );
+
+	size_t				numVoxels() const { return voxels.size() / 3; }
+
+	// appends 'numSamples' xyz samples. Returns false if no sample lies in
+	// the shell. Sample counts and inside tests (as rays) are added to
+	// 'stats' if given.
+	bool				Sample( int numSamples, Random& rng, std::vector< float >& samples, SamplerStats* stats = NULL );
+
+private:
+	enum {
+		TEST_INSIDE = 1,
+		TEST_DISTANCE = 2
+	};
+
+	TriangleBvh				bvh;
+	WindingNumber			winding;			// built with INSIDE_WINDING_NUMBER only
+	Bounds					bounds;
+	float					voxelSize[ 3 ];
+	float					thickness;
+	std::vector< int >		voxels;				// xyz coordinates
+	std::vector< unsigned char >	tests;		// TEST_ flags of each voxel
+
+	std::vector< float >	hits;				// scratch for the inside tests
+};
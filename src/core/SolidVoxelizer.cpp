@@ -0,0 +1,248 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "SolidVoxelizer.h"
+#include "BitOps.h"
+#include "Trace.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace {
+	// Top-left rule: a column center lying exactly on an edge belongs to the
+	// triangle only if the edge is 'owned', which happens for exactly one
+	// of the two (counter-clockwise) triangles sharing it.
+	inline bool ownsEdge( double dx, double dy ) {
+		return dy > 0 || ( dy == 0 && dx < 0 );
+	}
+
+	inline bool insideEdge( double w, double dx, double dy ) {
+		return w > 0 || ( w == 0 && ownsEdge( dx, dy ) );
+	}
+
+	// Rasterizes every triangle onto the columns of 'grid', calling
+	// visit( x, y, z ) for each column center it covers, with z the first
+	// voxel above the surface there (possibly outside the grid).
+	template< typename Visitor >
+	void rasterize( const MeshView& mesh, const VoxelGrid& grid, Visitor visit ) {
+		const Bounds& bounds = grid.bounds();
+		const int resX = grid.resX();
+		const int resY = grid.resY();
+		const double dx = grid.voxelSize( 0 );
+		const double dy = grid.voxelSize( 1 );
+		const double dz = grid.voxelSize( 2 );
+		if ( dx <= 0 || dy <= 0 || dz <= 0 ) return; // flat mesh, no interior
+
+		for( size_t t = 0; t < mesh.numTriangles; t++ ) {
+			const int* tri = mesh.triangle( t );
+			const float* a = mesh.point( tri[ 0 ] );
+			const float* b = mesh.point( tri[ 1 ] );
+			const float* c = mesh.point( tri[ 2 ] );
+
+			// work in grid units, where column (x, y) is centered at (x + 0.5, y + 0.5)
+			double ax = ( a[ 0 ] - bounds.min[ 0 ] ) / dx, ay = ( a[ 1 ] - bounds.min[ 1 ] ) / dy;
+			double bx = ( b[ 0 ] - bounds.min[ 0 ] ) / dx, by = ( b[ 1 ] - bounds.min[ 1 ] ) / dy;
+			double cx = ( c[ 0 ] - bounds.min[ 0 ] ) / dx, cy = ( c[ 1 ] - bounds.min[ 1 ] ) / dy;
+			double az = ( a[ 2 ] - bounds.min[ 2 ] ) / dz;
+			double bz = ( b[ 2 ] - bounds.min[ 2 ] ) / dz;
+			double cz = ( c[ 2 ] - bounds.min[ 2 ] ) / dz;
+
+			double area = ( bx - ax ) * ( cy - ay ) - ( by - ay ) * ( cx - ax );
+			if ( area == 0 ) continue; // parallel to the columns, never crossed
+			if ( area < 0 ) { // make it counter-clockwise
+				std::swap( bx, cx );
+				std::swap( by, cy );
+				std::swap( bz, cz );
+				area = -area;
+			}
+
+			const int x0 = std::max( 0, (int)ceil( std::min( ax, std::min( bx, cx ) ) - 0.5 ) );
+			const int x1 = std::min( resX - 1, (int)floor( std::max( ax, std::max( bx, cx ) ) - 0.5 ) );
+			const int y0 = std::max( 0, (int)ceil( std::min( ay, std::min( by, cy ) ) - 0.5 ) );
+			const int y1 = std::min( resY - 1, (int)floor( std::max( ay, std::max( by, cy ) ) - 0.5 ) );
+
+			for( int y = y0; y <= y1; y++ ) {
+				const double py = y + 0.5;
+				for( int x = x0; x <= x1; x++ ) {
+					const double px = x + 0.5;
+					// edge functions, each one weighting the opposite vertex
+					const double wa = ( cx - bx ) * ( py - by ) - ( cy - by ) * ( px - bx );
+					const double wb = ( ax - cx ) * ( py - cy ) - ( ay - cy ) * ( px - cx );
+					const double wc = ( bx - ax ) * ( py - ay ) - ( by - ay ) * ( px - ax );
+					if ( !insideEdge( wa, cx - bx, cy - by ) ||
+						 !insideEdge( wb, ax - cx, ay - cy ) ||
+						 !insideEdge( wc, bx - ax, by - ay ) ) {
+						continue;
+					}
+					// first voxel whose center lies above the surface
+					const double z = ( wa * az + wb * bz + wc * cz ) / area;
+					visit( x, y, (int)floor( z - 0.5 ) + 1 );
+				}
+			}
+		}
+	}
+
+	// spans with a winding number further than this from 0 or 1 are
+	// classified voxel by voxel
+	const float AMBIGUOUS_WINDING = 0.1f;
+
+	// sets the voxels [z0, z1) of the column
+	void setSpan( VoxelGrid::Word* column, int z0, int z1 ) {
+		const int BITS = VoxelGrid::BITS_PER_WORD;
+		for( int w = z0 / BITS; w * BITS < z1; w++ ) {
+			const int lo = std::max( z0 - w * BITS, 0 ), hi = std::min( z1 - w * BITS, BITS );
+			const VoxelGrid::Word bits = hi - lo == BITS ? ~(VoxelGrid::Word)0 : ( ( (VoxelGrid::Word)1 << ( hi - lo ) ) - 1 );
+			column[ w ] |= bits << lo;
+		}
+	}
+}
+
+bool SolidVoxelizer::Voxelize( const MeshView& mesh, int resX, int resY, int resZ, VoxelGrid& grid, InsideTest test ) {
+	resX = std::max( 1, resX );
+	resY = std::max( 1, resY );
+	resZ = std::max( 1, resZ );
+
+	const Bounds bounds = mesh.bounds();
+	if ( bounds.empty() ) {
+		grid.clear();
+		return false;
+	}
+
+	grid.init( resX, resY, resZ, bounds );
+	Voxelize( mesh, grid, test );
+	return true;
+}
+
+void SolidVoxelizer::Voxelize( const MeshView& mesh, VoxelGrid& grid, InsideTest test ) {
+	if ( test == INSIDE_WINDING_NUMBER ) {
+		WindingNumber winding;
+		winding.build( mesh );
+		Voxelize( mesh, grid, winding );
+		return;
+	}
+
+	TRACE_SCOPE( "SolidVoxelizer::Voxelize" );
+	// flip every voxel above each crossing of the surface
+	rasterize( mesh, grid, [ &grid ]( int x, int y, int z ) { grid.toggleFrom( x, y, z ); } );
+}
+
+void SolidVoxelizer::Voxelize( const MeshView& mesh, VoxelGrid& grid, const WindingNumber& winding, int threads ) {
+	TRACE_SCOPE( "SolidVoxelizer::Voxelize" );
+	if ( grid.empty() ) return;
+	const int resX = grid.resX(), resY = grid.resY(), resZ = grid.resZ();
+	const size_t numColumns = (size_t)resX * resY;
+
+	// the crossings of each column, clamped to the grid, counted first and
+	// then gathered by column
+	std::vector< uint32_t > columnStart( numColumns + 1, 0 );
+	rasterize( mesh, grid, [ & ]( int x, int y, int ) { columnStart[ (size_t)y * resX + x + 1 ]++; } );
+	for( size_t c = 0; c < numColumns; c++ ) {
+		columnStart[ c + 1 ] += columnStart[ c ];
+	}
+	std::vector< int > crossings( columnStart[ numColumns ] );
+	std::vector< uint32_t > next( columnStart.begin(), columnStart.end() - 1 );
+	rasterize( mesh, grid, [ & ]( int x, int y, int z ) {
+		crossings[ next[ (size_t)y * resX + x ]++ ] = std::max( 0, std::min( resZ, z ) );
+	} );
+
+	// The voxels between two crossings are either all inside or all outside
+	// a closed mesh, and for any other mesh they are classified together by
+	// the winding number at their middle: one query per span of voxels
+	// rather than per voxel.
+	struct Span {
+		uint32_t	column;
+		int			z0, z1;
+		bool		end;		// before the first crossing or after the last
+	};
+	std::vector< Span > spans;
+	std::vector< float > queries;
+	spans.reserve( numColumns + crossings.size() );
+	queries.reserve( 3 * ( numColumns + crossings.size() ) );
+	const Bounds& bounds = grid.bounds();
+	const float dx = grid.voxelSize( 0 ), dy = grid.voxelSize( 1 ), dz = grid.voxelSize( 2 );
+	for( int y = 0; y < resY; y++ ) {
+		for( int x = 0; x < resX; x++ ) {
+			const size_t c = (size_t)y * resX + x;
+			int* first = crossings.empty() ? NULL : &crossings[ 0 ] + columnStart[ c ];
+			int* last = crossings.empty() ? NULL : &crossings[ 0 ] + columnStart[ c + 1 ];
+			std::sort( first, last );
+			int z0 = 0;
+			for( int* crossing = first; ; crossing++ ) {
+				const int z1 = crossing < last ? *crossing : resZ;
+				if ( z1 > z0 ) {
+					const Span span = { (uint32_t)c, z0, z1, crossing == first || crossing >= last };
+					spans.push_back( span );
+					queries.push_back( bounds.min[ 0 ] + ( x + 0.5f ) * dx );
+					queries.push_back( bounds.min[ 1 ] + ( y + 0.5f ) * dy );
+					queries.push_back( bounds.min[ 2 ] + 0.5f * ( z0 + z1 ) * dz );
+				}
+				if ( crossing >= last ) break;
+				z0 = z1;
+			}
+		}
+	}
+
+	std::vector< float > values( spans.size() );
+	if ( !spans.empty() ) winding.evaluate( &queries[ 0 ], spans.size(), &values[ 0 ], threads );
+
+	// Near holes the winding number is fractional and may cross one half
+	// within a span, so those spans are classified voxel by voxel.
+	std::vector< Span > voxels;
+	queries.clear();
+	for( size_t i = 0; i < spans.size(); i++ ) {
+		const Span& span = spans[ i ];
+		const int x = span.column % resX, y = span.column / resX;
+		const float w = fabsf( values[ i ] );
+		// spans reaching the ends of a column without crossing the surface
+		// can only be inside past a hole
+		const bool end = span.end && WindingNumber::Inside( values[ i ] );
+		if ( ( !end && ( w < AMBIGUOUS_WINDING || w > 1.0f - AMBIGUOUS_WINDING ) ) || span.z1 - span.z0 == 1 ) {
+			if ( WindingNumber::Inside( values[ i ] ) ) setSpan( grid.column( x, y ), span.z0, span.z1 );
+			continue;
+		}
+		for( int z = span.z0; z < span.z1; z++ ) {
+			const Span voxel = { span.column, z, z + 1, false };
+			voxels.push_back( voxel );
+			queries.push_back( bounds.min[ 0 ] + ( x + 0.5f ) * dx );
+			queries.push_back( bounds.min[ 1 ] + ( y + 0.5f ) * dy );
+			queries.push_back( bounds.min[ 2 ] + ( z + 0.5f ) * dz );
+		}
+	}
+	values.resize( voxels.size() );
+	if ( !voxels.empty() ) winding.evaluate( &queries[ 0 ], voxels.size(), &values[ 0 ], threads );
+	for( size_t i = 0; i < voxels.size(); i++ ) {
+		if ( WindingNumber::Inside( values[ i ] ) ) grid.set( voxels[ i ].column % resX, voxels[ i ].column / resX, voxels[ i ].z0 );
+	}
+}
+
+void SolidVoxelizer::DecodeGpuColumns( const unsigned int* texels, int resX, int resY, int resZ,
+									   const Bounds& bounds, VoxelGrid& grid ) {
+	TRACE_SCOPE( "SolidVoxelizer::DecodeGpuColumns" );
+	// The GL bits count slices from the top of the bounds, channel 3 holding
+	// the first 32 of them. Also, due to the way the bits are constructed,
+	// the resulting slices are offset half a voxel, which we compensate by
+	// shifting the grid bounds instead.
+	const float deltaZ = bounds.size( 2 ) / resZ;
+	Bounds gridBounds = bounds;
+	gridBounds.min[ 2 ] += deltaZ * 0.5f;
+	gridBounds.max[ 2 ] += deltaZ * 0.5f;
+	grid.init( resX, resY, resZ, gridBounds );
+
+	for( int y = 0; y < resY; y++ ) {
+		for( int x = 0; x < resX; x++ ) {
+			const unsigned int* texel = texels + 4 * ( x + y * resX );
+			for( int i = 3; i >= 0; i-- ) {
+				for( unsigned int col = texel[ i ]; col != 0; col &= col - 1 ) { // unpack color data
+					const int z = resZ - 1 - ( 32 * ( 3 - i ) + LowestBit( col ) );
+					if ( z >= 0 ) {
+						grid.set( x, y, z );
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,57 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+#include "VoxelGrid.h"
+#include "WindingNumber.h"
+
+/* ==========================================
+	Class SolidVoxelizer
+
+	CPU counterpart of the GPU voxelizer used by the
+	VoxelSampler node ("Single-Pass GPU Solid Voxelization
+	for Real-Time Applications"): every triangle is rasterized
+	onto the XY grid of columns, and at each covered column
+	center the voxels above the surface are XORed. After all
+	triangles are processed the bits set are the voxels with
+	an odd number of surfaces below them, i.e. the interior.
+
+	Column centers lying exactly on a shared edge are assigned
+	to a single triangle (top-left rule), so parity is kept on
+	closed meshes. Unlike the GPU version the resolution along
+	Z is not limited to 128 voxels.
+
+	Parity only holds for closed meshes: a hole or an
+	overlapping shell flips the rest of the column. With
+	INSIDE_WINDING_NUMBER the crossings of each column are
+	gathered and sorted instead, and each span of voxels
+	between two of them is kept or not as a whole by the
+	winding number at its middle (see WindingNumber).
+
+   ========================================== */
+
+class SolidVoxelizer {
+public:
+	// voxelizes 'mesh' on a grid fitted to its bounds
+	static bool Voxelize( const MeshView& mesh, int resX, int resY, int resZ, VoxelGrid& grid,
+						  InsideTest test = INSIDE_PARITY );
+
+	// voxelizes 'mesh' on an already initialized grid, whose bounds should
+	// enclose the mesh
+	static void Voxelize( const MeshView& mesh, VoxelGrid& grid, InsideTest test = INSIDE_PARITY );
+
+	// same as above with the winding numbers of 'mesh' already built, and
+	// evaluated on up to 'threads' threads (0 for all the cores)
+	static void Voxelize( const MeshView& mesh, VoxelGrid& grid, const WindingNumber& winding, int threads = 0 );
+
+	// copies the render target read back by the GPU voxelizer (one RGBA32UI
+	// texel per column, voxelizing the given mesh bounds) to 'grid'
+	static void DecodeGpuColumns( const unsigned int* texels, int resX, int resY, int resZ,
+								  const Bounds& bounds, VoxelGrid& grid );
+};
@@ -0,0 +1,441 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Thinning.h"
+#include "Bounds.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+	// weighted sample elimination parameters for 3D, as in Yuksel's paper;
+	// its alpha of 8 is built into eliminationWeight
+	const float ELIMINATION_BETA = 0.65f;
+	const float ELIMINATION_GAMMA = 1.5f;
+
+	// the volume the points fill is estimated on a grid of this many cells
+	// per side
+	const int OCCUPANCY_RES = 64;
+
+	// bound on the cells of the stratification and neighbour grids
+	const size_t MAX_GRID_CELLS = (size_t)1 << 26;
+
+	// stratification grids tried to find one with enough filled cells
+	const int STRATIFY_ROUNDS = 4;
+
+	// radix selection collects the remaining keys once there are this few
+	const size_t COLLECT_KEYS = 1 << 16;
+	const int RADIX_BITS = 16;
+	const size_t RADIX_BUCKETS = (size_t)1 << RADIX_BITS;
+
+	// end of the point lists of WeightQueue
+	const uint32_t NO_POINT = 0xFFFFFFFF;
+
+	// random in the high half, the index in the low half so that no two
+	// points share a key
+	uint64_t pointKey( uint64_t seed, size_t index ) {
+		uint64_t z = seed + ( index + 1 ) * 0x9E3779B97F4A7C15ULL;
+		z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+		z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+		z ^= z >> 31;
+		return ( z & 0xFFFFFFFF00000000ULL ) | (uint32_t)index;
+	}
+
+	void atomicMin( std::atomic< uint64_t >& value, uint64_t candidate ) {
+		uint64_t current = value.load( std::memory_order_relaxed );
+		while( candidate < current && !value.compare_exchange_weak( current, candidate, std::memory_order_relaxed ) ) {}
+	}
+
+	// Finds the 'count'-th smallest of the keys of the candidate points,
+	// 'key' returning false for those that are not. Returns false if there
+	// aren't more candidates than 'count'.
+	template< typename KeyFn >
+	bool cutoffKey( size_t numPoints, size_t count, int threads, const KeyFn& key, uint64_t& cutoff ) {
+		TRACE_SCOPE( "cutoffKey" );
+		const size_t ranges = NumRanges( numPoints, threads );
+		uint64_t prefix = 0;
+		int shift = 64;		// bits below the prefix
+		size_t rank = count;
+		for( bool first = true; ; first = false ) {
+			// keys sharing the bits of the prefix, by the next bits
+			std::vector< std::vector< uint32_t > > histograms( ranges, std::vector< uint32_t >( RADIX_BUCKETS, 0 ) );
+			ParallelForRanges( numPoints, threads, [ & ]( size_t r, size_t begin, size_t end ) {
+				uint32_t* histogram = &histograms[ r ][ 0 ];
+				uint64_t k;
+				for( size_t i = begin; i < end; i++ ) {
+					if ( !key( i, k ) || ( shift < 64 && ( k >> shift ) != ( prefix >> shift ) ) ) continue;
+					histogram[ ( k >> ( shift - RADIX_BITS ) ) & ( RADIX_BUCKETS - 1 ) ]++;
+				}
+			} );
+			std::vector< size_t > histogram( RADIX_BUCKETS, 0 );
+			size_t total = 0;
+			for( size_t r = 0; r < ranges; r++ ) {
+				for( size_t b = 0; b < RADIX_BUCKETS; b++ ) histogram[ b ] += histograms[ r ][ b ];
+			}
+			for( size_t b = 0; b < RADIX_BUCKETS; b++ ) total += histogram[ b ];
+			if ( first && total <= count ) return false;
+
+			if ( total <= COLLECT_KEYS || shift == RADIX_BITS ) {
+				std::vector< uint64_t > keys;
+				keys.reserve( total );
+				uint64_t k;
+				for( size_t i = 0; i < numPoints; i++ ) {
+					if ( key( i, k ) && ( shift == 64 || ( k >> shift ) == ( prefix >> shift ) ) ) keys.push_back( k );
+				}
+				std::nth_element( keys.begin(), keys.begin() + ( rank - 1 ), keys.end() );
+				cutoff = keys[ rank - 1 ];
+				return true;
+			}
+
+			size_t bucket = 0;
+			while( histogram[ bucket ] < rank ) rank -= histogram[ bucket++ ];
+			shift -= RADIX_BITS;
+			prefix |= (uint64_t)bucket << shift;
+		}
+	}
+
+	// appends the points 'keep' accepts, in order
+	template< typename KeepFn >
+	void keepPoints( const float* points, size_t numPoints, int threads, const KeepFn& keep, std::vector< float >& result ) {
+		TRACE_SCOPE( "keepPoints" );
+		std::vector< std::vector< float > > kept( NumRanges( numPoints, threads ) );
+		ParallelForRanges( numPoints, threads, [ & ]( size_t r, size_t begin, size_t end ) {
+			for( size_t i = begin; i < end; i++ ) {
+				if ( keep( i ) ) kept[ r ].insert( kept[ r ].end(), points + 3 * i, points + 3 * i + 3 );
+			}
+		} );
+		for( size_t r = 0; r < kept.size(); r++ ) {
+			result.insert( result.end(), kept[ r ].begin(), kept[ r ].end() );
+		}
+	}
+
+	// bounds of the points, widened so that no side is under 1 / OCCUPANCY_RES
+	// of the largest one
+	Bounds pointBounds( const float* points, size_t numPoints, int threads ) {
+		std::vector< Bounds > partial( NumRanges( numPoints, threads ) );
+		ParallelForRanges( numPoints, threads, [ & ]( size_t r, size_t begin, size_t end ) {
+			partial[ r ].clear();
+			for( size_t i = begin; i < end; i++ ) partial[ r ].expand( points + 3 * i );
+		} );
+		Bounds bounds;
+		bounds.clear();
+		for( size_t r = 0; r < partial.size(); r++ ) bounds.expand( partial[ r ] );
+		const float largest = std::max( bounds.size( 0 ), std::max( bounds.size( 1 ), bounds.size( 2 ) ) );
+		const float smallest = std::max( largest / OCCUPANCY_RES, 1e-6f );
+		for( int axis = 0; axis < 3; axis++ ) {
+			const float grow = 0.5f * std::max( 0.0f, smallest - bounds.size( axis ) );
+			bounds.min[ axis ] -= grow;
+			bounds.max[ axis ] += grow;
+		}
+		return bounds;
+	}
+
+	// volume of the cells of a coarse grid over 'bounds' holding any point
+	float filledVolume( const float* points, size_t numPoints, const Bounds& bounds, int threads ) {
+		const size_t cells = (size_t)OCCUPANCY_RES * OCCUPANCY_RES * OCCUPANCY_RES;
+		std::vector< std::vector< unsigned char > > filled( NumRanges( numPoints, threads ), std::vector< unsigned char >( cells, 0 ) );
+		ParallelForRanges( numPoints, threads, [ & ]( size_t r, size_t begin, size_t end ) {
+			for( size_t i = begin; i < end; i++ ) {
+				size_t index = 0;
+				for( int axis = 2; axis >= 0; axis-- ) {
+					const float u = ( points[ 3 * i + axis ] - bounds.min[ axis ] ) / bounds.size( axis ) * OCCUPANCY_RES;
+					index = index * OCCUPANCY_RES + std::max( 0, std::min( OCCUPANCY_RES - 1, (int)u ) );
+				}
+				filled[ r ][ index ] = 1;
+			}
+		} );
+		size_t count = 0;
+		for( size_t c = 0; c < cells; c++ ) {
+			bool any = false;
+			for( size_t r = 0; r < filled.size() && !any; r++ ) any = filled[ r ][ c ] != 0;
+			if ( any ) count++;
+		}
+		return bounds.volume() * count / cells;
+	}
+
+	// uniform grid over some bounds, with cells of about 'cellSize'
+	struct PointGrid {
+		Bounds	bounds;
+		int		res[ 3 ];
+		float	scale[ 3 ];		// cells per unit
+		bool	coarsened;		// the cells are larger than asked for
+
+		PointGrid( const Bounds& bounds, float cellSize ) : bounds( bounds ), coarsened( false ) {
+			// coarser cells if there would be too many
+			double cells;
+			for( ;; ) {
+				cells = 1;
+				for( int axis = 0; axis < 3; axis++ ) {
+					res[ axis ] = std::max( 1, (int)ceilf( bounds.size( axis ) / cellSize ) );
+					cells *= res[ axis ];
+				}
+				if ( cells <= MAX_GRID_CELLS ) break;
+				cellSize *= 1.25f;
+				coarsened = true;
+			}
+			for( int axis = 0; axis < 3; axis++ ) scale[ axis ] = res[ axis ] / bounds.size( axis );
+		}
+
+		size_t numCells() const { return (size_t)res[ 0 ] * res[ 1 ] * res[ 2 ]; }
+
+		int coord( int axis, float p ) const {
+			return std::max( 0, std::min( res[ axis ] - 1, (int)( ( p - bounds.min[ axis ] ) * scale[ axis ] ) ) );
+		}
+
+		size_t cell( const float* p ) const {
+			return ( (size_t)coord( 2, p[ 2 ] ) * res[ 1 ] + coord( 1, p[ 1 ] ) ) * res[ 0 ] + coord( 0, p[ 0 ] );
+		}
+	};
+
+	void thinRandom( const float* points, size_t numPoints, size_t count, uint64_t seed, int threads, std::vector< float >& result ) {
+		uint64_t cutoff;
+		auto key = [ seed ]( size_t i, uint64_t& k ) { k = pointKey( seed, i ); return true; };
+		if ( !cutoffKey( numPoints, count, threads, key, cutoff ) ) {
+			result.insert( result.end(), points, points + 3 * numPoints );
+			return;
+		}
+		keepPoints( points, numPoints, threads, [ seed, cutoff ]( size_t i ) { return pointKey( seed, i ) <= cutoff; }, result );
+	}
+
+	void thinStratified( const float* points, size_t numPoints, size_t count, uint64_t seed, int threads, std::vector< float >& result ) {
+		const Bounds bounds = pointBounds( points, numPoints, threads );
+		float cellSize = cbrtf( filledVolume( points, numPoints, bounds, threads ) / count );
+
+		// the smallest key of each cell
+		std::vector< std::atomic< uint64_t > > best;
+		size_t filledCells = 0;
+		for( int round = 0; round < STRATIFY_ROUNDS; round++ ) {
+			TRACE_SCOPE( "thinStratified::round" );
+			const PointGrid grid( bounds, cellSize );
+			std::vector< std::atomic< uint64_t > > cells( grid.numCells() );
+			for( size_t c = 0; c < cells.size(); c++ ) cells[ c ].store( UINT64_MAX, std::memory_order_relaxed );
+			ParallelForRanges( numPoints, threads, [ & ]( size_t, size_t begin, size_t end ) {
+				for( size_t i = begin; i < end; i++ ) {
+					atomicMin( cells[ grid.cell( points + 3 * i ) ], pointKey( seed, i ) );
+				}
+			} );
+			filledCells = 0;
+			for( size_t c = 0; c < cells.size(); c++ ) {
+				if ( cells[ c ].load( std::memory_order_relaxed ) != UINT64_MAX ) filledCells++;
+			}
+			best.swap( cells );
+			if ( filledCells >= count || grid.coarsened ) break;
+			// points on surfaces fill cells as the square of their size, in
+			// volumes as the cube: the square root reaches the count for
+			// both, overshooting a little for volumes
+			cellSize *= sqrtf( (float)filledCells / count );
+		}
+
+		// the low half of the keys is the index of the point
+		std::vector< uint64_t > cellKeys;
+		cellKeys.reserve( filledCells );
+		for( size_t c = 0; c < best.size(); c++ ) {
+			const uint64_t key = best[ c ].load( std::memory_order_relaxed );
+			if ( key != UINT64_MAX ) cellKeys.push_back( key );
+		}
+		if ( cellKeys.size() > count ) {
+			// a random subset of the cells
+			std::nth_element( cellKeys.begin(), cellKeys.begin() + ( count - 1 ), cellKeys.end() );
+			cellKeys.resize( count );
+		}
+		std::vector< unsigned char > keep( numPoints, 0 );
+		for( size_t c = 0; c < cellKeys.size(); c++ ) keep[ (uint32_t)cellKeys[ c ] ] = 1;
+		if ( cellKeys.size() < count ) {
+			// every cell, and random points from the rest
+			uint64_t cutoff;
+			auto key = [ & ]( size_t i, uint64_t& k ) { k = pointKey( seed, i ); return !keep[ i ]; };
+			if ( !cutoffKey( numPoints, count - cellKeys.size(), threads, key, cutoff ) ) cutoff = UINT64_MAX;
+			ParallelForRanges( numPoints, threads, [ & ]( size_t, size_t begin, size_t end ) {
+				for( size_t i = begin; i < end; i++ ) {
+					if ( pointKey( seed, i ) <= cutoff ) keep[ i ] = 1;
+				}
+			} );
+		}
+		keepPoints( points, numPoints, threads, [ & ]( size_t i ) { return keep[ i ] != 0; }, result );
+	}
+
+	// weight of a neighbour at distance d: ( 1 - d / reach ) ^ 8, with the
+	// alpha of the paper, and d no smaller than 2 rMin
+	float eliminationWeight( float distance2, float minDistance, float invReach ) {
+		const float d = std::max( minDistance, sqrtf( distance2 ) );
+		const float w = 1.0f - d * invReach;
+		const float w2 = w * w;
+		const float w4 = w2 * w2;
+		return w4 * w4;
+	}
+
+	// the points of a weighted sample elimination, sorted by cell of a grid
+	// as wide as the reach of the weights
+	struct EliminationGrid {
+		PointGrid					grid;
+		std::vector< uint32_t >		cellStart;
+		std::vector< uint32_t >		order;		// original index of each sorted point
+		std::vector< float >		sorted;
+		std::vector< bool >			removed;
+		float						reach2;
+
+		EliminationGrid( const float* points, size_t numPoints, const Bounds& bounds, float reach ) :
+			grid( bounds, reach ), cellStart( grid.numCells() + 1, 0 ), order( numPoints ), sorted( 3 * numPoints ),
+			removed( numPoints, false ), reach2( reach * reach ) {
+			std::vector< size_t > pointCell( numPoints );
+			for( size_t i = 0; i < numPoints; i++ ) {
+				pointCell[ i ] = grid.cell( points + 3 * i );
+				cellStart[ pointCell[ i ] + 1 ]++;
+			}
+			for( size_t c = 0; c < grid.numCells(); c++ ) cellStart[ c + 1 ] += cellStart[ c ];
+			std::vector< uint32_t > next( cellStart.begin(), cellStart.end() - 1 );
+			for( size_t i = 0; i < numPoints; i++ ) {
+				const uint32_t slot = next[ pointCell[ i ] ]++;
+				order[ slot ] = (uint32_t)i;
+				std::copy( points + 3 * i, points + 3 * i + 3, &sorted[ 3 * slot ] );
+			}
+		}
+
+		// calls 'visit' with every point still there within the reach of 'k',
+		// and its squared distance
+		template< typename VisitFn >
+		void forNeighbours( uint32_t k, VisitFn& visit ) const {
+			const float* p = &sorted[ 3 * k ];
+			int lo[ 3 ], hi[ 3 ];
+			for( int axis = 0; axis < 3; axis++ ) {
+				const int c = grid.coord( axis, p[ axis ] );
+				lo[ axis ] = std::max( 0, c - 1 );
+				hi[ axis ] = std::min( grid.res[ axis ] - 1, c + 1 );
+			}
+			for( int z = lo[ 2 ]; z <= hi[ 2 ]; z++ ) {
+				for( int y = lo[ 1 ]; y <= hi[ 1 ]; y++ ) {
+					const size_t row = ( (size_t)z * grid.res[ 1 ] + y ) * grid.res[ 0 ];
+					const uint32_t end = cellStart[ row + hi[ 0 ] + 1 ];
+					for( uint32_t j = cellStart[ row + lo[ 0 ] ]; j < end; j++ ) {
+						if ( j == k || removed[ j ] ) continue;
+						const float* q = &sorted[ 3 * j ];
+						const float dx = q[ 0 ] - p[ 0 ], dy = q[ 1 ] - p[ 1 ], dz = q[ 2 ] - p[ 2 ];
+						const float d2 = dx * dx + dy * dy + dz * dz;
+						if ( d2 < reach2 ) visit( j, d2 );
+					}
+				}
+			}
+		}
+	};
+
+	// Points by weight, quantized to WEIGHT_LEVELS levels, in lists linked
+	// through the points. Weights only decrease, so the heaviest level is
+	// searched for from the last one down, and points are left in the level
+	// they were in when their weight drops: the level of a point is only
+	// corrected when it comes up, which is far rarer.
+	struct WeightQueue {
+		enum { WEIGHT_LEVELS = 1 << 16 };
+
+		const std::vector< float >&	weights;
+		std::vector< uint32_t >	head;		// of each level
+		std::vector< uint32_t >	next;
+		float					scale;		// levels per unit of weight
+		int						top;		// no point is heavier
+
+		explicit WeightQueue( const std::vector< float >& weights ) :
+			weights( weights ), head( WEIGHT_LEVELS, NO_POINT ), next( weights.size() ), top( WEIGHT_LEVELS - 1 ) {
+			const float heaviest = weights.empty() ? 0.0f : *std::max_element( weights.begin(), weights.end() );
+			scale = heaviest > 0 ? ( WEIGHT_LEVELS - 1 ) / heaviest : 0.0f;
+			// pushed backwards so that each level lists its points in order
+			for( size_t i = weights.size(); i-- > 0; ) push( (uint32_t)i, levelOf( (uint32_t)i ) );
+		}
+
+		int levelOf( uint32_t point ) const { return std::max( 0, std::min( (int)WEIGHT_LEVELS - 1, (int)( weights[ point ] * scale ) ) ); }
+
+		void push( uint32_t point, int level ) {
+			next[ point ] = head[ level ];
+			head[ level ] = point;
+		}
+
+		// removes the point with the heaviest weight, up to the quantization
+		uint32_t pop() {
+			for( ;; ) {
+				while( head[ top ] == NO_POINT ) top--;
+				const uint32_t point = head[ top ];
+				head[ top ] = next[ point ];
+				const int level = levelOf( point );
+				if ( level == top ) return point;
+				push( point, level );
+			}
+		}
+	};
+
+	void thinElimination( const float* points, size_t numPoints, size_t count, uint64_t seed, int threads, std::vector< float >& result ) {
+		// more input than this doesn't improve the result, only slows it down
+		std::vector< float > input;
+		if ( numPoints > ELIMINATION_INPUT_RATIO * count ) {
+			thinRandom( points, numPoints, ELIMINATION_INPUT_RATIO * count, seed, threads, input );
+			points = &input[ 0 ];
+			numPoints = input.size() / 3;
+		}
+
+		const Bounds bounds = pointBounds( points, numPoints, threads );
+		const float volume = filledVolume( points, numPoints, bounds, threads );
+		const float rMax = cbrtf( volume / ( 4.0f * sqrtf( 2.0f ) * count ) );
+		const float rMin = rMax * ( 1.0f - powf( (float)count / numPoints, ELIMINATION_GAMMA ) ) * ELIMINATION_BETA;
+		const float minDistance = 2.0f * rMin;
+		const float invReach = 1.0f / ( 2.0f * rMax );
+
+		EliminationGrid neighbours( points, numPoints, bounds, 2.0f * rMax );
+		std::vector< float > weights( numPoints, 0.0f );
+		{
+			TRACE_SCOPE( "thinElimination::weights" );
+			ParallelForRanges( numPoints, threads, [ & ]( size_t, size_t begin, size_t end ) {
+				for( size_t k = begin; k < end; k++ ) {
+					float sum = 0;
+					auto add = [ & ]( uint32_t, float d2 ) { sum += eliminationWeight( d2, minDistance, invReach ); };
+					neighbours.forNeighbours( (uint32_t)k, add );
+					weights[ k ] = sum;
+				}
+			} );
+		}
+
+		{
+			TRACE_SCOPE( "thinElimination::eliminate" );
+			WeightQueue queue( weights );
+			auto subtract = [ & ]( uint32_t j, float d2 ) {
+				weights[ j ] -= eliminationWeight( d2, minDistance, invReach );
+			};
+			for( size_t left = numPoints; left > count; left-- ) {
+				const uint32_t k = queue.pop();
+				neighbours.removed[ k ] = true;
+				neighbours.forNeighbours( k, subtract );
+			}
+		}
+
+		std::vector< bool > kept( numPoints, false );
+		for( size_t k = 0; k < numPoints; k++ ) {
+			if ( !neighbours.removed[ k ] ) kept[ neighbours.order[ k ] ] = true;
+		}
+		for( size_t i = 0; i < numPoints; i++ ) {
+			if ( kept[ i ] ) result.insert( result.end(), points + 3 * i, points + 3 * i + 3 );
+		}
+	}
+}
+
+void ThinPoints( const float* points, size_t numPoints, size_t count, ThinningMethod method, uint64_t seed,
+				 std::vector< float >& result, int threads ) {
+	TRACE_SCOPE( "ThinPoints" );
+	result.clear();
+	if ( count == 0 || numPoints == 0 ) return;
+	if ( count >= numPoints ) {
+		result.assign( points, points + 3 * numPoints );
+		return;
+	}
+	threads = WorkerThreads( threads );
+	result.reserve( 3 * count );
+
+	switch( method ) {
+		case THINNING_STRATIFIED:	thinStratified( points, numPoints, count, seed, threads, result ); break;
+		case THINNING_ELIMINATION:	thinElimination( points, numPoints, count, seed, threads, result ); break;
+		default:					thinRandom( points, numPoints, count, seed, threads, result ); break;
+	}
+}
+
@@ -0,0 +1,62 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+enum ThinningMethod {
+	THINNING_RANDOM = 0,		// a uniformly random subset
+	THINNING_STRATIFIED,		// one point per cell of a grid
+	THINNING_ELIMINATION		// weighted sample elimination, as blue noise
+};
+
+/* ==========================================
+	ThinPoints
+
+	Keeps 'count' of the 'numPoints' interleaved xyz points,
+	in their original order, so that a dense sample set can be
+	reduced to several sparser ones without sampling again.
+
+	Every point gets a random key hashed from 'seed' and its
+	index, and the subsets are chosen as the points with the
+	smallest keys: radix selection finds the cutoff key in a
+	couple of passes over the points, with no sorting.
+
+	THINNING_STRATIFIED keeps the point with the smallest key
+	in each cell of a grid sized so that about 'count' cells
+	hold points, then trims or tops up the rest by key.
+
+	THINNING_ELIMINATION follows Yuksel's weighted sample
+	elimination: every point is weighted by how close its
+	neighbours are, and the heaviest point is removed until
+	'count' remain. Inputs over ELIMINATION_INPUT_RATIO times
+	'count' are randomly thinned to that first, as the result
+	doesn't improve beyond it. The removals are sequential,
+	picking the heaviest point up to a fine quantization of
+	the weights so that each one takes constant time.
+
+	Every removal updates the neighbours of a point anywhere
+	in the set, so once the points outgrow the caches the
+	removals wait on memory, and the cost grows faster than
+	'count': keeping 100k points out of 500k takes about
+	1.7 s on one core, and 1M out of 5M about 26 s. Only the
+	weights are computed on several threads. For larger
+	counts THINNING_STRATIFIED is far cheaper.
+
+	The passes over all the points run on up to 'threads'
+	threads (0 for all the cores), and the result doesn't
+	depend on their number.
+
+   ========================================== */
+
+enum { ELIMINATION_INPUT_RATIO = 5 };
+
+void ThinPoints( const float* points, size_t numPoints, size_t count, ThinningMethod method, uint64_t seed,
+				 std::vector< float >& result, int threads = 0 );
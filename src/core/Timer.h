@@ -0,0 +1,32 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+
+/* ==========================================
+	Class Timer
+
+	Wall clock stopwatch with millisecond readings, used to
+	time the stages of the samplers.
+
+   ========================================== */
+
+class Timer {
+public:
+	Timer() { restart(); }
+
+	void	restart() { begin = std::chrono::steady_clock::now(); }
+
+	double	elapsedMs() const {
+		return std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - begin ).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point begin;
+};
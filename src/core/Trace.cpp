@@ -0,0 +1,135 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+std::atomic< bool > Trace::enabled( false );
+
+namespace {
+
+	struct Event {
+		const char*	name;
+		uint64_t	begin;
+		uint64_t	end;
+	};
+
+	// Single producer ring buffer, owned by one thread. 'count' is only
+	// written by the owner; readers see every event below it complete.
+	struct ThreadBuffer {
+		enum { CAPACITY = 1 << 16 };
+
+		ThreadBuffer( int threadId ) : id( threadId ), count( 0 ) {}
+
+		int						id;
+		std::atomic< uint64_t >	count;
+		Event					events[ CAPACITY ];
+	};
+
+	// Buffers are never freed: events from threads that already exited
+	// remain available until the trace is written.
+	std::mutex						buffersMutex;
+	std::vector< ThreadBuffer* >	buffers;
+
+	thread_local ThreadBuffer*		threadBuffer = NULL;
+
+	ThreadBuffer* getThreadBuffer() {
+		if ( threadBuffer == NULL ) {
+			std::lock_guard< std::mutex > lock( buffersMutex );
+			threadBuffer = new ThreadBuffer( (int)buffers.size() + 1 );
+			buffers.push_back( threadBuffer );
+		}
+		return threadBuffer;
+	}
+
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+	std::string exitTracePath;
+
+	void writeOnExit() {
+		Trace::WriteChromeJson( exitTracePath.c_str() );
+	}
+
+	void writeEscaped( FILE* f, const char* s ) {
+		for( ; *s; s++ ) {
+			if ( *s == '"' || *s == '\\' ) fputc( '\\', f );
+			if ( (unsigned char)*s >= 0x20 ) fputc( *s, f );
+		}
+	}
+}
+
+uint64_t Trace::Now() {
+	return (uint64_t)std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - epoch ).count();
+}
+
+void Trace::Enable( bool enable ) {
+	enabled.store( enable, std::memory_order_relaxed );
+}
+
+void Trace::Record( const char* name, uint64_t begin, uint64_t end ) {
+	ThreadBuffer* buffer = getThreadBuffer();
+	const uint64_t index = buffer->count.load( std::memory_order_relaxed );
+	Event& e = buffer->events[ index % ThreadBuffer::CAPACITY ];
+	e.name = name;
+	e.begin = begin;
+	e.end = end;
+	buffer->count.store( index + 1, std::memory_order_release );
+}
+
+void Trace::Clear() {
+	std::lock_guard< std::mutex > lock( buffersMutex );
+	for( size_t i = 0; i < buffers.size(); i++ ) {
+		buffers[ i ]->count.store( 0, std::memory_order_relaxed );
+	}
+}
+
+bool Trace::WriteChromeJson( const char* path ) {
+	FILE* f = fopen( path, "w" );
+	if ( f == NULL ) return false;
+
+	std::lock_guard< std::mutex > lock( buffersMutex );
+
+	fprintf( f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n" );
+	bool first = true;
+	for( size_t b = 0; b < buffers.size(); b++ ) {
+		const ThreadBuffer* buffer = buffers[ b ];
+		fprintf( f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+				 first ? "" : ",\n", buffer->id, buffer->id );
+		first = false;
+
+		const uint64_t count = buffer->count.load( std::memory_order_acquire );
+		const uint64_t oldest = count > ThreadBuffer::CAPACITY ? count - ThreadBuffer::CAPACITY : 0;
+		for( uint64_t i = oldest; i < count; i++ ) {
+			const Event& e = buffer->events[ i % ThreadBuffer::CAPACITY ];
+			fprintf( f, ",\n{\"name\": \"" );
+			writeEscaped( f, e.name );
+			// timestamps are in microseconds
+			fprintf( f, "\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+					 buffer->id, e.begin / 1000.0, ( e.end - e.begin ) / 1000.0 );
+		}
+	}
+	fprintf( f, "\n]}\n" );
+	return fclose( f ) == 0;
+}
+
+const char* Trace::ConfigureFromEnvironment( bool writeAtExit ) {
+	const char* path = getenv( "SAMPLER_TRACE" );
+	if ( path == NULL || path[ 0 ] == '\0' ) return NULL;
+
+	if ( writeAtExit && exitTracePath.empty() ) {
+		atexit( writeOnExit );
+	}
+	exitTracePath = path;
+	Enable( true );
+	return exitTracePath.c_str();
+}
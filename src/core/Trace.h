@@ -0,0 +1,93 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+/* ==========================================
+	Class Trace
+
+	Timeline of the sampling pipeline stages, exported in the
+	Chrome trace event format (chrome://tracing, Perfetto).
+
+	Stages are marked with TRACE_SCOPE( "name" ), which
+	records a complete event when the scope exits. Each thread
+	writes to its own ring buffer, so recording takes no lock;
+	when the buffer is full the oldest events are overwritten.
+	While tracing is disabled a scope costs a single relaxed
+	atomic load.
+
+	Names must be string literals (or otherwise outlive the
+	trace), since only the pointer is recorded.
+
+	Setting the SAMPLER_TRACE environment variable to a file
+	path enables tracing from the start, to be written to that
+	file on exit (see ConfigureFromEnvironment).
+
+   ========================================== */
+
+class Trace {
+public:
+	static bool		IsEnabled() { return enabled.load( std::memory_order_relaxed ); }
+	static void		Enable( bool enable );
+
+	// discards the events recorded so far
+	static void		Clear();
+
+	// writes every recorded event as Chrome trace JSON. Should be called
+	// while no scope is being recorded, as events written concurrently may
+	// come out torn.
+	static bool		WriteChromeJson( const char* path );
+
+	// enables tracing if SAMPLER_TRACE is set, and optionally registers an
+	// exit handler writing the trace to it (not for plugins, which may be
+	// unloaded before exit). Returns the output path, or NULL.
+	static const char*	ConfigureFromEnvironment( bool writeAtExit = true );
+
+	// nanoseconds since the trace epoch
+	static uint64_t	Now();
+
+	static void		Record( const char* name, uint64_t begin, uint64_t end );
+
+private:
+	static std::atomic< bool >	enabled;
+};
+
+/* ==========================================
+	Class TraceScope
+
+	Records the lifetime of the enclosing scope, see
+	TRACE_SCOPE.
+
+   ========================================== */
+
+class TraceScope {
+public:
+	explicit TraceScope( const char* scopeName ) : name( NULL ), begin( 0 ) {
+		if ( Trace::IsEnabled() ) {
+			name = scopeName;
+			begin = Trace::Now();
+		}
+	}
+	~TraceScope() {
+		if ( name != NULL ) Trace::Record( name, begin, Trace::Now() );
+	}
+
+private:
+	TraceScope( const TraceScope& );
+	TraceScope& operator=( const TraceScope& );
+
+	const char*	name;
+	uint64_t	begin;
+};
+
+#define TRACE_CONCAT_IMPL( a, b ) a##b
+#define TRACE_CONCAT( a, b ) TRACE_CONCAT_IMPL( a, b )
+#define TRACE_SCOPE( name ) TraceScope TRACE_CONCAT( traceScope, __LINE__ )( name )
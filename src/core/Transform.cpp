@@ -0,0 +1,76 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Transform.h"
+#include "Trace.h"
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define SAMPLER_TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+	inline void transformPoint( const float* m, const float* in, float* out ) {
+		const float x = in[ 0 ], y = in[ 1 ], z = in[ 2 ];
+		out[ 0 ] = x * m[ 0 ] + y * m[ 4 ] + z * m[ 8 ] + m[ 12 ];
+		out[ 1 ] = x * m[ 1 ] + y * m[ 5 ] + z * m[ 9 ] + m[ 13 ];
+		out[ 2 ] = x * m[ 2 ] + y * m[ 6 ] + z * m[ 10 ] + m[ 14 ];
+	}
+}
+
+void TransformPoints( const float* matrix, const float* in, size_t count, float* out ) {
+	TRACE_SCOPE( "TransformPoints" );
+	size_t i = 0;
+
+#ifdef SAMPLER_TRANSFORM_SSE
+	// every element of the matrix broadcast to a register
+	__m128 m[ 12 ];
+	for( int row = 0; row < 4; row++ ) {
+		for( int column = 0; column < 3; column++ ) {
+			m[ 3 * row + column ] = _mm_set1_ps( matrix[ 4 * row + column ] );
+		}
+	}
+
+	for( ; i + 4 <= count; i += 4, in += 12, out += 12 ) {
+		// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 to separate x, y and z
+		const __m128 a = _mm_loadu_ps( in );
+		const __m128 b = _mm_loadu_ps( in + 4 );
+		const __m128 c = _mm_loadu_ps( in + 8 );
+		const __m128 x = _mm_shuffle_ps( a, _mm_shuffle_ps( b, c, _MM_SHUFFLE( 1, 1, 2, 2 ) ), _MM_SHUFFLE( 2, 0, 3, 0 ) );
+		const __m128 y = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 0, 0, 1, 1 ) ),
+										 _mm_shuffle_ps( b, c, _MM_SHUFFLE( 2, 2, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		const __m128 z = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 1, 1, 2, 2 ) ),
+										 _mm_shuffle_ps( c, c, _MM_SHUFFLE( 3, 3, 0, 0 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) );
+
+		const __m128 tx = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, m[ 0 ] ), _mm_mul_ps( y, m[ 3 ] ) ),
+									  _mm_add_ps( _mm_mul_ps( z, m[ 6 ] ), m[ 9 ] ) );
+		const __m128 ty = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, m[ 1 ] ), _mm_mul_ps( y, m[ 4 ] ) ),
+									  _mm_add_ps( _mm_mul_ps( z, m[ 7 ] ), m[ 10 ] ) );
+		const __m128 tz = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, m[ 2 ] ), _mm_mul_ps( y, m[ 5 ] ) ),
+									  _mm_add_ps( _mm_mul_ps( z, m[ 8 ] ), m[ 11 ] ) );
+
+		// and back to interleaved points
+		const __m128 xyLow = _mm_unpacklo_ps( tx, ty );		// x0 y0 x1 y1
+		const __m128 xyHigh = _mm_unpackhi_ps( tx, ty );	// x2 y2 x3 y3
+		_mm_storeu_ps( out, _mm_shuffle_ps( xyLow, _mm_shuffle_ps( tz, xyLow, _MM_SHUFFLE( 2, 2, 0, 0 ) ), _MM_SHUFFLE( 2, 0, 1, 0 ) ) );
+		_mm_storeu_ps( out + 4, _mm_shuffle_ps( _mm_shuffle_ps( xyLow, tz, _MM_SHUFFLE( 1, 1, 3, 3 ) ), xyHigh, _MM_SHUFFLE( 1, 0, 2, 0 ) ) );
+		_mm_storeu_ps( out + 8, _mm_shuffle_ps( _mm_shuffle_ps( tz, xyHigh, _MM_SHUFFLE( 2, 2, 2, 2 ) ),
+												_mm_shuffle_ps( xyHigh, tz, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+	}
+#endif
+
+	for( ; i < count; i++, in += 3, out += 3 ) {
+		transformPoint( matrix, in, out );
+	}
+}
+
+bool IsIdentity( const float* matrix ) {
+	for( int i = 0; i < 16; i++ ) {
+		if ( matrix[ i ] != ( i % 5 == 0 ? 1.0f : 0.0f ) ) return false;
+	}
+	return true;
+}
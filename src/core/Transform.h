@@ -0,0 +1,28 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+/* ==========================================
+	TransformPoints
+
+	Applies an affine transform to 'count' interleaved xyz
+	points. 'matrix' holds 16 floats in row-major order and
+	follows Maya's convention of points as row vectors
+	(p' = p * M), so the translation is in elements 12-14.
+
+	Points are transformed 4 at a time with SSE when it is
+	available. 'in' and 'out' may be the same array.
+
+   ========================================== */
+
+void TransformPoints( const float* matrix, const float* in, size_t count, float* out );
+
+// true if 'matrix' is the identity
+bool IsIdentity( const float* matrix );
@@ -0,0 +1,321 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "TriangleBvh.h"
+#include "TriangleDistance.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+#include <assert.h>
+
+namespace {
+	struct BinPredicate {
+		BinPredicate( const float* c, int a, float cmin, float s, int split ) :
+			centroids( c ), axis( a ), centroidMin( cmin ), scale( s ), splitBin( split ) {}
+		bool operator()( unsigned int tri ) const {
+			int bin = (int)( ( centroids[ 3 * tri + axis ] - centroidMin ) * scale );
+			return bin <= splitBin;
+		}
+		const float* centroids;
+		int axis;
+		float centroidMin;
+		float scale;
+		int splitBin;
+	};
+
+	struct CentroidCompare {
+		CentroidCompare( const float* c, int a ) : centroids( c ), axis( a ) {}
+		bool operator()( unsigned int i, unsigned int j ) const {
+			return centroids[ 3 * i + axis ] < centroids[ 3 * j + axis ];
+		}
+		const float* centroids;
+		int axis;
+	};
+}
+
+void TriangleBvh::clear() {
+	nodes.clear();
+	indices.clear();
+	vertices.clear();
+}
+
+void TriangleBvh::build( const MeshView& mesh ) {
+	TRACE_SCOPE( "TriangleBvh::build" );
+	clear();
+	if ( mesh.numTriangles == 0 ) return;
+
+	const size_t numTriangles = mesh.numTriangles;
+	std::vector< float > centroids( 3 * numTriangles );
+	std::vector< Bounds > triBounds( numTriangles );
+	indices.resize( numTriangles );
+	for( size_t i = 0; i < numTriangles; i++ ) {
+		const int* tri = mesh.triangle( i );
+		Bounds& b = triBounds[ i ];
+		for( int v = 0; v < 3; v++ ) {
+			b.expand( mesh.point( tri[ v ] ) );
+		}
+		for( int axis = 0; axis < 3; axis++ ) {
+			centroids[ 3 * i + axis ] = b.center( axis );
+		}
+		indices[ i ] = (unsigned int)i;
+	}
+
+	nodes.reserve( 2 * numTriangles / MAX_LEAF_TRIANGLES + 1 );
+	buildRecursive( 0, (unsigned int)numTriangles, centroids, triBounds, 0 );
+
+	// copy the triangles in leaf order
+	vertices.resize( 9 * numTriangles );
+	for( size_t i = 0; i < numTriangles; i++ ) {
+		const int* tri = mesh.triangle( indices[ i ] );
+		for( int v = 0; v < 3; v++ ) {
+			const float* p = mesh.point( tri[ v ] );
+			vertices[ 9 * i + 3 * v + 0 ] = p[ 0 ];
+			vertices[ 9 * i + 3 * v + 1 ] = p[ 1 ];
+			vertices[ 9 * i + 3 * v + 2 ] = p[ 2 ];
+		}
+	}
+}
+
+unsigned int TriangleBvh::buildRecursive( unsigned int begin, unsigned int end, const std::vector< float >& centroids,
+										  const std::vector< Bounds >& triBounds, int depth ) {
+	const unsigned int nodeIndex = (unsigned int)nodes.size();
+	nodes.push_back( Node() );
+
+	Node node;
+	Bounds centroidBounds;
+	for( unsigned int i = begin; i < end; i++ ) {
+		node.bounds.expand( triBounds[ indices[ i ] ] );
+		centroidBounds.expand( &centroids[ 3 * indices[ i ] ] );
+	}
+
+	const unsigned int count = end - begin;
+	if ( count <= MAX_LEAF_TRIANGLES || depth >= MAX_DEPTH - 2 ) {
+		node.first = begin;
+		node.count = count;
+		nodes[ nodeIndex ] = node;
+		return nodeIndex;
+	}
+
+	const int axis = centroidBounds.longestAxis();
+	const float extent = centroidBounds.size( axis );
+	unsigned int middle = begin + count / 2;
+
+	if ( extent > 0 ) {
+		// bin the triangles by centroid and evaluate the SAH at each bin boundary
+		const float scale = NUM_BINS * ( 1 - 1e-5f ) / extent;
+		unsigned int binCount[ NUM_BINS ] = { 0 };
+		Bounds binBounds[ NUM_BINS ];
+		for( unsigned int i = begin; i < end; i++ ) {
+			const unsigned int tri = indices[ i ];
+			const int bin = std::min( (int)NUM_BINS - 1, (int)( ( centroids[ 3 * tri + axis ] - centroidBounds.min[ axis ] ) * scale ) );
+			binCount[ bin ]++;
+			binBounds[ bin ].expand( triBounds[ tri ] );
+		}
+
+		float rightArea[ NUM_BINS ];
+		unsigned int rightCount[ NUM_BINS ];
+		Bounds accum;
+		unsigned int accumCount = 0;
+		for( int i = NUM_BINS - 1; i > 0; i-- ) {
+			accum.expand( binBounds[ i ] );
+			accumCount += binCount[ i ];
+			rightArea[ i ] = accum.area();
+			rightCount[ i ] = accumCount;
+		}
+
+		float bestCost = FLT_MAX;
+		int bestSplit = -1;
+		accum.clear();
+		accumCount = 0;
+		for( int i = 0; i < NUM_BINS - 1; i++ ) {
+			accum.expand( binBounds[ i ] );
+			accumCount += binCount[ i ];
+			if ( accumCount == 0 || rightCount[ i + 1 ] == 0 ) continue;
+			const float cost = accum.area() * accumCount + rightArea[ i + 1 ] * rightCount[ i + 1 ];
+			if ( cost < bestCost ) {
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+
+		if ( bestSplit >= 0 ) {
+			unsigned int* first = &indices[ 0 ] + begin;
+			unsigned int* last = &indices[ 0 ] + end;
+			middle = (unsigned int)( std::partition( first, last, BinPredicate( &centroids[ 0 ], axis, centroidBounds.min[ axis ], scale, bestSplit ) ) - &indices[ 0 ] );
+		}
+	}
+
+	if ( middle == begin || middle == end || extent <= 0 ) {
+		// could not separate the centroids, split the range in halves
+		middle = begin + count / 2;
+		std::nth_element( indices.begin() + begin, indices.begin() + middle, indices.begin() + end, CentroidCompare( &centroids[ 0 ], axis ) );
+	}
+
+	buildRecursive( begin, middle, centroids, triBounds, depth + 1 ); // left child is nodeIndex + 1
+	node.first = buildRecursive( middle, end, centroids, triBounds, depth + 1 );
+	node.count = 0;
+	nodes[ nodeIndex ] = node;
+	return nodeIndex;
+}
+
+namespace {
+	// slab test, returns whether the segment [tMin, tMax] overlaps the box
+	inline bool intersectBox( const Bounds& b, const float* origin, const float* invDir, float tMin, float tMax ) {
+		for( int axis = 0; axis < 3; axis++ ) {
+			float t0 = ( b.min[ axis ] - origin[ axis ] ) * invDir[ axis ];
+			float t1 = ( b.max[ axis ] - origin[ axis ] ) * invDir[ axis ];
+			if ( t0 > t1 ) std::swap( t0, t1 );
+			tMin = t0 > tMin ? t0 : tMin;
+			tMax = t1 < tMax ? t1 : tMax;
+			if ( tMin > tMax ) return false;
+		}
+		return true;
+	}
+
+	// squared distance from 'p' to the box, 0 inside it
+	inline float boxDistanceSquared( const Bounds& b, const float* p ) {
+		float d2 = 0;
+		for( int axis = 0; axis < 3; axis++ ) {
+			const float d = std::max( b.min[ axis ] - p[ axis ], std::max( 0.0f, p[ axis ] - b.max[ axis ] ) );
+			d2 += d * d;
+		}
+		return d2;
+	}
+
+	// Moller-Trumbore ray/triangle intersection
+	inline bool intersectTriangle( const float* v, const float* origin, const float* dir, float& t ) {
+		const float e1[ 3 ] = { v[ 3 ] - v[ 0 ], v[ 4 ] - v[ 1 ], v[ 5 ] - v[ 2 ] };
+		const float e2[ 3 ] = { v[ 6 ] - v[ 0 ], v[ 7 ] - v[ 1 ], v[ 8 ] - v[ 2 ] };
+		const float p[ 3 ] = { dir[ 1 ] * e2[ 2 ] - dir[ 2 ] * e2[ 1 ],
+							   dir[ 2 ] * e2[ 0 ] - dir[ 0 ] * e2[ 2 ],
+							   dir[ 0 ] * e2[ 1 ] - dir[ 1 ] * e2[ 0 ] };
+		const float det = e1[ 0 ] * p[ 0 ] + e1[ 1 ] * p[ 1 ] + e1[ 2 ] * p[ 2 ];
+		if ( det == 0 ) return false;
+		const float invDet = 1.0f / det;
+		const float s[ 3 ] = { origin[ 0 ] - v[ 0 ], origin[ 1 ] - v[ 1 ], origin[ 2 ] - v[ 2 ] };
+		const float u = ( s[ 0 ] * p[ 0 ] + s[ 1 ] * p[ 1 ] + s[ 2 ] * p[ 2 ] ) * invDet;
+		if ( u < 0 || u > 1 ) return false;
+		const float q[ 3 ] = { s[ 1 ] * e1[ 2 ] - s[ 2 ] * e1[ 1 ],
+							   s[ 2 ] * e1[ 0 ] - s[ 0 ] * e1[ 2 ],
+							   s[ 0 ] * e1[ 1 ] - s[ 1 ] * e1[ 0 ] };
+		const float w = ( dir[ 0 ] * q[ 0 ] + dir[ 1 ] * q[ 1 ] + dir[ 2 ] * q[ 2 ] ) * invDet;
+		if ( w < 0 || u + w > 1 ) return false;
+		t = ( e2[ 0 ] * q[ 0 ] + e2[ 1 ] * q[ 1 ] + e2[ 2 ] * q[ 2 ] ) * invDet;
+		return true;
+	}
+}
+
+size_t TriangleBvh::allIntersections( const float* origin, const float* dir, std::vector< float >& hits ) const {
+	if ( nodes.empty() ) return 0;
+
+	const size_t firstHit = hits.size();
+	const float invDir[ 3 ] = { 1.0f / dir[ 0 ], 1.0f / dir[ 1 ], 1.0f / dir[ 2 ] };
+
+	unsigned int stack[ MAX_DEPTH ];
+	int stackSize = 0;
+	stack[ stackSize++ ] = 0;
+
+	while( stackSize > 0 ) {
+		const Node& node = nodes[ stack[ --stackSize ] ];
+		if ( !intersectBox( node.bounds, origin, invDir, 0.0f, 1.0f ) ) continue;
+
+		if ( node.count > 0 ) {
+			for( unsigned int i = node.first; i < node.first + node.count; i++ ) {
+				float t;
+				if ( intersectTriangle( &vertices[ 9 * i ], origin, dir, t ) && t >= 0 && t <= 1 ) {
+					hits.push_back( t );
+				}
+			}
+			continue;
+		}
+
+		assert( stackSize + 2 <= MAX_DEPTH );
+		stack[ stackSize++ ] = node.first;
+		stack[ stackSize++ ] = (unsigned int)( &node - &nodes[ 0 ] ) + 1;
+	}
+
+	std::sort( hits.begin() + firstHit, hits.end() );
+	return hits.size() - firstHit;
+}
+
+bool TriangleBvh::withinDistance( const float* p, float distance ) const {
+	if ( nodes.empty() ) return false;
+	const float distance2 = distance * distance;
+
+	unsigned int stack[ MAX_DEPTH ];
+	int stackSize = 0;
+	stack[ stackSize++ ] = 0;
+
+	while( stackSize > 0 ) {
+		const Node& node = nodes[ stack[ --stackSize ] ];
+		if ( boxDistanceSquared( node.bounds, p ) > distance2 ) continue;
+
+		if ( node.count > 0 ) {
+			for( unsigned int i = node.first; i < node.first + node.count; i++ ) {
+				const float* v = &vertices[ 9 * i ];
+				if ( TriangleDistanceSquared( p, v, v + 3, v + 6 ) <= distance2 ) return true;
+			}
+			continue;
+		}
+
+		assert( stackSize + 2 <= MAX_DEPTH );
+		stack[ stackSize++ ] = node.first;
+		stack[ stackSize++ ] = (unsigned int)( &node - &nodes[ 0 ] ) + 1;
+	}
+	return false;
+}
+
+float TriangleBvh::closestDistance( const float* p, float maxDistance ) const {
+	float closest2 = maxDistance * maxDistance;
+	if ( nodes.empty() ) return maxDistance;
+
+	unsigned int stack[ MAX_DEPTH ];
+	int stackSize = 0;
+	stack[ stackSize++ ] = 0;
+
+	while( stackSize > 0 ) {
+		const Node& node = nodes[ stack[ --stackSize ] ];
+		if ( boxDistanceSquared( node.bounds, p ) >= closest2 ) continue;
+
+		if ( node.count > 0 ) {
+			for( unsigned int i = node.first; i < node.first + node.count; i++ ) {
+				const float* v = &vertices[ 9 * i ];
+				closest2 = std::min( closest2, TriangleDistanceSquared( p, v, v + 3, v + 6 ) );
+			}
+			continue;
+		}
+
+		// the closer child is visited first, so that the other one is more
+		// likely to be culled
+		const unsigned int left = (unsigned int)( &node - &nodes[ 0 ] ) + 1;
+		const unsigned int right = node.first;
+		const bool leftFirst = boxDistanceSquared( nodes[ left ].bounds, p ) <= boxDistanceSquared( nodes[ right ].bounds, p );
+		assert( stackSize + 2 <= MAX_DEPTH );
+		stack[ stackSize++ ] = leftFirst ? right : left;
+		stack[ stackSize++ ] = leftFirst ? left : right;
+	}
+	return sqrtf( closest2 );
+}
+
+bool TriangleBvh::inside( const float* p, std::vector< float >& hits ) const {
+	if ( nodes.empty() ) return false;
+
+	// the shortest way out crosses the fewest triangles
+	const Bounds& b = bounds();
+	int axis = 0;
+	float length = FLT_MAX, sign = 1;
+	for( int a = 0; a < 3; a++ ) {
+		if ( p[ a ] - b.min[ a ] < length ) { axis = a; length = p[ a ] - b.min[ a ]; sign = -1; }
+		if ( b.max[ a ] - p[ a ] < length ) { axis = a; length = b.max[ a ] - p[ a ]; sign = 1; }
+	}
+	float dir[ 3 ] = { 0, 0, 0 };
+	dir[ axis ] = sign * ( std::max( 0.0f, length ) + 0.01f * b.size( axis ) + 1e-6f );
+	hits.clear();
+	return ( allIntersections( p, dir, hits ) & 1 ) != 0;
+}
@@ -0,0 +1,75 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+
+#include <vector>
+
+/* ==========================================
+	Class TriangleBvh
+
+	Ray intersection accelerator over the triangles of a mesh,
+	replacing the uniform grid Maya builds internally for
+	MFnMesh::allIntersections.
+
+	The hierarchy is built with a binned surface area
+	heuristic. Triangles are copied in leaf order so that the
+	traversal does not need to go through the index buffer.
+
+   ========================================== */
+
+class TriangleBvh {
+public:
+	TriangleBvh() {}
+
+	void			build( const MeshView& mesh );
+	void			clear();
+	bool			empty() const { return nodes.empty(); }
+	size_t			numNodes() const { return nodes.size(); }
+
+	const Bounds&	bounds() const { return nodes[ 0 ].bounds; }
+
+	// Appends the parametric distance 't' of every intersection between the
+	// triangles and the segment origin + t * dir, t in [0, 1], sorted in
+	// increasing order. Returns the number of hits found.
+	size_t			allIntersections( const float* origin, const float* dir, std::vector< float >& hits ) const;
+
+	// true if some triangle is within 'distance' of the point 'p'. Returns as
+	// soon as one is found.
+	bool			withinDistance( const float* p, float distance ) const;
+
+	// distance from 'p' to the closest triangle, or 'maxDistance' if none is
+	// closer than that
+	float			closestDistance( const float* p, float maxDistance ) const;
+
+	// true if 'p' is inside the (closed) mesh, by the parity of the crossings
+	// of a segment from 'p' to the closest face of the bounds. 'hits' is
+	// used as scratch.
+	bool			inside( const float* p, std::vector< float >& hits ) const;
+
+private:
+	struct Node {
+		Bounds			bounds;
+		unsigned int	first;	// leaves: first triangle. Inner nodes: right child
+		unsigned int	count;	// number of triangles, 0 for inner nodes
+	};
+
+	enum {
+		MAX_LEAF_TRIANGLES = 4,
+		NUM_BINS = 16,
+		MAX_DEPTH = 64
+	};
+
+	unsigned int	buildRecursive( unsigned int begin, unsigned int end, const std::vector< float >& centroids,
+									const std::vector< Bounds >& triBounds, int depth );
+
+	std::vector< Node >			nodes;
+	std::vector< unsigned int >	indices;	// original triangle index, in leaf order
+	std::vector< float >		vertices;	// 9 floats per triangle, in leaf order
+};
@@ -0,0 +1,60 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "TriangleDistance.h"
+
+#include <algorithm>
+
+namespace {
+	inline float dot( const float* a, const float* b ) { return a[ 0 ] * b[ 0 ] + a[ 1 ] * b[ 1 ] + a[ 2 ] * b[ 2 ]; }
+}
+
+float TriangleDistanceSquared( const float* p, const float* a, const float* b, const float* c ) {
+	float ab[ 3 ], ac[ 3 ], ap[ 3 ];
+	for( int i = 0; i < 3; i++ ) {
+		ab[ i ] = b[ i ] - a[ i ];
+		ac[ i ] = c[ i ] - a[ i ];
+		ap[ i ] = p[ i ] - a[ i ];
+	}
+	float closest[ 3 ];
+	const float d1 = dot( ab, ap ), d2 = dot( ac, ap );
+	if ( d1 <= 0 && d2 <= 0 ) {
+		std::copy( a, a + 3, closest );
+	} else {
+		float bp[ 3 ], cp[ 3 ];
+		for( int i = 0; i < 3; i++ ) {
+			bp[ i ] = p[ i ] - b[ i ];
+			cp[ i ] = p[ i ] - c[ i ];
+		}
+		const float d3 = dot( ab, bp ), d4 = dot( ac, bp );
+		const float d5 = dot( ab, cp ), d6 = dot( ac, cp );
+		const float vc = d1 * d4 - d3 * d2;
+		const float vb = d5 * d2 - d1 * d6;
+		const float va = d3 * d6 - d5 * d4;
+		if ( d3 >= 0 && d4 <= d3 ) {
+			std::copy( b, b + 3, closest );
+		} else if ( d6 >= 0 && d5 <= d6 ) {
+			std::copy( c, c + 3, closest );
+		} else if ( vc <= 0 && d1 >= 0 && d3 <= 0 ) {
+			const float v = d1 / ( d1 - d3 );
+			for( int i = 0; i < 3; i++ ) closest[ i ] = a[ i ] + v * ab[ i ];
+		} else if ( vb <= 0 && d2 >= 0 && d6 <= 0 ) {
+			const float w = d2 / ( d2 - d6 );
+			for( int i = 0; i < 3; i++ ) closest[ i ] = a[ i ] + w * ac[ i ];
+		} else if ( va <= 0 && ( d4 - d3 ) >= 0 && ( d5 - d6 ) >= 0 ) {
+			const float w = ( d4 - d3 ) / ( ( d4 - d3 ) + ( d5 - d6 ) );
+			for( int i = 0; i < 3; i++ ) closest[ i ] = b[ i ] + w * ( c[ i ] - b[ i ] );
+		} else {
+			const float denom = 1.0f / ( va + vb + vc );
+			const float v = vb * denom, w = vc * denom;
+			for( int i = 0; i < 3; i++ ) closest[ i ] = a[ i ] + v * ab[ i ] + w * ac[ i ];
+		}
+	}
+	float d[ 3 ];
+	for( int i = 0; i < 3; i++ ) d[ i ] = p[ i ] - closest[ i ];
+	return dot( d, d );
+}
@@ -0,0 +1,20 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+/* ==========================================
+	TriangleDistanceSquared
+
+	Squared distance from the point 'p' to the triangle abc,
+	found by locating the Voronoi region of the triangle that
+	contains p ("Real-Time Collision Detection", closest
+	point on triangle).
+
+   ========================================== */
+
+float TriangleDistanceSquared( const float* p, const float* a, const float* b, const float* c );
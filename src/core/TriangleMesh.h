@@ -0,0 +1,81 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "Bounds.h"
+#include "Hash.h"
+
+#include <vector>
+#include <stddef.h>
+
+/* ==========================================
+	Struct MeshView
+
+	Non-owning view of a triangle mesh: xyz float positions
+	and three vertex indices per triangle. This is all the
+	samplers need to know about the input geometry, so any
+	host (Maya, a file loader...) just has to expose its
+	data in this layout.
+
+   ========================================== */
+
+struct MeshView {
+	const float*	points;
+	size_t			numPoints;
+	const int*		triangles;
+	size_t			numTriangles;
+
+	MeshView() : points( NULL ), numPoints( 0 ), triangles( NULL ), numTriangles( 0 ) {}
+
+	const float*	point( size_t i ) const { return points + 3 * i; }
+	const int*		triangle( size_t i ) const { return triangles + 3 * i; }
+
+	Bounds			bounds() const;
+
+	// content hash of the positions and triangles
+	uint64_t		hash( uint64_t seed = 0 ) const {
+		seed = Hash64( points, numPoints * 3 * sizeof( float ), seed );
+		return Hash64( triangles, numTriangles * 3 * sizeof( int ), seed );
+	}
+};
+
+/* ==========================================
+	Class TriangleMesh
+
+	Owning storage for a triangle mesh, convertible to a
+	MeshView.
+
+   ========================================== */
+
+class TriangleMesh {
+public:
+	std::vector< float >	points;		// xyz
+	std::vector< int >		triangles;	// 3 indices per triangle
+
+	size_t			numPoints() const { return points.size() / 3; }
+	size_t			numTriangles() const { return triangles.size() / 3; }
+
+	void			clear() { points.clear(); triangles.clear(); }
+
+	MeshView		view() const {
+		MeshView v;
+		v.points = points.empty() ? NULL : &points[ 0 ];
+		v.numPoints = numPoints();
+		v.triangles = triangles.empty() ? NULL : &triangles[ 0 ];
+		v.numTriangles = numTriangles();
+		return v;
+	}
+};
+
+inline Bounds MeshView::bounds() const {
+	Bounds b;
+	for( size_t i = 0; i < numPoints; i++ ) {
+		b.expand( point( i ) );
+	}
+	return b;
+}
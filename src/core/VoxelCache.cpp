@@ -0,0 +1,213 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "VoxelCache.h"
+#include "MappedFile.h"
+#include "Hash.h"
+#include "Trace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+namespace {
+	const char MAGIC[ 4 ] = { 'S', 'M', 'V', 'C' };
+	const uint32_t VERSION = 1;
+	const char EXTENSION[] = ".smvc";
+
+	struct EntryHeader {
+		char		magic[ 4 ];
+		uint32_t	version;
+		uint64_t	key;
+		int32_t		res[ 3 ];
+		int32_t		columnWords;
+		float		boundsMin[ 3 ];
+		float		boundsMax[ 3 ];
+		uint64_t	numWords;	// followed by the packed columns
+	};
+
+	struct Entry {
+		std::string	path;
+		uint64_t	size;
+		time_t		lastUse;
+		bool operator<( const Entry& other ) const { return lastUse < other.lastUse; }
+	};
+
+	std::atomic< unsigned int > tempCounter( 0 );
+
+#ifdef _WIN32
+	void makeDirectory( const std::string& path ) { _mkdir( path.c_str() ); }
+	int processId() { return _getpid(); }
+	void touch( const std::string& path ) { _utime( path.c_str(), NULL ); }
+
+	void listEntries( const std::string& directory, std::vector< Entry >& entries ) {
+		WIN32_FIND_DATAA found;
+		HANDLE handle = FindFirstFileA( ( directory + "/*" + EXTENSION ).c_str(), &found );
+		if ( handle == INVALID_HANDLE_VALUE ) return;
+		do {
+			Entry entry;
+			entry.path = directory + "/" + found.cFileName;
+			entry.size = ( (uint64_t)found.nFileSizeHigh << 32 ) | found.nFileSizeLow;
+			const uint64_t ticks = ( (uint64_t)found.ftLastWriteTime.dwHighDateTime << 32 ) | found.ftLastWriteTime.dwLowDateTime;
+			entry.lastUse = (time_t)( ticks / 10000000ULL );
+			entries.push_back( entry );
+		} while( FindNextFileA( handle, &found ) );
+		FindClose( handle );
+	}
+#else
+	void makeDirectory( const std::string& path ) { mkdir( path.c_str(), 0777 ); }
+	int processId() { return (int)getpid(); }
+	void touch( const std::string& path ) { utime( path.c_str(), NULL ); }
+
+	void listEntries( const std::string& directory, std::vector< Entry >& entries ) {
+		DIR* dir = opendir( directory.c_str() );
+		if ( dir == NULL ) return;
+		const size_t extensionLength = sizeof( EXTENSION ) - 1;
+		while( struct dirent* file = readdir( dir ) ) {
+			const size_t length = strlen( file->d_name );
+			if ( length <= extensionLength || strcmp( file->d_name + length - extensionLength, EXTENSION ) != 0 ) continue;
+			Entry entry;
+			entry.path = directory + "/" + file->d_name;
+			struct stat st;
+			if ( stat( entry.path.c_str(), &st ) != 0 ) continue;
+			entry.size = (uint64_t)st.st_size;
+			entry.lastUse = st.st_mtime;
+			entries.push_back( entry );
+		}
+		closedir( dir );
+	}
+#endif
+
+	// creates 'path' and any missing parent directory
+	void makeDirectories( const std::string& path ) {
+		for( size_t slash = path.find_first_of( "/\\", 1 ); slash != std::string::npos; slash = path.find_first_of( "/\\", slash + 1 ) ) {
+			makeDirectory( path.substr( 0, slash ) );
+		}
+		makeDirectory( path );
+	}
+}
+
+uint64_t VoxelCache::Key( const MeshView& mesh, int resX, int resY, int resZ, int method ) {
+	TRACE_SCOPE( "VoxelCache::Key" );
+	const int32_t params[ 5 ] = { resX, resY, resZ, method, (int32_t)VERSION };
+	return mesh.hash( Hash64( params, sizeof( params ) ) );
+}
+
+std::string VoxelCache::entryPath( uint64_t key ) const {
+	char name[ 32 ];
+	sprintf( name, "/%016llx", (unsigned long long)key );
+	return directory + name + EXTENSION;
+}
+
+bool VoxelCache::load( uint64_t key, VoxelGrid& grid ) const {
+	TRACE_SCOPE( "VoxelCache::load" );
+	if ( !enabled() ) return false;
+
+	const std::string path = entryPath( key );
+	MappedFile file;
+	if ( !file.open( path.c_str() ) || file.size() < sizeof( EntryHeader ) ) return false;
+
+	const EntryHeader* header = (const EntryHeader*)file.data();
+	const uint64_t expectedWords = header->res[ 0 ] > 0 && header->res[ 1 ] > 0 && header->res[ 2 ] > 0 ?
+								   (uint64_t)header->res[ 0 ] * header->res[ 1 ] * ( ( header->res[ 2 ] + VoxelGrid::BITS_PER_WORD - 1 ) / VoxelGrid::BITS_PER_WORD ) : 0;
+	if ( memcmp( header->magic, MAGIC, sizeof( MAGIC ) ) != 0 || header->version != VERSION || header->key != key ||
+		 header->numWords != expectedWords ||
+		 file.size() != sizeof( EntryHeader ) + header->numWords * sizeof( VoxelGrid::Word ) ) {
+		return false;
+	}
+
+	Bounds bounds;
+	for( int axis = 0; axis < 3; axis++ ) {
+		bounds.min[ axis ] = header->boundsMin[ axis ];
+		bounds.max[ axis ] = header->boundsMax[ axis ];
+	}
+	grid.init( header->res[ 0 ], header->res[ 1 ], header->res[ 2 ], bounds );
+	if ( grid.numWords() > 0 ) {
+		memcpy( grid.data(), file.data() + sizeof( EntryHeader ), grid.numWords() * sizeof( VoxelGrid::Word ) );
+	}
+
+	// refresh the entry so that it is the last one to be evicted
+	touch( path );
+	return true;
+}
+
+bool VoxelCache::store( uint64_t key, const VoxelGrid& grid ) const {
+	TRACE_SCOPE( "VoxelCache::store" );
+	if ( !enabled() ) return false;
+	makeDirectories( directory );
+
+	EntryHeader header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+	header.version = VERSION;
+	header.key = key;
+	for( int axis = 0; axis < 3; axis++ ) {
+		header.res[ axis ] = grid.resolution( axis );
+		header.boundsMin[ axis ] = grid.bounds().min[ axis ];
+		header.boundsMax[ axis ] = grid.bounds().max[ axis ];
+	}
+	header.columnWords = grid.wordsPerColumn();
+	header.numWords = grid.numWords();
+
+	// written under a temporary name and renamed once complete, so that
+	// other processes sharing the directory never see a partial entry
+	const std::string path = entryPath( key );
+	char suffix[ 32 ];
+	sprintf( suffix, ".%d.%u.tmp", processId(), tempCounter++ );
+	const std::string tempPath = path + suffix;
+
+	FILE* f = fopen( tempPath.c_str(), "wb" );
+	if ( f == NULL ) return false;
+	bool ok = fwrite( &header, sizeof( header ), 1, f ) == 1 &&
+			  ( grid.numWords() == 0 || fwrite( grid.data(), sizeof( VoxelGrid::Word ), grid.numWords(), f ) == grid.numWords() );
+	if ( fclose( f ) != 0 ) ok = false;
+#ifdef _WIN32
+	remove( path.c_str() ); // rename does not replace existing files on Windows
+#endif
+	if ( !ok || rename( tempPath.c_str(), path.c_str() ) != 0 ) {
+		remove( tempPath.c_str() );
+		return false;
+	}
+
+	evict();
+	return true;
+}
+
+void VoxelCache::evict() const {
+	TRACE_SCOPE( "VoxelCache::evict" );
+	std::vector< Entry > entries;
+	listEntries( directory, entries );
+
+	uint64_t total = 0;
+	for( size_t i = 0; i < entries.size(); i++ ) {
+		total += entries[ i ].size;
+	}
+	if ( total <= maxBytes ) return;
+
+	std::sort( entries.begin(), entries.end() );
+	for( size_t i = 0; i < entries.size() && total > maxBytes; i++ ) {
+		if ( remove( entries[ i ].path.c_str() ) == 0 ) {
+			total -= entries[ i ].size;
+		}
+	}
+}
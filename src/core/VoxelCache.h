@@ -0,0 +1,64 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+#include "VoxelGrid.h"
+
+#include <stdint.h>
+#include <string>
+
+/* ==========================================
+	Class VoxelCache
+
+	Directory of voxelized meshes, so that a mesh is only
+	voxelized once for a given resolution no matter how
+	many times a scene is opened or rendered.
+
+	Entries are keyed by a hash of the mesh positions,
+	triangles, resolution and voxelizer, and hold the packed
+	columns of the grid as they are in memory. Loading an
+	entry maps the file instead of reading it.
+
+	The directory is kept under a size budget by removing
+	the least recently used entries; hits refresh the file
+	modification time, which is used as the access time.
+
+   ========================================== */
+
+class VoxelCache {
+public:
+	enum {
+		DEFAULT_MAX_MB = 1024
+	};
+
+						VoxelCache() : maxBytes( (uint64_t)DEFAULT_MAX_MB << 20 ) {}
+						VoxelCache( const std::string& dir, uint64_t maxSize ) : directory( dir ), maxBytes( maxSize ) {}
+
+	bool				enabled() const { return !directory.empty(); }
+
+	// 'method' distinguishes voxelizers which may produce different grids
+	// for the same input
+	static uint64_t		Key( const MeshView& mesh, int resX, int resY, int resZ, int method );
+
+	// fills 'grid' with the entry for 'key'. Returns false on a miss.
+	bool				load( uint64_t key, VoxelGrid& grid ) const;
+
+	// adds 'grid' to the cache and evicts old entries if over budget
+	bool				store( uint64_t key, const VoxelGrid& grid ) const;
+
+	// removes the least recently used entries until the directory fits
+	// in the size budget
+	void				evict() const;
+
+private:
+	std::string			entryPath( uint64_t key ) const;
+
+	std::string			directory;
+	uint64_t			maxBytes;
+};
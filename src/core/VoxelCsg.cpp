@@ -0,0 +1,90 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "VoxelCsg.h"
+#include "SolidVoxelizer.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <assert.h>
+#include <algorithm>
+
+namespace {
+	typedef VoxelGrid::Word Word;
+
+	// below this many words a single thread is faster
+	const size_t MIN_PARALLEL_WORDS = 1 << 16;
+
+	bool overlaps( const Bounds& a, const Bounds& b ) {
+		for( int axis = 0; axis < 3; axis++ ) {
+			if ( a.min[ axis ] > b.max[ axis ] || b.min[ axis ] > a.max[ axis ] ) return false;
+		}
+		return true;
+	}
+}
+
+void CombineVoxels( VoxelGrid& grid, const VoxelGrid& operand, CsgOp op, int threads ) {
+	TRACE_SCOPE( "CombineVoxels" );
+	assert( grid.resX() == operand.resX() && grid.resY() == operand.resY() && grid.resZ() == operand.resZ() );
+	assert( grid.numWords() == operand.numWords() );
+	if ( grid.empty() ) return;
+	threads = WorkerThreads( threads );
+	if ( grid.numWords() < MIN_PARALLEL_WORDS ) threads = 1;
+
+	// bits past resZ are 0 in both grids, and stay so with any of the
+	// operations
+	Word* dst = grid.data();
+	const Word* src = operand.data();
+	ParallelFor( grid.numWords(), threads, [ & ]( size_t begin, size_t end ) {
+		switch( op ) {
+			case CSG_UNION:
+				for( size_t i = begin; i < end; i++ ) dst[ i ] |= src[ i ];
+				break;
+			case CSG_INTERSECT:
+				for( size_t i = begin; i < end; i++ ) dst[ i ] &= src[ i ];
+				break;
+			case CSG_SUBTRACT:
+				for( size_t i = begin; i < end; i++ ) dst[ i ] &= ~src[ i ];
+				break;
+		}
+	} );
+}
+
+bool VoxelizeCsg( const MeshView& base, const CsgOperand* operands, size_t count,
+				  int resX, int resY, int resZ, VoxelGrid& grid, InsideTest test, int threads ) {
+	TRACE_SCOPE( "VoxelizeCsg" );
+	resX = std::max( 1, resX );
+	resY = std::max( 1, resY );
+	resZ = std::max( 1, resZ );
+
+	// only the meshes added by union can occupy voxels beyond the base
+	Bounds bounds = base.bounds();
+	for( size_t i = 0; i < count; i++ ) {
+		if ( operands[ i ].op == CSG_UNION ) bounds.expand( operands[ i ].mesh.bounds() );
+	}
+	if ( bounds.empty() ) {
+		grid.clear();
+		return false;
+	}
+
+	grid.init( resX, resY, resZ, bounds );
+	SolidVoxelizer::Voxelize( base, grid, test );
+
+	VoxelGrid operand;
+	for( size_t i = 0; i < count; i++ ) {
+		const Bounds meshBounds = operands[ i ].mesh.bounds();
+		if ( meshBounds.empty() || !overlaps( meshBounds, bounds ) ) {
+			// nothing inside the grid, only intersecting removes anything
+			if ( operands[ i ].op == CSG_INTERSECT ) grid.init( resX, resY, resZ, bounds );
+			continue;
+		}
+		operand.init( resX, resY, resZ, bounds );
+		SolidVoxelizer::Voxelize( operands[ i ].mesh, operand, test );
+		CombineVoxels( grid, operand, operands[ i ].op, threads );
+	}
+	return true;
+}
@@ -0,0 +1,51 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+#include "VoxelGrid.h"
+#include "WindingNumber.h"
+
+/* ==========================================
+	Voxel CSG
+
+	Boolean operations between the interiors of several
+	meshes, evaluated on their voxels rather than on the
+	meshes themselves, so that e.g. the inside of a container
+	minus its contents can be sampled directly instead of
+	rejecting the samples that land in the contents.
+
+	Grids sharing resolution and bounds are combined word by
+	word on the packed columns (OR, AND, AND NOT), so the cost
+	is linear in the size of the grid and independent of the
+	meshes. Words are split between up to 'threads' threads
+	(0 for all the cores).
+
+   ========================================== */
+
+enum CsgOp {
+	CSG_UNION = 0,		// voxels inside either
+	CSG_INTERSECT,		// voxels inside both
+	CSG_SUBTRACT		// voxels inside the first but not the second
+};
+
+struct CsgOperand {
+	MeshView	mesh;
+	CsgOp		op;
+};
+
+// combines 'operand' into 'grid', which must have the same resolution and
+// bounds
+void CombineVoxels( VoxelGrid& grid, const VoxelGrid& operand, CsgOp op, int threads = 0 );
+
+// Voxelizes 'base' and then applies each of the 'count' operands in order,
+// all on a grid fitted to the bounds of 'base' and of the meshes added by
+// union, telling the inside of every mesh with 'test'. Returns false if
+// there is nothing to voxelize.
+bool VoxelizeCsg( const MeshView& base, const CsgOperand* operands, size_t count,
+				  int resX, int resY, int resZ, VoxelGrid& grid, InsideTest test = INSIDE_PARITY, int threads = 0 );
@@ -0,0 +1,99 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "VoxelGrid.h"
+#include "BitOps.h"
+
+#include <assert.h>
+
+VoxelGrid::VoxelGrid() : columnWords( 0 ) {
+	res[ 0 ] = res[ 1 ] = res[ 2 ] = 0;
+}
+
+void VoxelGrid::init( int resX, int resY, int resZ, const Bounds& bounds ) {
+	res[ 0 ] = resX;
+	res[ 1 ] = resY;
+	res[ 2 ] = resZ;
+	box = bounds;
+	columnWords = ( resZ + BITS_PER_WORD - 1 ) / BITS_PER_WORD;
+	words.assign( (size_t)resX * resY * columnWords, 0 );
+}
+
+void VoxelGrid::clear() {
+	res[ 0 ] = res[ 1 ] = res[ 2 ] = 0;
+	columnWords = 0;
+	box.clear();
+	words.clear();
+}
+
+VoxelGrid::Word VoxelGrid::wordMask( int word ) const {
+	const int remaining = res[ 2 ] - word * BITS_PER_WORD;
+	if ( remaining >= BITS_PER_WORD ) return ~(Word)0;
+	if ( remaining <= 0 ) return 0;
+	return ( (Word)1 << remaining ) - 1;
+}
+
+void VoxelGrid::toggleFrom( int x, int y, int z ) {
+	if ( z >= res[ 2 ] ) return;
+	if ( z < 0 ) z = 0;
+	Word* col = column( x, y );
+	const int first = z / BITS_PER_WORD;
+	col[ first ] ^= ~( ( (Word)1 << ( z % BITS_PER_WORD ) ) - 1 ) & wordMask( first );
+	for( int i = first + 1; i < columnWords; i++ ) {
+		col[ i ] ^= wordMask( i );
+	}
+}
+
+size_t VoxelGrid::countOccupied() const {
+	size_t count = 0;
+	for( size_t i = 0; i < words.size(); i++ ) {
+		count += PopCount( words[ i ] );
+	}
+	return count;
+}
+
+void VoxelGrid::voxelBounds( int x, int y, int z, float* bbMin, float* bbMax ) const {
+	const int coords[ 3 ] = { x, y, z };
+	for( int axis = 0; axis < 3; axis++ ) {
+		const float size = voxelSize( axis );
+		bbMin[ axis ] = box.min[ axis ] + coords[ axis ] * size;
+		bbMax[ axis ] = bbMin[ axis ] + size;
+	}
+}
+
+void VoxelGrid::getVoxelBoxes( std::vector< float >& boxes ) const {
+	boxes.reserve( boxes.size() + 6 * countOccupied() );
+	float bbMin[ 3 ], bbMax[ 3 ];
+	for( int y = 0; y < res[ 1 ]; y++ ) {
+		for( int x = 0; x < res[ 0 ]; x++ ) {
+			const Word* col = column( x, y );
+			for( int i = 0; i < columnWords; i++ ) {
+				for( Word w = col[ i ]; w != 0; w &= w - 1 ) {
+					voxelBounds( x, y, i * BITS_PER_WORD + LowestBit( w ), bbMin, bbMax );
+					boxes.insert( boxes.end(), bbMin, bbMin + 3 );
+					boxes.insert( boxes.end(), bbMax, bbMax + 3 );
+				}
+			}
+		}
+	}
+}
+
+void VoxelGrid::getOccupied( std::vector< int >& coords ) const {
+	coords.reserve( coords.size() + 3 * countOccupied() );
+	for( int y = 0; y < res[ 1 ]; y++ ) {
+		for( int x = 0; x < res[ 0 ]; x++ ) {
+			const Word* col = column( x, y );
+			for( int i = 0; i < columnWords; i++ ) {
+				for( Word w = col[ i ]; w != 0; w &= w - 1 ) {
+					coords.push_back( x );
+					coords.push_back( y );
+					coords.push_back( i * BITS_PER_WORD + LowestBit( w ) );
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,90 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "Bounds.h"
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+/* ==========================================
+	Class VoxelGrid
+
+	Binary occupancy grid stored as packed columns: for each
+	(x, y) cell, the voxels along Z are the bits of a short
+	run of 64-bit words, bit k of the column being slice k
+	counted from the bottom of the bounds.
+
+	This is the same layout the GPU voxelizer produces in the
+	color channels of its render target, and it lets whole
+	columns be combined with plain bitwise operations.
+
+	Bits past resZ in the last word of a column are always 0.
+
+   ========================================== */
+
+class VoxelGrid {
+public:
+	typedef uint64_t Word;
+	enum { BITS_PER_WORD = 64 };
+
+						VoxelGrid();
+
+	// resizes the grid and clears every voxel
+	void				init( int resX, int resY, int resZ, const Bounds& bounds );
+	void				clear();
+
+	int					resX() const { return res[ 0 ]; }
+	int					resY() const { return res[ 1 ]; }
+	int					resZ() const { return res[ 2 ]; }
+	int					resolution( int axis ) const { return res[ axis ]; }
+	int					wordsPerColumn() const { return columnWords; }
+	bool				empty() const { return words.empty(); }
+
+	const Bounds&		bounds() const { return box; }
+	float				voxelSize( int axis ) const { return ( box.max[ axis ] - box.min[ axis ] ) / res[ axis ]; }
+
+	// every column, one after the other along X then Y
+	size_t				numWords() const { return words.size(); }
+	Word*				data() { return words.empty() ? NULL : &words[ 0 ]; }
+	const Word*			data() const { return words.empty() ? NULL : &words[ 0 ]; }
+
+	Word*				column( int x, int y ) { return &words[ ( (size_t)y * res[ 0 ] + x ) * columnWords ]; }
+	const Word*			column( int x, int y ) const { return &words[ ( (size_t)y * res[ 0 ] + x ) * columnWords ]; }
+
+	bool get( int x, int y, int z ) const {
+		return ( column( x, y )[ z / BITS_PER_WORD ] >> ( z % BITS_PER_WORD ) & 1 ) != 0;
+	}
+	void set( int x, int y, int z ) {
+		column( x, y )[ z / BITS_PER_WORD ] |= (Word)1 << ( z % BITS_PER_WORD );
+	}
+
+	// flips every voxel of the column from slice z (included) upwards
+	void				toggleFrom( int x, int y, int z );
+
+	// mask of the valid bits of the given word of a column
+	Word				wordMask( int word ) const;
+
+	size_t				countOccupied() const;
+
+	// min/max corners of the voxel at the given coordinates
+	void				voxelBounds( int x, int y, int z, float* bbMin, float* bbMax ) const;
+
+	// appends a (min, max) point pair per occupied voxel
+	void				getVoxelBoxes( std::vector< float >& boxes ) const;
+
+	// appends the (x, y, z) coordinates of every occupied voxel
+	void				getOccupied( std::vector< int >& coords ) const;
+
+private:
+	int						res[ 3 ];
+	int						columnWords;
+	Bounds					box;
+	std::vector< Word >		words;
+};
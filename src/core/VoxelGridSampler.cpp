@@ -0,0 +1,44 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "VoxelGridSampler.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+void VoxelGridSampler::setGrid( const VoxelGrid& grid ) {
+	TRACE_SCOPE( "VoxelGridSampler::setGrid" );
+	occupied.clear();
+	grid.getOccupied( occupied );
+	bounds = grid.bounds();
+	for( int axis = 0; axis < 3; axis++ ) {
+		voxelSize[ axis ] = grid.voxelSize( axis );
+	}
+}
+
+bool VoxelGridSampler::Sample( int numSamples, Random& rng, std::vector< float >& samples, SamplerStats* stats ) const {
+	TRACE_SCOPE( "VoxelGridSampler::Sample" );
+	if ( stats ) {
+		stats->samplesRequested += std::max( 0, numSamples );
+		stats->voxelsOccupied = (long long)numVoxels();
+	}
+	if ( numSamples <= 0 || occupied.empty() ) return false;
+
+	const uint32_t count = (uint32_t)numVoxels();
+
+	const size_t first = samples.size();
+	samples.resize( first + 3 * (size_t)numSamples );
+	float* out = &samples[ first ];
+	for( int i = 0; i < numSamples; i++, out += 3 ) {
+		const int* voxel = &occupied[ 3 * rng.nextInt( count ) ];
+		for( int axis = 0; axis < 3; axis++ ) {
+			out[ axis ] = bounds.min[ axis ] + ( voxel[ axis ] + rng.nextFloat() ) * voxelSize[ axis ];
+		}
+	}
+	if ( stats ) stats->samplesProduced += numSamples;
+	return true;
+}
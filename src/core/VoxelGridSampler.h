@@ -0,0 +1,43 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "VoxelGrid.h"
+#include "Random.h"
+#include "SamplerStats.h"
+
+#include <vector>
+
+/* ==========================================
+	Class VoxelGridSampler
+
+	Generates uniformly distributed samples within the
+	occupied voxels of a VoxelGrid. Since all voxels in the
+	grid share the same dimensions, choosing a voxel uniformly
+	and then a point uniformly within it yields a uniform
+	distribution over the whole occupied volume.
+
+	The occupied voxels are gathered once by setGrid, so
+	large sample sets can be produced in several calls.
+
+   ========================================== */
+
+class VoxelGridSampler {
+public:
+	void			setGrid( const VoxelGrid& grid );
+	size_t			numVoxels() const { return occupied.size() / 3; }
+
+	// appends 'numSamples' xyz samples. Returns false if the grid is empty.
+	// Sample counts are added to 'stats' if given.
+	bool			Sample( int numSamples, Random& rng, std::vector< float >& samples, SamplerStats* stats = NULL ) const;
+
+private:
+	std::vector< int >	occupied;	// xyz coordinates of the occupied voxels
+	Bounds				bounds;
+	float				voxelSize[ 3 ];
+};
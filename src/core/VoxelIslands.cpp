@@ -0,0 +1,312 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "VoxelIslands.h"
+#include "BitOps.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <math.h>
+#include <limits.h>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+	typedef std::vector< std::atomic< uint32_t > > Forest;
+
+	uint32_t findRoot( Forest& parent, uint32_t run ) {
+		for( ;; ) {
+			const uint32_t up = parent[ run ].load( std::memory_order_relaxed );
+			if ( up == run ) return run;
+			// halve the path: parents only ever move to lower runs of the
+			// same tree, so this is safe while other threads are linking
+			const uint32_t upper = parent[ up ].load( std::memory_order_relaxed );
+			if ( upper != up ) parent[ run ].store( upper, std::memory_order_relaxed );
+			run = upper;
+		}
+	}
+
+	void join( Forest& parent, uint32_t a, uint32_t b ) {
+		for( ;; ) {
+			a = findRoot( parent, a );
+			b = findRoot( parent, b );
+			if ( a == b ) return;
+			if ( a < b ) std::swap( a, b );
+			// link the higher root under the lower one, unless another thread
+			// linked it first
+			uint32_t expected = a;
+			if ( parent[ a ].compare_exchange_weak( expected, b, std::memory_order_relaxed ) ) return;
+		}
+	}
+
+	// calls 'visit' with the runs [z0, z1) of the column
+	template< typename VisitFn >
+	void columnRuns( const VoxelGrid::Word* column, int words, VisitFn& visit ) {
+		int open = -1;	// start of a run reaching the top of the previous word
+		for( int i = 0; i < words; i++ ) {
+			const int base = i * VoxelGrid::BITS_PER_WORD;
+			VoxelGrid::Word w = column[ i ];
+			if ( open >= 0 && ( w & 1 ) == 0 ) {
+				visit( open, base );
+				open = -1;
+			}
+			while( w != 0 ) {
+				const int start = LowestBit( w );
+				if ( open < 0 ) open = base + start;
+				// the first empty voxel from 'start' on
+				const VoxelGrid::Word filled = w | ( ( (VoxelGrid::Word)1 << start ) - 1 );
+				if ( ~filled == 0 ) break;
+				const int end = LowestBit( ~filled );
+				visit( open, base + end );
+				open = -1;
+				w &= ~( ( (VoxelGrid::Word)1 << end ) - 1 );
+			}
+		}
+		if ( open >= 0 ) visit( open, words * VoxelGrid::BITS_PER_WORD );
+	}
+}
+
+void VoxelIslands::clear() {
+	res[ 0 ] = res[ 1 ] = res[ 2 ] = 0;
+	bounds.clear();
+	voxelSize[ 0 ] = voxelSize[ 1 ] = voxelSize[ 2 ] = 0;
+	columnStart.clear();
+	runs.clear();
+	runIsland.clear();
+	islands.clear();
+	islandStart.clear();
+	islandRuns.clear();
+	islandOffsets.clear();
+}
+
+void VoxelIslands::build( const VoxelGrid& grid, int threads ) {
+	TRACE_SCOPE( "VoxelIslands::build" );
+	clear();
+	if ( grid.empty() ) return;
+	threads = WorkerThreads( threads );
+
+	for( int axis = 0; axis < 3; axis++ ) {
+		res[ axis ] = grid.resolution( axis );
+		voxelSize[ axis ] = grid.voxelSize( axis );
+	}
+	bounds = grid.bounds();
+	const int words = grid.wordsPerColumn();
+	const size_t numColumns = (size_t)res[ 0 ] * res[ 1 ];
+
+	{
+		TRACE_SCOPE( "VoxelIslands::runs" );
+		// a run starts at every occupied voxel with an empty one below
+		columnStart.assign( numColumns + 1, 0 );
+		ParallelFor( res[ 1 ], threads, [ & ]( size_t y0, size_t y1 ) {
+			for( size_t c = y0 * res[ 0 ]; c < y1 * res[ 0 ]; c++ ) {
+				const VoxelGrid::Word* column = grid.data() + c * words;
+				VoxelGrid::Word below = 0;
+				uint32_t count = 0;
+				for( int i = 0; i < words; i++ ) {
+					count += PopCount( column[ i ] & ~( ( column[ i ] << 1 ) | below ) );
+					below = column[ i ] >> ( VoxelGrid::BITS_PER_WORD - 1 );
+				}
+				columnStart[ c + 1 ] = count;
+			}
+		} );
+		for( size_t c = 0; c < numColumns; c++ ) columnStart[ c + 1 ] += columnStart[ c ];
+
+		runs.resize( columnStart[ numColumns ] );
+		ParallelFor( res[ 1 ], threads, [ & ]( size_t y0, size_t y1 ) {
+			for( size_t y = y0; y < y1; y++ ) {
+				for( int x = 0; x < res[ 0 ]; x++ ) {
+					Run* run = &runs[ columnStart[ y * res[ 0 ] + x ] ];
+					auto add = [ & ]( int z0, int z1 ) {
+						run->x = x;
+						run->y = (int)y;
+						run->z0 = z0;
+						run->z1 = z1;
+						run++;
+					};
+					columnRuns( grid.column( x, (int)y ), words, add );
+				}
+			}
+		} );
+	}
+
+	const uint32_t numRuns = (uint32_t)runs.size();
+	Forest parent( numRuns );
+	{
+		TRACE_SCOPE( "VoxelIslands::join" );
+		for( uint32_t r = 0; r < numRuns; r++ ) parent[ r ].store( r, std::memory_order_relaxed );
+		// joins the overlapping runs of columns a and b
+		auto joinColumns = [ & ]( size_t a, size_t b ) {
+			uint32_t i = columnStart[ a ], j = columnStart[ b ];
+			while( i < columnStart[ a + 1 ] && j < columnStart[ b + 1 ] ) {
+				if ( runs[ i ].z0 < runs[ j ].z1 && runs[ j ].z0 < runs[ i ].z1 ) join( parent, i, j );
+				if ( runs[ i ].z1 < runs[ j ].z1 ) i++;
+				else j++;
+			}
+		};
+		ParallelFor( res[ 1 ], threads, [ & ]( size_t y0, size_t y1 ) {
+			for( size_t y = y0; y < y1; y++ ) {
+				for( int x = 0; x < res[ 0 ]; x++ ) {
+					const size_t c = y * res[ 0 ] + x;
+					if ( x > 0 ) joinColumns( c, c - 1 );
+					if ( y > 0 ) joinColumns( c, c - res[ 0 ] );
+				}
+			}
+		} );
+	}
+
+	// every root gets the next island, in the order of the runs
+	runIsland.resize( numRuns );
+	for( uint32_t r = 0; r < numRuns; r++ ) {
+		const uint32_t root = findRoot( parent, r );
+		if ( root == r ) {
+			Island island;
+			island.voxels = 0;
+			island.min[ 0 ] = island.min[ 1 ] = island.min[ 2 ] = INT_MAX;
+			island.max[ 0 ] = island.max[ 1 ] = island.max[ 2 ] = -1;
+			runIsland[ r ] = (int)islands.size();
+			islands.push_back( island );
+		} else {
+			runIsland[ r ] = runIsland[ root ];
+		}
+		const Run& run = runs[ r ];
+		Island& island = islands[ runIsland[ r ] ];
+		island.voxels += run.z1 - run.z0;
+		const int lo[ 3 ] = { run.x, run.y, run.z0 };
+		const int hi[ 3 ] = { run.x, run.y, run.z1 - 1 };
+		for( int axis = 0; axis < 3; axis++ ) {
+			island.min[ axis ] = std::min( island.min[ axis ], lo[ axis ] );
+			island.max[ axis ] = std::max( island.max[ axis ], hi[ axis ] );
+		}
+	}
+
+	// runs grouped by island, for sampling
+	islandStart.assign( islands.size() + 1, 0 );
+	for( uint32_t r = 0; r < numRuns; r++ ) islandStart[ runIsland[ r ] + 1 ]++;
+	for( size_t i = 0; i < islands.size(); i++ ) islandStart[ i + 1 ] += islandStart[ i ];
+	islandRuns.resize( numRuns );
+	islandOffsets.resize( numRuns );
+	std::vector< uint32_t > next( islandStart.begin(), islandStart.end() - 1 );
+	std::vector< size_t > voxels( islands.size(), 0 );
+	for( uint32_t r = 0; r < numRuns; r++ ) {
+		const int i = runIsland[ r ];
+		islandRuns[ next[ i ] ] = r;
+		islandOffsets[ next[ i ]++ ] = voxels[ i ];
+		voxels[ i ] += runs[ r ].z1 - runs[ r ].z0;
+	}
+}
+
+void VoxelIslands::islandBounds( int i, float* bbMin, float* bbMax ) const {
+	for( int axis = 0; axis < 3; axis++ ) {
+		bbMin[ axis ] = bounds.min[ axis ] + islands[ i ].min[ axis ] * voxelSize[ axis ];
+		bbMax[ axis ] = bounds.min[ axis ] + ( islands[ i ].max[ axis ] + 1 ) * voxelSize[ axis ];
+	}
+}
+
+int VoxelIslands::islandAt( int x, int y, int z ) const {
+	if ( x < 0 || y < 0 || z < 0 || x >= res[ 0 ] || y >= res[ 1 ] || z >= res[ 2 ] ) return -1;
+	const size_t c = (size_t)y * res[ 0 ] + x;
+	// the last run starting at or below z
+	uint32_t lo = columnStart[ c ], hi = columnStart[ c + 1 ];
+	while( lo < hi ) {
+		const uint32_t mid = ( lo + hi ) / 2;
+		if ( runs[ mid ].z0 <= z ) lo = mid + 1;
+		else hi = mid;
+	}
+	if ( lo == columnStart[ c ] || runs[ lo - 1 ].z1 <= z ) return -1;
+	return runIsland[ lo - 1 ];
+}
+
+void VoxelIslands::labelPoints( const float* points, size_t count, int* labels ) const {
+	TRACE_SCOPE( "VoxelIslands::labelPoints" );
+	for( size_t i = 0; i < count; i++, points += 3 ) {
+		int voxel[ 3 ];
+		for( int axis = 0; axis < 3; axis++ ) {
+			voxel[ axis ] = voxelSize[ axis ] > 0 ? (int)floorf( ( points[ axis ] - bounds.min[ axis ] ) / voxelSize[ axis ] ) : -1;
+			// points on the upper faces of the grid belong to the last voxels
+			if ( voxel[ axis ] == res[ axis ] && points[ axis ] <= bounds.max[ axis ] ) voxel[ axis ]--;
+		}
+		labels[ i ] = islandAt( voxel[ 0 ], voxel[ 1 ], voxel[ 2 ] );
+	}
+}
+
+void VoxelIslands::budget( int numSamples, IslandBudget budget, int minSamples, std::vector< int >& counts ) const {
+	const size_t numIslands = islands.size();
+	counts.assign( numIslands, 0 );
+	if ( numIslands == 0 || numSamples <= 0 ) return;
+
+	if ( budget == BUDGET_EQUAL || ( budget == BUDGET_MINIMUM && (double)minSamples * numIslands >= numSamples ) ) {
+		for( size_t i = 0; i < numIslands; i++ ) {
+			counts[ i ] = numSamples / (int)numIslands + ( i < (size_t)( numSamples % numIslands ) ? 1 : 0 );
+		}
+		return;
+	}
+
+	// Islands whose share by volume is below the minimum get the minimum,
+	// and the rest is shared again between the others until every share is
+	// over it. With no minimum, every island is shared by volume.
+	std::vector< bool > floored( numIslands, false );
+	int left = numSamples;
+	double volume = 0;
+	for( size_t i = 0; i < numIslands; i++ ) volume += (double)islands[ i ].voxels;
+	if ( budget == BUDGET_MINIMUM ) {
+		for( bool changed = true; changed; ) {
+			changed = false;
+			for( size_t i = 0; i < numIslands; i++ ) {
+				if ( !floored[ i ] && left * ( islands[ i ].voxels / volume ) < minSamples ) {
+					floored[ i ] = true;
+					counts[ i ] = minSamples;
+					left -= minSamples;
+					volume -= (double)islands[ i ].voxels;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	// largest remainders get the samples lost rounding down, the first
+	// islands first on ties
+	std::vector< std::pair< double, int > > remainders;
+	int given = 0;
+	for( size_t i = 0; i < numIslands; i++ ) {
+		if ( floored[ i ] ) continue;
+		const double share = left * ( islands[ i ].voxels / volume );
+		counts[ i ] = (int)share;
+		given += counts[ i ];
+		remainders.push_back( std::make_pair( -( share - counts[ i ] ), (int)i ) );
+	}
+	std::sort( remainders.begin(), remainders.end() );
+	for( size_t k = 0; given < left && k < remainders.size(); k++, given++ ) {
+		counts[ remainders[ k ].second ]++;
+	}
+}
+
+void VoxelIslands::Sample( int i, int numSamples, Random& rng, std::vector< float >& samples, SamplerStats* stats ) const {
+	TRACE_SCOPE( "VoxelIslands::Sample" );
+	if ( stats ) stats->samplesRequested += std::max( 0, numSamples );
+	if ( numSamples <= 0 ) return;
+
+	const size_t* offsets = &islandOffsets[ islandStart[ i ] ];
+	const uint32_t* islandRun = &islandRuns[ islandStart[ i ] ];
+	const size_t numRuns = islandStart[ i + 1 ] - islandStart[ i ];
+	const uint32_t voxels = (uint32_t)islands[ i ].voxels;
+
+	const size_t first = samples.size();
+	samples.resize( first + 3 * (size_t)numSamples );
+	float* out = &samples[ first ];
+	for( int s = 0; s < numSamples; s++, out += 3 ) {
+		// the voxel-th voxel of the island, within the last run starting
+		// at or before it
+		const uint32_t voxel = rng.nextInt( voxels );
+		const size_t k = std::upper_bound( offsets, offsets + numRuns, (size_t)voxel ) - offsets - 1;
+		const Run& run = runs[ islandRun[ k ] ];
+		const int coords[ 3 ] = { run.x, run.y, run.z0 + (int)( voxel - offsets[ k ] ) };
+		for( int axis = 0; axis < 3; axis++ ) {
+			out[ axis ] = bounds.min[ axis ] + ( coords[ axis ] + rng.nextFloat() ) * voxelSize[ axis ];
+		}
+	}
+	if ( stats ) stats->samplesProduced += numSamples;
+}
@@ -0,0 +1,104 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "VoxelGrid.h"
+#include "Random.h"
+#include "SamplerStats.h"
+
+#include <vector>
+#include <stdint.h>
+
+/* ==========================================
+	Class VoxelIslands
+
+	Splits the occupied voxels of a VoxelGrid into islands,
+	the sets of voxels connected through their faces, so that
+	meshes made of several pieces can be sampled piece by
+	piece.
+
+	The voxels are handled as runs, the spans of consecutive
+	occupied voxels of a column, read from the packed column
+	words. Runs of neighbouring columns overlapping along Z
+	are joined in a union-find forest, in parallel over rows
+	of columns: roots are only ever linked to a root with a
+	lower index with an atomic compare and swap, so every
+	island ends up rooted at its first run. Islands are then
+	numbered in the order of their first run along X, Y and
+	then Z, whatever the number of threads.
+
+	Each island can be sampled on its own, and the samples
+	budget split between islands (see IslandBudget).
+
+   ========================================== */
+
+enum IslandBudget {
+	BUDGET_PROPORTIONAL = 0,	// by the volume of the islands
+	BUDGET_EQUAL,				// the same for every island
+	BUDGET_MINIMUM				// by volume, but no fewer than a minimum
+};
+
+class VoxelIslands {
+public:
+	struct Island {
+		size_t		voxels;
+		int			min[ 3 ];	// voxel coordinates, included
+		int			max[ 3 ];
+	};
+
+						VoxelIslands() { clear(); }
+
+	void				clear();
+
+	// labels the voxels of 'grid' on up to 'threads' threads (0 for all the
+	// cores)
+	void				build( const VoxelGrid& grid, int threads = 0 );
+
+	size_t				numIslands() const { return islands.size(); }
+	const Island&		island( int i ) const { return islands[ i ]; }
+
+	// min/max corners of an island
+	void				islandBounds( int i, float* bbMin, float* bbMax ) const;
+
+	// island of the voxel at the given coordinates, -1 if it is empty
+	int					islandAt( int x, int y, int z ) const;
+
+	// island of the voxel holding each of the 'count' xyz points, -1 for
+	// points outside the occupied voxels
+	void				labelPoints( const float* points, size_t count, int* labels ) const;
+
+	// Splits 'numSamples' between the islands, following 'budget'. With
+	// BUDGET_MINIMUM, islands get at least 'minSamples' as long as there are
+	// enough samples for all of them.
+	void				budget( int numSamples, IslandBudget budget, int minSamples, std::vector< int >& counts ) const;
+
+	// appends 'numSamples' xyz samples uniformly distributed in island 'i'.
+	// Sample counts are added to 'stats' if given.
+	void				Sample( int i, int numSamples, Random& rng, std::vector< float >& samples, SamplerStats* stats = NULL ) const;
+
+private:
+	struct Run {
+		int			x, y;
+		int			z0, z1;		// z1 excluded
+	};
+
+	int						res[ 3 ];
+	Bounds					bounds;
+	float					voxelSize[ 3 ];
+
+	std::vector< uint32_t >	columnStart;	// first run of each column, and the total
+	std::vector< Run >		runs;			// by column, then along Z
+	std::vector< int >		runIsland;
+
+	std::vector< Island >	islands;
+
+	// runs of each island, with the voxels before each of them in the island
+	std::vector< uint32_t >	islandStart;
+	std::vector< uint32_t >	islandRuns;
+	std::vector< size_t >	islandOffsets;
+};
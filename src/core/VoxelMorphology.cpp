@@ -0,0 +1,155 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "VoxelMorphology.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+namespace {
+	typedef VoxelGrid::Word Word;
+	const int BITS = VoxelGrid::BITS_PER_WORD;
+
+	// ORs the column with itself moved 's' voxels up, 0 < s < BITS
+	void spreadUp( Word* column, int words, int s ) {
+		for( int i = words - 1; i >= 0; i-- ) {
+			column[ i ] |= column[ i ] << s | ( i > 0 ? column[ i - 1 ] >> ( BITS - s ) : 0 );
+		}
+	}
+
+	// ORs the column with itself moved 's' voxels down, 0 < s < BITS
+	void spreadDown( Word* column, int words, int s ) {
+		for( int i = 0; i < words; i++ ) {
+			column[ i ] |= column[ i ] >> s | ( i + 1 < words ? column[ i + 1 ] << ( BITS - s ) : 0 );
+		}
+	}
+
+	// sets the voxels [z0, z1) of the column
+	void setRange( Word* column, int z0, int z1 ) {
+		for( int z = z0; z < z1; z++ ) {
+			column[ z / BITS ] |= (Word)1 << ( z % BITS );
+		}
+	}
+
+	// Dilates the occupied voxels by 'radius' along each axis. With
+	// 'outsideOccupied' the voxels beyond the grid count as occupied, and
+	// those within the radius of its bounds become so. With 'complement'
+	// the empty voxels are dilated instead, and the grid is left
+	// complemented, which erodes the occupied ones.
+	void dilate( VoxelGrid& grid, int radius, bool outsideOccupied, bool complement, const std::vector< Word >& masks, int threads ) {
+		TRACE_SCOPE( "dilate" );
+		const int resX = grid.resX(), resY = grid.resY(), resZ = grid.resZ();
+		const int words = grid.wordsPerColumn();
+		const size_t rowWords = (size_t)resX * words;
+		Word* data = grid.data();
+
+		// along Z and then X, one row of columns at a time
+		ParallelFor( resY, threads, [ & ]( size_t y0, size_t y1 ) {
+			std::vector< Word > up( words ), row( rowWords );
+			for( size_t y = y0; y < y1; y++ ) {
+				Word* rowData = data + y * rowWords;
+				for( int x = 0; x < resX; x++ ) {
+					Word* column = rowData + (size_t)x * words;
+					if ( complement ) {
+						for( int i = 0; i < words; i++ ) column[ i ] = ~column[ i ] & masks[ i ];
+					}
+					// both copies cover [0, covered] voxels in their direction,
+					// and grow by up to as much again on each spread
+					std::copy( column, column + words, up.begin() );
+					for( int covered = 0; covered < radius; ) {
+						const int s = std::min( std::min( covered + 1, radius - covered ), BITS - 1 );
+						spreadUp( &up[ 0 ], words, s );
+						spreadDown( column, words, s );
+						covered += s;
+					}
+					for( int i = 0; i < words; i++ ) {
+						column[ i ] = ( column[ i ] | up[ i ] ) & masks[ i ];
+					}
+					if ( outsideOccupied ) {
+						setRange( column, 0, std::min( radius, resZ ) );
+						setRange( column, std::max( 0, resZ - radius ), resZ );
+					}
+				}
+
+				std::copy( rowData, rowData + rowWords, row.begin() );
+				for( int x = 0; x < resX; x++ ) {
+					Word* column = rowData + (size_t)x * words;
+					if ( outsideOccupied && ( x < radius || x + radius >= resX ) ) {
+						std::copy( masks.begin(), masks.end(), column );
+						continue;
+					}
+					const int last = std::min( resX - 1, x + radius );
+					for( int n = std::max( 0, x - radius ); n <= last; n++ ) {
+						const Word* neighbour = &row[ (size_t)n * words ];
+						for( int i = 0; i < words; i++ ) column[ i ] |= neighbour[ i ];
+					}
+				}
+			}
+		} );
+
+		// along Y, whole rows at a time
+		const std::vector< Word > source( data, data + grid.numWords() );
+		ParallelFor( resY, threads, [ & ]( size_t y0, size_t y1 ) {
+			for( size_t y = y0; y < y1; y++ ) {
+				Word* rowData = data + y * rowWords;
+				if ( outsideOccupied && ( (int)y < radius || (int)y + radius >= resY ) ) {
+					for( int x = 0; x < resX; x++ ) {
+						Word* column = rowData + (size_t)x * words;
+						for( int i = 0; i < words; i++ ) column[ i ] = complement ? 0 : masks[ i ];
+					}
+					continue;
+				}
+				const int last = std::min( resY - 1, (int)y + radius );
+				for( int n = std::max( 0, (int)y - radius ); n <= last; n++ ) {
+					const Word* neighbour = &source[ (size_t)n * rowWords ];
+					for( size_t k = 0; k < rowWords; k++ ) rowData[ k ] |= neighbour[ k ];
+				}
+				if ( complement ) {
+					for( int x = 0; x < resX; x++ ) {
+						Word* column = rowData + (size_t)x * words;
+						for( int i = 0; i < words; i++ ) column[ i ] = ~column[ i ] & masks[ i ];
+					}
+				}
+			}
+		} );
+	}
+
+	// the outside of the grid is empty for the empty voxels if it is
+	// occupied for the occupied ones
+	void erode( VoxelGrid& grid, int radius, bool outsideOccupied, const std::vector< Word >& masks, int threads ) {
+		dilate( grid, radius, !outsideOccupied, true, masks, threads );
+	}
+}
+
+void ApplyMorphology( VoxelGrid& grid, MorphologyOp op, int radius, int threads ) {
+	TRACE_SCOPE( "ApplyMorphology" );
+	if ( op == MORPHOLOGY_NONE || radius <= 0 || grid.empty() ) return;
+	threads = WorkerThreads( threads );
+
+	std::vector< Word > masks( grid.wordsPerColumn() );
+	for( int i = 0; i < grid.wordsPerColumn(); i++ ) masks[ i ] = grid.wordMask( i );
+
+	switch( op ) {
+		case MORPHOLOGY_DILATE:
+			dilate( grid, radius, false, false, masks, threads );
+			break;
+		case MORPHOLOGY_ERODE:
+			erode( grid, radius, false, masks, threads );
+			break;
+		case MORPHOLOGY_OPEN:
+			erode( grid, radius, false, masks, threads );
+			dilate( grid, radius, false, false, masks, threads );
+			break;
+		case MORPHOLOGY_CLOSE:
+			dilate( grid, radius, false, false, masks, threads );
+			erode( grid, radius, true, masks, threads );
+			break;
+		default:
+			break;
+	}
+}
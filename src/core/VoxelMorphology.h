@@ -0,0 +1,44 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "VoxelGrid.h"
+
+enum MorphologyOp {
+	MORPHOLOGY_NONE = 0,
+	MORPHOLOGY_DILATE,		// grows the occupied voxels by the radius
+	MORPHOLOGY_ERODE,		// shrinks them by the radius
+	MORPHOLOGY_OPEN,		// erodes then dilates, removing thin parts
+	MORPHOLOGY_CLOSE		// dilates then erodes, filling small holes
+};
+
+/* ==========================================
+	ApplyMorphology
+
+	Morphological operations on the occupied voxels of a
+	VoxelGrid, with a cube of 2 * radius + 1 voxels per side
+	as the structuring element.
+
+	The cube is separable, so each operation runs as three
+	passes, one per axis, on the packed column words: along Z
+	the bits of a column are ORed with shifted copies of
+	themselves, doubling the covered span every time, and
+	along X and Y whole columns are ORed with their
+	neighbours a word at a time. Erosion is the dilation of
+	the empty voxels. Rows of columns are split between up to
+	'threads' threads (0 for all the cores).
+
+	The space outside the grid counts as empty, so voxels
+	within the radius of its bounds are eroded, except when
+	closing, where the erosion undoes a dilation that
+	couldn't grow past the bounds and the outside is taken as
+	occupied instead.
+
+   ========================================== */
+
+void ApplyMorphology( VoxelGrid& grid, MorphologyOp op, int radius, int threads = 0 );
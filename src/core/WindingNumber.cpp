@@ -0,0 +1,373 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "WindingNumber.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define SAMPLER_WINDING_SSE
+#include <emmintrin.h>
+#endif
+
+namespace {
+	const float PI = 3.14159265358979f;
+
+	// below this many points per thread, threads cost more than they save
+	const size_t MIN_POINTS_PER_THREAD = 256;
+
+	inline float dot( const float* a, const float* b ) {
+		return a[ 0 ] * b[ 0 ] + a[ 1 ] * b[ 1 ] + a[ 2 ] * b[ 2 ];
+	}
+
+	// normal of a triangle scaled by its area, as half the cross product of
+	// its edges
+	void areaNormal( const MeshView& mesh, unsigned int t, float* n ) {
+		const int* tri = mesh.triangle( t );
+		const float* a = mesh.point( tri[ 0 ] );
+		const float* b = mesh.point( tri[ 1 ] );
+		const float* c = mesh.point( tri[ 2 ] );
+		const float e1[ 3 ] = { b[ 0 ] - a[ 0 ], b[ 1 ] - a[ 1 ], b[ 2 ] - a[ 2 ] };
+		const float e2[ 3 ] = { c[ 0 ] - a[ 0 ], c[ 1 ] - a[ 1 ], c[ 2 ] - a[ 2 ] };
+		n[ 0 ] = 0.5f * ( e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ] );
+		n[ 1 ] = 0.5f * ( e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ] );
+		n[ 2 ] = 0.5f * ( e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ] );
+	}
+
+	// signed solid angle of triangle abc seen from 'p' (Van Oosterom and
+	// Strackee), positive when the triangle is counter-clockwise from there
+	float solidAngle( const float* tri, const float* p ) {
+		float a[ 3 ], b[ 3 ], c[ 3 ];
+		for( int axis = 0; axis < 3; axis++ ) {
+			a[ axis ] = tri[ axis ] - p[ axis ];
+			b[ axis ] = tri[ 3 + axis ] - p[ axis ];
+			c[ axis ] = tri[ 6 + axis ] - p[ axis ];
+		}
+		const float la = sqrtf( dot( a, a ) ), lb = sqrtf( dot( b, b ) ), lc = sqrtf( dot( c, c ) );
+		const float det = a[ 0 ] * ( b[ 1 ] * c[ 2 ] - b[ 2 ] * c[ 1 ] ) +
+						  a[ 1 ] * ( b[ 2 ] * c[ 0 ] - b[ 0 ] * c[ 2 ] ) +
+						  a[ 2 ] * ( b[ 0 ] * c[ 1 ] - b[ 1 ] * c[ 0 ] );
+		const float denominator = la * lb * lc + dot( a, b ) * lc + dot( b, c ) * la + dot( c, a ) * lb;
+		return 2.0f * atan2f( det, denominator );
+	}
+
+	// Solid angle of the triangles of a node seen from the point at 'r' from
+	// its center, by the Taylor expansion of the dipole kernel r / |r|^3 to
+	// first order around it.
+	float farField( const float* normal, const float* moments, const float* r, float r2 ) {
+		const float inv = 1.0f / sqrtf( r2 );
+		const float inv3 = inv * inv * inv;
+		const float inv5 = inv3 * inv * inv;
+		float rMr = 0;
+		for( int i = 0; i < 3; i++ ) {
+			rMr += r[ i ] * ( moments[ 3 * i ] * r[ 0 ] + moments[ 3 * i + 1 ] * r[ 1 ] + moments[ 3 * i + 2 ] * r[ 2 ] );
+		}
+		const float trace = moments[ 0 ] + moments[ 4 ] + moments[ 8 ];
+		return ( dot( normal, r ) + trace ) * inv3 - 3.0f * rMr * inv5;
+	}
+
+#ifdef SAMPLER_WINDING_SSE
+	inline __m128 select( __m128 mask, __m128 a, __m128 b ) {
+		return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+	}
+
+	// atan2 with a polynomial on [0, 1] and the octant fixed up, within 1e-5
+	__m128 atan2Packet( __m128 y, __m128 x ) {
+		const __m128 sign = _mm_set1_ps( -0.0f );
+		const __m128 ax = _mm_andnot_ps( sign, x ), ay = _mm_andnot_ps( sign, y );
+		const __m128 a = _mm_div_ps( _mm_min_ps( ax, ay ), _mm_max_ps( _mm_max_ps( ax, ay ), _mm_set1_ps( FLT_MIN ) ) );
+		const __m128 s = _mm_mul_ps( a, a );
+		__m128 r = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( -0.0464964749f ), s ), _mm_set1_ps( 0.15931422f ) );
+		r = _mm_add_ps( _mm_mul_ps( r, s ), _mm_set1_ps( -0.327622764f ) );
+		r = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( r, s ), a ), a );
+		r = select( _mm_cmpgt_ps( ay, ax ), _mm_sub_ps( _mm_set1_ps( 0.5f * PI ), r ), r );
+		r = select( _mm_cmplt_ps( x, _mm_setzero_ps() ), _mm_sub_ps( _mm_set1_ps( PI ), r ), r );
+		return _mm_or_ps( r, _mm_and_ps( y, sign ) );
+	}
+
+	inline __m128 dotPacket( const __m128* a, const __m128* b ) {
+		return _mm_add_ps( _mm_add_ps( _mm_mul_ps( a[ 0 ], b[ 0 ] ), _mm_mul_ps( a[ 1 ], b[ 1 ] ) ), _mm_mul_ps( a[ 2 ], b[ 2 ] ) );
+	}
+
+	// lanes of 'bits' as a mask
+	inline __m128 laneMask( int bits ) {
+		const __m128i lanes = _mm_setr_epi32( 1, 2, 4, 8 );
+		return _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( _mm_set1_epi32( bits ), lanes ), lanes ) );
+	}
+#endif
+}
+
+void WindingNumber::clear() {
+	nodes.clear();
+	vertices.clear();
+}
+
+void WindingNumber::build( const MeshView& mesh, float accuracy ) {
+	TRACE_SCOPE( "WindingNumber::build" );
+	clear();
+	if ( mesh.numTriangles == 0 ) return;
+
+	const size_t numTriangles = mesh.numTriangles;
+	std::vector< float > centroids( 3 * numTriangles );
+	std::vector< unsigned int > order( numTriangles );
+	for( size_t i = 0; i < numTriangles; i++ ) {
+		const int* tri = mesh.triangle( i );
+		for( int axis = 0; axis < 3; axis++ ) {
+			centroids[ 3 * i + axis ] = ( mesh.point( tri[ 0 ] )[ axis ] + mesh.point( tri[ 1 ] )[ axis ] + mesh.point( tri[ 2 ] )[ axis ] ) / 3.0f;
+		}
+		order[ i ] = (unsigned int)i;
+	}
+
+	nodes.reserve( 2 * numTriangles / MAX_LEAF_TRIANGLES + 1 );
+	float area, radius;
+	buildRecursive( 0, (unsigned int)numTriangles, mesh, order, centroids, std::max( accuracy, 1.0f ), 0, area, radius );
+
+	// copy the triangles in leaf order
+	vertices.resize( 9 * numTriangles );
+	for( size_t i = 0; i < numTriangles; i++ ) {
+		const int* tri = mesh.triangle( order[ i ] );
+		for( int v = 0; v < 3; v++ ) {
+			const float* p = mesh.point( tri[ v ] );
+			vertices[ 9 * i + 3 * v + 0 ] = p[ 0 ];
+			vertices[ 9 * i + 3 * v + 1 ] = p[ 1 ];
+			vertices[ 9 * i + 3 * v + 2 ] = p[ 2 ];
+		}
+	}
+}
+
+unsigned int WindingNumber::buildRecursive( unsigned int begin, unsigned int end, const MeshView& mesh, std::vector< unsigned int >& order,
+											const std::vector< float >& centroids, float accuracy, int depth, float& area, float& radius ) {
+	const unsigned int nodeIndex = (unsigned int)nodes.size();
+	nodes.push_back( Node() );
+
+	Node node;
+	for( int i = 0; i < 3; i++ ) node.center[ i ] = node.normal[ i ] = 0;
+	for( int i = 0; i < 9; i++ ) node.moments[ i ] = 0;
+
+	const unsigned int count = end - begin;
+	if ( count <= MAX_LEAF_TRIANGLES || depth >= MAX_DEPTH - 1 ) {
+		area = 0;
+		Bounds bounds;
+		for( unsigned int i = begin; i < end; i++ ) {
+			float n[ 3 ];
+			areaNormal( mesh, order[ i ], n );
+			const float triangleArea = sqrtf( dot( n, n ) );
+			const float* centroid = &centroids[ 3 * order[ i ] ];
+			for( int axis = 0; axis < 3; axis++ ) {
+				node.normal[ axis ] += n[ axis ];
+				node.center[ axis ] += triangleArea * centroid[ axis ];
+			}
+			area += triangleArea;
+			bounds.expand( centroid );
+		}
+		for( int axis = 0; axis < 3; axis++ ) {
+			node.center[ axis ] = area > 0 ? node.center[ axis ] / area : bounds.center( axis );
+		}
+
+		radius = 0;
+		for( unsigned int i = begin; i < end; i++ ) {
+			float n[ 3 ], offset[ 3 ];
+			areaNormal( mesh, order[ i ], n );
+			const float* centroid = &centroids[ 3 * order[ i ] ];
+			for( int axis = 0; axis < 3; axis++ ) offset[ axis ] = centroid[ axis ] - node.center[ axis ];
+			for( int row = 0; row < 3; row++ ) {
+				for( int column = 0; column < 3; column++ ) {
+					node.moments[ 3 * row + column ] += n[ row ] * offset[ column ];
+				}
+			}
+			const int* tri = mesh.triangle( order[ i ] );
+			for( int v = 0; v < 3; v++ ) {
+				const float* p = mesh.point( tri[ v ] );
+				const float d[ 3 ] = { p[ 0 ] - node.center[ 0 ], p[ 1 ] - node.center[ 1 ], p[ 2 ] - node.center[ 2 ] };
+				radius = std::max( radius, sqrtf( dot( d, d ) ) );
+			}
+		}
+		node.farDistance2 = accuracy * accuracy * radius * radius;
+		node.first = begin;
+		node.count = count;
+		nodes[ nodeIndex ] = node;
+		return nodeIndex;
+	}
+
+	// median split along the longest side of the centroids
+	Bounds centroidBounds;
+	for( unsigned int i = begin; i < end; i++ ) {
+		centroidBounds.expand( &centroids[ 3 * order[ i ] ] );
+	}
+	const int axis = centroidBounds.longestAxis();
+	const unsigned int middle = begin + count / 2;
+	std::nth_element( order.begin() + begin, order.begin() + middle, order.begin() + end,
+		[ & ]( unsigned int i, unsigned int j ) { return centroids[ 3 * i + axis ] < centroids[ 3 * j + axis ]; } );
+
+	float leftArea, leftRadius, rightArea, rightRadius;
+	const unsigned int left = buildRecursive( begin, middle, mesh, order, centroids, accuracy, depth + 1, leftArea, leftRadius );
+	const unsigned int right = buildRecursive( middle, end, mesh, order, centroids, accuracy, depth + 1, rightArea, rightRadius );
+	const Node& l = nodes[ left ];
+	const Node& r = nodes[ right ];
+
+	// The children are combined around the area weighted center of both,
+	// their moments moved to it along with their normals.
+	area = leftArea + rightArea;
+	for( int i = 0; i < 3; i++ ) {
+		node.normal[ i ] = l.normal[ i ] + r.normal[ i ];
+		node.center[ i ] = area > 0 ? ( leftArea * l.center[ i ] + rightArea * r.center[ i ] ) / area : 0.5f * ( l.center[ i ] + r.center[ i ] );
+	}
+	float leftOffset[ 3 ], rightOffset[ 3 ];
+	for( int i = 0; i < 3; i++ ) {
+		leftOffset[ i ] = l.center[ i ] - node.center[ i ];
+		rightOffset[ i ] = r.center[ i ] - node.center[ i ];
+	}
+	for( int row = 0; row < 3; row++ ) {
+		for( int column = 0; column < 3; column++ ) {
+			node.moments[ 3 * row + column ] = l.moments[ 3 * row + column ] + l.normal[ row ] * leftOffset[ column ] +
+											   r.moments[ 3 * row + column ] + r.normal[ row ] * rightOffset[ column ];
+		}
+	}
+	radius = std::max( sqrtf( dot( leftOffset, leftOffset ) ) + leftRadius, sqrtf( dot( rightOffset, rightOffset ) ) + rightRadius );
+	node.farDistance2 = accuracy * accuracy * radius * radius;
+	node.first = right;
+	node.count = 0;
+	nodes[ nodeIndex ] = node;
+	return nodeIndex;
+}
+
+float WindingNumber::evaluate( const float* p ) const {
+	if ( nodes.empty() ) return 0;
+
+	float sum = 0;
+	unsigned int stack[ MAX_DEPTH + 1 ];
+	int stackSize = 0;
+	unsigned int current = 0;
+	while( true ) {
+		const Node& node = nodes[ current ];
+		const float r[ 3 ] = { node.center[ 0 ] - p[ 0 ], node.center[ 1 ] - p[ 1 ], node.center[ 2 ] - p[ 2 ] };
+		const float r2 = dot( r, r );
+		if ( r2 > node.farDistance2 ) {
+			sum += farField( node.normal, node.moments, r, r2 );
+		} else if ( node.count > 0 ) {
+			for( unsigned int i = 0; i < node.count; i++ ) {
+				sum += solidAngle( &vertices[ 9 * ( node.first + i ) ], p );
+			}
+		} else {
+			stack[ stackSize++ ] = node.first;
+			current++;
+			continue;
+		}
+		if ( stackSize == 0 ) break;
+		current = stack[ --stackSize ];
+	}
+	return sum / ( 4.0f * PI );
+}
+
+#ifdef SAMPLER_WINDING_SSE
+void WindingNumber::evaluatePacket( const float* points, float* values ) const {
+	const __m128 q[ 3 ] = { _mm_setr_ps( points[ 0 ], points[ 3 ], points[ 6 ], points[ 9 ] ),
+							_mm_setr_ps( points[ 1 ], points[ 4 ], points[ 7 ], points[ 10 ] ),
+							_mm_setr_ps( points[ 2 ], points[ 5 ], points[ 8 ], points[ 11 ] ) };
+	__m128 sum = _mm_setzero_ps();
+
+	// The 4 points go down the hierarchy together: each node is approximated
+	// for the points far enough from it, and opened for the rest.
+	struct Entry {
+		unsigned int	node;
+		int				lanes;
+	};
+	Entry stack[ MAX_DEPTH + 1 ];
+	int stackSize = 0;
+	Entry current = { 0, 0xf };
+	while( true ) {
+		const Node& node = nodes[ current.node ];
+		__m128 r[ 3 ];
+		for( int i = 0; i < 3; i++ ) r[ i ] = _mm_sub_ps( _mm_set1_ps( node.center[ i ] ), q[ i ] );
+		const __m128 r2 = dotPacket( r, r );
+		const __m128 far = _mm_and_ps( laneMask( current.lanes ), _mm_cmpgt_ps( r2, _mm_set1_ps( node.farDistance2 ) ) );
+		const int farLanes = _mm_movemask_ps( far );
+
+		if ( farLanes != 0 ) {
+			const __m128 inv = _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_sqrt_ps( r2 ) );
+			const __m128 inv3 = _mm_mul_ps( _mm_mul_ps( inv, inv ), inv );
+			const __m128 inv5 = _mm_mul_ps( _mm_mul_ps( inv3, inv ), inv );
+			__m128 rMr = _mm_setzero_ps();
+			for( int i = 0; i < 3; i++ ) {
+				const __m128 row[ 3 ] = { _mm_set1_ps( node.moments[ 3 * i ] ), _mm_set1_ps( node.moments[ 3 * i + 1 ] ), _mm_set1_ps( node.moments[ 3 * i + 2 ] ) };
+				rMr = _mm_add_ps( rMr, _mm_mul_ps( r[ i ], dotPacket( row, r ) ) );
+			}
+			const __m128 normal[ 3 ] = { _mm_set1_ps( node.normal[ 0 ] ), _mm_set1_ps( node.normal[ 1 ] ), _mm_set1_ps( node.normal[ 2 ] ) };
+			const __m128 trace = _mm_set1_ps( node.moments[ 0 ] + node.moments[ 4 ] + node.moments[ 8 ] );
+			const __m128 value = _mm_sub_ps( _mm_mul_ps( _mm_add_ps( dotPacket( normal, r ), trace ), inv3 ),
+											 _mm_mul_ps( _mm_set1_ps( 3.0f ), _mm_mul_ps( rMr, inv5 ) ) );
+			sum = _mm_add_ps( sum, _mm_and_ps( far, value ) );
+		}
+
+		const int nearLanes = current.lanes & ~farLanes;
+		if ( nearLanes != 0 && node.count == 0 ) {
+			const Entry right = { node.first, nearLanes };
+			stack[ stackSize++ ] = right;
+			current.node++;
+			current.lanes = nearLanes;
+			continue;
+		}
+		if ( nearLanes != 0 ) {
+			const __m128 near = laneMask( nearLanes );
+			for( unsigned int t = 0; t < node.count; t++ ) {
+				const float* tri = &vertices[ 9 * ( node.first + t ) ];
+				__m128 a[ 3 ], b[ 3 ], c[ 3 ];
+				for( int i = 0; i < 3; i++ ) {
+					a[ i ] = _mm_sub_ps( _mm_set1_ps( tri[ i ] ), q[ i ] );
+					b[ i ] = _mm_sub_ps( _mm_set1_ps( tri[ 3 + i ] ), q[ i ] );
+					c[ i ] = _mm_sub_ps( _mm_set1_ps( tri[ 6 + i ] ), q[ i ] );
+				}
+				const __m128 la = _mm_sqrt_ps( dotPacket( a, a ) ), lb = _mm_sqrt_ps( dotPacket( b, b ) ), lc = _mm_sqrt_ps( dotPacket( c, c ) );
+				const __m128 bc[ 3 ] = { _mm_sub_ps( _mm_mul_ps( b[ 1 ], c[ 2 ] ), _mm_mul_ps( b[ 2 ], c[ 1 ] ) ),
+										 _mm_sub_ps( _mm_mul_ps( b[ 2 ], c[ 0 ] ), _mm_mul_ps( b[ 0 ], c[ 2 ] ) ),
+										 _mm_sub_ps( _mm_mul_ps( b[ 0 ], c[ 1 ] ), _mm_mul_ps( b[ 1 ], c[ 0 ] ) ) };
+				const __m128 det = dotPacket( a, bc );
+				const __m128 denominator = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_mul_ps( la, lb ), lc ), _mm_mul_ps( dotPacket( a, b ), lc ) ),
+													   _mm_add_ps( _mm_mul_ps( dotPacket( b, c ), la ), _mm_mul_ps( dotPacket( c, a ), lb ) ) );
+				const __m128 angle = _mm_mul_ps( _mm_set1_ps( 2.0f ), atan2Packet( det, denominator ) );
+				sum = _mm_add_ps( sum, _mm_and_ps( near, angle ) );
+			}
+		}
+		if ( stackSize == 0 ) break;
+		current = stack[ --stackSize ];
+	}
+	_mm_storeu_ps( values, _mm_mul_ps( sum, _mm_set1_ps( 1.0f / ( 4.0f * PI ) ) ) );
+}
+#else
+void WindingNumber::evaluatePacket( const float* points, float* values ) const {
+	for( int i = 0; i < 4; i++ ) {
+		values[ i ] = evaluate( points + 3 * i );
+	}
+}
+#endif
+
+void WindingNumber::evaluate( const float* points, size_t count, float* values, int threads ) const {
+	TRACE_SCOPE( "WindingNumber::evaluate" );
+	if ( nodes.empty() ) {
+		std::fill( values, values + count, 0.0f );
+		return;
+	}
+	threads = WorkerThreads( threads );
+	threads = (int)std::max( (size_t)1, std::min( (size_t)threads, count / MIN_POINTS_PER_THREAD ) );
+
+	// ranges of whole packets, so that consecutive points stay together
+	const size_t packets = ( count + 3 ) / 4;
+	ParallelFor( packets, threads, [ & ]( size_t begin, size_t end ) {
+		for( size_t packet = begin; packet < end; packet++ ) {
+			const size_t i = 4 * packet;
+			if ( i + 4 <= count ) {
+				evaluatePacket( points + 3 * i, values + i );
+			} else {
+				for( size_t j = i; j < count; j++ ) values[ j ] = evaluate( points + 3 * j );
+			}
+		}
+	} );
+}
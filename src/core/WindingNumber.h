@@ -0,0 +1,96 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+
+#include <vector>
+
+// how the samplers tell the inside of a mesh from the outside
+enum InsideTest {
+	INSIDE_PARITY = 0,			// odd number of surfaces crossed, for closed meshes
+	INSIDE_WINDING_NUMBER		// see WindingNumber, for meshes with holes or overlaps
+};
+
+/* ==========================================
+	Class WindingNumber
+
+	Generalized winding number of a triangle mesh ("Robust
+	Inside-Outside Segmentation using Generalized Winding
+	Numbers", Jacobson et al.): the sum of the signed solid
+	angles of its triangles seen from a point, over 4 pi. It
+	is 1 inside a closed mesh and 0 outside, and degrades
+	gracefully on meshes with holes, overlapping shells or
+	self intersections, where parity gives garbage: points
+	are inside where it is over one half.
+
+	The triangles are kept in a hierarchy ("Fast Winding
+	Numbers for Soups and Clouds", Barill et al.). Each node
+	stores the dipole expansion of its triangles (the sum of
+	their area weighted normals, and its first moment about
+	their center), which stands for all of them when the
+	point is further than 'accuracy' times their radius.
+	Only the nodes near the point are opened down to exact
+	solid angles, so a query costs about the logarithm of the
+	number of triangles.
+
+	Batches of points are evaluated 4 at a time with SSE,
+	traversing the hierarchy once for the 4 of them, so
+	nearby points should be given in sequence.
+
+   ========================================== */
+
+class WindingNumber {
+public:
+					WindingNumber() {}
+
+	// builds the hierarchy of 'mesh'. Larger 'accuracy' opens more nodes,
+	// trading speed for precision.
+	void			build( const MeshView& mesh, float accuracy = 2.0f );
+	void			clear();
+	bool			empty() const { return nodes.empty(); }
+
+	// winding number of the mesh at 'p'
+	float			evaluate( const float* p ) const;
+
+	// winding numbers of 'count' xyz points, split between up to 'threads'
+	// threads (0 for all the cores)
+	void			evaluate( const float* points, size_t count, float* values, int threads = 1 ) const;
+
+	// The winding number is negative for meshes facing inwards, so its
+	// magnitude is tested: inverted meshes are not flipped inside out.
+	static bool		Inside( float value ) { return value > 0.5f || value < -0.5f; }
+
+	bool			inside( const float* p ) const { return Inside( evaluate( p ) ); }
+
+private:
+	struct Node {
+		float			center[ 3 ];	// area weighted centroid of the triangles
+		float			farDistance2;	// squared distance beyond which the expansion is used
+		float			normal[ 3 ];	// sum of the area weighted normals
+		float			moments[ 9 ];	// sum of normal[ i ] * ( centroid - center )[ j ], by rows
+		unsigned int	first;			// leaves: first triangle. Inner nodes: right child
+		unsigned int	count;			// number of triangles, 0 for inner nodes
+	};
+
+	enum {
+		MAX_LEAF_TRIANGLES = 4,
+		MAX_DEPTH = 64
+	};
+
+	// builds the node over order[ begin, end ), and returns its index, the
+	// area of its triangles and their radius around its center
+	unsigned int	buildRecursive( unsigned int begin, unsigned int end, const MeshView& mesh, std::vector< unsigned int >& order,
+									const std::vector< float >& centroids, float accuracy, int depth, float& area, float& radius );
+
+	// winding numbers of 4 xyz points
+	void			evaluatePacket( const float* points, float* values ) const;
+
+	std::vector< Node >		nodes;
+	std::vector< float >	vertices;	// 9 floats per triangle, in leaf order
+};
@@ -11,6 +11,10 @@
 #include "SamplePreviewShape.h"
 #include "SamplePreviewShapeUI.h"
 #include "RaySampler.h"
+#include "SampleThinner.h"
+#include "SampleBufferData.h"
+#include "SamplerTraceCmd.h"
+#include "Trace.h"
 
 #include <maya/MFnPlugin.h>
 
@@ -28,6 +32,16 @@ MStatus initializePlugin( MObject obj )
 	MStatus   status;
 	MFnPlugin plugin( obj, "Jose Esteve - www.joesfer.com", "2011", "Any");
 
+	// SAMPLER_TRACE enables tracing from the start, the trace is written when
+	// the plug-in is unloaded
+	Trace::ConfigureFromEnvironment( false );
+
+	status = plugin.registerData( SampleBufferData::typeName, SampleBufferData::id, SampleBufferData::creator );
+	if (!status) {
+		status.perror("registerData");
+		return status;
+	}
+
 	status = plugin.registerData( VoxelPreviewDataWrapper::typeName, VoxelPreviewDataWrapper::id, VoxelPreviewDataWrapper::creator, MPxData::kGeometryData );
 	if (!status) {
 		status.perror("registerData");
@@ -74,6 +88,21 @@ MStatus initializePlugin( MObject obj )
 		return status;
 	}
 
+	status = plugin.registerNode( "SampleThinner", 
+								  SampleThinner::id, 
+								  SampleThinner::creator,
+								  SampleThinner::initialize );
+	if (!status) {
+		status.perror("registerNode");
+		return status;
+	}
+
+	status = plugin.registerCommand( SamplerTraceCmd::name, SamplerTraceCmd::creator, SamplerTraceCmd::newSyntax );
+	if (!status) {
+		status.perror("registerCommand");
+		return status;
+	}
+
 	return status;
 }
 
@@ -90,6 +119,17 @@ MStatus uninitializePlugin( MObject obj)
 	MStatus   status;
 	MFnPlugin plugin( obj );
 
+	const char* tracePath = Trace::ConfigureFromEnvironment( false );
+	if ( tracePath != NULL ) {
+		Trace::WriteChromeJson( tracePath );
+	}
+
+	status = plugin.deregisterCommand( SamplerTraceCmd::name );
+	if (!status) {
+		status.perror("deregisterCommand");
+		return status;
+	}
+
 	status = plugin.deregisterData( VoxelPreviewDataWrapper::id );
 	if (!status) {
 		status.perror("deregisterData");
@@ -114,6 +154,18 @@ MStatus uninitializePlugin( MObject obj)
 		return status;
 	}
 
+	status = plugin.deregisterNode( SampleThinner::id );
+	if (!status) {
+		status.perror("deregisterNode");
+		return status;
+	}
+
+	status = plugin.deregisterData( SampleBufferData::id );
+	if (!status) {
+		status.perror("deregisterData");
+		return status;
+	}
+
 
 	return status;
 }
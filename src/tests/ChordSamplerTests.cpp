@@ -0,0 +1,62 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "ChordSampler.h"
+#include "WindingNumber.h"
+#include "SyntheticMeshes.h"
+
+#include <math.h>
+#include <vector>
+
+namespace {
+
+	bool testChordSampler() {
+		// every sample of a box lies in it, and they fill it evenly
+		const float boxMin[ 3 ] = { 0.2f, 0.1f, 0.3f }, boxMax[ 3 ] = { 0.9f, 0.6f, 0.8f };
+		TriangleMesh box;
+		AddBox( boxMin, boxMax, box );
+		ChordSampler sampler;
+		sampler.setMesh( box.view(), 32 );
+		CHECK( sampler.numChords() > 0 );
+		const double boxVolume = ( boxMax[ 0 ] - boxMin[ 0 ] ) * ( boxMax[ 1 ] - boxMin[ 1 ] ) * ( boxMax[ 2 ] - boxMin[ 2 ] );
+		CHECK( fabs( sampler.volume() - boxVolume ) < 0.05 * boxVolume );
+
+		const int count = 20000;
+		Random rng( 10 );
+		std::vector< float > samples;
+		CHECK( sampler.Sample( count, rng, samples ) );
+		CHECK( samples.size() == 3 * (size_t)count );
+		double sum[ 3 ] = { 0, 0, 0 };
+		for( int i = 0; i < count; i++ ) {
+			for( int axis = 0; axis < 3; axis++ ) {
+				const float p = samples[ 3 * i + axis ];
+				CHECK( p >= boxMin[ axis ] && p <= boxMax[ axis ] );
+				sum[ axis ] += p;
+			}
+		}
+		for( int axis = 0; axis < 3; axis++ ) {
+			const double center = 0.5 * ( boxMin[ axis ] + boxMax[ axis ] );
+			CHECK( fabs( sum[ axis ] / count - center ) < 0.01 * ( boxMax[ axis ] - boxMin[ axis ] ) );
+		}
+
+		// the samples of curved meshes stay inside them too
+		TriangleMesh torus;
+		SyntheticMeshes::Generate( SyntheticMeshes::TORUS, 5000, torus );
+		WindingNumber winding;
+		winding.build( torus.view() );
+		sampler.setMesh( torus.view(), 32 );
+		samples.clear();
+		CHECK( sampler.Sample( count, rng, samples ) );
+		for( int i = 0; i < count; i++ ) {
+			CHECK( winding.inside( &samples[ 3 * i ] ) );
+		}
+		return true;
+	}
+
+	const TestRegistration registration( "ChordSampler", testChordSampler );
+}
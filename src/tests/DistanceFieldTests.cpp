@@ -0,0 +1,79 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "DistanceField.h"
+#include "TriangleDistance.h"
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+namespace {
+
+	// distance from 'p' to the closest triangle of 'mesh', triangle by triangle
+	float naiveDistance( const MeshView& mesh, const float* p ) {
+		float closest = FLT_MAX;
+		for( size_t t = 0; t < mesh.numTriangles; t++ ) {
+			const int* tri = mesh.triangle( t );
+			closest = std::min( closest, TriangleDistanceSquared( p, mesh.point( tri[ 0 ] ), mesh.point( tri[ 1 ] ), mesh.point( tri[ 2 ] ) ) );
+		}
+		return sqrtf( closest );
+	}
+
+	bool testDistanceField() {
+		// a box filling its grid, and one away from the borders
+		const float fullMin[ 3 ] = { 0, 0, 0 }, fullMax[ 3 ] = { 1, 1, 1 };
+		const float innerMin[ 3 ] = { 0.2f, 0.3f, 0.25f }, innerMax[ 3 ] = { 0.7f, 0.8f, 0.6f };
+		const float* boxMin[ 2 ] = { fullMin, innerMin };
+		const float* boxMax[ 2 ] = { fullMax, innerMax };
+		const int res = 16;
+		const float voxelSize = 1.0f / res;
+
+		for( int b = 0; b < 2; b++ ) {
+			TriangleMesh box;
+			AddBox( boxMin[ b ], boxMax[ b ], box );
+			VoxelGrid grid;
+			grid.init( res, res, res, UnitBounds() );
+			for( int z = 0; z < res; z++ ) {
+				for( int y = 0; y < res; y++ ) {
+					for( int x = 0; x < res; x++ ) {
+						const float p[ 3 ] = { ( x + 0.5f ) * voxelSize, ( y + 0.5f ) * voxelSize, ( z + 0.5f ) * voxelSize };
+						bool inside = true;
+						for( int axis = 0; axis < 3; axis++ ) {
+							inside = inside && p[ axis ] > boxMin[ b ][ axis ] && p[ axis ] < boxMax[ b ][ axis ];
+						}
+						if ( inside ) grid.set( x, y, z );
+					}
+				}
+			}
+
+			// the whole field, and narrow bands of one and three voxels
+			for( int band = 0; band <= 3; band += band == 0 ? 1 : 2 ) {
+				for( int threads = 1; threads <= 3; threads += 2 ) {
+					DistanceField field;
+					field.build( box.view(), grid, band, threads );
+					CHECK( !field.empty() );
+					const float limit = band > 0 ? band * voxelSize : FLT_MAX;
+					for( int z = 0; z < res; z++ ) {
+						for( int y = 0; y < res; y++ ) {
+							for( int x = 0; x < res; x++ ) {
+								const float p[ 3 ] = { ( x + 0.5f ) * voxelSize, ( y + 0.5f ) * voxelSize, ( z + 0.5f ) * voxelSize };
+								const float d = std::min( limit, naiveDistance( box.view(), p ) );
+								const float expected = grid.get( x, y, z ) ? -d : d;
+								CHECK( fabsf( field.at( x, y, z ) - expected ) < 1e-5f );
+							}
+						}
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	const TestRegistration registration( "DistanceField", testDistanceField );
+}
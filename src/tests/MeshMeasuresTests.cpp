@@ -0,0 +1,63 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "MeshMeasures.h"
+#include "SyntheticMeshes.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace {
+
+	bool testMeshMeasures() {
+		const float boxMin[ 3 ] = { 0.2f, 0.1f, 0.3f }, boxMax[ 3 ] = { 0.9f, 0.6f, 0.8f };
+		const double size[ 3 ] = { boxMax[ 0 ] - boxMin[ 0 ], boxMax[ 1 ] - boxMin[ 1 ], boxMax[ 2 ] - boxMin[ 2 ] };
+		TriangleMesh box;
+		AddBox( boxMin, boxMax, box );
+		const MeshMeasures measures = MeshMeasures::Compute( box.view() );
+		CHECK( fabs( measures.volume - size[ 0 ] * size[ 1 ] * size[ 2 ] ) < 1e-6 );
+		CHECK( fabs( measures.area - 2 * ( size[ 0 ] * size[ 1 ] + size[ 1 ] * size[ 2 ] + size[ 2 ] * size[ 0 ] ) ) < 1e-6 );
+
+		// facing inwards
+		for( size_t t = 0; t < box.triangles.size(); t += 3 ) {
+			std::swap( box.triangles[ t + 1 ], box.triangles[ t + 2 ] );
+		}
+		const MeshMeasures inverted = MeshMeasures::Compute( box.view() );
+		CHECK( fabs( inverted.volume + measures.volume ) < 1e-6 );
+		CHECK( fabs( inverted.area - measures.area ) < 1e-6 );
+
+		// triangle by triangle, with enough triangles to be split among threads
+		TriangleMesh torus;
+		SyntheticMeshes::Generate( SyntheticMeshes::TORUS, 200000, torus );
+		const MeshView mesh = torus.view();
+		double volume = 0, area = 0;
+		for( size_t t = 0; t < mesh.numTriangles; t++ ) {
+			const int* tri = mesh.triangle( t );
+			const float* a = mesh.point( tri[ 0 ] );
+			const float* b = mesh.point( tri[ 1 ] );
+			const float* c = mesh.point( tri[ 2 ] );
+			double e1[ 3 ], e2[ 3 ];
+			for( int axis = 0; axis < 3; axis++ ) {
+				e1[ axis ] = (double)b[ axis ] - a[ axis ];
+				e2[ axis ] = (double)c[ axis ] - a[ axis ];
+			}
+			const double n[ 3 ] = { e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ], e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ], e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ] };
+			area += 0.5 * sqrt( n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ] );
+			volume += ( a[ 0 ] * n[ 0 ] + a[ 1 ] * n[ 1 ] + a[ 2 ] * n[ 2 ] ) / 6;
+		}
+		CHECK( volume > 0 );
+		for( int threads = 1; threads <= 3; threads += 2 ) {
+			const MeshMeasures computed = MeshMeasures::Compute( mesh, threads );
+			CHECK( fabs( computed.volume - volume ) < 1e-4 * volume );
+			CHECK( fabs( computed.area - area ) < 1e-4 * area );
+		}
+		return true;
+	}
+
+	const TestRegistration registration( "MeshMeasures", testMeshMeasures );
+}
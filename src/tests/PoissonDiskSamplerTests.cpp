@@ -0,0 +1,73 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "PoissonDiskSampler.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+	float minSquaredDistance( const std::vector< float >& samples ) {
+		float closest = 1e30f;
+		for( size_t i = 0; i < samples.size(); i += 3 ) {
+			for( size_t j = i + 3; j < samples.size(); j += 3 ) {
+				const float dx = samples[ i ] - samples[ j ], dy = samples[ i + 1 ] - samples[ j + 1 ], dz = samples[ i + 2 ] - samples[ j + 2 ];
+				closest = std::min( closest, dx * dx + dy * dy + dz * dz );
+			}
+		}
+		return closest;
+	}
+
+	bool testPoissonDiskSampler() {
+		// an L shaped set of voxels
+		const int res = 16;
+		VoxelGrid grid;
+		grid.init( res, res, res, UnitBounds() );
+		for( int z = 0; z < res; z++ ) {
+			for( int y = 0; y < res; y++ ) {
+				for( int x = 0; x < res; x++ ) {
+					if ( x < res / 2 || y < res / 2 ) grid.set( x, y, z );
+				}
+			}
+		}
+		PoissonDiskSampler sampler;
+		sampler.setGrid( grid );
+
+		// no two samples closer than the distance, all of them in the voxels,
+		// and the same ones on any number of threads
+		const float minDistance = 0.08f;
+		std::vector< float > samples[ 2 ];
+		for( int t = 0; t < 2; t++ ) {
+			Random rng( 11 );
+			CHECK( sampler.Sample( minDistance, 1 << 20, rng, samples[ t ], NULL, 1 + 2 * t ) );
+		}
+		CHECK( samples[ 0 ] == samples[ 1 ] );
+		CHECK( samples[ 0 ].size() > 3 * 500 );
+		CHECK( minSquaredDistance( samples[ 0 ] ) >= minDistance * minDistance );
+		for( size_t i = 0; i < samples[ 0 ].size(); i += 3 ) {
+			int v[ 3 ];
+			for( int axis = 0; axis < 3; axis++ ) {
+				CHECK( samples[ 0 ][ i + axis ] >= 0 && samples[ 0 ][ i + axis ] <= 1 );
+				v[ axis ] = std::min( res - 1, (int)( samples[ 0 ][ i + axis ] * res ) );
+			}
+			CHECK( grid.get( v[ 0 ], v[ 1 ], v[ 2 ] ) );
+		}
+
+		// capped counts widen the distance instead
+		const int maxSamples = 200;
+		std::vector< float > capped;
+		Random rng( 12 );
+		CHECK( sampler.Sample( minDistance, maxSamples, rng, capped ) );
+		CHECK( capped.size() <= 3 * (size_t)maxSamples && capped.size() > 3 * (size_t)maxSamples / 2 );
+		CHECK( minSquaredDistance( capped ) > minSquaredDistance( samples[ 0 ] ) );
+		return true;
+	}
+
+	const TestRegistration registration( "PoissonDiskSampler", testPoissonDiskSampler );
+}
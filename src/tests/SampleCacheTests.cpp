@@ -0,0 +1,77 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "SampleCache.h"
+#include "Random.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+	bool copyFile( const char* from, const char* to, size_t size ) {
+		FILE* in = fopen( from, "rb" );
+		if ( in == NULL ) return false;
+		std::vector< char > bytes( size );
+		const bool read = fread( &bytes[ 0 ], 1, size, in ) == size;
+		fclose( in );
+		FILE* out = fopen( to, "wb" );
+		if ( out == NULL ) return false;
+		const bool written = read && fwrite( &bytes[ 0 ], 1, size, out ) == size;
+		fclose( out );
+		return written;
+	}
+
+	size_t fileSize( const char* path ) {
+		FILE* file = fopen( path, "rb" );
+		if ( file == NULL ) return 0;
+		fseek( file, 0, SEEK_END );
+		const long size = ftell( file );
+		fclose( file );
+		return size > 0 ? (size_t)size : 0;
+	}
+
+	bool testSampleCache() {
+		const char* path = "test_samples.smpc";
+		const char* truncatedPath = "test_truncated.smpc";
+		const size_t count = 5000;
+		std::vector< float > samples( 3 * count );
+		Random rng( 4 );
+		for( size_t i = 0; i < samples.size(); i++ ) samples[ i ] = rng.nextFloat();
+
+		SampleCacheWriter writer;
+		CHECK( writer.open( path, 7, 1024 ) );
+		writer.append( &samples[ 0 ], count );
+		CHECK( writer.close() );
+
+		{
+			SampleCacheReader reader;
+			CHECK( reader.open( path ) );
+			CHECK( reader.numSamples() == count && reader.header().seed == 7 );
+			std::vector< float > read;
+			CHECK( reader.readAll( read ) );
+			CHECK( read == samples );
+		}
+
+		// cut in the middle of the blocks, and of the block table
+		const size_t size = fileSize( path );
+		const size_t cuts[] = { size / 2, size - 8, sizeof( SampleCacheHeader ) - 1 };
+		for( size_t c = 0; c < sizeof( cuts ) / sizeof( cuts[ 0 ] ); c++ ) {
+			CHECK( copyFile( path, truncatedPath, cuts[ c ] ) );
+			SampleCacheReader reader;
+			std::string error;
+			CHECK( !reader.open( truncatedPath, &error ) );
+			CHECK( !error.empty() );
+		}
+		remove( path );
+		remove( truncatedPath );
+		return true;
+	}
+
+	const TestRegistration registration( "SampleCache", testSampleCache );
+}
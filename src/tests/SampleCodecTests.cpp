@@ -0,0 +1,61 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "SampleCodec.h"
+#include "Random.h"
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+	bool testSampleCodec() {
+		const size_t count = 3000;
+		const float maxErrors[] = { 1e-1f, 1e-3f, 1e-5f };
+		Random rng( 1 );
+		std::vector< float > x( count ), y( count ), z( count );
+		for( size_t i = 0; i < count; i++ ) {
+			x[ i ] = -10 + 20 * rng.nextFloat();
+			y[ i ] = 5 * rng.nextFloat();
+			z[ i ] = 100 + rng.nextFloat();
+		}
+
+		for( size_t e = 0; e < sizeof( maxErrors ) / sizeof( maxErrors[ 0 ] ); e++ ) {
+			const float maxError = maxErrors[ e ];
+			std::vector< unsigned char > stream;
+			SampleCodec::Encode( &x[ 0 ], &y[ 0 ], &z[ 0 ], count, maxError, stream );
+			std::vector< float > dx( count ), dy( count ), dz( count );
+			CHECK( SampleCodec::Decode( &stream[ 0 ], stream.size(), count, &dx[ 0 ], &dy[ 0 ], &dz[ 0 ] ) );
+
+			// the order is not kept: every decoded point has to be within the
+			// error of a different original one, the closest it hasn't been
+			// matched yet
+			std::vector< bool > used( count, false );
+			for( size_t i = 0; i < count; i++ ) {
+				size_t match = count;
+				float closest = maxError;
+				for( size_t j = 0; j < count; j++ ) {
+					const float d = std::max( fabsf( dx[ i ] - x[ j ] ), std::max( fabsf( dy[ i ] - y[ j ] ), fabsf( dz[ i ] - z[ j ] ) ) );
+					if ( !used[ j ] && d <= closest ) {
+						match = j;
+						closest = d;
+					}
+				}
+				CHECK( match < count );
+				used[ match ] = true;
+			}
+
+			// a truncated stream is rejected rather than read past its end
+			CHECK( !SampleCodec::Decode( &stream[ 0 ], stream.size() / 2, count, &dx[ 0 ], &dy[ 0 ], &dz[ 0 ] ) );
+		}
+		return true;
+	}
+
+	const TestRegistration registration( "SampleCodec", testSampleCodec );
+}
@@ -0,0 +1,87 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "ShellSampler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+	// the shell of a box filling its grid has to be the same along every face
+	bool testShellSampler() {
+		const int res = 16;
+		const float thickness = 0.1f;
+		TriangleMesh box;
+		const float boxMin[ 3 ] = { 0, 0, 0 }, boxMax[ 3 ] = { 1, 1, 1 };
+		AddBox( boxMin, boxMax, box );
+		VoxelGrid grid;
+		grid.init( res, res, res, UnitBounds() );
+		for( int z = 0; z < res; z++ ) {
+			for( int y = 0; y < res; y++ ) {
+				for( int x = 0; x < res; x++ ) grid.set( x, y, z );
+			}
+		}
+
+		ShellSampler sampler;
+		sampler.setMesh( box.view(), grid, thickness );
+
+		// voxels whose center is closer to a face than the thickness plus
+		// their half diagonal
+		const float voxelSize = 1.0f / res;
+		const float reach = thickness + 0.5f * sqrtf( 3.0f ) * voxelSize;
+		size_t expected = 0;
+		for( int z = 0; z < res; z++ ) {
+			for( int y = 0; y < res; y++ ) {
+				for( int x = 0; x < res; x++ ) {
+					const int v[ 3 ] = { x, y, z };
+					float distance = 1;
+					for( int axis = 0; axis < 3; axis++ ) {
+						const float center = ( v[ axis ] + 0.5f ) * voxelSize;
+						distance = std::min( distance, std::min( center, 1 - center ) );
+					}
+					if ( distance < reach ) expected++;
+				}
+			}
+		}
+		CHECK( sampler.numVoxels() == expected );
+
+		const int count = 20000;
+		Random rng( 6 );
+		std::vector< float > samples;
+		CHECK( sampler.Sample( count, rng, samples ) );
+		CHECK( samples.size() == 3 * (size_t)count );
+
+		int nearMin[ 3 ] = { 0, 0, 0 }, nearMax[ 3 ] = { 0, 0, 0 };
+		double sum[ 3 ] = { 0, 0, 0 };
+		for( int i = 0; i < count; i++ ) {
+			const float* p = &samples[ 3 * i ];
+			float distance = 1;
+			for( int axis = 0; axis < 3; axis++ ) {
+				CHECK( p[ axis ] >= 0 && p[ axis ] <= 1 );
+				distance = std::min( distance, std::min( p[ axis ], 1 - p[ axis ] ) );
+				if ( p[ axis ] < thickness ) nearMin[ axis ]++;
+				if ( p[ axis ] > 1 - thickness ) nearMax[ axis ]++;
+				sum[ axis ] += p[ axis ];
+			}
+			CHECK( distance <= thickness );
+		}
+
+		// each slab along a face holds about a fifth of the shell, give or
+		// take a few hundred samples
+		for( int axis = 0; axis < 3; axis++ ) {
+			CHECK( abs( nearMin[ axis ] - nearMax[ axis ] ) < 300 );
+			CHECK( fabs( sum[ axis ] / count - 0.5 ) < 0.01 );
+		}
+		return true;
+	}
+
+	const TestRegistration registration( "ShellSampler", testShellSampler );
+}
@@ -0,0 +1,108 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "Random.h"
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+	struct Test {
+		const char*		name;
+		TestFunction	run;
+	};
+
+	// filled by the static registrations, which may run before any other
+	// static of this file is initialized
+	std::vector< Test >& registry() {
+		static std::vector< Test > tests;
+		return tests;
+	}
+}
+
+TestRegistration::TestRegistration( const char* name, TestFunction run ) {
+	const Test test = { name, run };
+	registry().push_back( test );
+}
+
+Bounds UnitBounds() {
+	Bounds bounds;
+	bounds.min[ 0 ] = bounds.min[ 1 ] = bounds.min[ 2 ] = 0;
+	bounds.max[ 0 ] = bounds.max[ 1 ] = bounds.max[ 2 ] = 1;
+	return bounds;
+}
+
+void RandomGrid( int resX, int resY, int resZ, float density, uint64_t seed, VoxelGrid& grid ) {
+	grid.init( resX, resY, resZ, UnitBounds() );
+	Random rng( seed );
+	const size_t target = (size_t)( density * resX * resY * resZ );
+	while( grid.countOccupied() < target ) {
+		const int cx = (int)rng.nextInt( resX ), cy = (int)rng.nextInt( resY ), cz = (int)rng.nextInt( resZ );
+		const int r = 1 + (int)rng.nextInt( 3 );
+		for( int z = std::max( 0, cz - r ); z <= std::min( resZ - 1, cz + r ); z++ ) {
+			for( int y = std::max( 0, cy - r ); y <= std::min( resY - 1, cy + r ); y++ ) {
+				for( int x = std::max( 0, cx - r ); x <= std::min( resX - 1, cx + r ); x++ ) {
+					if ( rng.nextFloat() < 0.7f ) grid.set( x, y, z );
+				}
+			}
+		}
+	}
+}
+
+bool SameVoxels( const VoxelGrid& a, const VoxelGrid& b ) {
+	if ( a.resX() != b.resX() || a.resY() != b.resY() || a.resZ() != b.resZ() ) return false;
+	for( int z = 0; z < a.resZ(); z++ ) {
+		for( int y = 0; y < a.resY(); y++ ) {
+			for( int x = 0; x < a.resX(); x++ ) {
+				if ( a.get( x, y, z ) != b.get( x, y, z ) ) return false;
+			}
+		}
+	}
+	return true;
+}
+
+void AddBox( const float* boxMin, const float* boxMax, TriangleMesh& mesh ) {
+	// corner i takes the max along the axes whose bit is set
+	const int first = (int)mesh.numPoints();
+	for( int i = 0; i < 8; i++ ) {
+		for( int axis = 0; axis < 3; axis++ ) {
+			mesh.points.push_back( i >> axis & 1 ? boxMax[ axis ] : boxMin[ axis ] );
+		}
+	}
+	const int faces[ 12 ][ 3 ] = {
+		{ 0, 2, 1 }, { 1, 2, 3 },	// -z
+		{ 4, 5, 6 }, { 5, 7, 6 },	// +z
+		{ 0, 1, 4 }, { 1, 5, 4 },	// -y
+		{ 2, 6, 3 }, { 3, 6, 7 },	// +y
+		{ 0, 4, 2 }, { 2, 4, 6 },	// -x
+		{ 1, 3, 5 }, { 3, 7, 5 }	// +x
+	};
+	for( int f = 0; f < 12; f++ ) {
+		for( int k = 0; k < 3; k++ ) {
+			mesh.triangles.push_back( first + faces[ f ][ k ] );
+		}
+	}
+}
+
+int main( int argc, char** argv ) {
+	const std::vector< Test >& tests = registry();
+	int failed = 0, run = 0;
+	for( size_t i = 0; i < tests.size(); i++ ) {
+		if ( argc > 1 && strcmp( argv[ 1 ], tests[ i ].name ) ) continue;
+		run++;
+		const bool passed = tests[ i ].run();
+		printf( "%s: %s\n", tests[ i ].name, passed ? "passed" : "FAILED" );
+		if ( !passed ) failed++;
+	}
+	if ( run == 0 && argc > 1 ) {
+		fprintf( stderr, "unknown test %s\n", argv[ 1 ] );
+		return 1;
+	}
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,52 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+#include "VoxelGrid.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* ==========================================
+	Core library tests
+
+	Checks of the core library against brute force versions
+	of the same computations. Every <Name>Tests.cpp file
+	registers a test called <Name>, which CMake adds to ctest
+	and the sampler_tests executable runs by name, or along
+	with all the others when given no arguments.
+
+   ========================================== */
+
+// reports a failed check and returns false from the test
+#define CHECK( condition ) \
+	do { \
+		if ( !( condition ) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition ); \
+			return false; \
+		} \
+	} while( 0 )
+
+typedef bool ( *TestFunction )();
+
+// adds a test to the ones sampler_tests can run, from a static instance
+struct TestRegistration {
+	TestRegistration( const char* name, TestFunction run );
+};
+
+// [0, 1] on every axis
+Bounds UnitBounds();
+
+// random blobs of voxels, filling about 'density' of the grid
+void RandomGrid( int resX, int resY, int resZ, float density, uint64_t seed, VoxelGrid& grid );
+
+bool SameVoxels( const VoxelGrid& a, const VoxelGrid& b );
+
+// appends an axis aligned box, facing outwards
+void AddBox( const float* boxMin, const float* boxMax, TriangleMesh& mesh );
@@ -0,0 +1,75 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "Thinning.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+	// whether 'subset' lists points of 'points' in their order
+	bool inOrder( const std::vector< float >& subset, const std::vector< float >& points ) {
+		size_t i = 0;
+		for( size_t s = 0; s < subset.size(); s += 3, i += 3 ) {
+			while( i < points.size() && !std::equal( &subset[ s ], &subset[ s ] + 3, &points[ i ] ) ) i += 3;
+			if ( i == points.size() ) return false;
+		}
+		return true;
+	}
+
+	float minSquaredDistance( const std::vector< float >& points ) {
+		float closest = 1e30f;
+		for( size_t i = 0; i < points.size(); i += 3 ) {
+			for( size_t j = i + 3; j < points.size(); j += 3 ) {
+				const float dx = points[ i ] - points[ j ], dy = points[ i + 1 ] - points[ j + 1 ], dz = points[ i + 2 ] - points[ j + 2 ];
+				closest = std::min( closest, dx * dx + dy * dy + dz * dz );
+			}
+		}
+		return closest;
+	}
+
+	bool testThinning() {
+		const size_t numPoints = 30000;
+		std::vector< float > points( 3 * numPoints );
+		Random rng( 13 );
+		for( size_t i = 0; i < points.size(); i++ ) points[ i ] = rng.nextFloat();
+
+		std::vector< float > result;
+		ThinPoints( &points[ 0 ], numPoints, 0, THINNING_RANDOM, 1, result );
+		CHECK( result.empty() );
+		ThinPoints( &points[ 0 ], numPoints, numPoints + 1, THINNING_ELIMINATION, 1, result );
+		CHECK( result == points );
+
+		// the input is thinned at random before the elimination for the first
+		// count, being over ELIMINATION_INPUT_RATIO times larger, and not for
+		// the second
+		const size_t counts[] = { 2000, 10000 };
+		for( size_t c = 0; c < sizeof( counts ) / sizeof( counts[ 0 ] ); c++ ) {
+			float closest[ 3 ];
+			for( int method = THINNING_RANDOM; method <= THINNING_ELIMINATION; method++ ) {
+				std::vector< float > thinned[ 2 ];
+				for( int t = 0; t < 2; t++ ) {
+					ThinPoints( &points[ 0 ], numPoints, counts[ c ], (ThinningMethod)method, 7, thinned[ t ], 1 + 2 * t );
+				}
+				CHECK( thinned[ 0 ] == thinned[ 1 ] );
+				CHECK( thinned[ 0 ].size() == 3 * counts[ c ] );
+				CHECK( inOrder( thinned[ 0 ], points ) );
+				closest[ method ] = minSquaredDistance( thinned[ 0 ] );
+			}
+			// stratification avoids the clumps of a random subset, and
+			// elimination spreads the points further apart
+			CHECK( closest[ THINNING_STRATIFIED ] > closest[ THINNING_RANDOM ] );
+			CHECK( closest[ THINNING_ELIMINATION ] > closest[ THINNING_STRATIFIED ] );
+		}
+		return true;
+	}
+
+	const TestRegistration registration( "Thinning", testThinning );
+}
@@ -0,0 +1,38 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "VoxelCache.h"
+
+namespace {
+
+	bool testVoxelCache() {
+		const VoxelCache cache( "test_voxel_cache", 1 << 20 );
+		VoxelGrid grid;
+		RandomGrid( 13, 7, 70, 0.3f, 5, grid );
+
+		const uint64_t key = 0x1234567890ABCDEFULL;
+		VoxelGrid loaded;
+		CHECK( !cache.load( key, loaded ) );
+		CHECK( cache.store( key, grid ) );
+		CHECK( cache.load( key, loaded ) );
+		CHECK( loaded.resX() == grid.resX() && loaded.resY() == grid.resY() && loaded.resZ() == grid.resZ() );
+		for( int axis = 0; axis < 3; axis++ ) {
+			CHECK( loaded.bounds().min[ axis ] == grid.bounds().min[ axis ] && loaded.bounds().max[ axis ] == grid.bounds().max[ axis ] );
+		}
+		CHECK( SameVoxels( loaded, grid ) );
+		CHECK( !cache.load( key + 1, loaded ) );
+
+		// entries over the budget are evicted
+		const VoxelCache small( "test_voxel_cache", 1 );
+		small.evict();
+		CHECK( !cache.load( key, loaded ) );
+		return true;
+	}
+
+	const TestRegistration registration( "VoxelCache", testVoxelCache );
+}
@@ -0,0 +1,124 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "VoxelCsg.h"
+#include "Random.h"
+
+#include <vector>
+
+namespace {
+
+	struct Box {
+		float	min[ 3 ];
+		float	max[ 3 ];
+
+		bool contains( const float* p ) const {
+			for( int axis = 0; axis < 3; axis++ ) {
+				if ( p[ axis ] <= min[ axis ] || p[ axis ] >= max[ axis ] ) return false;
+			}
+			return true;
+		}
+	};
+
+	// voxelizes base op[ 0 ] operand[ 0 ] op[ 1 ] operand[ 1 ] ... and checks
+	// every voxel against its center in the same boxes
+	bool checkCsg( const Box& base, const Box* operands, const CsgOp* ops, size_t count, InsideTest test ) {
+		TriangleMesh baseMesh;
+		AddBox( base.min, base.max, baseMesh );
+		std::vector< TriangleMesh > meshes( count );
+		std::vector< CsgOperand > csg( count );
+		for( size_t i = 0; i < count; i++ ) {
+			AddBox( operands[ i ].min, operands[ i ].max, meshes[ i ] );
+			csg[ i ].mesh = meshes[ i ].view();
+			csg[ i ].op = ops[ i ];
+		}
+
+		VoxelGrid grid;
+		CHECK( VoxelizeCsg( baseMesh.view(), count > 0 ? &csg[ 0 ] : NULL, count, 24, 16, 70, grid, test ) );
+
+		const Bounds& bounds = grid.bounds();
+		for( int z = 0; z < grid.resZ(); z++ ) {
+			for( int y = 0; y < grid.resY(); y++ ) {
+				for( int x = 0; x < grid.resX(); x++ ) {
+					const int v[ 3 ] = { x, y, z };
+					float center[ 3 ];
+					for( int axis = 0; axis < 3; axis++ ) {
+						center[ axis ] = bounds.min[ axis ] + ( v[ axis ] + 0.5f ) * grid.voxelSize( axis );
+					}
+					bool inside = base.contains( center );
+					for( size_t i = 0; i < count; i++ ) {
+						const bool operand = operands[ i ].contains( center );
+						switch( ops[ i ] ) {
+							case CSG_UNION: inside = inside || operand; break;
+							case CSG_INTERSECT: inside = inside && operand; break;
+							case CSG_SUBTRACT: inside = inside && !operand; break;
+						}
+					}
+					CHECK( grid.get( x, y, z ) == inside );
+				}
+			}
+		}
+		return true;
+	}
+
+	bool testVoxelCsg() {
+		// corners away from the voxel centers of the grids they end up on
+		const Box base = { { 0, 0, 0 }, { 1, 1, 1 } };
+		const Box boxes[] = {
+			{ { 0.61f, 0.23f, 0.11f }, { 1.53f, 0.67f, 0.87f } },	// crosses the base
+			{ { 0.27f, 0.41f, 0.33f }, { 0.78f, 0.92f, 0.71f } },	// within the base
+			{ { 2.1f, 2.2f, 2.3f }, { 2.9f, 2.8f, 2.7f } }			// away from the base
+		};
+		const CsgOp unionSubtract[] = { CSG_UNION, CSG_SUBTRACT };
+		const CsgOp intersect[] = { CSG_INTERSECT };
+		const CsgOp subtractUnion[] = { CSG_SUBTRACT, CSG_UNION };
+		const CsgOp intersectAway[] = { CSG_INTERSECT };
+
+		for( int test = INSIDE_PARITY; test <= INSIDE_WINDING_NUMBER; test++ ) {
+			CHECK( checkCsg( base, NULL, NULL, 0, (InsideTest)test ) );
+			CHECK( checkCsg( base, boxes, unionSubtract, 2, (InsideTest)test ) );
+			CHECK( checkCsg( base, boxes + 1, intersect, 1, (InsideTest)test ) );
+			CHECK( checkCsg( base, boxes + 1, subtractUnion, 2, (InsideTest)test ) );
+			CHECK( checkCsg( base, boxes + 2, intersectAway, 1, (InsideTest)test ) );
+		}
+
+		// word by word against voxel by voxel, on enough words to be split
+		// among threads, with the last word of each column partially used
+		Bounds bounds = UnitBounds();
+		VoxelGrid a, b;
+		a.init( 148, 148, 129, bounds );
+		b.init( 148, 148, 129, bounds );
+		Random rng( 8 );
+		for( int z = 0; z < a.resZ(); z++ ) {
+			for( int y = 0; y < a.resY(); y++ ) {
+				for( int x = 0; x < a.resX(); x++ ) {
+					if ( rng.nextFloat() < 0.5f ) a.set( x, y, z );
+					if ( rng.nextFloat() < 0.5f ) b.set( x, y, z );
+				}
+			}
+		}
+		for( int op = CSG_UNION; op <= CSG_SUBTRACT; op++ ) {
+			for( int threads = 1; threads <= 3; threads += 2 ) {
+				VoxelGrid result = a;
+				CombineVoxels( result, b, (CsgOp)op, threads );
+				for( int z = 0; z < a.resZ(); z++ ) {
+					for( int y = 0; y < a.resY(); y++ ) {
+						for( int x = 0; x < a.resX(); x++ ) {
+							const bool inA = a.get( x, y, z ), inB = b.get( x, y, z );
+							const bool expected = op == CSG_UNION ? inA || inB : op == CSG_INTERSECT ? inA && inB : inA && !inB;
+							CHECK( result.get( x, y, z ) == expected );
+						}
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	const TestRegistration registration( "VoxelCsg", testVoxelCsg );
+}
@@ -0,0 +1,99 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "VoxelIslands.h"
+
+#include <vector>
+
+namespace {
+
+	// labels the voxels connected through their faces, -1 for empty ones
+	int floodFill( const VoxelGrid& grid, std::vector< int >& labels ) {
+		const int res[ 3 ] = { grid.resX(), grid.resY(), grid.resZ() };
+		labels.assign( (size_t)res[ 0 ] * res[ 1 ] * res[ 2 ], -1 );
+		const int offsets[ 6 ][ 3 ] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		int numLabels = 0;
+		std::vector< int > stack;
+		for( int z = 0; z < res[ 2 ]; z++ ) {
+			for( int y = 0; y < res[ 1 ]; y++ ) {
+				for( int x = 0; x < res[ 0 ]; x++ ) {
+					const size_t seed = ( (size_t)z * res[ 1 ] + y ) * res[ 0 ] + x;
+					if ( !grid.get( x, y, z ) || labels[ seed ] >= 0 ) continue;
+					labels[ seed ] = numLabels;
+					stack.push_back( x );
+					stack.push_back( y );
+					stack.push_back( z );
+					while( !stack.empty() ) {
+						int p[ 3 ];
+						p[ 2 ] = stack.back(); stack.pop_back();
+						p[ 1 ] = stack.back(); stack.pop_back();
+						p[ 0 ] = stack.back(); stack.pop_back();
+						for( int n = 0; n < 6; n++ ) {
+							int q[ 3 ];
+							bool inGrid = true;
+							for( int axis = 0; axis < 3; axis++ ) {
+								q[ axis ] = p[ axis ] + offsets[ n ][ axis ];
+								inGrid = inGrid && q[ axis ] >= 0 && q[ axis ] < res[ axis ];
+							}
+							if ( !inGrid || !grid.get( q[ 0 ], q[ 1 ], q[ 2 ] ) ) continue;
+							const size_t index = ( (size_t)q[ 2 ] * res[ 1 ] + q[ 1 ] ) * res[ 0 ] + q[ 0 ];
+							if ( labels[ index ] >= 0 ) continue;
+							labels[ index ] = numLabels;
+							stack.insert( stack.end(), q, q + 3 );
+						}
+					}
+					numLabels++;
+				}
+			}
+		}
+		return numLabels;
+	}
+
+	bool testVoxelIslands() {
+		const float densities[] = { 0.05f, 0.2f, 0.35f };
+		for( size_t d = 0; d < sizeof( densities ) / sizeof( densities[ 0 ] ); d++ ) {
+			VoxelGrid grid;
+			RandomGrid( 23, 19, 90, densities[ d ], 3 + d, grid );
+
+			std::vector< int > expected;
+			const int numLabels = floodFill( grid, expected );
+			for( int threads = 1; threads <= 4; threads += 3 ) {
+				VoxelIslands islands;
+				islands.build( grid, threads );
+				CHECK( (int)islands.numIslands() == numLabels );
+
+				// both labelings split the voxels the same way
+				std::vector< int > toIsland( numLabels, -1 ), toLabel( numLabels, -1 );
+				std::vector< size_t > sizes( numLabels, 0 );
+				for( int z = 0; z < grid.resZ(); z++ ) {
+					for( int y = 0; y < grid.resY(); y++ ) {
+						for( int x = 0; x < grid.resX(); x++ ) {
+							const int label = expected[ ( (size_t)z * grid.resY() + y ) * grid.resX() + x ];
+							const int island = islands.islandAt( x, y, z );
+							if ( label < 0 ) {
+								CHECK( island == -1 );
+								continue;
+							}
+							CHECK( island >= 0 && island < numLabels );
+							if ( toIsland[ label ] < 0 ) toIsland[ label ] = island;
+							if ( toLabel[ island ] < 0 ) toLabel[ island ] = label;
+							CHECK( toIsland[ label ] == island && toLabel[ island ] == label );
+							sizes[ island ]++;
+						}
+					}
+				}
+				for( int i = 0; i < numLabels; i++ ) {
+					CHECK( islands.island( i ).voxels == sizes[ i ] );
+				}
+			}
+		}
+		return true;
+	}
+
+	const TestRegistration registration( "VoxelIslands", testVoxelIslands );
+}
@@ -0,0 +1,90 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "VoxelMorphology.h"
+
+#include <algorithm>
+
+namespace {
+
+	// dilation or erosion with a cube of side 2 * radius + 1, voxel by voxel.
+	// 'outside' is the value of the voxels beyond the grid.
+	void naiveMorphology( const VoxelGrid& grid, bool dilate, int radius, bool outside, VoxelGrid& result ) {
+		result.init( grid.resX(), grid.resY(), grid.resZ(), grid.bounds() );
+		const int res[ 3 ] = { grid.resX(), grid.resY(), grid.resZ() };
+		for( int z = 0; z < res[ 2 ]; z++ ) {
+			for( int y = 0; y < res[ 1 ]; y++ ) {
+				for( int x = 0; x < res[ 0 ]; x++ ) {
+					const int p[ 3 ] = { x, y, z };
+					int lo[ 3 ], hi[ 3 ];
+					bool clipped = false;
+					for( int axis = 0; axis < 3; axis++ ) {
+						lo[ axis ] = std::max( 0, p[ axis ] - radius );
+						hi[ axis ] = std::min( res[ axis ] - 1, p[ axis ] + radius );
+						clipped = clipped || p[ axis ] - radius < 0 || p[ axis ] + radius >= res[ axis ];
+					}
+					bool any = clipped && outside, all = !clipped || outside;
+					for( int nz = lo[ 2 ]; nz <= hi[ 2 ]; nz++ ) {
+						for( int ny = lo[ 1 ]; ny <= hi[ 1 ]; ny++ ) {
+							for( int nx = lo[ 0 ]; nx <= hi[ 0 ]; nx++ ) {
+								const bool occupied = grid.get( nx, ny, nz );
+								any = any || occupied;
+								all = all && occupied;
+							}
+						}
+					}
+					if ( dilate ? any : all ) result.set( x, y, z );
+				}
+			}
+		}
+	}
+
+	bool testVoxelMorphology() {
+		// several words per column, and a last one partially used
+		VoxelGrid grid;
+		RandomGrid( 11, 9, 150, 0.25f, 2, grid );
+
+		VoxelGrid expected, temp, result;
+		for( int radius = 1; radius <= 3; radius++ ) {
+			for( int op = MORPHOLOGY_DILATE; op <= MORPHOLOGY_CLOSE; op++ ) {
+				switch( op ) {
+					case MORPHOLOGY_DILATE:
+						naiveMorphology( grid, true, radius, false, expected );
+						break;
+					case MORPHOLOGY_ERODE:
+						naiveMorphology( grid, false, radius, false, expected );
+						break;
+					case MORPHOLOGY_OPEN:
+						naiveMorphology( grid, false, radius, false, temp );
+						naiveMorphology( temp, true, radius, false, expected );
+						break;
+					case MORPHOLOGY_CLOSE:
+						naiveMorphology( grid, true, radius, false, temp );
+						naiveMorphology( temp, false, radius, true, expected );
+						break;
+				}
+				for( int threads = 1; threads <= 3; threads += 2 ) {
+					result = grid;
+					ApplyMorphology( result, (MorphologyOp)op, radius, threads );
+					CHECK( SameVoxels( result, expected ) );
+				}
+			}
+		}
+
+		// radii past the width of a word along Z
+		for( int radius = 63; radius <= 65; radius += 2 ) {
+			naiveMorphology( grid, true, radius, false, expected );
+			result = grid;
+			ApplyMorphology( result, MORPHOLOGY_DILATE, radius, 1 );
+			CHECK( SameVoxels( result, expected ) );
+		}
+		return true;
+	}
+
+	const TestRegistration registration( "VoxelMorphology", testVoxelMorphology );
+}
@@ -0,0 +1,86 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "Tests.h"
+#include "WindingNumber.h"
+#include "SolidVoxelizer.h"
+#include "SyntheticMeshes.h"
+#include "Random.h"
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+	bool testWindingNumber() {
+		const float boxMin[ 3 ] = { 0.2f, 0.1f, 0.3f }, boxMax[ 3 ] = { 0.9f, 0.6f, 0.8f };
+		TriangleMesh box;
+		AddBox( boxMin, boxMax, box );
+
+		// 1 inside a closed mesh and 0 outside, away from its surface, and -1
+		// inside once turned inside out
+		TriangleMesh inverted( box );
+		for( size_t t = 0; t < inverted.triangles.size(); t += 3 ) {
+			std::swap( inverted.triangles[ t + 1 ], inverted.triangles[ t + 2 ] );
+		}
+		WindingNumber winding, invertedWinding;
+		winding.build( box.view() );
+		invertedWinding.build( inverted.view() );
+		const size_t count = 2000;
+		std::vector< float > points( 3 * count );
+		Random rng( 9 );
+		for( size_t i = 0; i < points.size(); i++ ) points[ i ] = rng.nextFloat();
+		std::vector< float > values( count );
+		for( size_t i = 0; i < count; i++ ) {
+			const float* p = &points[ 3 * i ];
+			float distance = 1;
+			bool inside = true;
+			for( int axis = 0; axis < 3; axis++ ) {
+				distance = std::min( distance, std::min( fabsf( p[ axis ] - boxMin[ axis ] ), fabsf( p[ axis ] - boxMax[ axis ] ) ) );
+				inside = inside && p[ axis ] > boxMin[ axis ] && p[ axis ] < boxMax[ axis ];
+			}
+			values[ i ] = winding.evaluate( p );
+			if ( distance < 0.01f ) continue;
+			CHECK( fabsf( values[ i ] - ( inside ? 1.0f : 0.0f ) ) < 0.01f );
+			CHECK( fabsf( invertedWinding.evaluate( p ) + ( inside ? 1.0f : 0.0f ) ) < 0.01f );
+			CHECK( winding.inside( p ) == inside && invertedWinding.inside( p ) == inside );
+		}
+
+		// batches give the same values as single points, up to the dipole
+		// expansions used for some of the nodes
+		for( int threads = 1; threads <= 3; threads += 2 ) {
+			std::vector< float > batch( count );
+			winding.evaluate( &points[ 0 ], count, &batch[ 0 ], threads );
+			for( size_t i = 0; i < count; i++ ) {
+				CHECK( fabsf( batch[ i ] - values[ i ] ) < 1e-3f );
+			}
+		}
+
+		// with a face missing the center still sees most of the box around it
+		TriangleMesh open( box );
+		open.triangles.resize( open.triangles.size() - 6 );
+		WindingNumber openWinding;
+		openWinding.build( open.view() );
+		const float center[ 3 ] = { 0.55f, 0.35f, 0.55f };
+		CHECK( openWinding.inside( center ) );
+
+		// on closed meshes both inside tests voxelize the same
+		for( int type = 0; type < SyntheticMeshes::NUM_TYPES; type++ ) {
+			TriangleMesh mesh;
+			SyntheticMeshes::Generate( (SyntheticMeshes::Type)type, 5000, mesh );
+			VoxelGrid parity, windingGrid;
+			CHECK( SolidVoxelizer::Voxelize( mesh.view(), 32, 32, 32, parity, INSIDE_PARITY ) );
+			CHECK( SolidVoxelizer::Voxelize( mesh.view(), 32, 32, 32, windingGrid, INSIDE_WINDING_NUMBER ) );
+			CHECK( parity.countOccupied() > 0 );
+			CHECK( SameVoxels( parity, windingGrid ) );
+		}
+		return true;
+	}
+
+	const TestRegistration registration( "WindingNumber", testWindingNumber );
+}
@@ -0,0 +1,340 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+// Standalone batch sampler: generates interior samples for a list of OBJ
+// meshes with the same algorithms as the RaySampler and VoxelSampler nodes,
+// without going through Maya. Meshes are processed in parallel, and samples
+// are streamed to disk in fixed size chunks so that memory use does not
+// depend on the number of samples requested.
+
+#include "ObjReader.h"
+#include "RayMarchSampler.h"
+#include "ChordSampler.h"
+#include "ShellSampler.h"
+#include "PoissonDiskSampler.h"
+#include "SolidVoxelizer.h"
+#include "VoxelGridSampler.h"
+#include "VoxelCache.h"
+#include "SampleCache.h"
+#include "Hash.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+namespace {
+
+	enum SamplerType {
+		SAMPLER_RAY,
+		SAMPLER_VOXEL,
+		SAMPLER_CHORDS,
+		SAMPLER_SHELL,
+		SAMPLER_BLUE_NOISE
+	};
+
+	enum OutputFormat {
+		FORMAT_XYZ,	// text, one "x y z" sample per line
+		FORMAT_BIN,	// raw little-endian float32 triplets
+		FORMAT_CACHE	// sample cache file, see SampleCache.h
+	};
+
+	struct Options {
+		SamplerType		sampler;
+		OutputFormat	format;
+		int				resolution[ 3 ];
+		long long		count;
+		unsigned long long	seed;
+		int				jobs;
+		int				chunkSize;
+		bool			compress;
+		bool			guideRays;
+		InsideTest		insideTest;
+		float			maxError;
+		float			thickness;
+		float			minDistance;
+		std::string		outputDir;
+		std::string		voxelCache;
+		std::vector< std::string > inputs;
+
+		Options() : sampler( SAMPLER_RAY ), format( FORMAT_XYZ ), count( 1000 ), seed( 0 ), jobs( 0 ), chunkSize( 1 << 20 ), compress( false ), guideRays( false ), insideTest( INSIDE_PARITY ), maxError( 0 ), thickness( 0.1f ), minDistance( 0 ) {
+			resolution[ 0 ] = resolution[ 1 ] = resolution[ 2 ] = 16;
+		}
+	};
+
+	std::mutex logMutex;
+
+	void log( const char* format, const char* path, const char* message ) {
+		std::lock_guard< std::mutex > lock( logMutex );
+		fprintf( stderr, format, path, message );
+	}
+
+	void printUsage( const char* program ) {
+		fprintf( stderr,
+			"usage: %s [options] mesh.obj...\n"
+			"\n"
+			"  -s, --sampler NAME        ray, voxel, chords, shell or bluenoise (default: ray)\n"
+			"  -r, --resolution N[,N,N]  voxel resolution, cells per side for chords (default: 16)\n"
+			"  -n, --count N             samples per mesh (default: 1000)\n"
+			"      --seed N              random seed (default: 0)\n"
+			"  -j, --jobs N              meshes processed in parallel (default: all cores)\n"
+			"  -c, --chunk N             samples generated and written at once (default: 1048576)\n"
+			"  -f, --format FORMAT       xyz, bin or cache (default: xyz)\n"
+			"  -t, --thickness D         depth of the shell sampler below the surface (default: 0.1)\n"
+			"  -d, --min-distance D      distance between blue noise samples (default: from the count)\n"
+			"  -g, --guide-rays          cast rays only through occupied voxel columns\n"
+			"  -w, --winding             tell the inside by winding number, for meshes with holes\n"
+			"  -z, --compress            compress the blocks of cache files\n"
+			"  -q, --quantize ERROR      quantize cache files within ERROR of the samples\n"
+			"  -o, --output DIR          output directory (default: next to each mesh)\n"
+			"      --voxel-cache DIR     reuse voxelized meshes stored in DIR\n",
+			program );
+	}
+
+	bool parseOptions( int argc, char** argv, Options& options ) {
+		for( int i = 1; i < argc; i++ ) {
+			const char* arg = argv[ i ];
+			if ( arg[ 0 ] != '-' ) {
+				options.inputs.push_back( arg );
+				continue;
+			}
+			if ( !strcmp( arg, "-z" ) || !strcmp( arg, "--compress" ) ) {
+				options.compress = true;
+				continue;
+			}
+			if ( !strcmp( arg, "-g" ) || !strcmp( arg, "--guide-rays" ) ) {
+				options.guideRays = true;
+				continue;
+			}
+			if ( !strcmp( arg, "-w" ) || !strcmp( arg, "--winding" ) ) {
+				options.insideTest = INSIDE_WINDING_NUMBER;
+				continue;
+			}
+			if ( i + 1 >= argc ) {
+				fprintf( stderr, "missing value for %s\n", arg );
+				return false;
+			}
+			const char* value = argv[ ++i ];
+			if ( !strcmp( arg, "-s" ) || !strcmp( arg, "--sampler" ) ) {
+				if ( !strcmp( value, "ray" ) ) options.sampler = SAMPLER_RAY;
+				else if ( !strcmp( value, "voxel" ) ) options.sampler = SAMPLER_VOXEL;
+				else if ( !strcmp( value, "chords" ) ) options.sampler = SAMPLER_CHORDS;
+				else if ( !strcmp( value, "shell" ) ) options.sampler = SAMPLER_SHELL;
+				else if ( !strcmp( value, "bluenoise" ) ) options.sampler = SAMPLER_BLUE_NOISE;
+				else return false;
+			} else if ( !strcmp( arg, "-r" ) || !strcmp( arg, "--resolution" ) ) {
+				int* res = options.resolution;
+				const int n = sscanf( value, "%d,%d,%d", &res[ 0 ], &res[ 1 ], &res[ 2 ] );
+				if ( n == 1 ) res[ 1 ] = res[ 2 ] = res[ 0 ];
+				else if ( n != 3 ) return false;
+			} else if ( !strcmp( arg, "-t" ) || !strcmp( arg, "--thickness" ) ) {
+				options.thickness = (float)atof( value );
+				if ( options.thickness <= 0 ) return false;
+			} else if ( !strcmp( arg, "-d" ) || !strcmp( arg, "--min-distance" ) ) {
+				options.minDistance = (float)atof( value );
+				if ( options.minDistance < 0 ) return false;
+			} else if ( !strcmp( arg, "-n" ) || !strcmp( arg, "--count" ) ) {
+				options.count = atoll( value );
+			} else if ( !strcmp( arg, "--seed" ) ) {
+				options.seed = strtoull( value, NULL, 10 );
+			} else if ( !strcmp( arg, "-j" ) || !strcmp( arg, "--jobs" ) ) {
+				options.jobs = atoi( value );
+			} else if ( !strcmp( arg, "-c" ) || !strcmp( arg, "--chunk" ) ) {
+				options.chunkSize = atoi( value );
+			} else if ( !strcmp( arg, "-f" ) || !strcmp( arg, "--format" ) ) {
+				if ( !strcmp( value, "xyz" ) ) options.format = FORMAT_XYZ;
+				else if ( !strcmp( value, "bin" ) ) options.format = FORMAT_BIN;
+				else if ( !strcmp( value, "cache" ) ) options.format = FORMAT_CACHE;
+				else return false;
+			} else if ( !strcmp( arg, "-q" ) || !strcmp( arg, "--quantize" ) ) {
+				options.maxError = (float)atof( value );
+				if ( options.maxError <= 0 ) return false;
+			} else if ( !strcmp( arg, "-o" ) || !strcmp( arg, "--output" ) ) {
+				options.outputDir = value;
+			} else if ( !strcmp( arg, "--voxel-cache" ) ) {
+				options.voxelCache = value;
+			} else {
+				fprintf( stderr, "unknown option %s\n", arg );
+				return false;
+			}
+		}
+		return !options.inputs.empty() && options.count > 0 && options.chunkSize > 0;
+	}
+
+	std::string outputPath( const std::string& input, const Options& options ) {
+		std::string path = input;
+		const size_t dot = path.find_last_of( '.' );
+		const size_t slash = path.find_last_of( "/\\" );
+		if ( dot != std::string::npos && ( slash == std::string::npos || dot > slash ) ) {
+			path.erase( dot );
+		}
+		if ( !options.outputDir.empty() ) {
+			path = options.outputDir + "/" + ( slash == std::string::npos ? path : path.substr( slash + 1 ) );
+		}
+		static const char* extensions[] = { ".xyz", ".bin", ".smpc" };
+		return path + extensions[ options.format ];
+	}
+
+	// destination of the samples, either a plain file or a sample cache
+	struct Output {
+		FILE*				file;
+		SampleCacheWriter	cache;
+
+		Output() : file( NULL ) {}
+
+		bool open( const std::string& path, const Options& options, unsigned long long seed ) {
+			if ( options.format == FORMAT_CACHE ) {
+				const SampleCacheCodec codec = options.maxError > 0 ? SAMPLE_CODEC_QUANTIZED :
+											   options.compress ? SAMPLE_CODEC_DEFLATE : SAMPLE_CODEC_RAW;
+				return cache.open( path.c_str(), seed, SampleCacheWriter::DEFAULT_BLOCK_SIZE, codec, options.maxError );
+			}
+			file = fopen( path.c_str(), options.format == FORMAT_BIN ? "wb" : "w" );
+			return file != NULL;
+		}
+
+		bool close() {
+			if ( cache.isOpen() ) return cache.close();
+			return fclose( file ) == 0;
+		}
+	};
+
+	bool writeChunk( Output& output, const std::vector< float >& samples, OutputFormat format ) {
+		if ( format == FORMAT_CACHE ) {
+			// blocks are written by the cache's own thread, errors are reported on close
+			output.cache.append( &samples[ 0 ], samples.size() / 3 );
+			return true;
+		}
+		FILE* f = output.file;
+		if ( format == FORMAT_BIN ) {
+			return fwrite( &samples[ 0 ], sizeof( float ), samples.size(), f ) == samples.size();
+		}
+		for( size_t i = 0; i < samples.size(); i += 3 ) {
+			if ( fprintf( f, "%.7g %.7g %.7g\n", samples[ i ], samples[ i + 1 ], samples[ i + 2 ] ) < 0 ) return false;
+		}
+		return true;
+	}
+
+	bool processMesh( const std::string& input, size_t index, const Options& options ) {
+		TriangleMesh mesh;
+		std::string error;
+		if ( !ObjReader::Read( input.c_str(), mesh, &error ) ) {
+			log( "%s: %s\n", input.c_str(), error.c_str() );
+			return false;
+		}
+
+		RayMarchSampler raySampler;
+		VoxelGridSampler voxelSampler;
+		ChordSampler chordSampler;
+		ShellSampler shellSampler;
+		PoissonDiskSampler blueNoiseSampler;
+		if ( options.sampler == SAMPLER_RAY ) {
+			raySampler.setMesh( mesh.view(), options.guideRays ? RayMarchSampler::DEFAULT_GUIDE_RESOLUTION : 0, options.insideTest );
+		} else if ( options.sampler == SAMPLER_CHORDS ) {
+			chordSampler.setMesh( mesh.view(), options.resolution[ 0 ] );
+		} else {
+			const int* res = options.resolution;
+			const VoxelCache cache( options.voxelCache, (uint64_t)VoxelCache::DEFAULT_MAX_MB << 20 );
+			// keyed as the CPU voxelizer of the VoxelSampler node, so entries are shared with Maya
+			const int cpuVoxelizer = 1;
+			const int insideTest = options.insideTest;
+			uint64_t key = cache.enabled() ? VoxelCache::Key( mesh.view(), res[ 0 ], res[ 1 ], res[ 2 ], cpuVoxelizer ) : 0;
+			if ( cache.enabled() && insideTest != INSIDE_PARITY ) key = Hash64( &insideTest, sizeof( insideTest ), key );
+			VoxelGrid grid;
+			if ( !cache.load( key, grid ) ) {
+				if ( !SolidVoxelizer::Voxelize( mesh.view(), res[ 0 ], res[ 1 ], res[ 2 ], grid, options.insideTest ) ) {
+					log( "%s: %s\n", input.c_str(), "nothing to voxelize" );
+					return false;
+				}
+				if ( cache.enabled() && !cache.store( key, grid ) ) {
+					log( "%s: can't write to the voxel cache %s\n", input.c_str(), options.voxelCache.c_str() );
+				}
+			}
+			if ( options.sampler == SAMPLER_SHELL ) shellSampler.setMesh( mesh.view(), grid, options.thickness, options.insideTest );
+			else if ( options.sampler == SAMPLER_BLUE_NOISE ) blueNoiseSampler.setGrid( grid );
+			else voxelSampler.setGrid( grid );
+		}
+		mesh.clear(); // no longer needed, release it before sampling
+
+		// every mesh gets its own sequence, so the output does not depend on
+		// the order in which the meshes are scheduled
+		const unsigned long long seed = options.seed ^ ( (unsigned long long)index * 0x9E3779B97F4A7C15ULL );
+		Random rng( seed );
+
+		const std::string output = outputPath( input, options );
+		Output out;
+		if ( !out.open( output, options, seed ) ) {
+			log( "%s: %s\n", output.c_str(), "can't open for writing" );
+			return false;
+		}
+
+		const int totalSamples = (int)std::min( options.count, (long long)INT_MAX );
+		std::vector< float > samples;
+		bool ok = true;
+		// blue noise samples depend on each other, so they are all produced at once
+		const long long chunkSize = options.sampler == SAMPLER_BLUE_NOISE ? totalSamples : options.chunkSize;
+		for( long long done = 0; done < options.count && ok; ) {
+			const int chunk = (int)std::min( chunkSize, options.count - done );
+			samples.clear();
+			const bool sampled = options.sampler == SAMPLER_RAY ? raySampler.Sample( chunk, totalSamples, rng, samples ) :
+								 options.sampler == SAMPLER_CHORDS ? chordSampler.Sample( chunk, rng, samples ) :
+								 options.sampler == SAMPLER_SHELL ? shellSampler.Sample( chunk, rng, samples ) :
+								 options.sampler == SAMPLER_BLUE_NOISE ? blueNoiseSampler.Sample( options.minDistance, chunk, rng, samples ) :
+								 voxelSampler.Sample( chunk, rng, samples );
+			if ( !sampled ) {
+				log( "%s: %s\n", input.c_str(), "mesh has no interior to sample" );
+				ok = false;
+				break;
+			}
+			ok = writeChunk( out, samples, options.format );
+			done += chunk;
+		}
+
+		if ( !out.close() || !ok ) {
+			if ( ok ) log( "%s: %s\n", output.c_str(), "write failed" );
+			remove( output.c_str() );
+			return false;
+		}
+		log( "%s -> %s\n", input.c_str(), output.c_str() );
+		return true;
+	}
+}
+
+int main( int argc, char** argv ) {
+	Trace::ConfigureFromEnvironment();
+
+	Options options;
+	if ( !parseOptions( argc, argv, options ) ) {
+		printUsage( argv[ 0 ] );
+		return 2;
+	}
+
+	const int jobs = std::max( 1, std::min( WorkerThreads( options.jobs ), (int)options.inputs.size() ) );
+
+	std::atomic< size_t > next( 0 );
+	std::atomic< int > failed( 0 );
+	std::vector< std::thread > workers;
+	for( int i = 0; i < jobs; i++ ) {
+		workers.push_back( std::thread( [ & ]() {
+			for( size_t index = next++; index < options.inputs.size(); index = next++ ) {
+				if ( !processMesh( options.inputs[ index ], index, options ) ) failed++;
+			}
+		} ) );
+	}
+	for( size_t i = 0; i < workers.size(); i++ ) {
+		workers[ i ].join();
+	}
+
+	return failed > 0 ? 1 : 0;
+}
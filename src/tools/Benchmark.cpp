@@ -0,0 +1,326 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+// Benchmark of the core samplers over a synthetic mesh corpus. Every
+// combination of mesh type, triangle count, sampler, voxel resolution and
+// sample count is a case; the time spent in each stage of the pipeline,
+// the throughput and the peak memory of each case are written as JSON.
+
+#include "SyntheticMeshes.h"
+#include "RayMarchSampler.h"
+#include "SolidVoxelizer.h"
+#include "VoxelGridSampler.h"
+#include "Trace.h"
+#include "Timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if defined( __linux__ )
+#include <fstream>
+#endif
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+	enum SamplerType {
+		SAMPLER_RAY,
+		SAMPLER_VOXEL
+	};
+
+	struct Options {
+		std::vector< SyntheticMeshes::Type >	meshes;
+		std::vector< long long >	triangles;
+		std::vector< long long >	samples;
+		std::vector< long long >	resolutions;
+		std::vector< SamplerType >	samplers;
+		int							repeat;
+		unsigned long long			seed;
+		std::string					output;
+
+		Options() : repeat( 3 ), seed( 0 ) {}
+	};
+
+	struct Stage {
+		const char*	name;
+		double		ms;
+		Stage( const char* n, double t ) : name( n ), ms( t ) {}
+	};
+
+	struct Result {
+		std::vector< Stage >	stages;
+		size_t					samples;
+		size_t					voxels;
+		SamplerStats			stats;
+
+		Result() : samples( 0 ), voxels( 0 ) {}
+		double total() const {
+			double ms = 0;
+			for( size_t i = 0; i < stages.size(); i++ ) ms += stages[ i ].ms;
+			return ms;
+		}
+	};
+
+	// Resets the peak resident set size so the next reading is the peak of
+	// the current case alone. Only possible on Linux, elsewhere the peak is
+	// that of the whole process so far.
+	void resetPeakMemory() {
+#if defined( __linux__ )
+		std::ofstream clearRefs( "/proc/self/clear_refs" );
+		clearRefs << "5";
+#endif
+	}
+
+	long long peakMemoryKb() {
+#if defined( __linux__ )
+		std::ifstream status( "/proc/self/status" );
+		std::string line;
+		while( std::getline( status, line ) ) {
+			if ( line.compare( 0, 6, "VmHWM:" ) == 0 ) return atoll( line.c_str() + 6 );
+		}
+#endif
+#if defined( __unix__ ) || defined( __APPLE__ )
+		struct rusage usage;
+		if ( getrusage( RUSAGE_SELF, &usage ) == 0 ) {
+#if defined( __APPLE__ )
+			return usage.ru_maxrss / 1024;
+#else
+			return usage.ru_maxrss;
+#endif
+		}
+#endif
+		return -1;
+	}
+
+	// Builds the render target the GPU voxelizer would read back for 'grid',
+	// so the decoding can be measured without a GL context.
+	void encodeGpuColumns( const VoxelGrid& grid, std::vector< unsigned int >& texels ) {
+		const int resX = grid.resX(), resY = grid.resY(), resZ = grid.resZ();
+		texels.assign( 4 * (size_t)resX * resY, 0 );
+		for( int y = 0; y < resY; y++ ) {
+			for( int x = 0; x < resX; x++ ) {
+				unsigned int* texel = &texels[ 4 * ( x + (size_t)y * resX ) ];
+				for( int z = 0; z < resZ; z++ ) {
+					if ( !grid.get( x, y, z ) ) continue;
+					const int slice = resZ - 1 - z;
+					texel[ 3 - slice / 32 ] |= 1U << ( slice % 32 );
+				}
+			}
+		}
+	}
+
+	Result runRay( const TriangleMesh& mesh, int numSamples, unsigned long long seed ) {
+		Result result;
+		Timer timer;
+		const Bounds bounds = mesh.view().bounds();
+		result.stages.push_back( Stage( "bounds", timer.elapsedMs() ) );
+		if ( bounds.empty() ) return result;
+
+		timer.restart();
+		RayMarchSampler sampler;
+		sampler.setMesh( mesh.view() );
+		result.stages.push_back( Stage( "accelerator_build", timer.elapsedMs() ) );
+
+		// rays are cast and samples placed along their chords in the same loop
+		timer.restart();
+		std::vector< float > samples;
+		Random rng( seed );
+		sampler.Sample( numSamples, rng, samples, &result.stats );
+		result.stages.push_back( Stage( "ray_casting", timer.elapsedMs() ) );
+		result.samples = samples.size() / 3;
+		return result;
+	}
+
+	Result runVoxel( const TriangleMesh& mesh, int resolution, int numSamples, unsigned long long seed ) {
+		Result result;
+		Timer timer;
+		const Bounds bounds = mesh.view().bounds();
+		result.stages.push_back( Stage( "bounds", timer.elapsedMs() ) );
+
+		timer.restart();
+		VoxelGrid grid;
+		SolidVoxelizer::Voxelize( mesh.view(), resolution, resolution, resolution, grid );
+		result.stages.push_back( Stage( "voxelization", timer.elapsedMs() ) );
+		result.voxels = grid.countOccupied();
+
+		// the GPU voxelizer is limited to 128 slices
+		if ( resolution <= 128 ) {
+			std::vector< unsigned int > texels;
+			encodeGpuColumns( grid, texels );
+			VoxelGrid decoded;
+			timer.restart();
+			SolidVoxelizer::DecodeGpuColumns( &texels[ 0 ], resolution, resolution, resolution, bounds, decoded );
+			result.stages.push_back( Stage( "readback_decode", timer.elapsedMs() ) );
+		}
+
+		timer.restart();
+		VoxelGridSampler sampler;
+		sampler.setGrid( grid );
+		std::vector< float > samples;
+		Random rng( seed );
+		sampler.Sample( numSamples, rng, samples );
+		result.stages.push_back( Stage( "sample_generation", timer.elapsedMs() ) );
+		result.samples = samples.size() / 3;
+		return result;
+	}
+
+	void writeCase( FILE* f, bool first, const char* mesh, size_t triangles, SamplerType sampler, int resolution,
+					int requested, const Result& result, long long peakKb ) {
+		const double total = result.total();
+		fprintf( f, "%s\n    {\"mesh\": \"%s\", \"triangles\": %zu, \"sampler\": \"%s\", ",
+				 first ? "" : ",", mesh, triangles, sampler == SAMPLER_RAY ? "ray" : "voxel" );
+		if ( sampler == SAMPLER_VOXEL ) {
+			fprintf( f, "\"resolution\": %d, \"voxels\": %zu, ", resolution, result.voxels );
+		}
+		if ( sampler == SAMPLER_RAY ) {
+			fprintf( f, "\"rays_cast\": %lld, \"rays_missed\": %lld, \"chords\": %lld, ",
+					 result.stats.raysCast, result.stats.raysMissed, result.stats.chords );
+		}
+		fprintf( f, "\"samples_requested\": %d, \"samples\": %zu,\n     \"stages_ms\": {", requested, result.samples );
+		for( size_t i = 0; i < result.stages.size(); i++ ) {
+			fprintf( f, "%s\"%s\": %.3f", i > 0 ? ", " : "", result.stages[ i ].name, result.stages[ i ].ms );
+		}
+		fprintf( f, "},\n     \"total_ms\": %.3f, \"samples_per_second\": %.0f, \"peak_memory_kb\": %lld}",
+				 total, total > 0 ? result.samples / ( total / 1000.0 ) : 0.0, peakKb );
+	}
+
+	bool parseList( const char* value, std::vector< long long >& list ) {
+		list.clear();
+		for( const char* p = value; *p; ) {
+			char* next;
+			const long long v = strtoll( p, &next, 10 );
+			if ( next == p || v <= 0 ) return false;
+			list.push_back( v );
+			p = *next == ',' ? next + 1 : next;
+		}
+		return !list.empty();
+	}
+
+	bool parseOptions( int argc, char** argv, Options& options ) {
+		for( int i = 1; i < argc; i++ ) {
+			const char* arg = argv[ i ];
+			if ( i + 1 >= argc ) return false;
+			const char* value = argv[ ++i ];
+			if ( !strcmp( arg, "--meshes" ) ) {
+				options.meshes.clear();
+				std::string names( value );
+				for( size_t begin = 0; begin <= names.size(); ) {
+					size_t end = names.find( ',', begin );
+					if ( end == std::string::npos ) end = names.size();
+					SyntheticMeshes::Type type;
+					if ( !SyntheticMeshes::FromName( names.substr( begin, end - begin ).c_str(), type ) ) return false;
+					options.meshes.push_back( type );
+					begin = end + 1;
+				}
+			} else if ( !strcmp( arg, "--triangles" ) ) {
+				if ( !parseList( value, options.triangles ) ) return false;
+			} else if ( !strcmp( arg, "--samples" ) ) {
+				if ( !parseList( value, options.samples ) ) return false;
+			} else if ( !strcmp( arg, "--resolutions" ) ) {
+				if ( !parseList( value, options.resolutions ) ) return false;
+			} else if ( !strcmp( arg, "--samplers" ) ) {
+				options.samplers.clear();
+				if ( strstr( value, "ray" ) ) options.samplers.push_back( SAMPLER_RAY );
+				if ( strstr( value, "voxel" ) ) options.samplers.push_back( SAMPLER_VOXEL );
+				if ( options.samplers.empty() ) return false;
+			} else if ( !strcmp( arg, "--repeat" ) ) {
+				options.repeat = std::max( 1, atoi( value ) );
+			} else if ( !strcmp( arg, "--seed" ) ) {
+				options.seed = strtoull( value, NULL, 10 );
+			} else if ( !strcmp( arg, "--output" ) || !strcmp( arg, "-o" ) ) {
+				options.output = value;
+			} else {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void printUsage( const char* program ) {
+		fprintf( stderr,
+			"usage: %s [options]\n"
+			"\n"
+			"  --meshes LIST        torus,noisy_sphere,thin_shell,multi_shell (default: all)\n"
+			"  --triangles LIST     mesh sizes (default: 1000,10000,100000,1000000)\n"
+			"  --samplers LIST      ray,voxel (default: both)\n"
+			"  --resolutions LIST   voxel resolutions (default: 32,128)\n"
+			"  --samples LIST       sample counts (default: 10000,1000000)\n"
+			"  --repeat N           runs per case, the fastest is reported (default: 3)\n"
+			"  --seed N             random seed (default: 0)\n"
+			"  -o, --output FILE    JSON report (default: stdout)\n",
+			program );
+	}
+}
+
+int main( int argc, char** argv ) {
+	Trace::ConfigureFromEnvironment();
+
+	Options options;
+	if ( !parseOptions( argc, argv, options ) ) {
+		printUsage( argv[ 0 ] );
+		return 2;
+	}
+	if ( options.meshes.empty() ) {
+		for( int i = 0; i < SyntheticMeshes::NUM_TYPES; i++ ) options.meshes.push_back( (SyntheticMeshes::Type)i );
+	}
+	if ( options.triangles.empty() ) parseList( "1000,10000,100000,1000000", options.triangles );
+	if ( options.samples.empty() ) parseList( "10000,1000000", options.samples );
+	if ( options.resolutions.empty() ) parseList( "32,128", options.resolutions );
+	if ( options.samplers.empty() ) {
+		options.samplers.push_back( SAMPLER_RAY );
+		options.samplers.push_back( SAMPLER_VOXEL );
+	}
+
+	FILE* f = options.output.empty() ? stdout : fopen( options.output.c_str(), "w" );
+	if ( f == NULL ) {
+		fprintf( stderr, "can't open %s for writing\n", options.output.c_str() );
+		return 1;
+	}
+
+	fprintf( f, "{\"repeat\": %d, \"seed\": %llu, \"cases\": [", options.repeat, options.seed );
+	bool first = true;
+	TriangleMesh mesh;
+	for( size_t m = 0; m < options.meshes.size(); m++ ) {
+		for( size_t t = 0; t < options.triangles.size(); t++ ) {
+			SyntheticMeshes::Generate( options.meshes[ m ], (size_t)options.triangles[ t ], mesh );
+			const char* meshName = SyntheticMeshes::Name( options.meshes[ m ] );
+
+			for( size_t s = 0; s < options.samplers.size(); s++ ) {
+				const SamplerType sampler = options.samplers[ s ];
+				const size_t numResolutions = sampler == SAMPLER_VOXEL ? options.resolutions.size() : 1;
+				for( size_t r = 0; r < numResolutions; r++ ) {
+					const int resolution = sampler == SAMPLER_VOXEL ? (int)options.resolutions[ r ] : 0;
+					for( size_t n = 0; n < options.samples.size(); n++ ) {
+						const int numSamples = (int)options.samples[ n ];
+						Result best;
+						resetPeakMemory();
+						for( int run = 0; run < options.repeat; run++ ) {
+							const Result result = sampler == SAMPLER_RAY ?
+												  runRay( mesh, numSamples, options.seed ) :
+												  runVoxel( mesh, resolution, numSamples, options.seed );
+							if ( run == 0 || result.total() < best.total() ) best = result;
+						}
+						writeCase( f, first, meshName, mesh.numTriangles(), sampler, resolution, numSamples, best, peakMemoryKb() );
+						first = false;
+						fflush( f );
+						fprintf( stderr, "%s, %zu triangles, %s %d, %d samples: %.1f ms\n", meshName, mesh.numTriangles(),
+								 sampler == SAMPLER_RAY ? "ray" : "voxel", resolution, numSamples, best.total() );
+					}
+				}
+			}
+		}
+	}
+	fprintf( f, "\n]}\n" );
+
+	if ( f != stdout ) fclose( f );
+	return 0;
+}
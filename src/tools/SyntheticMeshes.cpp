@@ -0,0 +1,142 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#include "SyntheticMeshes.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+namespace {
+	const float PI = 3.14159265358979f;
+
+	void appendTriangle( TriangleMesh& mesh, int a, int b, int c ) {
+		mesh.triangles.push_back( a );
+		mesh.triangles.push_back( b );
+		mesh.triangles.push_back( c );
+	}
+
+	void appendPoint( TriangleMesh& mesh, const float* center, float x, float y, float z ) {
+		mesh.points.push_back( center[ 0 ] + x );
+		mesh.points.push_back( center[ 1 ] + y );
+		mesh.points.push_back( center[ 2 ] + z );
+	}
+
+	// 2 * rings * segments triangles
+	void appendTorus( TriangleMesh& mesh, const float* center, float radius, float sectionRadius, size_t targetTriangles ) {
+		const int segments = std::max( 3, (int)sqrtf( targetTriangles / 4.0f ) );
+		const int rings = 2 * segments;
+		const int first = (int)mesh.numPoints();
+		for( int i = 0; i < rings; i++ ) {
+			const float u = 2 * PI * i / rings;
+			for( int j = 0; j < segments; j++ ) {
+				const float v = 2 * PI * j / segments;
+				const float r = radius + sectionRadius * cosf( v );
+				appendPoint( mesh, center, r * cosf( u ), r * sinf( u ), sectionRadius * sinf( v ) );
+			}
+		}
+		for( int i = 0; i < rings; i++ ) {
+			const int i1 = ( i + 1 ) % rings;
+			for( int j = 0; j < segments; j++ ) {
+				const int j1 = ( j + 1 ) % segments;
+				const int a = first + i * segments + j, b = first + i1 * segments + j;
+				const int c = first + i1 * segments + j1, d = first + i * segments + j1;
+				appendTriangle( mesh, a, b, c );
+				appendTriangle( mesh, a, c, d );
+			}
+		}
+	}
+
+	// 2 * segments * ( rings - 1 ) triangles. 'noise' displaces the radius with
+	// a smooth function of the position, so the surface stays closed.
+	void appendSphere( TriangleMesh& mesh, const float* center, float radius, float noise, bool inward, size_t targetTriangles ) {
+		const int rings = std::max( 3, (int)sqrtf( targetTriangles / 4.0f ) );
+		const int segments = 2 * rings;
+		const int first = (int)mesh.numPoints();
+
+		for( int i = 0; i <= rings; i++ ) {
+			const float theta = PI * i / rings;
+			const int count = ( i == 0 || i == rings ) ? 1 : segments; // single vertex at the poles
+			for( int j = 0; j < count; j++ ) {
+				const float phi = 2 * PI * j / segments;
+				const float x = sinf( theta ) * cosf( phi ), y = sinf( theta ) * sinf( phi ), z = cosf( theta );
+				const float r = radius * ( 1 + noise * sinf( 7 * x ) * sinf( 9 * y ) * sinf( 11 * z ) );
+				appendPoint( mesh, center, r * x, r * y, r * z );
+			}
+		}
+
+		const int northPole = first;
+		const int southPole = first + 1 + ( rings - 1 ) * segments;
+		for( int j = 0; j < segments; j++ ) {
+			const int j1 = ( j + 1 ) % segments;
+			// ring i (1..rings-1) starts at first + 1 + ( i - 1 ) * segments
+			for( int i = 0; i < rings; i++ ) {
+				const int top = first + 1 + ( i - 1 ) * segments;
+				const int bottom = first + 1 + i * segments;
+				int tri[ 2 ][ 3 ];
+				int numTris = 0;
+				if ( i == 0 ) {
+					tri[ numTris ][ 0 ] = northPole; tri[ numTris ][ 1 ] = bottom + j; tri[ numTris ][ 2 ] = bottom + j1; numTris++;
+				} else if ( i == rings - 1 ) {
+					tri[ numTris ][ 0 ] = top + j; tri[ numTris ][ 1 ] = southPole; tri[ numTris ][ 2 ] = top + j1; numTris++;
+				} else {
+					tri[ numTris ][ 0 ] = top + j; tri[ numTris ][ 1 ] = bottom + j; tri[ numTris ][ 2 ] = bottom + j1; numTris++;
+					tri[ numTris ][ 0 ] = top + j; tri[ numTris ][ 1 ] = bottom + j1; tri[ numTris ][ 2 ] = top + j1; numTris++;
+				}
+				for( int t = 0; t < numTris; t++ ) {
+					if ( inward ) std::swap( tri[ t ][ 1 ], tri[ t ][ 2 ] );
+					appendTriangle( mesh, tri[ t ][ 0 ], tri[ t ][ 1 ], tri[ t ][ 2 ] );
+				}
+			}
+		}
+	}
+
+	const char* names[ SyntheticMeshes::NUM_TYPES ] = { "torus", "noisy_sphere", "thin_shell", "multi_shell" };
+}
+
+const char* SyntheticMeshes::Name( Type type ) {
+	return names[ type ];
+}
+
+bool SyntheticMeshes::FromName( const char* name, Type& type ) {
+	for( int i = 0; i < NUM_TYPES; i++ ) {
+		if ( !strcmp( name, names[ i ] ) ) {
+			type = (Type)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void SyntheticMeshes::Generate( Type type, size_t targetTriangles, TriangleMesh& mesh ) {
+	mesh.clear();
+	const float origin[ 3 ] = { 0, 0, 0 };
+	switch( type ) {
+		case TORUS:
+			appendTorus( mesh, origin, 6.4f, 1.9f, targetTriangles );
+			break;
+		case NOISY_SPHERE:
+			appendSphere( mesh, origin, 6.0f, 0.1f, false, targetTriangles );
+			break;
+		case THIN_SHELL:
+			appendSphere( mesh, origin, 6.0f, 0.0f, false, targetTriangles / 2 );
+			appendSphere( mesh, origin, 5.94f, 0.0f, true, targetTriangles / 2 );
+			break;
+		case MULTI_SHELL:
+			for( int i = 0; i < 8; i++ ) {
+				const float center[ 3 ] = { ( i & 1 ) ? 8.0f : -8.0f, ( i & 2 ) ? 8.0f : -8.0f, ( i & 4 ) ? 8.0f : -8.0f };
+				if ( i % 2 == 0 ) {
+					appendTorus( mesh, center, 4.0f, 1.5f, targetTriangles / 8 );
+				} else {
+					appendSphere( mesh, center, 4.0f, 0.05f, false, targetTriangles / 8 );
+				}
+			}
+			break;
+		default:
+			break;
+	}
+}
@@ -0,0 +1,36 @@
+/*
+	================================================================================
+	Copyright (c) 2012, Jose Esteve. http://www.joesfer.com
+	This software is released under the LGPL-3.0 license: http://www.opensource.org/licenses/lgpl-3.0.html
+	================================================================================
+*/
+
+#pragma once
+
+#include "TriangleMesh.h"
+
+/* ==========================================
+	Class SyntheticMeshes
+
+	Procedural closed meshes of roughly a requested number
+	of triangles, used as the benchmark corpus. They are
+	scaled like the torus in MEL/Sample.mel, so the samplers'
+	density heuristics behave as they do in a scene.
+
+   ========================================== */
+
+class SyntheticMeshes {
+public:
+	enum Type {
+		TORUS,
+		NOISY_SPHERE,
+		THIN_SHELL,		// hollow sphere with a wall 1% of its radius thick
+		MULTI_SHELL,	// several disjoint tori and spheres
+		NUM_TYPES
+	};
+
+	static const char*	Name( Type type );
+	static bool			FromName( const char* name, Type& type );
+
+	static void			Generate( Type type, size_t targetTriangles, TriangleMesh& mesh );
+};